@@ -0,0 +1,653 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Micro-benchmarks of the RPL data structures and codecs:
+//  - RplRoutingTable::Lookup over tables of downward routes;
+//  - RplNeighborSet insert, update and SelectParent;
+//  - Serialize and Deserialize of every message and option;
+//  - the Rpl::Receive dispatch of DIS and DIO messages.
+//
+// Each benchmark is run for some warm-up repetitions, whose timings are
+// dropped, and then for the measured repetitions; a repetition times a
+// batch of operations and yields one sample in nanoseconds per operation.
+// The samples are summarized as a JSON document, on the standard output
+// or in a file, so that runs can be compared and regressions gated:
+//
+// ./waf --run "rpl-bench"
+// ./waf --run "rpl-bench --sizes=10,1000,100000 --repetitions=50 --output=rpl-bench.json"
+// ./waf --run "rpl-bench --filter=lookup"
+//
+// The protocol prints debugging output on std::cout; it is muted while
+// the benchmarks run, so that only the JSON document is printed.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplBench");
+
+static const uint16_t BENCH_PORT = 5210;
+
+typedef std::chrono::steady_clock BenchClock;
+
+// the samples of one benchmark, in nanoseconds per operation
+struct BenchResult
+{
+  std::string name;
+  uint32_t size;
+  uint32_t operations;
+  std::vector<double> samples;
+};
+
+static std::vector<BenchResult> g_results;
+static uint32_t g_warmup = 3;
+static uint32_t g_repetitions = 20;
+static uint32_t g_operations = 1000;
+static std::string g_filter;
+
+// keeps the compiler from optimizing the measured operations away
+static volatile uint64_t g_sink;
+
+static bool Selected (std::string name)
+{
+  return g_filter.empty () || name.find (g_filter) != std::string::npos;
+}
+
+static double Elapsed (BenchClock::time_point start, BenchClock::time_point end)
+{
+  return std::chrono::duration<double, std::nano> (end - start).count ();
+}
+
+// Time a benchmark: body.Reset () prepares each repetition, untimed, and
+// body (i) runs operation i of the batch
+template <typename Body>
+static void Measure (std::string name, uint32_t size, uint32_t operations, Body &body)
+{
+  if (!Selected (name))
+    {
+      return;
+    }
+
+  BenchResult result;
+  result.name = name;
+  result.size = size;
+  result.operations = operations;
+  for (uint32_t r = 0; r < g_warmup + g_repetitions; r++)
+    {
+      body.Reset ();
+      BenchClock::time_point start = BenchClock::now ();
+      for (uint32_t i = 0; i < operations; i++)
+        {
+          body (i);
+        }
+      BenchClock::time_point end = BenchClock::now ();
+      if (r >= g_warmup)
+        {
+          result.samples.push_back (Elapsed (start, end) / operations);
+        }
+    }
+  g_results.push_back (result);
+}
+
+// fewer operations per batch on large tables, so that a batch takes about as long at any size
+static uint32_t Operations (uint32_t size)
+{
+  return std::max<uint32_t> (1, uint64_t (g_operations) * 100 / std::max<uint32_t> (size, 100));
+}
+
+static Ipv6Address MakeAddress (uint8_t first, uint8_t second, uint32_t index)
+{
+  uint8_t bytes[16] = { 0 };
+  bytes[0] = first;
+  bytes[1] = second;
+  bytes[12] = index >> 24;
+  bytes[13] = index >> 16;
+  bytes[14] = index >> 8;
+  bytes[15] = index;
+  return Ipv6Address (bytes);
+}
+
+static std::vector<uint32_t> ParseSizes (std::string list)
+{
+  std::vector<uint32_t> sizes;
+  std::istringstream stream (list);
+  std::string token;
+  while (std::getline (stream, token, ','))
+    {
+      sizes.push_back (atoi (token.c_str ()));
+      NS_ABORT_MSG_IF (sizes.back () == 0, "sizes must be positive");
+    }
+  return sizes;
+}
+
+//
+// Routing table lookup
+//
+
+struct LookupBody
+{
+  RplRoutingTable *table;
+  std::vector<Ipv6Address> destinations;
+
+  void Reset ()
+  {
+  }
+  void operator() (uint32_t i)
+  {
+    Ptr<Ipv6Route> route = table->Lookup (destinations[i % destinations.size ()]);
+    g_sink += (route != 0);
+  }
+};
+
+static void BenchLookup (Ptr<Ipv6> ipv6, const std::vector<uint32_t> &sizes)
+{
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  for (uint32_t s = 0; s < sizes.size (); s++)
+    {
+      uint32_t size = sizes[s];
+      RplRoutingTable table;
+      table.SetIpv6 (ipv6);
+      table.SetDodagParent (Ipv6Address ("fe80::1"), 1);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          // one /128 downward route per node of the sub-DODAG, through 16 children
+          Ipv6Address nextHop = MakeAddress (0xfe, 0x80, 2 + i % 16);
+          table.AddNetworkRouteTo (nextHop, 1, nextHop, MakeAddress (0x20, 0x01, i), Ipv6Prefix (128));
+        }
+
+      LookupBody hit;
+      hit.table = &table;
+      for (uint32_t i = 0; i < 1024; i++)
+        {
+          hit.destinations.push_back (MakeAddress (0x20, 0x01, uniform->GetInteger (0, size - 1)));
+        }
+      Measure ("lookup-downward", size, Operations (size), hit);
+
+      // a destination outside the sub-DODAG scans the whole table before the default route
+      LookupBody miss;
+      miss.table = &table;
+      miss.destinations.push_back (MakeAddress (0x20, 0x02, 1));
+      Measure ("lookup-default", size, Operations (size), miss);
+
+      table.ClearRoutingTable ();
+      table.SetIpv6 (0);
+    }
+}
+
+//
+// Neighbor set
+//
+
+struct NeighborInsertBody
+{
+  RplNeighborSet neighbors;
+  std::vector<Neighbor> fresh;
+
+  void Reset ()
+  {
+    neighbors.ClearNeighborSet ();
+  }
+  void operator() (uint32_t i)
+  {
+    g_sink += (neighbors.AddNeighbor (fresh[i]) != 0);
+  }
+};
+
+struct NeighborUpdateBody
+{
+  RplNeighborSet *neighbors;
+  uint32_t size;
+
+  void Reset ()
+  {
+  }
+  void operator() (uint32_t i)
+  {
+    neighbors->UpdateNeighbor (MakeAddress (0xfe, 0x80, (i * 7919) % size), Ipv6Address ("2001:1::1"), 1,
+                               256 + (i % 8) * 256, 1);
+  }
+};
+
+struct SelectParentBody
+{
+  RplNeighborSet *neighbors;
+
+  void Reset ()
+  {
+  }
+  void operator() (uint32_t i)
+  {
+    Ptr<Neighbor> parent = neighbors->SelectParent (Ipv6Address ("2001:1::1"));
+    g_sink += (parent != 0);
+  }
+};
+
+static Neighbor MakeNeighbor (uint32_t index)
+{
+  Neighbor neighbor;
+  neighbor.SetNeighborAddress (MakeAddress (0xfe, 0x80, index));
+  neighbor.SetDodagId (Ipv6Address ("2001:1::1"));
+  neighbor.SetDtsn (1);
+  neighbor.SetRank (256 + (index % 8) * 256);
+  neighbor.SetInterface (1);
+  neighbor.SetReachable (true);
+  return neighbor;
+}
+
+static void BenchNeighborSet (const std::vector<uint32_t> &sizes)
+{
+  for (uint32_t s = 0; s < sizes.size (); s++)
+    {
+      uint32_t size = sizes[s];
+
+      // a batch fills an empty set up to the size
+      NeighborInsertBody insert;
+      for (uint32_t i = 0; i < size; i++)
+        {
+          insert.fresh.push_back (MakeNeighbor (i));
+        }
+      Measure ("neighbor-insert", size, size, insert);
+
+      RplNeighborSet neighbors;
+      for (uint32_t i = 0; i < size; i++)
+        {
+          neighbors.AddNeighbor (MakeNeighbor (i));
+        }
+      NeighborUpdateBody update;
+      update.neighbors = &neighbors;
+      update.size = size;
+      Measure ("neighbor-update", size, Operations (size), update);
+
+      SelectParentBody select;
+      select.neighbors = &neighbors;
+      Measure ("neighbor-select-parent", size, Operations (size), select);
+    }
+}
+
+//
+// Codecs
+//
+
+template <typename T>
+struct SerializeBody
+{
+  T header;
+  Buffer buffer;
+
+  void Reset ()
+  {
+  }
+  void operator() (uint32_t i)
+  {
+    header.Serialize (buffer.Begin ());
+  }
+};
+
+template <typename T>
+struct DeserializeBody
+{
+  T header;
+  Buffer buffer;
+
+  void Reset ()
+  {
+  }
+  void operator() (uint32_t i)
+  {
+    g_sink += header.Deserialize (buffer.Begin ());
+  }
+};
+
+template <typename T>
+static void BenchCodec (std::string name, const T &header)
+{
+  uint32_t size = header.GetSerializedSize ();
+
+  SerializeBody<T> serialize;
+  serialize.header = header;
+  serialize.buffer.AddAtStart (size);
+  Measure ("serialize-" + name, size, g_operations, serialize);
+
+  DeserializeBody<T> deserialize;
+  deserialize.buffer.AddAtStart (size);
+  header.Serialize (deserialize.buffer.Begin ());
+  Measure ("deserialize-" + name, size, g_operations, deserialize);
+}
+
+static void BenchCodecs ()
+{
+  RplDisMessage dis;
+  BenchCodec ("dis", dis);
+
+  RplDioMessage dio;
+  dio.SetFlagG (true);
+  dio.SetRplInstanceId (0);
+  dio.SetVersionNumber (1);
+  dio.SetRank (256);
+  dio.SetDtsn (1);
+  dio.SetDodagId (Ipv6Address ("2001:1::1"));
+  BenchCodec ("dio", dio);
+
+  RplDaoMessage dao;
+  dao.SetFlagK (true);
+  dao.SetFlagD (true);
+  dao.SetDaoSequence (1);
+  dao.SetDodagId (Ipv6Address ("2001:1::1"));
+  BenchCodec ("dao", dao);
+
+  RplDroMessage dro;
+  dro.SetFlagS (true);
+  dro.SetRplInstanceId (0x80);
+  dro.SetDodagId (Ipv6Address ("2001:1::2"));
+  BenchCodec ("dro", dro);
+
+  RplRouteInformationOption routeInformation;
+  routeInformation.SetPrefixLength (64);
+  routeInformation.SetRouteLifetime (3600);
+  routeInformation.SetPrefix (Ipv6Address ("2001:1::"));
+  BenchCodec ("route-information", routeInformation);
+
+  RplDodagConfigurationOption dodagConfiguration;
+  dodagConfiguration.SetDioIntervalDoublings (20);
+  dodagConfiguration.SetDioIntervalMin (3);
+  dodagConfiguration.SetDioRedundancyConstant (10);
+  dodagConfiguration.SetMinHopRankIncrease (256);
+  BenchCodec ("dodag-configuration", dodagConfiguration);
+
+  RplTargetOption target;
+  target.SetPrefixLength (128);
+  target.SetTarget (Ipv6Address ("2001:1::2"));
+  BenchCodec ("target", target);
+
+  RplTransitInformationOption transit;
+  transit.SetPathSequence (1);
+  transit.SetPathLifetime (30);
+  BenchCodec ("transit-information", transit);
+
+  RplOption rplOption;
+  rplOption.SetRplInstanceId (0);
+  rplOption.SetSenderRank (256);
+  BenchCodec ("rpl-option", rplOption);
+
+  RplSolicitedInformationOption solicitedInformation;
+  solicitedInformation.SetFlagV (true);
+  solicitedInformation.SetVersionNumber (1);
+  BenchCodec ("solicited-information", solicitedInformation);
+
+  RplMetricContainerOption metricContainer;
+  metricContainer.SetRootLoad (10);
+  metricContainer.SetQueueLoad (20);
+  BenchCodec ("metric-container", metricContainer);
+
+  RplP2pRouteDiscoveryOption routeDiscovery;
+  routeDiscovery.SetMaxRank (8);
+  routeDiscovery.SetTarget (Ipv6Address ("2001:1::9"));
+  routeDiscovery.AddAddress (Ipv6Address ("2001:1::3"));
+  routeDiscovery.AddAddress (Ipv6Address ("2001:1::4"));
+  BenchCodec ("p2p-route-discovery", routeDiscovery);
+}
+
+//
+// Receive dispatch
+//
+
+// the Rpl::Receive calls of the current repetition
+static Ptr<Rpl> g_receiver;
+static double g_receiveTime;
+static uint32_t g_received;
+
+static void TimedReceive (Ptr<Socket> socket)
+{
+  BenchClock::time_point start = BenchClock::now ();
+  g_receiver->Receive (socket);
+  BenchClock::time_point end = BenchClock::now ();
+  g_receiveTime += Elapsed (start, end);
+  g_received++;
+}
+
+static void Send (Ptr<Socket> socket, Ptr<Packet> message, Ipv6Address destination)
+{
+  socket->SendTo (message->Copy (), 0, Inet6SocketAddress (destination, BENCH_PORT));
+}
+
+// Time the dispatch of a message sent by the root to the other node, in
+// simulated batches one millisecond apart so that no queue overflows
+static void BenchReceive (std::string name, Ptr<Socket> sender, Ipv6Address receiver, Ptr<Packet> message)
+{
+  if (!Selected (name))
+    {
+      return;
+    }
+
+  BenchResult result;
+  result.name = name;
+  result.size = message->GetSize ();
+  result.operations = g_operations;
+  for (uint32_t r = 0; r < g_warmup + g_repetitions; r++)
+    {
+      g_receiveTime = 0;
+      g_received = 0;
+      for (uint32_t i = 0; i < g_operations; i++)
+        {
+          Simulator::Schedule (MilliSeconds (i), &Send, sender, message, receiver);
+        }
+      Simulator::Stop (MilliSeconds (g_operations + 10));
+      Simulator::Run ();
+      NS_ABORT_MSG_IF (g_received == 0, "no " << name << " message received");
+      if (r >= g_warmup)
+        {
+          result.samples.push_back (g_receiveTime / g_received);
+        }
+    }
+  g_results.push_back (result);
+}
+
+static void BenchReceiveDispatch ()
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  SimpleNetDeviceHelper simple;
+  NetDeviceContainer devices = simple.Install (nodes);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (nodes.Get (0), Ipv6Address ("2001:1::1"));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (nodes);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6.Assign (devices);
+
+  // the root sends the messages, the other node dispatches them
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<Socket> sender = Socket::CreateSocket (nodes.Get (0), tid);
+  sender->Bind6 ();
+  sender->BindToNetDevice (devices.Get (0));
+
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (1), tid);
+  sink->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), BENCH_PORT));
+  sink->SetRecvPktInfo (true);
+  sink->SetRecvCallback (MakeCallback (&TimedReceive));
+  g_receiver = nodes.Get (1)->GetObject<Rpl> ();
+
+  // RPL messages are exchanged between link-local addresses
+  Ptr<Ipv6> receiverIpv6 = nodes.Get (1)->GetObject<Ipv6> ();
+  uint32_t receiverInterface = receiverIpv6->GetInterfaceForDevice (devices.Get (1));
+  Ipv6Address receiver;
+  for (uint32_t j = 0; j < receiverIpv6->GetNAddresses (receiverInterface); j++)
+    {
+      Ipv6InterfaceAddress address = receiverIpv6->GetAddress (receiverInterface, j);
+      if (address.GetScope () == Ipv6InterfaceAddress::LINKLOCAL)
+        {
+          receiver = address.GetAddress ();
+        }
+    }
+
+  // let the node join, so that DIOs and DISs take the paths of a running DODAG
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  Icmpv6Header icmp;
+  icmp.SetType (155);
+
+  Ptr<Packet> dis = Create<Packet> ();
+  dis->AddHeader (RplSolicitedInformationOption ());
+  dis->AddHeader (RplDisMessage ());
+  icmp.SetCode (0);
+  dis->AddHeader (icmp);
+  BenchReceive ("receive-dis", sender, receiver, dis);
+
+  RplDioMessage dioMessage;
+  dioMessage.SetFlagG (true);
+  dioMessage.SetRplInstanceId (0);
+  dioMessage.SetVersionNumber (1);
+  dioMessage.SetRank (1);
+  dioMessage.SetDtsn (1);
+  dioMessage.SetDodagId (Ipv6Address ("2001:1::1"));
+  RplDodagConfigurationOption dodagConfiguration;
+  dodagConfiguration.SetMinHopRankIncrease (256);
+  Ptr<Packet> dio = Create<Packet> ();
+  dio->AddHeader (dodagConfiguration);
+  dio->AddHeader (dioMessage);
+  icmp.SetCode (1);
+  dio->AddHeader (icmp);
+  BenchReceive ("receive-dio", sender, receiver, dio);
+
+  g_receiver = 0;
+  Simulator::Destroy ();
+}
+
+//
+// Output
+//
+
+static double Percentile (const std::vector<double> &sorted, double p)
+{
+  // nearest rank
+  uint32_t rank = std::ceil (p / 100 * sorted.size ());
+  return sorted[std::max<uint32_t> (rank, 1) - 1];
+}
+
+static void WriteJson (std::ostream &os)
+{
+  os << "{" << std::endl;
+  os << "  \"warmup\": " << g_warmup << "," << std::endl;
+  os << "  \"repetitions\": " << g_repetitions << "," << std::endl;
+  os << "  \"unit\": \"ns/op\"," << std::endl;
+  os << "  \"benchmarks\": [" << std::endl;
+  for (uint32_t b = 0; b < g_results.size (); b++)
+    {
+      const BenchResult &result = g_results[b];
+      std::vector<double> sorted = result.samples;
+      std::sort (sorted.begin (), sorted.end ());
+      double mean = 0;
+      for (uint32_t i = 0; i < sorted.size (); i++)
+        {
+          mean += sorted[i];
+        }
+      mean /= sorted.size ();
+      double variance = 0;
+      for (uint32_t i = 0; i < sorted.size (); i++)
+        {
+          variance += (sorted[i] - mean) * (sorted[i] - mean);
+        }
+      variance /= sorted.size ();
+
+      os << "    { \"name\": \"" << result.name << "\", \"size\": " << result.size
+         << ", \"operations\": " << result.operations
+         << ", \"min\": " << sorted.front ()
+         << ", \"p50\": " << Percentile (sorted, 50)
+         << ", \"p90\": " << Percentile (sorted, 90)
+         << ", \"p99\": " << Percentile (sorted, 99)
+         << ", \"max\": " << sorted.back ()
+         << ", \"mean\": " << mean
+         << ", \"stddev\": " << std::sqrt (variance) << " }"
+         << (b + 1 < g_results.size () ? "," : "") << std::endl;
+    }
+  os << "  ]" << std::endl;
+  os << "}" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string sizes ("10,100,1000,10000,100000");
+  std::string neighborSizes ("10,100,1000");
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "comma separated routing table sizes", sizes);
+  cmd.AddValue ("neighborSizes", "comma separated neighbor set sizes", neighborSizes);
+  cmd.AddValue ("warmup", "repetitions run before the measured ones", g_warmup);
+  cmd.AddValue ("repetitions", "measured repetitions of each benchmark", g_repetitions);
+  cmd.AddValue ("operations", "operations per repetition (fewer on tables over 100 entries)", g_operations);
+  cmd.AddValue ("filter", "only run the benchmarks whose name contains this", g_filter);
+  cmd.AddValue ("output", "JSON output file (default: standard output)", output);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (g_repetitions == 0 || g_operations == 0, "repetitions and operations must be positive");
+
+  std::cout.setstate (std::ios::failbit);
+
+  // the lookups build routes with source addresses, so the tables need an IPv6 stack
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  InternetStackHelper internetv6;
+  internetv6.SetIpv4StackInstall (false);
+  internetv6.Install (node);
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  ipv6.Assign (NetDeviceContainer (device));
+
+  BenchLookup (node->GetObject<Ipv6> (), ParseSizes (sizes));
+  BenchNeighborSet (ParseSizes (neighborSizes));
+  BenchCodecs ();
+  BenchReceiveDispatch ();
+
+  std::cout.clear ();
+  if (output.empty ())
+    {
+      WriteJson (std::cout);
+    }
+  else
+    {
+      std::ofstream file (output.c_str ());
+      NS_ABORT_MSG_IF (!file, "cannot open " << output);
+      WriteJson (file);
+    }
+
+  return 0;
+}
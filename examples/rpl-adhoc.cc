@@ -180,6 +180,7 @@ int main (int argc, char *argv[])
 */
 
   RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
   InternetStackHelper internetv6routers;
   internetv6routers.SetIpv4StackInstall (false);
   internetv6routers.SetRoutingHelper (RplRouting);
@@ -0,0 +1,174 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// A border router, root of the DODAG, bridging a wired backhaul (CSMA) and
+// a line of 802.11b adhoc mesh nodes. A second router is attached to both
+// networks too, so it hears the root on two interfaces. RPL runs on every
+// interface of both routers: each sends its DIOs on the backhaul and on the
+// mesh, advertising the rank plus the cost of the interface.
+//
+// The rank of every node is printed at the end, along with the rank each
+// router advertises on each interface. With a mesh cost the dual-homed
+// router joins through the backhaul, and the mesh ranks grow by the cost:
+//
+// ./waf --run "rpl-border-router --meshCost=0"
+// ./waf --run "rpl-border-router --meshCost=512"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplBorderRouter");
+
+// the backhaul is assigned first, so it is interface 1 of the routers and the mesh interface 2
+static const uint32_t BACKHAUL_INTERFACE = 1;
+static const uint32_t MESH_INTERFACE = 2;
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t backhaulSize = 2;
+  uint32_t meshSize = 5;
+  double spacing = 40;
+  double range = 50;
+  uint32_t meshCost = 512;
+  double simTime = 30;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("backhaulSize", "number of nodes on the backhaul only", backhaulSize);
+  cmd.AddValue ("meshSize", "number of nodes in the mesh line", meshSize);
+  cmd.AddValue ("spacing", "distance between mesh neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("meshCost", "rank cost of the mesh interface of both routers", meshCost);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (meshCost > 0xffff, "the cost is a rank");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  // node 0 is the border router, node 1 the dual-homed router
+  NodeContainer routers;
+  routers.Create (2);
+  NodeContainer backhaulOnly;
+  backhaulOnly.Create (backhaulSize);
+  NodeContainer meshOnly;
+  meshOnly.Create (meshSize);
+
+  NodeContainer backhaul (routers, backhaulOnly);
+  NodeContainer mesh (routers, meshOnly);
+  NodeContainer all (routers, backhaulOnly, meshOnly);
+
+  CsmaHelper csma;
+  csma.SetChannelAttribute ("DataRate", DataRateValue (100000000));
+  csma.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+  NetDeviceContainer backhaulDevices = csma.Install (backhaul);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer meshDevices = wifi.Install (wifiPhy, wifiMac, mesh);
+
+  // the routers side by side, the mesh line going away from them
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (0.0, 0.0, 0.0));
+  positions->Add (Vector (0.0, spacing / 2, 0.0));
+  for (uint32_t i = 0; i < meshSize; i++)
+    {
+      positions->Add (Vector (spacing * (i + 1), 0.0, 0.0));
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (mesh);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (routers.Get (0));
+  for (uint32_t i = 0; i < routers.GetN (); i++)
+    {
+      RplRouting.SetInterfaceCost (routers.Get (i), MESH_INTERFACE, meshCost);
+    }
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (all);
+  ConnectRplWifiHooks (meshDevices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer backhaulInterfaces = ipv6.Assign (backhaulDevices);
+  ipv6.SetBase (Ipv6Address ("2001:2::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer meshInterfaces = ipv6.Assign (meshDevices);
+  for (uint32_t i = 0; i < backhaul.GetN (); i++)
+    {
+      backhaulInterfaces.SetForwarding (i, true);
+    }
+  for (uint32_t i = 0; i < mesh.GetN (); i++)
+    {
+      meshInterfaces.SetForwarding (i, true);
+    }
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  std::cout << "Mesh interface cost " << meshCost << std::endl;
+  std::cout << "router\tRPL interfaces\trank\tbackhaul rank\tmesh rank" << std::endl;
+  for (uint32_t i = 0; i < routers.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = routers.Get (i)->GetObject<Rpl> ();
+      std::cout << i << "\t" << rpl->GetNRplInterfaces () << "\t\t" << rpl->GetRank () << "\t"
+                << rpl->GetAdvertisedRank (BACKHAUL_INTERFACE) << "\t\t"
+                << rpl->GetAdvertisedRank (MESH_INTERFACE) << std::endl;
+    }
+  std::cout << "node\tnetwork\t\trank" << std::endl;
+  for (uint32_t i = 0; i < backhaulOnly.GetN (); i++)
+    {
+      std::cout << routers.GetN () + i << "\tbackhaul\t" << backhaulOnly.Get (i)->GetObject<Rpl> ()->GetRank () << std::endl;
+    }
+  for (uint32_t i = 0; i < meshOnly.GetN (); i++)
+    {
+      std::cout << routers.GetN () + backhaulSize + i << "\tmesh\t\t"
+                << meshOnly.Get (i)->GetObject<Rpl> ()->GetRank () << std::endl;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,186 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Convergecast over a grid of 802.11b adhoc nodes: every node sends UDP
+// packets to a single DODAG root in the corner. The offered load is raised
+// step by step and, for each rate, the same scenario is run with plain OF0
+// parent selection and with congestion-aware selection, where parents
+// advertise their queue occupancy in DIOs. The throughput received by
+// the root is printed for both, so the saturation points can be compared.
+//
+// ./waf --run "rpl-congestion"
+// ./waf --run "rpl-congestion --rates=1,2,4,8,16 --size=6"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplCongestion");
+
+static const uint16_t SINK_PORT = 9;
+
+static void SendToRoot (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                        Time interval, Time stop)
+{
+  Ipv6Address root = rpl->GetDodagId ();
+  if (root != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (root, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToRoot, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+// Run the convergecast once and return the throughput at the root, in kbit/s
+static double RunConvergecast (bool congestionAware, double rate, uint32_t size, double spacing,
+                               double range, uint32_t packetSize, double simTime, std::string phyMode)
+{
+  Config::SetDefault ("ns3::Rpl::CongestionAware", BooleanValue (congestionAware));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (c.Get (0));
+  sinks.Start (Seconds (0.0));
+
+  // traffic starts once the DODAG had time to form
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  Time interval = Seconds (1.0 / rate);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
+      Simulator::ScheduleWithContext (c.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval.GetSeconds ())),
+                                      &SendToRoot, source, rpl, packetSize, interval, stop);
+    }
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  Ptr<PacketSink> rootSink = DynamicCast<PacketSink> (sinks.Get (0));
+  double throughput = rootSink->GetTotalRx () * 8.0 / (stop - start).GetSeconds () / 1000.0;
+
+  Simulator::Destroy ();
+  return throughput;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  std::string rates ("0.5,1,2,4,8");
+  uint32_t size = 5;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  double simTime = 70;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("rates", "comma separated packet rates (packets per second per node)", rates);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("simTime", "simulation time of each run (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  std::vector<double> rateList;
+  std::istringstream rateStream (rates);
+  std::string token;
+  while (std::getline (rateStream, token, ','))
+    {
+      rateList.push_back (atof (token.c_str ()));
+    }
+
+  std::cout << "rate (pkt/s/node)\tOF0 (kbit/s)\tcongestion-aware (kbit/s)" << std::endl;
+  for (uint32_t r = 0; r < rateList.size (); r++)
+    {
+      NS_ABORT_MSG_IF (rateList[r] <= 0, "rates must be positive");
+      double of0 = RunConvergecast (false, rateList[r], size, spacing, range, packetSize, simTime, phyMode);
+      double aware = RunConvergecast (true, rateList[r], size, spacing, range, packetSize, simTime, phyMode);
+      std::cout << rateList[r] << "\t\t\t" << of0 << "\t\t" << aware << std::endl;
+    }
+
+  return 0;
+}
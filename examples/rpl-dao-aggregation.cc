@@ -0,0 +1,194 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// A grid of 802.11b adhoc nodes forming a storing mode DODAG rooted in the
+// corner: every node announces its address upwards in DAOs, and every
+// router installs the downward routes it learns and passes them on to its
+// own parent. The nodes whose preferred parent is the root (the root's
+// one-hop ring) relay the announcements of the whole DODAG, so their DAO
+// traffic is where the control plane is heaviest.
+//
+// At the end the DAO messages and bytes sent to the root by each node of
+// the ring are printed, along with the DAO totals of the whole DODAG and
+// the downward routes held by the root, which carries one route per node
+// unless they are collapsed into covering prefixes. Compare one DAO per
+// announcement with merged, prefix-compressed DAOs, and the root's table
+// with and without route aggregation:
+//
+// ./waf --run "rpl-dao-aggregation --daoAggregation=0 --routeAggregation=0"
+// ./waf --run "rpl-dao-aggregation --daoAggregation=1 --routeAggregation=0"
+// ./waf --run "rpl-dao-aggregation --daoAggregation=1 --routeAggregation=1"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplDaoAggregation");
+
+// DAO messages, bytes and targets sent by each node
+struct DaoCount
+{
+  uint32_t messages;
+  uint32_t bytes;
+  uint32_t targets;
+};
+
+static Ipv6Address g_root;
+static std::map<uint32_t, DaoCount> g_toRoot;
+static DaoCount g_total;
+
+static void DaoSent (uint32_t node, Ptr<const Packet> packet, Ipv6Address parent, uint32_t targets)
+{
+  g_total.messages++;
+  g_total.bytes += packet->GetSize ();
+  g_total.targets += targets;
+  if (parent == g_root)
+    {
+      DaoCount &count = g_toRoot[node];
+      count.messages++;
+      count.bytes += packet->GetSize ();
+      count.targets += targets;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 7;
+  double spacing = 40;
+  double range = 50;
+  double simTime = 60;
+  bool daoAggregation = true;
+  double daoDelay = 1.0;
+  bool routeAggregation = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("daoAggregation", "merge DAO targets into as few DAOs and prefixes as possible", daoAggregation);
+  cmd.AddValue ("daoDelay", "time (seconds) a DAO target is held to be merged with others", daoDelay);
+  cmd.AddValue ("routeAggregation", "collapse the downward routes into covering prefixes", routeAggregation);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::DownwardRoutes", BooleanValue (true));
+  Config::SetDefault ("ns3::Rpl::DaoAggregation", BooleanValue (daoAggregation));
+  Config::SetDefault ("ns3::Rpl::DaoDelay", TimeValue (Seconds (daoDelay)));
+  Config::SetDefault ("ns3::Rpl::RouteAggregationInterval", TimeValue (routeAggregation ? Seconds (10) : Seconds (0)));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  // DAOs are sent to the link-local address of the parent
+  g_root = c.Get (0)->GetObject<Ipv6> ()->GetAddress (1, 0).GetAddress ();
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      c.Get (i)->GetObject<Rpl> ()->TraceConnectWithoutContext ("DaoTx", MakeBoundCallback (&DaoSent, i));
+    }
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  std::cout << "DAO aggregation " << (daoAggregation ? "on" : "off") << ", route aggregation "
+            << (routeAggregation ? "on" : "off") << ", " << c.GetN () << " nodes" << std::endl;
+  std::cout << "node\tDAOs to root\tbytes\ttargets" << std::endl;
+  DaoCount ring = { 0, 0, 0 };
+  for (std::map<uint32_t, DaoCount>::const_iterator it = g_toRoot.begin (); it != g_toRoot.end (); it++)
+    {
+      std::cout << it->first << "\t" << it->second.messages << "\t\t" << it->second.bytes
+                << "\t" << it->second.targets << std::endl;
+      ring.messages += it->second.messages;
+      ring.bytes += it->second.bytes;
+      ring.targets += it->second.targets;
+    }
+
+  uint32_t ringSize = g_toRoot.size ();
+  std::cout << "Root one-hop ring: " << ringSize << " nodes, " << ring.messages << " DAOs, "
+            << ring.bytes << " bytes" << std::endl;
+  if (ringSize > 0)
+    {
+      std::cout << "Per ring node: " << double (ring.messages) / ringSize << " DAOs, "
+                << double (ring.bytes) / ringSize << " bytes" << std::endl;
+    }
+  std::cout << "Whole DODAG: " << g_total.messages << " DAOs, " << g_total.bytes << " bytes, "
+            << g_total.targets << " targets" << std::endl;
+
+  uint32_t rootRoutes = c.Get (0)->GetObject<Rpl> ()->GetNDownwardRoutes ();
+  std::cout << "Root downward routes: " << rootRoutes << " (about "
+            << rootRoutes * sizeof (RplRoutingTableEntry) << " bytes of entries)" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,197 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Trickle DIOs aligned to the wake windows of a duty-cycled radio. A grid
+// of 802.11b adhoc nodes forms a DODAG; every node is given the same
+// RplDutyCycle, standing in for a synchronized duty-cycled MAC: the radio is
+// awake for wakeDuration at the start of every period. The same scenario is
+// run with the DIOs sent at the plain Trickle times, each one outside a
+// window waking the radio up, and with the DIOs moved into the windows.
+//
+// The wifi radio itself stays on: the schedule only accounts for the time
+// a duty-cycled radio would be on. For each run, the DIOs sent, the extra
+// wakeups and the radio-on time per node are printed, along with the nodes
+// that joined and the radio-on time saved by the alignment:
+//
+// ./waf --run "rpl-duty-cycle"
+// ./waf --run "rpl-duty-cycle --period=0.25 --wakeDuration=0.005 --simTime=300"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplDutyCycle");
+
+// DIO activity of the nodes in a run, per node
+struct DioActivity
+{
+  uint32_t joined;
+  double dios;
+  double wakeups;
+  double radioOn;
+};
+
+static uint32_t g_dios;
+
+static void ControlTx (Ptr<const Packet> packet, uint8_t code)
+{
+  if (code == 1)
+    {
+      g_dios++;
+    }
+}
+
+// Run the scenario once and return the DIO activity of the nodes
+static DioActivity RunScenario (bool aligned, uint32_t size, double spacing, double range,
+                                Time period, Time wakeDuration, double simTime, std::string phyMode)
+{
+  Config::SetDefault ("ns3::Rpl::WakeAlignment", BooleanValue (aligned));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  // the schedule is published by aggregating it to the node, as a MAC would
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<RplDutyCycle> dutyCycle = CreateObject<RplDutyCycle> ();
+      dutyCycle->SetSchedule (period, wakeDuration, Seconds (0));
+      c.Get (i)->AggregateObject (dutyCycle);
+    }
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  g_dios = 0;
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      c.Get (i)->GetObject<Rpl> ()->TraceConnectWithoutContext ("ControlTx", MakeCallback (&ControlTx));
+    }
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  DioActivity activity = { 0, 0, 0, 0 };
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      Ptr<RplDutyCycle> dutyCycle = c.Get (i)->GetObject<RplDutyCycle> ();
+      activity.joined += (rpl->GetRank () != 0);
+      activity.wakeups += rpl->GetNDioWakeups ();
+      activity.radioOn += dutyCycle->GetRadioOnTime (Seconds (simTime), rpl->GetNDioWakeups ()).GetSeconds ();
+    }
+  activity.dios = (double)g_dios / c.GetN ();
+  activity.wakeups /= c.GetN ();
+  activity.radioOn /= c.GetN ();
+
+  Simulator::Destroy ();
+  return activity;
+}
+
+static void PrintActivity (std::string mode, const DioActivity &activity, uint32_t nNodes)
+{
+  std::cout << mode << "\t" << activity.joined << "/" << nNodes << "\t" << activity.dios << "\t\t"
+            << activity.wakeups << "\t\t" << activity.radioOn << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 5;
+  double spacing = 40;
+  double range = 50;
+  double period = 0.5;
+  double wakeDuration = 0.01;
+  double simTime = 120;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("period", "time between two wake windows (seconds)", period);
+  cmd.AddValue ("wakeDuration", "length of a wake window (seconds)", wakeDuration);
+  cmd.AddValue ("simTime", "simulation time of each run (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (period <= 0 || wakeDuration <= 0 || wakeDuration > period, "invalid wake schedule");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  DioActivity plain = RunScenario (false, size, spacing, range, Seconds (period), Seconds (wakeDuration),
+                                   simTime, phyMode);
+  DioActivity aligned = RunScenario (true, size, spacing, range, Seconds (period), Seconds (wakeDuration),
+                                     simTime, phyMode);
+
+  std::cout << "Per node, duty cycle " << 100 * wakeDuration / period << "%" << std::endl;
+  std::cout << "mode\tjoined\tDIOs sent\textra wakeups\tradio on (s)" << std::endl;
+  PrintActivity ("plain", plain, size * size);
+  PrintActivity ("aligned", aligned, size * size);
+  std::cout << "radio-on time saved per node: " << plain.radioOn - aligned.radioOn << " s" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,284 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Network lifetime with energy-aware parent selection. A grid of 802.11b
+// adhoc nodes sends UDP packets to a mains-powered DODAG root in the
+// corner. Every other node runs on a battery (BasicEnergySource) drained by
+// its radio (WifiRadioEnergyModel), with initial energies drawn once
+// between minEnergy and maxEnergy so that some forwarders are weaker than
+// others. The same scenario is run with plain OF0 parent selection and with
+// energy-aware selection, where nodes advertise the lowest residual energy
+// on their path in the DIO Node Energy object.
+//
+// For each run the time the first node runs out of energy, the nodes out
+// of energy at the end and the packets delivered to the root are printed:
+//
+// ./waf --run "rpl-energy"
+// ./waf --run "rpl-energy --size=6 --interval=0.5 --simTime=900"
+//
+// The idle current is that of a duty-cycled radio, so that the energy is
+// spent on the frames sent and received rather than on listening.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/energy-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplEnergy");
+
+static const uint16_t SINK_PORT = 9;
+static const double LOW_BATTERY_THRESHOLD = 0.1;
+
+// lifetime of the network in a run
+struct Lifetime
+{
+  Time firstDeath;
+  uint32_t dead;
+  uint32_t delivered;
+};
+
+static Time g_firstDeath;
+static uint32_t g_dead;
+
+// a source is depleted once it reaches the low battery threshold
+static void RemainingEnergy (double depleted, double oldValue, double newValue)
+{
+  if (oldValue > depleted && newValue <= depleted)
+    {
+      if (g_dead == 0)
+        {
+          g_firstDeath = Simulator::Now ();
+        }
+      g_dead++;
+    }
+}
+
+// the residual energy of a node is that of its weakest source
+static double ResidualEnergy (Ptr<EnergySourceContainer> sources)
+{
+  double fraction = 1.0;
+  for (EnergySourceContainer::Iterator it = sources->Begin (); it != sources->End (); it++)
+    {
+      fraction = std::min (fraction, (*it)->GetEnergyFraction ());
+    }
+  return fraction;
+}
+
+static void SendToRoot (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                        Time interval, Time stop)
+{
+  Ipv6Address root = rpl->GetDodagId ();
+  if (root != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (root, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToRoot, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+// Run the convergecast once, the nodes starting with the given energies
+static Lifetime RunScenario (bool energyAware, const std::vector<double> &energies, uint32_t size,
+                             double spacing, double range, uint32_t packetSize, double interval,
+                             double idleCurrent, double simTime, std::string phyMode)
+{
+  Config::SetDefault ("ns3::Rpl::EnergyAware", BooleanValue (energyAware));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  // the root is mains-powered: no energy source, so it advertises a full battery
+  g_firstDeath = Time ();
+  g_dead = 0;
+  BasicEnergySourceHelper battery;
+  battery.Set ("BasicEnergyLowBatteryThreshold", DoubleValue (LOW_BATTERY_THRESHOLD));
+  EnergySourceContainer sources;
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      battery.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (energies[i - 1]));
+      EnergySourceContainer source = battery.Install (c.Get (i));
+      source.Get (0)->TraceConnectWithoutContext ("RemainingEnergy",
+                                                  MakeBoundCallback (&RemainingEnergy, energies[i - 1] * LOW_BATTERY_THRESHOLD));
+      sources.Add (source);
+    }
+
+  NetDeviceContainer batteryDevices;
+  for (uint32_t i = 1; i < devices.GetN (); i++)
+    {
+      batteryDevices.Add (devices.Get (i));
+    }
+  WifiRadioEnergyModelHelper radio;
+  radio.Set ("IdleCurrentA", DoubleValue (idleCurrent));
+  radio.Install (batteryDevices, sources);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      c.Get (i)->GetObject<Rpl> ()->SetResidualEnergyCallback (
+        MakeBoundCallback (&ResidualEnergy, c.Get (i)->GetObject<EnergySourceContainer> ()));
+    }
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (c.Get (0));
+  sinks.Start (Seconds (0.0));
+
+  // traffic starts once the DODAG had time to form
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
+      Simulator::ScheduleWithContext (c.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval)),
+                                      &SendToRoot, source, c.Get (i)->GetObject<Rpl> (), packetSize,
+                                      Seconds (interval), stop);
+    }
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  Lifetime lifetime;
+  lifetime.firstDeath = g_firstDeath;
+  lifetime.dead = g_dead;
+  lifetime.delivered = DynamicCast<PacketSink> (sinks.Get (0))->GetTotalRx () / packetSize;
+
+  Simulator::Destroy ();
+  return lifetime;
+}
+
+static void PrintLifetime (std::string mode, const Lifetime &lifetime, uint32_t nBatteries)
+{
+  std::cout << mode << "\t";
+  if (lifetime.dead == 0)
+    {
+      std::cout << "none\t\t";
+    }
+  else
+    {
+      std::cout << lifetime.firstDeath.GetSeconds () << "\t\t";
+    }
+  std::cout << lifetime.dead << "/" << nBatteries << "\t\t" << lifetime.delivered << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 5;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  double interval = 1.0;
+  double minEnergy = 5;
+  double maxEnergy = 15;
+  double idleCurrent = 0.001;
+  double simTime = 600;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a node", interval);
+  cmd.AddValue ("minEnergy", "lowest initial energy of a battery (J)", minEnergy);
+  cmd.AddValue ("maxEnergy", "highest initial energy of a battery (J)", maxEnergy);
+  cmd.AddValue ("idleCurrent", "current drawn by an idle radio (A)", idleCurrent);
+  cmd.AddValue ("simTime", "simulation time of each run (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (size < 2, "the grid needs a root and a battery node at least");
+  NS_ABORT_MSG_IF (minEnergy <= 0 || maxEnergy < minEnergy, "invalid energy range");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  // both runs start from the same batteries
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  std::vector<double> energies;
+  for (uint32_t i = 1; i < size * size; i++)
+    {
+      energies.push_back (uniform->GetValue (minEnergy, maxEnergy));
+    }
+
+  Lifetime of0 = RunScenario (false, energies, size, spacing, range, packetSize, interval,
+                              idleCurrent, simTime, phyMode);
+  Lifetime aware = RunScenario (true, energies, size, spacing, range, packetSize, interval,
+                                idleCurrent, simTime, phyMode);
+
+  std::cout << "mode\tfirst death (s)\tout of energy\tdelivered packets" << std::endl;
+  PrintLifetime ("OF0", of0, energies.size ());
+  PrintLifetime ("energy", aware, energies.size ());
+
+  return 0;
+}
@@ -0,0 +1,208 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Memory held by battery sensors running as RPL routers or as leaves. A
+// line of 802.11b adhoc routers, rooted at one end, carries a cluster of
+// sensors scattered around each router. The same scenario is run twice:
+// once with the sensors as routers, which keep every neighbor they hear,
+// a route to each of them and a Trickle timer, and once with the sensors
+// as leaves, which keep their parent only and send no DIO.
+//
+// For each run the state held by a sensor is printed: neighbors, routes and
+// the estimated bytes of their entries, along with the DIOs the sensors
+// sent and how many of them joined the DODAG:
+//
+// ./waf --run "rpl-leaf-memory"
+// ./waf --run "rpl-leaf-memory --routers=5 --sensors=20"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplLeafMemory");
+
+// state held by the sensors at the end of a run
+struct SensorMemory
+{
+  uint32_t joined;
+  double neighbors;
+  double routes;
+  double bytes;
+  uint32_t maxBytes;
+  uint32_t dios;
+};
+
+static uint32_t g_sensorDios;
+
+static void ControlTx (Ptr<const Packet> packet, uint8_t code)
+{
+  if (code == 1)
+    {
+      g_sensorDios++;
+    }
+}
+
+// Run the scenario once and return the state held by the sensors
+static SensorMemory RunScenario (bool leaves, uint32_t routers, uint32_t sensors, double spacing,
+                                 double range, double simTime, std::string phyMode)
+{
+  NodeContainer routerNodes;
+  routerNodes.Create (routers);
+  NodeContainer sensorNodes;
+  sensorNodes.Create (routers * sensors);
+  NodeContainer c (routerNodes, sensorNodes);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  // the sensors of a router are scattered within half the range around it
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < routers; i++)
+    {
+      positions->Add (Vector (spacing * i, 0.0, 0.0));
+    }
+  Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < routers; i++)
+    {
+      for (uint32_t j = 0; j < sensors; j++)
+        {
+          double distance = uniform->GetValue (0, range / 2);
+          double angle = uniform->GetValue (0, 2 * M_PI);
+          positions->Add (Vector (spacing * i + distance * std::cos (angle), distance * std::sin (angle), 0.0));
+        }
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (routerNodes.Get (0));
+  if (leaves)
+    {
+      RplRouting.SetLeaf (sensorNodes);
+    }
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  g_sensorDios = 0;
+  for (uint32_t i = 0; i < sensorNodes.GetN (); i++)
+    {
+      sensorNodes.Get (i)->GetObject<Rpl> ()->TraceConnectWithoutContext ("ControlTx", MakeCallback (&ControlTx));
+    }
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  SensorMemory memory = { 0, 0, 0, 0, 0, g_sensorDios };
+  for (uint32_t i = 0; i < sensorNodes.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = sensorNodes.Get (i)->GetObject<Rpl> ();
+      uint32_t neighbors = rpl->GetNeighborSet ().GetNNeighbors ();
+      uint32_t routes = rpl->GetNRoutes ();
+      uint32_t bytes = neighbors * sizeof (Neighbor) + routes * sizeof (RplRoutingTableEntry);
+      memory.joined += (rpl->GetRank () != 0);
+      memory.neighbors += neighbors;
+      memory.routes += routes;
+      memory.bytes += bytes;
+      memory.maxBytes = std::max (memory.maxBytes, bytes);
+    }
+  memory.neighbors /= sensorNodes.GetN ();
+  memory.routes /= sensorNodes.GetN ();
+  memory.bytes /= sensorNodes.GetN ();
+
+  Simulator::Destroy ();
+  return memory;
+}
+
+static void PrintMemory (std::string mode, const SensorMemory &memory, uint32_t nSensors)
+{
+  std::cout << mode << "\t" << memory.joined << "/" << nSensors << "\t" << memory.neighbors << "\t\t"
+            << memory.routes << "\t" << memory.bytes << "\t\t" << memory.maxBytes << "\t\t"
+            << memory.dios << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t routers = 4;
+  uint32_t sensors = 10;
+  double spacing = 40;
+  double range = 50;
+  double simTime = 60;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("routers", "number of routers in the line", routers);
+  cmd.AddValue ("sensors", "number of sensors around each router", sensors);
+  cmd.AddValue ("spacing", "distance between routers (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("simTime", "simulation time of each run (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (routers == 0 || sensors == 0, "routers and sensors are needed");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  SensorMemory router = RunScenario (false, routers, sensors, spacing, range, simTime, phyMode);
+  SensorMemory leaf = RunScenario (true, routers, sensors, spacing, range, simTime, phyMode);
+
+  std::cout << "Per sensor, " << routers * sensors << " sensors (protocol object "
+            << sizeof (Rpl) << " bytes in both modes)" << std::endl;
+  std::cout << "mode\tjoined\tneighbors\troutes\tentry bytes\tmax bytes\tDIOs sent" << std::endl;
+  PrintMemory ("router", router, routers * sensors);
+  PrintMemory ("leaf", leaf, routers * sensors);
+
+  return 0;
+}
@@ -0,0 +1,272 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Fast parent switching for mobile nodes. A grid of static 802.11b adhoc
+// nodes forms a DODAG rooted in the corner, and mobile nodes move over it
+// with a RandomWaypointMobilityModel, sending UDP packets to the root. The
+// received power falls off with distance (LogDistancePropagationLossModel),
+// so the RSSI of a parent link drops as a mobile node moves away from it.
+//
+// The same scenario is run without and with the mobility mode. Without it,
+// a mobile node keeps its parent until the link breaks and the parent is
+// declared unreachable. With it, the node follows the RSSI and ETX trend of
+// the parent link, solicits DIOs with unicast DIS once the link degrades
+// and hands over to another parent before the link breaks.
+//
+// For each run the packet delivery ratio of the mobile nodes, the
+// handovers and reroutes, and the mean handover latency (from detecting a
+// degrading link to the switch) are printed:
+//
+// ./waf --run "rpl-mobility"
+// ./waf --run "rpl-mobility --nMobile=6 --maxSpeed=10 --simTime=600"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplMobility");
+
+static const uint16_t SINK_PORT = 9;
+
+// delivery and parent changes of the mobile nodes in a run
+struct MobilityStats
+{
+  uint32_t sent;
+  uint32_t delivered;
+  uint32_t handovers;
+  uint32_t reroutes;
+  Time latency;
+};
+
+static MobilityStats g_stats;
+
+static void Handover (Ipv6Address oldParent, Ipv6Address newParent, Time latency)
+{
+  g_stats.handovers++;
+  g_stats.latency += latency;
+}
+
+static void Reroute (Ipv6Address oldParent, Ipv6Address newParent, Time latency)
+{
+  g_stats.reroutes++;
+}
+
+static void SendToRoot (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                        Time interval, Time stop)
+{
+  // a packet the node could not route still counts as sent
+  g_stats.sent++;
+  Ipv6Address root = rpl->GetDodagId ();
+  if (root != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (root, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToRoot, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+// Run the scenario once and return the delivery and handovers of the mobile nodes
+static MobilityStats RunScenario (bool mobilityMode, uint32_t size, uint32_t nMobile, double spacing,
+                                  double minSpeed, double maxSpeed, uint32_t packetSize,
+                                  double interval, double simTime, std::string phyMode)
+{
+  Config::SetDefault ("ns3::Rpl::MobilityMode", BooleanValue (mobilityMode));
+
+  NodeContainer grid;
+  grid.Create (size * size);
+  NodeContainer mobile;
+  mobile.Create (nMobile);
+  NodeContainer c (grid, mobile);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::LogDistancePropagationLossModel", "Exponent", DoubleValue (3.0));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (grid);
+
+  // the mobile nodes wander over the area covered by the grid
+  std::ostringstream side;
+  side << "ns3::UniformRandomVariable[Min=0.0|Max=" << spacing * (size - 1) << "]";
+  ObjectFactory waypoints;
+  waypoints.SetTypeId ("ns3::RandomRectanglePositionAllocator");
+  waypoints.Set ("X", StringValue (side.str ()));
+  waypoints.Set ("Y", StringValue (side.str ()));
+  Ptr<PositionAllocator> waypointAlloc = waypoints.Create<PositionAllocator> ();
+
+  std::ostringstream speed;
+  speed << "ns3::UniformRandomVariable[Min=" << minSpeed << "|Max=" << maxSpeed << "]";
+  MobilityHelper walk;
+  walk.SetPositionAllocator (waypointAlloc);
+  walk.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                         "Speed", StringValue (speed.str ()),
+                         "Pause", StringValue ("ns3::ConstantRandomVariable[Constant=2.0]"),
+                         "PositionAllocator", PointerValue (waypointAlloc));
+  walk.Install (mobile);
+  // both runs follow the same paths
+  walk.AssignStreams (mobile, 0);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (grid.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (grid.Get (0));
+  sinks.Start (Seconds (0.0));
+
+  g_stats.sent = 0;
+  g_stats.handovers = 0;
+  g_stats.reroutes = 0;
+  g_stats.latency = Time ();
+
+  // only the mobile nodes send, once the DODAG had time to form
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < mobile.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = mobile.Get (i)->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("Handover", MakeCallback (&Handover));
+      rpl->TraceConnectWithoutContext ("Reroute", MakeCallback (&Reroute));
+
+      Ptr<Socket> source = Socket::CreateSocket (mobile.Get (i), tid);
+      Simulator::ScheduleWithContext (mobile.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval)),
+                                      &SendToRoot, source, rpl, packetSize, Seconds (interval), stop);
+    }
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  g_stats.delivered = DynamicCast<PacketSink> (sinks.Get (0))->GetTotalRx () / packetSize;
+  MobilityStats stats = g_stats;
+
+  Simulator::Destroy ();
+  return stats;
+}
+
+static void PrintStats (std::string mode, const MobilityStats &stats)
+{
+  std::cout << mode << "\t" << stats.delivered << "/" << stats.sent << "\t";
+  if (stats.sent)
+    {
+      std::cout << 100.0 * stats.delivered / stats.sent;
+    }
+  else
+    {
+      std::cout << "-";
+    }
+  std::cout << "\t" << stats.handovers << "\t\t" << stats.reroutes << "\t\t";
+  if (stats.handovers)
+    {
+      std::cout << stats.latency.GetSeconds () / stats.handovers;
+    }
+  else
+    {
+      std::cout << "-";
+    }
+  std::cout << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 4;
+  uint32_t nMobile = 4;
+  double spacing = 60;
+  double minSpeed = 1;
+  double maxSpeed = 5;
+  uint32_t packetSize = 64;
+  double interval = 0.5;
+  double simTime = 300;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "static grid width and height", size);
+  cmd.AddValue ("nMobile", "number of mobile nodes", nMobile);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("minSpeed", "lowest speed of a mobile node (m/s)", minSpeed);
+  cmd.AddValue ("maxSpeed", "highest speed of a mobile node (m/s)", maxSpeed);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a mobile node", interval);
+  cmd.AddValue ("simTime", "simulation time of each run (seconds)", simTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (size < 2, "the grid needs two nodes per side at least");
+  NS_ABORT_MSG_IF (minSpeed <= 0 || maxSpeed < minSpeed, "invalid speed range");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+
+  MobilityStats breakage = RunScenario (false, size, nMobile, spacing, minSpeed, maxSpeed, packetSize,
+                                        interval, simTime, phyMode);
+  MobilityStats handover = RunScenario (true, size, nMobile, spacing, minSpeed, maxSpeed, packetSize,
+                                        interval, simTime, phyMode);
+
+  std::cout << "mode\tdelivered\tPDR (%)\thandovers\treroutes\thandover latency (s)" << std::endl;
+  PrintStats ("default", breakage);
+  PrintStats ("mobility", handover);
+
+  return 0;
+}
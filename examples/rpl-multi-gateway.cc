@@ -0,0 +1,196 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// A grid of 802.11b adhoc nodes served by several gateways, each one the
+// root of its own DODAG. Every other node periodically sends a UDP packet
+// to the root of the DODAG it currently belongs to. At the end the
+// throughput received by each gateway and Jain's fairness index over the
+// gateways are printed.
+//
+// The gateways sit in the first row of the grid, so with plain rank-based
+// DODAG selection most nodes crowd the closest gateways. Compare:
+//
+// ./waf --run "rpl-multi-gateway --loadBalancing=0"
+// ./waf --run "rpl-multi-gateway --loadBalancing=1"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplMultiGateway");
+
+static const uint16_t SINK_PORT = 9;
+
+static void SendToGateway (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                           Time interval, Time stop)
+{
+  Ipv6Address gateway = rpl->GetDodagId ();
+  if (gateway != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (gateway, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToGateway, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t gridWidth = 6;
+  uint32_t gridHeight = 4;
+  uint32_t numGateways = 3;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  double interval = 1.0;
+  double simTime = 120;
+  bool loadBalancing = true;
+  double rootCapacity = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("gridWidth", "nodes per grid row", gridWidth);
+  cmd.AddValue ("gridHeight", "number of grid rows", gridHeight);
+  cmd.AddValue ("numGateways", "number of gateways (DODAG roots) in the first row", numGateways);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a node", interval);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("loadBalancing", "balance nodes across gateways by root load", loadBalancing);
+  cmd.AddValue ("rootCapacity", "packets per second a gateway takes at full load", rootCapacity);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (numGateways == 0 || numGateways > gridWidth, "numGateways must be between 1 and gridWidth");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::LoadBalancing", BooleanValue (loadBalancing));
+  Config::SetDefault ("ns3::Rpl::RootCapacity", DoubleValue (rootCapacity));
+
+  NodeContainer c;
+  c.Create (gridWidth * gridHeight);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (gridWidth),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  // gateways spread over the first row
+  NodeContainer gateways;
+  for (uint32_t g = 0; g < numGateways; g++)
+    {
+      gateways.Add (c.Get (g * gridWidth / numGateways));
+    }
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (gateways);
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (gateways);
+  sinks.Start (Seconds (0.0));
+
+  // traffic starts once the DODAGs had time to form
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      if (rpl->IsRoot ())
+        {
+          continue;
+        }
+      Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
+      Simulator::ScheduleWithContext (c.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval)),
+                                      &SendToGateway, source, rpl, packetSize, Seconds (interval), stop);
+    }
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  double sum = 0;
+  double sumSquares = 0;
+  double duration = (stop - start).GetSeconds ();
+  for (uint32_t g = 0; g < sinks.GetN (); g++)
+    {
+      Ptr<PacketSink> gatewaySink = DynamicCast<PacketSink> (sinks.Get (g));
+      double throughput = gatewaySink->GetTotalRx () * 8.0 / duration / 1000.0;
+      sum += throughput;
+      sumSquares += throughput * throughput;
+      std::cout << "Gateway " << g << " (node " << gateways.Get (g)->GetId () << "): "
+                << throughput << " kbit/s" << std::endl;
+    }
+
+  double fairness = (sumSquares > 0) ? (sum * sum) / (sinks.GetN () * sumSquares) : 0;
+  std::cout << "Aggregate throughput: " << sum << " kbit/s" << std::endl;
+  std::cout << "Jain's fairness index: " << fairness << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,239 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Firmware update style one-to-many traffic. A grid of 802.11b adhoc nodes
+// forms a storing mode DODAG rooted in the corner; some of the nodes
+// subscribe to a multicast group, and the root sends a burst of packets to
+// the group, as an image pushed to a class of devices.
+//
+// The same scenario is run with the packets flooded, every router passing
+// each packet on once, and in storing mode with multicast (MOP 3), where
+// the subscriptions travel up in DAOs and a packet is only forwarded into
+// the sub-DODAGs with subscribers. For each run the transmissions per
+// packet and the delivery to the subscribers are printed, along with the
+// transmissions saved:
+//
+// ./waf --run "rpl-multicast"
+// ./waf --run "rpl-multicast --size=8 --subscriberShare=0.1"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplMulticast");
+
+static const uint16_t GROUP_PORT = 5683;
+
+// transmissions and delivery of the packets sent to the group in a run
+struct MulticastStats
+{
+  uint32_t sent;
+  uint32_t transmissions;
+  uint32_t delivered;
+  uint32_t subscribers;
+};
+
+static MulticastStats g_stats;
+
+static void MulticastTx (Ptr<const Packet> packet, Ipv6Address group, Ipv6Address nextHop)
+{
+  g_stats.transmissions++;
+}
+
+static void Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      g_stats.delivered++;
+    }
+}
+
+static void SendToGroup (Ptr<Socket> socket, Ipv6Address group, uint32_t packetSize, Time interval, uint32_t count)
+{
+  g_stats.sent++;
+  socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (group, GROUP_PORT));
+
+  if (count > 1)
+    {
+      Simulator::Schedule (interval, &SendToGroup, socket, group, packetSize, interval, count - 1);
+    }
+}
+
+// Run the scenario once and return the transmissions and delivery
+static MulticastStats RunScenario (bool multicast, uint32_t size, double spacing, double range,
+                                   double subscriberShare, uint32_t packetSize, uint32_t packets,
+                                   double interval, double start, std::string phyMode)
+{
+  Config::SetDefault ("ns3::Rpl::Multicast", BooleanValue (multicast));
+  Ipv6Address group ("ff05::fb");
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  g_stats.sent = 0;
+  g_stats.transmissions = 0;
+  g_stats.delivered = 0;
+  g_stats.subscribers = 0;
+
+  // both runs pick the same subscribers
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable> ();
+  pick->SetStream (1);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("MulticastTx", MakeCallback (&MulticastTx));
+      if (i == 0 || pick->GetValue () >= subscriberShare)
+        {
+          continue;
+        }
+
+      g_stats.subscribers++;
+      rpl->JoinGroup (group);
+      Ptr<Socket> sink = Socket::CreateSocket (c.Get (i), tid);
+      sink->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), GROUP_PORT));
+      sink->Ipv6JoinGroup (group);
+      sink->SetRecvCallback (MakeCallback (&Receive));
+    }
+
+  Ptr<Socket> source = Socket::CreateSocket (c.Get (0), tid);
+  Simulator::ScheduleWithContext (c.Get (0)->GetId (), Seconds (start), &SendToGroup, source, group, packetSize,
+                                  Seconds (interval), packets);
+
+  Simulator::Stop (Seconds (start + interval * packets + 5));
+  Simulator::Run ();
+
+  MulticastStats stats = g_stats;
+  Simulator::Destroy ();
+  return stats;
+}
+
+static void PrintStats (std::string mode, const MulticastStats &stats)
+{
+  std::cout << mode << "\t" << stats.transmissions << "\t\t";
+  if (stats.sent)
+    {
+      std::cout << (double)stats.transmissions / stats.sent;
+    }
+  else
+    {
+      std::cout << "-";
+    }
+  std::cout << "\t\t" << stats.delivered << "/" << stats.sent * stats.subscribers << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 6;
+  double spacing = 40;
+  double range = 50;
+  double subscriberShare = 0.2;
+  uint32_t packetSize = 256;
+  uint32_t packets = 100;
+  double interval = 0.1;
+  double start = 60;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("subscriberShare", "share of the nodes subscribed to the group", subscriberShare);
+  cmd.AddValue ("packetSize", "size of the image blocks", packetSize);
+  cmd.AddValue ("packets", "number of image blocks sent by the root", packets);
+  cmd.AddValue ("interval", "interval (seconds) between two blocks", interval);
+  cmd.AddValue ("start", "time (seconds) the DODAG and the subscriptions are given to form", start);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (subscriberShare < 0 || subscriberShare > 1, "the subscriber share is within [0, 1]");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::DownwardRoutes", BooleanValue (true));
+
+  MulticastStats flooding = RunScenario (false, size, spacing, range, subscriberShare, packetSize, packets,
+                                         interval, start, phyMode);
+  MulticastStats storing = RunScenario (true, size, spacing, range, subscriberShare, packetSize, packets,
+                                        interval, start, phyMode);
+
+  std::cout << storing.subscribers << " subscribers out of " << size * size - 1 << " nodes" << std::endl;
+  std::cout << "mode\ttransmissions\tper packet\tdelivered" << std::endl;
+  PrintStats ("flood", flooding);
+  PrintStats ("mop3", storing);
+  if (flooding.transmissions)
+    {
+      std::cout << "transmissions saved: " << (int32_t)(flooding.transmissions - storing.transmissions) << " ("
+                << 100.0 * ((double)flooding.transmissions - storing.transmissions) / flooding.transmissions
+                << "%)" << std::endl;
+    }
+
+  return 0;
+}
@@ -0,0 +1,206 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Upward traffic over 802.11b adhoc nodes towards a single DODAG root in
+// the corner of the topology. Every other node runs several UDP flows to
+// the root. At the end the load of each upward link (packets handed from
+// a node to one of its parents), its variance, the busiest link and the
+// throughput received by the root are printed.
+//
+// Two topologies are available: "grid", where most nodes have two parents
+// of equal rank, and "line", a two-node-wide line in which every node past
+// the first hop has an equal-rank parent in each row. Compare:
+//
+// ./waf --run "rpl-multipath --topology=grid --multipath=0"
+// ./waf --run "rpl-multipath --topology=grid --multipath=1"
+// ./waf --run "rpl-multipath --topology=line --multipath=1"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplMultipath");
+
+static const uint16_t SINK_PORT = 9;
+
+// packets per (node, next hop) upward link
+static std::map<std::pair<uint32_t, Ipv6Address>, uint32_t> g_linkLoad;
+
+static void UpwardPacket (uint32_t node, Ptr<const Packet> packet, Ipv6Address nextHop)
+{
+  g_linkLoad[std::make_pair (node, nextHop)]++;
+}
+
+static void SendToRoot (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                        Time interval, Time stop)
+{
+  Ipv6Address root = rpl->GetDodagId ();
+  if (root != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (root, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToRoot, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  std::string topology ("grid");
+  uint32_t size = 5;
+  uint32_t flowsPerNode = 4;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  double interval = 2.0;
+  double simTime = 120;
+  bool multipath = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("topology", "grid or line", topology);
+  cmd.AddValue ("size", "grid width and height, or line length", size);
+  cmd.AddValue ("flowsPerNode", "UDP flows (source ports) per node", flowsPerNode);
+  cmd.AddValue ("spacing", "distance between neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a flow", interval);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("multipath", "spread flows over equal-rank parents", multipath);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (topology != "grid" && topology != "line", "topology must be grid or line");
+  uint32_t gridWidth = (topology == "grid") ? size : 2;
+  uint32_t gridHeight = size;
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::Multipath", BooleanValue (multipath));
+
+  NodeContainer c;
+  c.Create (gridWidth * gridHeight);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (gridWidth),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (c.Get (0));
+  sinks.Start (Seconds (0.0));
+
+  // traffic starts once the DODAG had time to form; each flow has its own source port
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("Upward", MakeBoundCallback (&UpwardPacket, i));
+      for (uint32_t f = 0; f < flowsPerNode; f++)
+        {
+          Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
+          source->Bind6 ();
+          Simulator::ScheduleWithContext (c.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval)),
+                                          &SendToRoot, source, rpl, packetSize, Seconds (interval), stop);
+        }
+    }
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  double sum = 0;
+  double sumSquares = 0;
+  uint32_t peak = 0;
+  for (std::map<std::pair<uint32_t, Ipv6Address>, uint32_t>::const_iterator it = g_linkLoad.begin ();
+       it != g_linkLoad.end (); it++)
+    {
+      sum += it->second;
+      sumSquares += double (it->second) * it->second;
+      peak = std::max (peak, it->second);
+    }
+
+  uint32_t links = g_linkLoad.size ();
+  double mean = links ? sum / links : 0;
+  double variance = links ? sumSquares / links - mean * mean : 0;
+  double duration = (stop - start).GetSeconds ();
+  Ptr<PacketSink> rootSink = DynamicCast<PacketSink> (sinks.Get (0));
+
+  std::cout << "Topology: " << topology << ", multipath " << (multipath ? "on" : "off") << std::endl;
+  std::cout << "Upward links used: " << links << std::endl;
+  std::cout << "Mean link load: " << mean << " packets" << std::endl;
+  std::cout << "Link load variance: " << variance << std::endl;
+  std::cout << "Busiest link: " << peak << " packets" << std::endl;
+  std::cout << "Root throughput: " << rootSink->GetTotalRx () * 8.0 / duration / 1000.0 << " kbit/s" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
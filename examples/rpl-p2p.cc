@@ -0,0 +1,259 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Path stretch of root-routed delivery against P2P route discovery. A grid
+// of 802.11b adhoc nodes forms a storing mode DODAG rooted in the corner.
+// Pairs of nodes two hops apart, in the rows far from the root, exchange
+// UDP packets: first along the DODAG routes, up to a common ancestor and
+// back down, then along the hop-by-hop routes found by Rpl::DiscoverRoute.
+//
+// The hops of a packet are read from the hop limit it arrives with. For
+// both phases the packets delivered, the mean hops and the mean latency are
+// printed, along with the path stretch of root-routed delivery and the
+// routes found by the discoveries:
+//
+// ./waf --run "rpl-p2p"
+// ./waf --run "rpl-p2p --size=8 --nPairs=5"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplP2p");
+
+static const uint16_t SINK_PORT = 9;
+static const uint8_t SEND_HOP_LIMIT = 64;
+
+// delivery of the packets sent in a phase
+struct PhaseStats
+{
+  uint32_t sent;
+  uint32_t delivered;
+  uint32_t hops;
+  Time latency;
+};
+
+static PhaseStats g_phases[2];
+static uint32_t g_phase = 0;
+static std::map<uint64_t, std::pair<uint32_t, Time> > g_sendTimes;
+
+static uint32_t g_routes = 0;
+static uint32_t g_routeHops = 0;
+static Time g_discoveryLatency;
+
+static void P2pRoute (Ipv6Address target, uint32_t hops, Time latency)
+{
+  g_routes++;
+  g_routeHops += hops;
+  g_discoveryLatency += latency;
+}
+
+static void Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      std::map<uint64_t, std::pair<uint32_t, Time> >::iterator it = g_sendTimes.find (packet->GetUid ());
+      SocketIpv6HopLimitTag hopLimit;
+      if (it == g_sendTimes.end () || !packet->RemovePacketTag (hopLimit))
+        {
+          continue;
+        }
+      // each router on the way decremented the hop limit once
+      PhaseStats &phase = g_phases[it->second.first];
+      phase.delivered++;
+      phase.hops += SEND_HOP_LIMIT - hopLimit.GetHopLimit () + 1;
+      phase.latency += Simulator::Now () - it->second.second;
+      g_sendTimes.erase (it);
+    }
+}
+
+static void Send (Ptr<Socket> socket, Ipv6Address target, uint32_t packetSize, Time interval, uint32_t count)
+{
+  Ptr<Packet> packet = Create<Packet> (packetSize);
+  g_sendTimes[packet->GetUid ()] = std::make_pair (g_phase, Simulator::Now ());
+  g_phases[g_phase].sent++;
+  socket->SendTo (packet, 0, Inet6SocketAddress (target, SINK_PORT));
+
+  if (count > 1)
+    {
+      Simulator::Schedule (interval, &Send, socket, target, packetSize, interval, count - 1);
+    }
+}
+
+static void StartPhase (uint32_t phase)
+{
+  g_phase = phase;
+}
+
+static void PrintPhase (std::string mode, const PhaseStats &phase)
+{
+  std::cout << mode << "\t" << phase.delivered << "/" << phase.sent << "\t";
+  if (phase.delivered)
+    {
+      std::cout << (double)phase.hops / phase.delivered << "\t\t"
+                << phase.latency.GetSeconds () * 1000 / phase.delivered;
+    }
+  else
+    {
+      std::cout << "-\t\t-";
+    }
+  std::cout << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 6;
+  uint32_t nPairs = 3;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  uint32_t packets = 50;
+  double interval = 0.2;
+  double start = 60;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("nPairs", "number of node pairs, one per row from the far side", nPairs);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("packets", "packets sent by each pair in each phase", packets);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a pair", interval);
+  cmd.AddValue ("start", "time (seconds) the DODAG is given to form", start);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (size < 3, "the grid needs three nodes per side at least");
+  NS_ABORT_MSG_IF (nPairs == 0 || nPairs > size - 1, "one pair per row, the root row excluded");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::DownwardRoutes", BooleanValue (true));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  // the pairs sit at the far end of a row, two hops apart
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Time interPacket = Seconds (interval);
+  Time phaseLength = interPacket * packets + Seconds (5);
+  Time discovery = Seconds (start) + phaseLength;
+  for (uint32_t i = 0; i < nPairs; i++)
+    {
+      uint32_t row = size - 1 - i;
+      Ptr<Node> source = c.Get (row * size + size - 3);
+      Ptr<Node> target = c.Get (row * size + size - 1);
+      Ipv6Address targetAddress = interfaces.GetAddress (row * size + size - 1, 1);
+
+      Ptr<Socket> sink = Socket::CreateSocket (target, tid);
+      sink->Bind (Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+      sink->SetIpv6RecvHopLimit (true);
+      sink->SetRecvCallback (MakeCallback (&Receive));
+
+      Ptr<Socket> socket = Socket::CreateSocket (source, tid);
+      socket->SetIpv6HopLimit (SEND_HOP_LIMIT);
+
+      Ptr<Rpl> rpl = source->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("P2pRoute", MakeCallback (&P2pRoute));
+
+      Simulator::ScheduleWithContext (source->GetId (), Seconds (start), &Send, socket, targetAddress,
+                                      packetSize, interPacket, packets);
+      Simulator::ScheduleWithContext (source->GetId (), discovery, &Rpl::DiscoverRoute, rpl, targetAddress);
+      Simulator::ScheduleWithContext (source->GetId (), discovery + Seconds (5), &Send, socket, targetAddress,
+                                      packetSize, interPacket, packets);
+    }
+  Simulator::Schedule (discovery, &StartPhase, 1);
+
+  Simulator::Stop (discovery + Seconds (5) + phaseLength);
+  Simulator::Run ();
+
+  std::cout << "mode\tdelivered\tmean hops\tmean latency (ms)" << std::endl;
+  PrintPhase ("root", g_phases[0]);
+  PrintPhase ("p2p", g_phases[1]);
+  if (g_phases[0].delivered && g_phases[1].delivered)
+    {
+      double rootHops = (double)g_phases[0].hops / g_phases[0].delivered;
+      double p2pHops = (double)g_phases[1].hops / g_phases[1].delivered;
+      std::cout << "path stretch of root-routed delivery: " << rootHops / p2pHops << std::endl;
+    }
+  std::cout << "routes found: " << g_routes << "/" << nPairs;
+  if (g_routes)
+    {
+      std::cout << ", mean " << (double)g_routeHops / g_routes << " hops, mean discovery latency "
+                << g_discoveryLatency.GetSeconds () * 1000 / g_routes << " ms";
+    }
+  std::cout << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,223 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Per-flow RPL path statistics joined with FlowMonitor. A grid of 802.11b
+// adhoc nodes sends UDP flows to the DODAG root in a corner. Every node
+// records the packets it forwards in a ring buffer of PathStatsSize
+// entries; at the end the records are joined with the FlowMonitor
+// statistics, one CSV line per flow: FlowMonitor counters and delay, then
+// hop count, distinct paths, parent switches along the way and the path
+// and ranks of the last packet.
+//
+// ./waf --run "rpl-path-stats --size=4 --output=path-stats.csv"
+// ./waf --run "rpl-path-stats --pathStatsSize=0"
+//
+// With a PathStatsSize of 0 nothing is recorded, and only the FlowMonitor
+// columns are filled.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplPathStats");
+
+static const uint16_t SINK_PORT = 9;
+
+// Join the RPL path statistics with the FlowMonitor statistics, one CSV
+// line per flow of the monitor
+static void WritePathStats (Ptr<FlowMonitor> monitor, Ptr<Ipv6FlowClassifier> classifier, std::ostream &os)
+{
+  std::map<uint32_t, RplFlowPaths> flows = RplHelper::GetFlowPaths ();
+
+  os << "flow,source,destination,protocol,source_port,destination_port,tx_packets,rx_packets,lost_packets,"
+     << "mean_delay,traced_packets,mean_hops,paths,parent_switches,last_path,last_ranks\n";
+  FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
+  for (FlowMonitor::FlowStatsContainer::const_iterator flow = stats.begin (); flow != stats.end (); flow++)
+    {
+      Ipv6FlowClassifier::FiveTuple tuple = classifier->FindFlow (flow->first);
+      const FlowMonitor::FlowStats &counters = flow->second;
+      os << flow->first << "," << tuple.sourceAddress << "," << tuple.destinationAddress << ","
+         << (uint32_t)tuple.protocol << "," << tuple.sourcePort << "," << tuple.destinationPort << ","
+         << counters.txPackets << "," << counters.rxPackets << "," << counters.lostPackets << ","
+         << (counters.rxPackets ? counters.delaySum.GetSeconds () / counters.rxPackets : 0) << ",";
+
+      std::map<uint32_t, RplFlowPaths>::const_iterator paths =
+        flows.find (RplPathStats::FlowKey (tuple.sourceAddress, tuple.destinationAddress, tuple.protocol,
+                                           tuple.sourcePort, tuple.destinationPort));
+      if (paths == flows.end ())
+        {
+          os << "0,0,0,0,,\n";
+          continue;
+        }
+      os << paths->second.packets << "," << paths->second.meanHops << "," << paths->second.paths << ","
+         << paths->second.parentSwitches << ",";
+      for (uint32_t n = 0; n < paths->second.lastPath.size (); n++)
+        {
+          os << (n ? " " : "") << paths->second.lastPath[n];
+        }
+      os << ",";
+      for (uint32_t n = 0; n < paths->second.lastRanks.size (); n++)
+        {
+          os << (n ? " " : "") << paths->second.lastRanks[n];
+        }
+      os << "\n";
+    }
+}
+
+static void SendToRoot (Ptr<Socket> socket, Ptr<Rpl> rpl, uint32_t packetSize,
+                        Time interval, Time stop)
+{
+  Ipv6Address root = rpl->GetDodagId ();
+  if (root != Ipv6Address::GetZero ())
+    {
+      socket->SendTo (Create<Packet> (packetSize), 0, Inet6SocketAddress (root, SINK_PORT));
+    }
+
+  if (Simulator::Now () + interval < stop)
+    {
+      Simulator::Schedule (interval, &SendToRoot, socket, rpl, packetSize, interval, stop);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 4;
+  double spacing = 40;
+  double range = 50;
+  uint32_t packetSize = 64;
+  double interval = 1.0;
+  double simTime = 60;
+  uint32_t pathStatsSize = 1024;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("packetSize", "size of application packets", packetSize);
+  cmd.AddValue ("interval", "interval (seconds) between packets of a flow", interval);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("pathStatsSize", "forwarded packets recorded per node, 0 to record none", pathStatsSize);
+  cmd.AddValue ("output", "CSV file, standard output if empty", output);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::PathStatsSize", UintegerValue (pathStatsSize));
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", Inet6SocketAddress (Ipv6Address::GetAny (), SINK_PORT));
+  ApplicationContainer sinks = sink.Install (c.Get (0));
+  sinks.Start (Seconds (0.0));
+
+  // one flow per node, once the DODAG had time to form
+  Time start = Seconds (10.0);
+  Time stop = Seconds (simTime);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      Ptr<Socket> source = Socket::CreateSocket (c.Get (i), tid);
+      source->Bind6 ();
+      Simulator::ScheduleWithContext (c.Get (i)->GetId (), start + Seconds (jitter->GetValue (0, interval)),
+                                      &SendToRoot, source, c.Get (i)->GetObject<Rpl> (), packetSize,
+                                      Seconds (interval), stop);
+    }
+
+  FlowMonitorHelper flowmon;
+  Ptr<FlowMonitor> monitor = flowmon.InstallAll ();
+
+  Simulator::Stop (stop + Seconds (1.0));
+  Simulator::Run ();
+
+  monitor->CheckForLostPackets ();
+  Ptr<Ipv6FlowClassifier> classifier = DynamicCast<Ipv6FlowClassifier> (flowmon.GetClassifier6 ());
+  if (output.empty ())
+    {
+      WritePathStats (monitor, classifier, std::cout);
+    }
+  else
+    {
+      std::ofstream file (output.c_str ());
+      NS_ABORT_MSG_IF (!file, "Cannot open " << output);
+      WritePathStats (monitor, classifier, file);
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
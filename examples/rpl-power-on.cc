@@ -0,0 +1,217 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Mass power-on: a grid of 802.11b adhoc nodes, all switched on at the
+// same time, joins a DODAG rooted in the corner. Every joining node
+// solicits DIOs, so routers face bursts of DISs. At the end the time
+// until 95% of the nodes had joined is printed, with the DISs received,
+// those answered at once and those coalesced into a single multicast DIO,
+// and the DIOs and DISs sent. Compare no limit with rate-limited DIS
+// responses, and DISs sent every second with randomized, backed-off DISs:
+//
+// ./waf --run "rpl-power-on --disResponseRate=0"
+// ./waf --run "rpl-power-on --disResponseRate=1 --disResponseBurst=3"
+// ./waf --run "rpl-power-on --disBackoff=0"
+// ./waf --run "rpl-power-on --disBackoff=1 --size=15"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplPowerOn");
+
+static const double JOINED_RATIO = 0.95;
+static const double CHECK_INTERVAL = 0.05;
+
+static Time g_joinedTime;
+static uint32_t g_disReceived = 0;
+static uint32_t g_disAnswered = 0;
+static uint32_t g_sent[3] = { 0, 0, 0 };
+
+static void DisReceived (Ipv6Address sender, bool multicast, bool answered)
+{
+  g_disReceived++;
+  if (answered)
+    {
+      g_disAnswered++;
+    }
+}
+
+static void ControlTx (Ptr<const Packet> packet, uint8_t code)
+{
+  if (code < 3)
+    {
+      g_sent[code]++;
+    }
+}
+
+// record when enough nodes have joined
+static void CheckJoined (NodeContainer c)
+{
+  uint32_t joined = 0;
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      if (c.Get (i)->GetObject<Rpl> ()->GetRank () != 0)
+        {
+          joined++;
+        }
+    }
+
+  if (joined >= JOINED_RATIO * (c.GetN () - 1))
+    {
+      g_joinedTime = Simulator::Now ();
+      return;
+    }
+  Simulator::Schedule (Seconds (CHECK_INTERVAL), &CheckJoined, c);
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 7;
+  double spacing = 40;
+  double range = 50;
+  double simTime = 60;
+  double disResponseRate = 1;
+  uint32_t disResponseBurst = 3;
+  bool disBackoff = true;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "grid width and height", size);
+  cmd.AddValue ("spacing", "distance between grid neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("disResponseRate", "DIS responses per second and interface, 0 for no limit", disResponseRate);
+  cmd.AddValue ("disResponseBurst", "DIS responses in a burst", disResponseBurst);
+  cmd.AddValue ("disBackoff", "random first DIS and exponential backoff, instead of a DIS every second", disBackoff);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::DisResponseRate", DoubleValue (disResponseRate));
+  Config::SetDefault ("ns3::Rpl::DisResponseBurst", UintegerValue (disResponseBurst));
+  if (!disBackoff)
+    {
+      Config::SetDefault ("ns3::Rpl::DisStartDelay", TimeValue (Seconds (0)));
+      Config::SetDefault ("ns3::Rpl::DisMaxInterval", TimeValue (Seconds (1)));
+    }
+
+  NodeContainer c;
+  c.Create (size * size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("DisRx", MakeCallback (&DisReceived));
+      rpl->TraceConnectWithoutContext ("ControlTx", MakeCallback (&ControlTx));
+    }
+
+  Simulator::Schedule (Seconds (CHECK_INTERVAL), &CheckJoined, c);
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  uint32_t joined = 0;
+  for (uint32_t i = 1; i < c.GetN (); i++)
+    {
+      if (c.Get (i)->GetObject<Rpl> ()->GetRank () != 0)
+        {
+          joined++;
+        }
+    }
+
+  std::cout << c.GetN () << " nodes, DIS responses ";
+  if (disResponseRate > 0)
+    {
+      std::cout << "limited to " << disResponseRate << "/s, bursts of " << disResponseBurst << std::endl;
+    }
+  else
+    {
+      std::cout << "not limited" << std::endl;
+    }
+  std::cout << "DIS backoff " << (disBackoff ? "on" : "off") << std::endl;
+  std::cout << "Joined: " << joined << " of " << c.GetN () - 1 << " nodes" << std::endl;
+  if (g_joinedTime.IsZero ())
+    {
+      std::cout << "Less than " << JOINED_RATIO * 100 << "% of the nodes joined" << std::endl;
+    }
+  else
+    {
+      std::cout << JOINED_RATIO * 100 << "% joined after " << g_joinedTime.GetSeconds () << " s" << std::endl;
+    }
+  std::cout << "DIS received: " << g_disReceived << ", answered at once: " << g_disAnswered
+            << ", ignored or coalesced: " << g_disReceived - g_disAnswered << std::endl;
+  std::cout << "Sent: " << g_sent[0] << " DISs, " << g_sent[1] << " DIOs, " << g_sent[2] << " DAOs, "
+            << g_sent[0] + g_sent[1] + g_sent[2] << " control messages in total" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,212 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// A line of 802.11b adhoc nodes with the DODAG root at one end, repaired
+// twice. First the root starts a global repair: every node joins the new
+// DODAG version. Then a node in the middle of the line is moved out of
+// range: the next node loses its only parent, detaches and poisons the
+// rest of the line, which either waits for a parent or, with floating
+// DODAGs, stays connected under the detached node.
+//
+// For each repair the time until the last node was attached again and the
+// control messages sent meanwhile are printed, so that the repair period
+// can be weighed against its overhead:
+//
+// ./waf --run "rpl-repair --floating=0"
+// ./waf --run "rpl-repair --floating=1 --size=20"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rpl-module.h"
+#include "rpl-wifi-hooks.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RplRepair");
+
+// one repair: when it started and when the last node was attached again
+struct RepairStats
+{
+  bool started;
+  Time start;
+  Time converged;
+  uint32_t repaired;
+};
+
+static RepairStats g_repairs[2];
+
+// time and ICMPv6 code of every control message sent
+static std::vector<std::pair<Time, uint8_t> > g_controlTx;
+
+static void RepairStart (bool global, uint8_t version)
+{
+  RepairStats &stats = g_repairs[global];
+  if (!stats.started)
+    {
+      stats.started = true;
+      stats.start = Simulator::Now ();
+      stats.converged = Simulator::Now ();
+    }
+}
+
+static void Repaired (bool global, uint8_t version)
+{
+  RepairStats &stats = g_repairs[global];
+  stats.repaired++;
+  stats.converged = Simulator::Now ();
+}
+
+static void ControlTx (Ptr<const Packet> packet, uint8_t code)
+{
+  g_controlTx.push_back (std::make_pair (Simulator::Now (), code));
+}
+
+static void MoveAway (Ptr<Node> node)
+{
+  node->GetObject<MobilityModel> ()->SetPosition (Vector (0.0, 10000.0, 0.0));
+}
+
+static void PrintRepair (std::string name, const RepairStats &stats)
+{
+  std::cout << name << ": ";
+  if (!stats.started)
+    {
+      std::cout << "not started" << std::endl;
+      return;
+    }
+
+  // the control burst is what was sent until the last node was attached again
+  uint32_t messages[3] = { 0, 0, 0 };
+  for (uint32_t i = 0; i < g_controlTx.size (); i++)
+    {
+      if (g_controlTx[i].first >= stats.start && g_controlTx[i].first <= stats.converged &&
+          g_controlTx[i].second < 3)
+        {
+          messages[g_controlTx[i].second]++;
+        }
+    }
+  std::cout << stats.repaired << " nodes attached again in "
+            << (stats.converged - stats.start).GetSeconds () << " s, with "
+            << messages[1] << " DIOs, " << messages[0] << " DISs and "
+            << messages[2] << " DAOs sent meanwhile" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string phyMode ("DsssRate1Mbps");
+  uint32_t size = 10;
+  double spacing = 40;
+  double range = 50;
+  double globalRepairTime = 30;
+  double failTime = 60;
+  double simTime = 120;
+  bool floating = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("phyMode", "Wifi Phy mode", phyMode);
+  cmd.AddValue ("size", "number of nodes in the line", size);
+  cmd.AddValue ("spacing", "distance between neighbors (m)", spacing);
+  cmd.AddValue ("range", "radio range (m)", range);
+  cmd.AddValue ("globalRepairTime", "time (seconds) the root starts a global repair", globalRepairTime);
+  cmd.AddValue ("failTime", "time (seconds) the middle node leaves", failTime);
+  cmd.AddValue ("simTime", "simulation time (seconds)", simTime);
+  cmd.AddValue ("floating", "form a floating DODAG after detaching", floating);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (size < 3, "the line needs at least 3 nodes");
+  NS_ABORT_MSG_IF (failTime <= globalRepairTime, "the node must leave after the global repair");
+
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::Rpl::FloatingDodag", BooleanValue (floating));
+
+  NodeContainer c;
+  c.Create (size);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (range));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, c);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (spacing),
+                                 "DeltaY", DoubleValue (spacing),
+                                 "GridWidth", UintegerValue (size),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (c);
+
+  RplHelper RplRouting;
+  RplRouting.SetRoot (c.Get (0));
+  InternetStackHelper internetv6routers;
+  internetv6routers.SetIpv4StackInstall (false);
+  internetv6routers.SetRoutingHelper (RplRouting);
+  internetv6routers.Install (c);
+  ConnectRplWifiHooks (devices);
+
+  Ipv6AddressHelper ipv6;
+  ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+  Ipv6InterfaceContainer interfaces = ipv6.Assign (devices);
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      interfaces.SetForwarding (i, true);
+    }
+
+  for (uint32_t i = 0; i < c.GetN (); i++)
+    {
+      Ptr<Rpl> rpl = c.Get (i)->GetObject<Rpl> ();
+      rpl->TraceConnectWithoutContext ("RepairStart", MakeCallback (&RepairStart));
+      rpl->TraceConnectWithoutContext ("Repaired", MakeCallback (&Repaired));
+      rpl->TraceConnectWithoutContext ("ControlTx", MakeCallback (&ControlTx));
+    }
+
+  Simulator::ScheduleWithContext (c.Get (0)->GetId (), Seconds (globalRepairTime),
+                                  &Rpl::GlobalRepair, c.Get (0)->GetObject<Rpl> ());
+  Simulator::Schedule (Seconds (failTime), &MoveAway, c.Get (size / 2));
+
+  Simulator::Stop (Seconds (simTime));
+  Simulator::Run ();
+
+  std::cout << c.GetN () << " nodes in a line, floating DODAGs " << (floating ? "on" : "off") << std::endl;
+  PrintRepair ("Global repair", g_repairs[true]);
+  PrintRepair ("Local repair", g_repairs[false]);
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RPL_WIFI_HOOKS_H
+#define RPL_WIFI_HOOKS_H
+
+//
+// Wi-Fi glue shared by the RPL examples. The RPL model does not depend on
+// any device; its link hooks are fed here from the traces of the Wi-Fi
+// devices, so that ETX and neighbor unreachability follow the unicast
+// outcomes reported by the MAC, and the mobility mode the RSSI of the
+// frames heard by the PHY.
+//
+
+#include "ns3/net-device-container.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/wifi-remote-station-manager.h"
+#include "ns3/boolean.h"
+#include "ns3/rpl.h"
+
+namespace ns3 {
+
+static void RplWifiTxRetry (Ptr<Rpl> rpl, Mac48Address address)
+{
+  rpl->NotifyTxRetry (address);
+}
+
+static void RplWifiTxFailed (Ptr<Rpl> rpl, Mac48Address address)
+{
+  rpl->NotifyTxResult (address, false);
+}
+
+static void RplWifiTxOk (Ptr<Rpl> rpl, const WifiMacHeader &header)
+{
+  // only unicast data frames are acknowledged
+  if (header.IsData () && !header.GetAddr1 ().IsGroup ())
+    {
+      rpl->NotifyTxResult (header.GetAddr1 (), true);
+    }
+}
+
+static void RplWifiMonitorRx (Ptr<Rpl> rpl, Ptr<const Packet> packet, uint16_t channelFreqMhz,
+                              WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise)
+{
+  WifiMacHeader header;
+  if (packet->PeekHeader (header) != 0 && header.IsData ())
+    {
+      rpl->NotifyRssi (header.GetAddr2 (), signalNoise.signal);
+    }
+}
+
+// Connect the Wi-Fi devices to the RPL instance of their node, once the
+// internet stack is installed
+static void ConnectRplWifiHooks (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator it = devices.Begin (); it != devices.End (); it++)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*it);
+      Ptr<Rpl> rpl = (*it)->GetNode ()->GetObject<Rpl> ();
+      if (!device || !rpl)
+        {
+          continue;
+        }
+      Ptr<WifiRemoteStationManager> manager = device->GetRemoteStationManager ();
+      manager->TraceConnectWithoutContext ("MacTxDataFailed", MakeBoundCallback (&RplWifiTxRetry, rpl));
+      manager->TraceConnectWithoutContext ("MacTxFinalDataFailed", MakeBoundCallback (&RplWifiTxFailed, rpl));
+      device->GetMac ()->TraceConnectWithoutContext ("TxOkHeader", MakeBoundCallback (&RplWifiTxOk, rpl));
+
+      // every frame heard is parsed, only when the RSSI is of use
+      BooleanValue mobilityMode;
+      rpl->GetAttribute ("MobilityMode", mobilityMode);
+      if (mobilityMode.Get ())
+        {
+          device->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferRx", MakeBoundCallback (&RplWifiMonitorRx, rpl));
+        }
+    }
+}
+
+}
+
+#endif /* RPL_WIFI_HOOKS_H */
@@ -3,9 +3,23 @@
 #include "ns3/node.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv6-list-routing.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 #include "ns3/rpl.h"
 #include "rpl-helper.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+/* Routing table dump */
+#define DUMP_MAGIC 0x52504c44
+#define DUMP_VERSION 1
+#define DUMP_HEADER_SIZE 17
+#define DUMP_NODE_SIZE 6
+
 namespace ns3 {
 
 RplHelper::RplHelper ()
@@ -69,10 +83,356 @@ RplHelper::AssignStreams (NodeContainer c, int64_t stream)
   return (currentStream - stream);
 }
 
+void
+RplHelper::SetRoot (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      m_roots[(*i)->GetId ()] = Ipv6Address::GetZero ();
+    }
+}
+
+void
+RplHelper::SetRoot (Ptr<Node> node, Ipv6Address dodagId)
+{
+  m_roots[node->GetId ()] = dodagId;
+}
+
+void
+RplHelper::SetInterfaceCost (Ptr<Node> node, uint32_t interface, uint16_t cost)
+{
+  m_interfaceCosts[node->GetId ()][interface] = cost;
+}
+
+void
+RplHelper::SetLeaf (NodeContainer c)
+{
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      m_leaves.insert ((*i)->GetId ());
+    }
+}
+
+void
+RplHelper::ExportDodagEvery (Time printInterval, std::string filename)
+{
+  bool dot = filename.size () >= 4 && filename.compare (filename.size () - 4, 4, ".dot") == 0;
+  Ptr<OutputStreamWrapper> stream = ns3::Create<OutputStreamWrapper> (filename, std::ios::out);
+  Simulator::Schedule (printInterval, &RplHelper::ExportDodagPeriodically, printInterval, stream, dot);
+}
+
+void
+RplHelper::ExportDodagPeriodically (Time printInterval, Ptr<OutputStreamWrapper> stream, bool dot)
+{
+  ExportDodag (stream, dot);
+  Simulator::Schedule (printInterval, &RplHelper::ExportDodagPeriodically, printInterval, stream, dot);
+}
+
+// write the node ID owning an address, or the address itself, as a JSON value or a DOT node
+static void
+WriteNode (std::ostream &os, const std::map<Ipv6Address, uint32_t> &owners, Ipv6Address address, bool dot)
+{
+  std::map<Ipv6Address, uint32_t>::const_iterator owner = owners.find (address);
+  if (owner != owners.end ())
+    {
+      os << (dot ? "n" : "") << owner->second;
+    }
+  else
+    {
+      os << "\"" << address << "\"";
+    }
+}
+
+void
+RplHelper::ExportDodag (Ptr<OutputStreamWrapper> stream, bool dot)
+{
+  std::ostream *os = stream->GetStream ();
+  double now = Simulator::Now ().GetSeconds ();
+
+  // parents are known by their link-local address only
+  std::map<Ipv6Address, uint32_t> owners;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Ipv6> ipv6 = (*i)->GetObject<Ipv6> ();
+      if (ipv6)
+        {
+          for (uint32_t j = 0; j < ipv6->GetNInterfaces (); j++)
+            {
+              for (uint32_t k = 0; k < ipv6->GetNAddresses (j); k++)
+                {
+                  owners[ipv6->GetAddress (j, k).GetAddress ()] = (*i)->GetId ();
+                }
+            }
+        }
+    }
+
+  if (dot)
+    {
+      *os << "digraph \"t=" << now << "s\" {\n";
+    }
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Rpl> rpl = (*i)->GetObject<Rpl> ();
+      if (!rpl)
+        {
+          continue;
+        }
+      const RplNeighborSet &neighbors = rpl->GetNeighborSet ();
+      Ipv6Address parent = rpl->GetPreferredParent ();
+      if (dot)
+        {
+          *os << "  n" << (*i)->GetId () << " [label=\"" << (*i)->GetId () << "\\nrank " << rpl->GetRank ()
+              << "\\nroutes " << rpl->GetNRoutes () << "\"];\n";
+          if (parent != Ipv6Address::GetZero ())
+            {
+              *os << "  n" << (*i)->GetId () << " -> ";
+              WriteNode (*os, owners, parent, true);
+              *os << ";\n";
+            }
+          for (uint32_t p = 0; p < neighbors.GetNParents (); p++)
+            {
+              if (neighbors.GetParentAddress (p) != parent)
+                {
+                  *os << "  n" << (*i)->GetId () << " -> ";
+                  WriteNode (*os, owners, neighbors.GetParentAddress (p), true);
+                  *os << " [style=dashed];\n";
+                }
+            }
+        }
+      else
+        {
+          *os << "{\"time\":" << now << ",\"node\":" << (*i)->GetId () << ",\"rank\":" << rpl->GetRank ()
+              << ",\"parent\":";
+          if (parent != Ipv6Address::GetZero ())
+            {
+              WriteNode (*os, owners, parent, false);
+            }
+          else
+            {
+              *os << "null";
+            }
+          *os << ",\"parents\":[";
+          for (uint32_t p = 0; p < neighbors.GetNParents (); p++)
+            {
+              *os << (p ? "," : "");
+              WriteNode (*os, owners, neighbors.GetParentAddress (p), false);
+            }
+          *os << "],\"routes\":" << rpl->GetNRoutes () << "}\n";
+        }
+    }
+  if (dot)
+    {
+      *os << "}\n";
+    }
+  os->flush ();
+}
+
+void
+RplHelper::DumpRoutingTablesAt (Time dumpTime, std::string filename)
+{
+  Simulator::Schedule (dumpTime, &RplHelper::DumpRoutingTablesToFile, filename);
+}
+
+void
+RplHelper::DumpRoutingTablesToFile (std::string filename)
+{
+  std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_IF (!os, "Cannot open " << filename);
+  DumpRoutingTables (os);
+}
+
+void
+RplHelper::DumpRoutingTables (std::ostream &os)
+{
+  std::vector<Ptr<Node> > nodes;
+  uint32_t size = DUMP_HEADER_SIZE;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Rpl> rpl = (*i)->GetObject<Rpl> ();
+      if (rpl)
+        {
+          nodes.push_back (*i);
+          size += DUMP_NODE_SIZE + rpl->GetRoutingTable ().GetSerializedSize ();
+        }
+    }
+
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator i = buffer.Begin ();
+  i.WriteHtonU32 (DUMP_MAGIC);
+  i.WriteU8 (DUMP_VERSION);
+  i.WriteHtonU64 (Simulator::Now ().GetNanoSeconds ());
+  i.WriteHtonU32 (nodes.size ());
+  for (std::vector<Ptr<Node> >::const_iterator node = nodes.begin (); node != nodes.end (); node++)
+    {
+      Ptr<Rpl> rpl = (*node)->GetObject<Rpl> ();
+      i.WriteHtonU32 ((*node)->GetId ());
+      i.WriteHtonU16 (rpl->GetRank ());
+      rpl->GetRoutingTable ().Serialize (i);
+      i.Next (rpl->GetRoutingTable ().GetSerializedSize ());
+    }
+  buffer.CopyData (&os, size);
+}
+
+bool
+RplHelper::ConvertRoutingTableDump (std::istream &dump, std::ostream &csv)
+{
+  std::string data ((std::istreambuf_iterator<char> (dump)), std::istreambuf_iterator<char> ());
+  uint32_t size = data.size ();
+  if (size < DUMP_HEADER_SIZE)
+    {
+      return false;
+    }
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator i = buffer.Begin ();
+  i.Write ((const uint8_t *) data.data (), size);
+
+  i = buffer.Begin ();
+  if (i.ReadNtohU32 () != DUMP_MAGIC || i.ReadU8 () != DUMP_VERSION)
+    {
+      return false;
+    }
+  double time = NanoSeconds (i.ReadNtohU64 ()).GetSeconds ();
+  uint32_t nNodes = i.ReadNtohU32 ();
+  uint32_t remaining = size - DUMP_HEADER_SIZE;
+
+  csv << "time,node,rank,type,destination,prefix_length,next_hop,interface,path_sequence,lifetime\n";
+  for (uint32_t n = 0; n < nNodes; n++)
+    {
+      if (remaining < DUMP_NODE_SIZE)
+        {
+          return false;
+        }
+      std::ostringstream rowPrefix;
+      rowPrefix << time << "," << i.ReadNtohU32 ();
+      rowPrefix << "," << i.ReadNtohU16 () << ",";
+      remaining -= DUMP_NODE_SIZE;
+      uint32_t read = RplRoutingTable::ConvertToCsv (i, remaining, csv, rowPrefix.str ());
+      if (read == 0)
+        {
+          return false;
+        }
+      i.Next (read);
+      remaining -= read;
+    }
+  return remaining == 0;
+}
+
+// a packet forwarded by a node, for the join of path statistics
+struct PathHop
+{
+  uint64_t packetUid;
+  int64_t time;
+  uint32_t node;
+  uint16_t rank;
+  uint16_t parentSwitches;
+};
+
+static bool
+HopBefore (const PathHop &a, const PathHop &b)
+{
+  return a.packetUid < b.packetUid || (a.packetUid == b.packetUid && a.time < b.time);
+}
+
+std::map<uint32_t, RplFlowPaths>
+RplHelper::GetFlowPaths ()
+{
+  std::map<uint32_t, std::vector<PathHop> > flows;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Rpl> rpl = (*i)->GetObject<Rpl> ();
+      if (!rpl)
+        {
+          continue;
+        }
+      const RplPathStats &stats = rpl->GetPathStats ();
+      for (uint32_t r = 0; r < stats.GetNRecords (); r++)
+        {
+          const RplPathRecord &record = stats.GetRecord (r);
+          PathHop hop = { record.packetUid, record.time, (*i)->GetId (), record.rank, record.parentSwitches };
+          flows[record.flow].push_back (hop);
+        }
+    }
+
+  std::map<uint32_t, RplFlowPaths> result;
+  for (std::map<uint32_t, std::vector<PathHop> >::iterator flow = flows.begin (); flow != flows.end (); flow++)
+    {
+      std::vector<PathHop> &hops = flow->second;
+      std::sort (hops.begin (), hops.end (), &HopBefore);
+
+      // per packet, the forwarders in the order they were reached
+      RplFlowPaths &summary = result[flow->first];
+      summary.packets = 0;
+      std::set<std::vector<uint32_t> > paths;
+      std::map<uint32_t, std::pair<PathHop, PathHop> > firstLast;
+      for (uint32_t h = 0; h < hops.size (); h++)
+        {
+          if (h == 0 || hops[h].packetUid != hops[h - 1].packetUid)
+            {
+              summary.packets++;
+              summary.lastPath.clear ();
+              summary.lastRanks.clear ();
+            }
+          summary.lastPath.push_back (hops[h].node);
+          summary.lastRanks.push_back (hops[h].rank);
+          if (h + 1 == hops.size () || hops[h + 1].packetUid != hops[h].packetUid)
+            {
+              paths.insert (summary.lastPath);
+            }
+
+          std::map<uint32_t, std::pair<PathHop, PathHop> >::iterator node = firstLast.find (hops[h].node);
+          if (node == firstLast.end ())
+            {
+              firstLast[hops[h].node] = std::make_pair (hops[h], hops[h]);
+            }
+          else if (hops[h].time < node->second.first.time)
+            {
+              node->second.first = hops[h];
+            }
+          else if (hops[h].time > node->second.second.time)
+            {
+              node->second.second = hops[h];
+            }
+        }
+      summary.parentSwitches = 0;
+      for (std::map<uint32_t, std::pair<PathHop, PathHop> >::const_iterator node = firstLast.begin ();
+           node != firstLast.end (); node++)
+        {
+          summary.parentSwitches += (uint16_t)(node->second.second.parentSwitches - node->second.first.parentSwitches);
+        }
+      summary.meanHops = double (hops.size ()) / summary.packets + 1;
+      summary.paths = paths.size ();
+    }
+  return result;
+}
+
 Ptr<Ipv6RoutingProtocol>
 RplHelper::Create (Ptr<Node> node) const
 {
   Ptr<Rpl> rpl = m_factory.Create<Rpl> ();
+
+  std::map<uint32_t, Ipv6Address>::const_iterator root = m_roots.find (node->GetId ());
+  if (root != m_roots.end ())
+    {
+      rpl->SetAttribute ("Root", BooleanValue (true));
+      rpl->SetAttribute ("DodagId", Ipv6AddressValue (root->second));
+    }
+  if (m_leaves.count (node->GetId ()))
+    {
+      rpl->SetAttribute ("Leaf", BooleanValue (true));
+    }
+
+  std::map<uint32_t, std::map<uint32_t, uint16_t> >::const_iterator costs = m_interfaceCosts.find (node->GetId ());
+  if (costs != m_interfaceCosts.end ())
+    {
+      for (std::map<uint32_t, uint16_t>::const_iterator cost = costs->second.begin ();
+           cost != costs->second.end (); cost++)
+        {
+          rpl->SetInterfaceCost (cost->first, cost->second);
+        }
+    }
+
   node->AggregateObject (rpl);
   return rpl;
 }
@@ -8,6 +8,12 @@
 #include "ns3/ipv6-routing-helper.h"
 #include "ns3/node-container.h"
 #include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/rpl-path-stats.h"
+
+#include <map>
+#include <set>
 
 namespace ns3 {
 
@@ -67,10 +73,144 @@ public:
    */
   int64_t AssignStreams (NodeContainer c, int64_t stream);
 
+  /**
+   * \brief Make the given nodes DODAG roots.
+   * \param c the nodes that will start a DODAG
+   *
+   * Each root advertises its own first global address as the DODAG ID.
+   * Several roots may be set; nodes join the best grounded DODAG they hear.
+   * Must be called before InternetStackHelper::SetRoutingHelper.
+   */
+  void SetRoot (NodeContainer c);
+
+  /**
+   * \brief Make a node the root of a DODAG with the given DODAG ID.
+   * \param node the node that will start a DODAG
+   * \param dodagId the DODAG ID advertised by this root
+   *
+   * Must be called before InternetStackHelper::SetRoutingHelper.
+   */
+  void SetRoot (Ptr<Node> node, Ipv6Address dodagId);
+
+  /**
+   * \brief Set the rank cost of an interface of a node.
+   * \param node the node
+   * \param interface the interface index
+   * \param cost added to the rank the node advertises on the interface
+   *
+   * Must be called before InternetStackHelper::SetRoutingHelper.
+   */
+  void SetInterfaceCost (Ptr<Node> node, uint32_t interface, uint16_t cost);
+
+  /**
+   * \brief Make the given nodes leaves.
+   * \param c the nodes that will join as leaves
+   *
+   * A leaf joins a DODAG without ever advertising it: it runs no Trickle
+   * timer, keeps its preferred parent as its only neighbor and stores no
+   * route but the default one. Must be called before
+   * InternetStackHelper::SetRoutingHelper.
+   */
+  void SetLeaf (NodeContainer c);
+
+  /**
+   * \brief Export the shape of the DODAG periodically.
+   * \param printInterval the time between two snapshots, the first one included
+   * \param filename the file the snapshots are written to, in DOT if its
+   *        name ends in ".dot" and in JSON lines otherwise
+   *
+   * Each snapshot holds the rank, preferred parent, parent set and number
+   * of routes of every node running RPL. The file is truncated by this
+   * call, and each snapshot is then appended to it. See ExportDodag.
+   */
+  static void ExportDodagEvery (Time printInterval, std::string filename);
+
+  /**
+   * \brief Write a snapshot of the DODAG.
+   * \param stream the output stream
+   * \param dot true for a DOT digraph, false for JSON lines
+   *
+   * In JSON lines, each node is a line such as
+   * {"time":2.5,"node":3,"rank":768,"parent":1,"parents":[1,4],"routes":6},
+   * parent being null before the node joins. In DOT, each node points to
+   * its preferred parent with a solid edge and to its other parents with
+   * dashed ones. Parents are given by node ID, or by address if no node
+   * owns it. The cost is a constant per address and per parent of each node.
+   */
+  static void ExportDodag (Ptr<OutputStreamWrapper> stream, bool dot);
+
+  /**
+   * \brief Dump the routing tables of all nodes at a given time.
+   * \param dumpTime when to dump, from now
+   * \param filename the file the dump is written to, in binary form
+   *
+   * Much faster than printing the tables through
+   * Ipv6RoutingHelper::PrintRoutingTableAllAt on large networks: the dump
+   * is built in a single buffer of fixed size records and written at
+   * once. ConvertRoutingTableDump, or the rpl-dump-to-csv program, turns
+   * it into CSV.
+   */
+  static void DumpRoutingTablesAt (Time dumpTime, std::string filename);
+
+  /**
+   * \brief Dump the routing tables of all nodes now.
+   * \param os the output stream, opened in binary mode
+   *
+   * The dump is a header (magic "RPLD", version, time in nanoseconds,
+   * number of nodes) followed, for every node running RPL, by its node ID,
+   * its rank and its routes as written by RplRoutingTable::Serialize, all
+   * in network order.
+   */
+  static void DumpRoutingTables (std::ostream &os);
+
+  /**
+   * \brief Convert a routing table dump into CSV.
+   * \param dump the dump, as written by DumpRoutingTables
+   * \param csv the output stream, one line per route after the header line
+   * \return false if the dump is malformed or truncated
+   */
+  static bool ConvertRoutingTableDump (std::istream &dump, std::ostream &csv);
+
+  /**
+   * \brief Join the path statistics of all nodes, per flow.
+   * \return the paths of every flow traced, by flow key
+   *
+   * Nodes record the packets they forward once the PathStatsSize attribute
+   * of ns3::Rpl is set. The flows are keyed by RplPathStats::FlowKey, the
+   * five-tuple FlowMonitor classifies them by, so that they can be joined
+   * with the FlowMonitor statistics. Packets whose records were
+   * overwritten in a ring buffer are counted over the hops still recorded.
+   */
+  static std::map<uint32_t, RplFlowPaths> GetFlowPaths ();
+
 private:
+  /**
+   * \brief Write a snapshot of the DODAG and schedule the next one.
+   * \param printInterval the time between two snapshots
+   * \param stream the output stream
+   * \param dot true for DOT, false for JSON lines
+   */
+  static void ExportDodagPeriodically (Time printInterval, Ptr<OutputStreamWrapper> stream, bool dot);
+
+  /**
+   * \brief Dump the routing tables of all nodes to a file.
+   * \param filename the file name
+   */
+  static void DumpRoutingTablesToFile (std::string filename);
+
+
   /** the factory to create RPL routing object */
   ObjectFactory m_factory;
 
+  /** the DODAG roots, by node ID, with their DODAG ID (zero: first global address) */
+  std::map<uint32_t, Ipv6Address> m_roots;
+
+  /** the interface rank costs, by node ID and interface */
+  std::map<uint32_t, std::map<uint32_t, uint16_t> > m_interfaceCosts;
+
+  /** the leaves, by node ID */
+  std::set<uint32_t> m_leaves;
+
 
 
 };
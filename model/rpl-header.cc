@@ -191,12 +191,11 @@ void RplDioMessage::Serialize (Buffer::Iterator start) const
   i.WriteU8 (m_versionNumber);
   i.WriteU8 (m_rplInstanceId);
   i.WriteU16 (m_rank);
-  i.WriteU8 (m_mop);
+  i.WriteU8 ((m_flagG ? 0x80 : 0x00) | (m_mop & 0x07)); //Ground flag shares the MOP byte
   i.WriteU8 (m_prf);
   m_dodagId.Serialize (buff_dodagId);
   i.Write (buff_dodagId, 16);
 
-  //Ground flag not serialized and deserialized
   //i.WriteU8 (m_options);
   //Still have to include options, haven't checked bytes yet.
 
@@ -216,7 +215,9 @@ uint32_t RplDioMessage::Deserialize (Buffer::Iterator start)
   m_versionNumber = i.ReadU8 ();
   m_rplInstanceId = i.ReadU8 ();
   m_rank = i.ReadU16 ();
-  m_mop = i.ReadU8 ();
+  uint8_t flagGMop = i.ReadU8 ();
+  m_flagG = (flagGMop & 0x80) != 0;
+  m_mop = flagGMop & 0x07;
   m_prf = i.ReadU8 ();
   i.Read (buf, 16);
   m_dodagId.Set (buf);
@@ -416,7 +417,7 @@ void RplDaoMessage::Print (std::ostream& os) const
 uint32_t RplDaoMessage::GetSerializedSize () const
 {
   NS_LOG_FUNCTION (this);
-  return 24; //Not including options.
+  return 22; //Not including options.
 }
 
 void RplDaoMessage::Serialize (Buffer::Iterator start) const
@@ -462,6 +463,8 @@ uint32_t RplDaoMessage::Deserialize (Buffer::Iterator start)
   SetType (i.ReadU8 ());
   SetCode (i.ReadU8 ());
   m_flags = i.ReadU8 ();
+  m_flagK = (m_flags & (1 << 7)) != 0;
+  m_flagD = (m_flags & (1 << 6)) != 0;
   m_reserved = i.ReadU8 ();
   m_daoSequence = i.ReadU8 ();
   m_rplInstanceId = i.ReadU8 ();
@@ -561,4 +564,172 @@ void RplDaoMessage::SetDodagId (Ipv6Address dodagId)
 
 }
 
-}
\ No newline at end of file
+NS_OBJECT_ENSURE_REGISTERED(RplDroMessage);
+
+TypeId RplDroMessage::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RplDroMessage")
+    .SetParent<Icmpv6Header> ()
+    .SetGroupName ("rpl")
+    .AddConstructor<RplDroMessage> ()
+  ;
+  return tid;
+}
+
+TypeId RplDroMessage::GetInstanceTypeId () const
+{
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+RplDroMessage::RplDroMessage ()
+{
+  NS_LOG_FUNCTION (this);
+  SetType (155);
+  SetCode (4);
+  SetFlagS (false);
+  SetFlagA (false);
+  SetSequence (0);
+  SetRplInstanceId (0);
+  SetVersionNumber (0);
+}
+
+RplDroMessage::~RplDroMessage ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void RplDroMessage::Print (std::ostream& os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "( type = " << (uint32_t)GetType () << " (Rpl) code = " << (uint32_t)GetCode () << " checksum = " << (uint32_t)GetChecksum () << ")";
+}
+
+uint32_t RplDroMessage::GetSerializedSize () const
+{
+  NS_LOG_FUNCTION (this);
+  return 22; //Not including options.
+}
+
+void RplDroMessage::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this << &start);
+  uint8_t buff_dodagId[16];
+  Buffer::Iterator i = start;
+  uint8_t flags = (m_sequence & 0x03) << 4;
+
+  i.WriteU8 (GetType ());
+  i.WriteU8 (GetCode ());
+  i.WriteU8 (m_rplInstanceId);
+  i.WriteU8 (m_versionNumber);
+
+  if (m_flagS)
+    {
+      flags |= (uint8_t)(1 << 7);
+    }
+
+  if (m_flagA)
+    {
+      flags |= (uint8_t)(1 << 6);
+    }
+
+  i.WriteU8 (flags);
+  i.WriteU8 (0);
+  m_dodagId.Serialize (buff_dodagId);
+  i.Write (buff_dodagId, 16);
+}
+
+uint32_t RplDroMessage::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this << &start);
+  uint8_t buf[16];
+  Buffer::Iterator i = start;
+
+  SetType (i.ReadU8 ());
+  SetCode (i.ReadU8 ());
+  m_rplInstanceId = i.ReadU8 ();
+  m_versionNumber = i.ReadU8 ();
+  uint8_t flags = i.ReadU8 ();
+  m_flagS = (flags & (1 << 7)) != 0;
+  m_flagA = (flags & (1 << 6)) != 0;
+  m_sequence = (flags >> 4) & 0x03;
+  i.ReadU8 ();
+  i.Read (buf, 16);
+  m_dodagId.Set (buf);
+
+  return GetSerializedSize ();
+}
+
+bool RplDroMessage::GetFlagS () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_flagS;
+}
+
+void RplDroMessage::SetFlagS (bool s)
+{
+  NS_LOG_FUNCTION (this << s);
+  m_flagS = s;
+}
+
+bool RplDroMessage::GetFlagA () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_flagA;
+}
+
+void RplDroMessage::SetFlagA (bool a)
+{
+  NS_LOG_FUNCTION (this << a);
+  m_flagA = a;
+}
+
+uint8_t RplDroMessage::GetSequence () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sequence;
+}
+
+void RplDroMessage::SetSequence (uint8_t sequence)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)sequence);
+  m_sequence = sequence & 0x03;
+}
+
+uint8_t RplDroMessage::GetRplInstanceId () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_rplInstanceId;
+}
+
+void RplDroMessage::SetRplInstanceId (uint8_t rplinstanceid)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)rplinstanceid);
+  m_rplInstanceId = rplinstanceid;
+}
+
+uint8_t RplDroMessage::GetVersionNumber () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_versionNumber;
+}
+
+void RplDroMessage::SetVersionNumber (uint8_t version)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)version);
+  m_versionNumber = version;
+}
+
+Ipv6Address RplDroMessage::GetDodagId () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_dodagId;
+}
+
+void RplDroMessage::SetDodagId (Ipv6Address dodagId)
+{
+  NS_LOG_FUNCTION (this << dodagId);
+  m_dodagId = dodagId;
+}
+
+}
@@ -555,6 +555,181 @@ private:
   Ipv6Address m_dodagId;
 };
 
+/*
+*  \brief (DRO Base Object) Format (RFC 6997)
+   \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | RPLInstanceID |Version Number |S|A|Seq|        Reserved       |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                                                               |
+  +                                                               +
+  |                                                               |
+  +                            DODAGID                            +
+  |                                                               |
+  +                                                               +
+  |                                                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  | Option(s)...
+  +-+-+-+-+-+-+-+
+  \endverbatim
+ */
+class RplDroMessage : public Icmpv6Header
+{
+
+public:
+  /**
+   * \brief Constructor.
+   */
+  RplDroMessage ();
+
+  /**
+   * \brief Destructor.
+   */
+  virtual ~RplDroMessage ();
+
+  /**
+   * \brief Get the UID of this class.
+   * \return UID
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief Get the instance type ID.
+   * \return instance type ID
+   */
+  virtual TypeId GetInstanceTypeId () const;
+
+  /**
+   * \brief Print informations.
+   * \param os output stream
+   */
+  virtual void Print (std::ostream& os) const;
+
+  /**
+   * \brief Get the serialized size.
+   * \return serialized size
+   */
+  virtual uint32_t GetSerializedSize () const;
+
+  /**
+   * \brief Serialize the packet.
+   * \param start start offset
+   */
+  virtual void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Deserialize the packet.
+   * \param start start offset
+   * \return length of packet
+   */
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  /**
+   * \brief Get the s (stop) flag.
+   * \return s flag
+   */
+  bool GetFlagS () const;
+
+  /**
+   * \brief Set the s (stop) flag.
+   * \param s value
+   */
+  void SetFlagS (bool s);
+
+  /**
+   * \brief Get the a (acknowledgement required) flag.
+   * \return a flag
+   */
+  bool GetFlagA () const;
+
+  /**
+   * \brief Set the a (acknowledgement required) flag.
+   * \param a value
+   */
+  void SetFlagA (bool a);
+
+  /**
+   * \brief Get the sequence number.
+   * \return the sequence number, 0 to 3
+   */
+  uint8_t GetSequence () const;
+
+  /**
+   * \brief Set the sequence number.
+   * \param sequence the sequence number, 0 to 3
+   */
+  void SetSequence (uint8_t sequence);
+
+  /**
+   * \brief Get rpl instance id.
+   * \return the rpl instance id value
+   */
+  uint8_t GetRplInstanceId () const;
+
+  /**
+   * \brief Set rpl instance id.
+   * \param rplinstanceid the rpl instance id value
+   */
+  void SetRplInstanceId (uint8_t rplinstanceid);
+
+  /**
+   * \brief Get version number.
+   * \return the version number value
+   */
+  uint8_t GetVersionNumber () const;
+
+  /**
+   * \brief Set version number.
+   * \param version the version number value
+   */
+  void SetVersionNumber (uint8_t version);
+
+  /**
+   * \brief Get DODAG ID.
+   * \return the DODAG ID value, the address of the origin
+   */
+  Ipv6Address GetDodagId () const;
+
+  /**
+   * \brief Set DODAG ID.
+   * \param dodagId the DODAG ID value, the address of the origin
+   */
+  void SetDodagId (Ipv6Address dodagId);
+
+private:
+  /**
+   * \brief The S flag.
+   */
+  bool m_flagS;
+
+  /**
+   * \brief The A flag.
+   */
+  bool m_flagA;
+
+  /**
+   * \brief The sequence number.
+   */
+  uint8_t m_sequence;
+
+  /**
+   * \brief The RPL Instance ID field value.
+   */
+  uint8_t m_rplInstanceId;
+
+  /**
+   * \brief The version number field value.
+   */
+  uint8_t m_versionNumber;
+
+  /**
+   * \brief The DODAG ID.
+   */
+  Ipv6Address m_dodagId;
+};
+
 }
 
 #endif
\ No newline at end of file
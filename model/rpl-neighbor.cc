@@ -1,10 +1,43 @@
 
 #include "ns3/rpl-neighbor.h"
 
+#define ETX_DIVISOR 128
+#define ETX_INITIAL 256
+#define ETX_NOACK_PENALTY 12
+#define ETX_ALPHA 90
+#define ENERGY_FULL 100
+#define RSSI_ALPHA 0.7
+#define RSSI_TREND_ALPHA 0.8
+
 namespace ns3 {
 
 //NS_LOG_COMPONENT_DEFINE ("RplNeigbor");
 
+Neighbor::Neighbor(void)
+  : m_address (Ipv6Address::GetZero ()),
+    m_dodagId (Ipv6Address::GetZero ()),
+    m_dtsn (0),
+    m_rank (0xffff),
+    m_interface (0),
+    m_macAddress (),
+    m_type (diffDodag),
+    m_reachability (false),
+    m_rootLoad (0),
+    m_queueLoad (0),
+    m_energy (ENERGY_FULL),
+    m_pathLatency (0),
+    m_etx (ETX_INITIAL),
+    m_lastHeard (Seconds (0)),
+    m_probes (0),
+    m_rssi (0),
+    m_rssiTrend (0),
+    m_rssiTime (Seconds (0)),
+    m_hasRssi (false),
+    m_txRetries (0),
+    m_txFailures (0)
+{
+}
+
 Ipv6Address Neighbor::GetNeighborAddress(void) const
 {
 //  NS_LOG_FUNCTION (this);
@@ -65,6 +98,18 @@ void Neighbor::SetInterface(uint32_t interface)
   m_interface = interface;
 }
 
+Address Neighbor::GetMacAddress(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_macAddress;
+}
+
+void Neighbor::SetMacAddress(const Address &address)
+{
+//  NS_LOG_FUNCTION (this << address);
+  m_macAddress = address;
+}
+
 uint32_t Neighbor::GetNeighborType(void) const
 {
 //  NS_LOG_FUNCTION (this);
@@ -89,4 +134,181 @@ void Neighbor::SetReachable(bool reach)
   m_reachability = reach;
 }
 
-}
\ No newline at end of file
+uint8_t Neighbor::GetRootLoad(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_rootLoad;
+}
+
+void Neighbor::SetRootLoad(uint8_t load)
+{
+//  NS_LOG_FUNCTION (this << load);
+  m_rootLoad = load;
+}
+
+uint8_t Neighbor::GetQueueLoad(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_queueLoad;
+}
+
+void Neighbor::SetQueueLoad(uint8_t load)
+{
+//  NS_LOG_FUNCTION (this << load);
+  m_queueLoad = load;
+}
+
+uint8_t Neighbor::GetEnergy(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_energy;
+}
+
+void Neighbor::SetEnergy(uint8_t energy)
+{
+//  NS_LOG_FUNCTION (this << energy);
+  m_energy = energy;
+}
+
+uint32_t Neighbor::GetPathLatency(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_pathLatency;
+}
+
+void Neighbor::SetPathLatency(uint32_t latency)
+{
+//  NS_LOG_FUNCTION (this << latency);
+  m_pathLatency = latency;
+}
+
+uint16_t Neighbor::GetEtx(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_etx;
+}
+
+void Neighbor::SetEtx(uint16_t etx)
+{
+//  NS_LOG_FUNCTION (this << etx);
+  m_etx = etx;
+}
+
+Time Neighbor::GetLastHeard(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_lastHeard;
+}
+
+void Neighbor::SetLastHeard(Time time)
+{
+//  NS_LOG_FUNCTION (this << time);
+  m_lastHeard = time;
+}
+
+uint8_t Neighbor::GetProbes(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_probes;
+}
+
+void Neighbor::SetProbes(uint8_t probes)
+{
+//  NS_LOG_FUNCTION (this << probes);
+  m_probes = probes;
+}
+
+uint8_t Neighbor::GetTxRetries(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_txRetries;
+}
+
+void Neighbor::SetTxRetries(uint8_t retries)
+{
+//  NS_LOG_FUNCTION (this << retries);
+  m_txRetries = retries;
+}
+
+uint8_t Neighbor::GetTxFailures(void) const
+{
+//  NS_LOG_FUNCTION (this);
+  return m_txFailures;
+}
+
+void Neighbor::SetTxFailures(uint8_t failures)
+{
+//  NS_LOG_FUNCTION (this << failures);
+  m_txFailures = failures;
+}
+
+void Neighbor::UpdateEtx(uint32_t attempts, bool acked)
+{
+//  NS_LOG_FUNCTION (this << attempts << acked);
+  if (attempts == 0)
+    {
+      attempts = 1;
+    }
+  if (!acked && attempts < ETX_NOACK_PENALTY)
+    {
+      attempts = ETX_NOACK_PENALTY;
+    }
+
+  uint32_t sample = attempts * ETX_DIVISOR;
+  uint32_t etx = (m_etx * ETX_ALPHA + sample * (100 - ETX_ALPHA)) / 100;
+  m_etx = (etx > 0xffff) ? 0xffff : etx;
+}
+
+void Neighbor::UpdateRssi(double rssi, Time now)
+{
+//  NS_LOG_FUNCTION (this << rssi << now);
+  if (!m_hasRssi)
+    {
+      m_rssi = rssi;
+      m_rssiTrend = 0;
+      m_rssiTime = now;
+      m_hasRssi = true;
+      return;
+    }
+
+  double smoothed = RSSI_ALPHA * m_rssi + (1 - RSSI_ALPHA) * rssi;
+  double elapsed = (now - m_rssiTime).GetSeconds ();
+  if (elapsed > 0)
+    {
+      double slope = (smoothed - m_rssi) / elapsed;
+      m_rssiTrend = RSSI_TREND_ALPHA * m_rssiTrend + (1 - RSSI_TREND_ALPHA) * slope;
+    }
+  m_rssi = smoothed;
+  m_rssiTime = now;
+}
+
+bool Neighbor::HasRssi(void) const
+{
+  return m_hasRssi;
+}
+
+double Neighbor::GetRssi(void) const
+{
+  return m_rssi;
+}
+
+double Neighbor::GetRssiTrend(void) const
+{
+  return m_rssiTrend;
+}
+
+double Neighbor::PredictRssi(Time horizon) const
+{
+  return m_rssi + m_rssiTrend * horizon.GetSeconds ();
+}
+
+bool Neighbor::IsDegrading(double rssiThreshold, uint16_t etxThreshold, Time horizon) const
+{
+  if (m_etx >= etxThreshold)
+    {
+      return true;
+    }
+  return m_hasRssi && PredictRssi (horizon) < rssiThreshold;
+}
+
+}
@@ -3,7 +3,9 @@
 #define RPL_NEIGHBOR_H
 
 #include "ns3/ipv6-address.h"
+#include "ns3/address.h"
 #include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
 #include <list>
 
 namespace ns3 {
@@ -27,6 +29,11 @@ class Neighbor : public SimpleRefCount<Neighbor>
 
 public:
 
+  /**
+   * \brief Constructor. A new neighbor is unreachable until heard from.
+   */
+  Neighbor(void);
+
   /**
    * \brief Get the Neighbor address.
    * \return address
@@ -86,6 +93,18 @@ public:
    */
   void SetInterface(uint32_t interface);
 
+  /**
+   * \brief Get the link-layer address of the Neighbor.
+   * \return the address, invalid until it is learnt
+   */
+  Address GetMacAddress(void) const;
+
+  /**
+   * \brief Set the link-layer address of the Neighbor.
+   * \param address the link-layer address of the neighbor
+   */
+  void SetMacAddress(const Address &address);
+
   /**
    * \brief Get the Neighbor Type.
    * \return type
@@ -110,6 +129,167 @@ public:
    */
   void SetReachable(bool reach);
 
+  /**
+   * \brief Get the root load advertised by the Neighbor.
+   * \return root load, 0 (idle) to 255 (saturated)
+   */
+  uint8_t GetRootLoad(void) const;
+
+  /**
+   * \brief Set the root load advertised by the Neighbor.
+   * \param load the root load of the neighbor's DODAG
+   */
+  void SetRootLoad(uint8_t load);
+
+  /**
+   * \brief Get the path queue occupancy advertised by the Neighbor.
+   * \return occupancy, 0 (empty) to 255 (full)
+   */
+  uint8_t GetQueueLoad(void) const;
+
+  /**
+   * \brief Set the path queue occupancy advertised by the Neighbor.
+   * \param load the occupancy of the neighbor's path to the root
+   */
+  void SetQueueLoad(uint8_t load);
+
+  /**
+   * \brief Get the path residual energy advertised by the Neighbor.
+   * \return the lowest residual energy from the neighbor to the root, in percent
+   */
+  uint8_t GetEnergy(void) const;
+
+  /**
+   * \brief Set the path residual energy advertised by the Neighbor.
+   * \param energy the energy of the neighbor's path to the root, in percent
+   */
+  void SetEnergy(uint8_t energy);
+
+  /**
+   * \brief Get the path latency advertised by the Neighbor.
+   * \return path latency to the root, in microseconds
+   */
+  uint32_t GetPathLatency(void) const;
+
+  /**
+   * \brief Set the path latency advertised by the Neighbor.
+   * \param latency the path latency of the neighbor, in microseconds
+   */
+  void SetPathLatency(uint32_t latency);
+
+  /**
+   * \brief Get the ETX of the link to the Neighbor.
+   * \return smoothed ETX, ETX * 128
+   */
+  uint16_t GetEtx(void) const;
+
+  /**
+   * \brief Set the ETX of the link to the Neighbor.
+   * \param etx the smoothed ETX, ETX * 128
+   */
+  void SetEtx(uint16_t etx);
+
+  /**
+   * \brief Get the last time the Neighbor was known to be reachable.
+   * \return freshness timestamp
+   */
+  Time GetLastHeard(void) const;
+
+  /**
+   * \brief Set the last time the Neighbor was known to be reachable.
+   * \param time freshness timestamp
+   */
+  void SetLastHeard(Time time);
+
+  /**
+   * \brief Get the number of unanswered NUD probes.
+   * \return probes
+   */
+  uint8_t GetProbes(void) const;
+
+  /**
+   * \brief Set the number of unanswered NUD probes.
+   * \param probes probes sent since the Neighbor was last heard
+   */
+  void SetProbes(uint8_t probes);
+
+  /**
+   * \brief Get the failed attempts of the unicast packet in flight.
+   * \return retries
+   */
+  uint8_t GetTxRetries(void) const;
+
+  /**
+   * \brief Set the failed attempts of the unicast packet in flight.
+   * \param retries the retries
+   */
+  void SetTxRetries(uint8_t retries);
+
+  /**
+   * \brief Get the consecutive unicast packets lost towards the Neighbor.
+   * \return failures
+   */
+  uint8_t GetTxFailures(void) const;
+
+  /**
+   * \brief Set the consecutive unicast packets lost towards the Neighbor.
+   * \param failures the failures
+   */
+  void SetTxFailures(uint8_t failures);
+
+  /**
+   * \brief Fold the outcome of a unicast packet into the ETX estimate.
+   *
+   * The sample is the number of attempts, or at least the no-ack
+   * penalty when the packet was lost, smoothed with an EWMA.
+   * \param attempts transmissions spent on the packet
+   * \param acked true if the packet was acknowledged
+   */
+  void UpdateEtx(uint32_t attempts, bool acked);
+
+  /**
+   * \brief Fold the signal strength of a frame from the Neighbor into the RSSI estimate.
+   *
+   * The RSSI is smoothed with an EWMA, and so is its rate of change.
+   * \param rssi signal strength of the frame, in dBm
+   * \param now reception time
+   */
+  void UpdateRssi(double rssi, Time now);
+
+  /**
+   * \brief Check if a frame from the Neighbor was heard with its signal strength.
+   * \return true if the RSSI estimate is set
+   */
+  bool HasRssi(void) const;
+
+  /**
+   * \brief Get the RSSI of the link to the Neighbor.
+   * \return smoothed RSSI, in dBm
+   */
+  double GetRssi(void) const;
+
+  /**
+   * \brief Get the rate of change of the RSSI.
+   * \return smoothed trend, in dB per second, negative when the link fades
+   */
+  double GetRssiTrend(void) const;
+
+  /**
+   * \brief Extrapolate the RSSI along its trend.
+   * \param horizon how far ahead
+   * \return the expected RSSI, in dBm
+   */
+  double PredictRssi(Time horizon) const;
+
+  /**
+   * \brief Check if the link to the Neighbor is about to break.
+   * \param rssiThreshold lowest usable RSSI, in dBm
+   * \param etxThreshold highest usable ETX, ETX * 128
+   * \param horizon how far ahead the RSSI is extrapolated
+   * \return true if the ETX is too high or the RSSI is expected below the threshold
+   */
+  bool IsDegrading(double rssiThreshold, uint16_t etxThreshold, Time horizon) const;
+
 
 private:
 
@@ -123,10 +303,38 @@ private:
   uint16_t m_rank;
   //interface of neighbor
   uint32_t m_interface;
+  //link-layer address of neighbor
+  Address m_macAddress;
   //type of neighbor
   neighborType m_type;
   //reachability
   bool m_reachability;
+  //load of the neighbor's DODAG root
+  uint8_t m_rootLoad;
+  //highest queue occupancy from the neighbor to the root
+  uint8_t m_queueLoad;
+  //lowest residual energy from the neighbor to the root, in percent
+  uint8_t m_energy;
+  //latency from the neighbor to the root
+  uint32_t m_pathLatency;
+  //smoothed ETX of the link, ETX * 128
+  uint16_t m_etx;
+  //freshness timestamp
+  Time m_lastHeard;
+  //NUD probes sent since last heard
+  uint8_t m_probes;
+  //smoothed RSSI of the link, in dBm
+  double m_rssi;
+  //smoothed rate of change of the RSSI, in dB/s
+  double m_rssiTrend;
+  //last RSSI sample
+  Time m_rssiTime;
+  //RSSI heard at least once
+  bool m_hasRssi;
+  //failed attempts of the packet in flight
+  uint8_t m_txRetries;
+  //consecutive packets lost
+  uint8_t m_txFailures;
 };
 
   typedef std::list<Neighbor> NeighborList;
@@ -4,8 +4,10 @@
 #include "ns3/ipv6-interface.h"
 #include "rpl-neighbor.h"
 #include "rpl-neighborset.h"
+#include "rpl-objective-function.h"
 #include "ns3/log.h"
 #include <ostream>
+#include <algorithm>
 
 
 namespace ns3 {
@@ -14,13 +16,18 @@ NS_LOG_COMPONENT_DEFINE ("RplNeighborSet");
 
 //NS_OBJECT_ENSURE_REGISTERED(RplNeighborSet);
 
-bool SortByRank (const Neighbor &lhs, const Neighbor &rhs)
+bool SortByRank (const std::pair<uint16_t, Ipv6Address> &lhs, const std::pair<uint16_t, Ipv6Address> &rhs)
 {
-  return lhs.GetRank() < rhs.GetRank();
+  return lhs.first < rhs.first;
 }
 
 
 RplNeighborSet::RplNeighborSet()
+  : m_capacity (0),
+    m_policy (RPL_EVICT_LRU),
+    m_evictions (0),
+    m_rejections (0),
+    m_churn (0)
 {
 //  NS_LOG_FUNCTION(this);
 }
@@ -48,11 +55,124 @@ TypeId RplNeighborSet::GetInstanceTypeId () const
 */
 //void RplNeighborSet::AddNeighbor(Ipv6Address address, Ipv6Address dodagId, uint8_t dtsn, uint16d _t rank, uint32_t interface)
 
-void RplNeighborSet::AddNeighbor(Neighbor neighbor)
+Ptr<Neighbor> RplNeighborSet::AddNeighbor(Neighbor neighbor)
 {
 //  NS_LOG_FUNCTION (this << neighbor);
 
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetNeighborAddress() == neighbor.GetNeighborAddress())
+        {
+          *it = neighbor;
+          m_neighborList.splice (m_neighborList.end (), m_neighborList, it);
+          return &m_neighborList.back ();
+        }
+    }
+
+  if (m_capacity != 0 && m_neighborList.size () >= m_capacity)
+    {
+      NeighborList::iterator victim = FindVictim (neighbor);
+      if (victim == m_neighborList.end ())
+        {
+          NS_LOG_LOGIC ("Neighbor set full, rejecting " << neighbor.GetNeighborAddress ());
+          m_rejections++;
+          return 0;
+        }
+      NS_LOG_LOGIC ("Neighbor set full, evicting " << victim->GetNeighborAddress ());
+      m_parentSet.erase (std::remove (m_parentSet.begin (), m_parentSet.end (), victim->GetNeighborAddress ()),
+                         m_parentSet.end ());
+      m_neighborList.erase (victim);
+      m_evictions++;
+      m_churn++;
+    }
+
   m_neighborList.push_back (neighbor);
+  m_churn++;
+  return &m_neighborList.back ();
+}
+
+NeighborList::iterator RplNeighborSet::FindVictim(const Neighbor &candidate)
+{
+  // the list is ordered least recently heard first
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (!it->GetReachable())
+        {
+          return it;
+        }
+    }
+
+  NeighborList::iterator victim = m_neighborList.end ();
+  switch (m_policy)
+    {
+    case RPL_EVICT_LRU:
+      victim = m_neighborList.begin ();
+      break;
+    case RPL_EVICT_WORST_RANK:
+      for (NeighborList::iterator it = m_neighborList.begin ();
+           it != m_neighborList.end (); it++)
+        {
+          if (victim == m_neighborList.end () || it->GetRank() > victim->GetRank())
+            {
+              victim = it;
+            }
+        }
+      if (victim != m_neighborList.end () && victim->GetRank() <= candidate.GetRank())
+        {
+          victim = m_neighborList.end ();
+        }
+      break;
+    case RPL_EVICT_PIN_PARENTS:
+      for (NeighborList::iterator it = m_neighborList.begin ();
+           it != m_neighborList.end (); it++)
+        {
+          if (!IsParent (it->GetNeighborAddress()))
+            {
+              victim = it;
+              break;
+            }
+        }
+      break;
+    }
+  return victim;
+}
+
+bool RplNeighborSet::IsParent(Ipv6Address address) const
+{
+  return std::find (m_parentSet.begin (), m_parentSet.end (), address) != m_parentSet.end ();
+}
+
+void RplNeighborSet::SetCapacity(uint32_t capacity, RplEvictionPolicy policy)
+{
+  m_capacity = capacity;
+  m_policy = policy;
+}
+
+uint32_t RplNeighborSet::GetCapacity() const
+{
+  return m_capacity;
+}
+
+uint32_t RplNeighborSet::GetNNeighbors() const
+{
+  return m_neighborList.size ();
+}
+
+uint32_t RplNeighborSet::GetEvictions() const
+{
+  return m_evictions;
+}
+
+uint32_t RplNeighborSet::GetRejections() const
+{
+  return m_rejections;
+}
+
+uint32_t RplNeighborSet::GetChurn() const
+{
+  return m_churn;
 }
 
 void RplNeighborSet::DeleteNeighbor(Ipv6Address address)
@@ -65,6 +185,7 @@ void RplNeighborSet::DeleteNeighbor(Ipv6Address address)
       if (it->GetNeighborAddress() == address)
         {
           m_neighborList.erase (it);
+          m_churn++;
           break;
         }
     }
@@ -88,6 +209,35 @@ Ptr<Neighbor> RplNeighborSet::FindNeighbor (Ipv6Address address)
   return NULL;
 }
 
+Ptr<Neighbor> RplNeighborSet::FindNeighborByMac (const Address &address)
+{
+  Ptr<Neighbor> neighbor = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetMacAddress() == address)
+        {
+          neighbor = (&(*it));
+          return neighbor;
+        }
+    }
+  return NULL;
+}
+
+std::vector<Ptr<Neighbor> > RplNeighborSet::GetUnresolvedNeighbors()
+{
+  std::vector<Ptr<Neighbor> > unresolved;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetMacAddress().IsInvalid ())
+        {
+          unresolved.push_back (&(*it));
+        }
+    }
+  return unresolved;
+}
+
 void RplNeighborSet::UpdateNeighbor(Ipv6Address address, Ipv6Address dodagId, uint8_t dtsn, uint16_t rank, uint32_t interface)
 {
  // NS_LOG_FUNCTION (this << address << dodagId << dtsn << rank << interface);
@@ -99,8 +249,9 @@ void RplNeighborSet::UpdateNeighbor(Ipv6Address address, Ipv6Address dodagId, ui
         it->SetDodagId(dodagId);
         it->SetRank(rank);
         it->SetDtsn(dtsn);
-        it->SetInterface(interface);    
-        break;    
+        it->SetInterface(interface);
+        m_neighborList.splice (m_neighborList.end (), m_neighborList, it);
+        break;
       }
     }
 }
@@ -109,27 +260,293 @@ void RplNeighborSet::ClearNeighborSet()
 {
 //  NS_LOG_FUNCTION (this);
 
+  m_churn += m_neighborList.size ();
+  m_neighborList.clear ();
+  m_parentSet.clear ();
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectParent()
+{
+  NS_LOG_FUNCTION (this);
+  // the list is kept in recency order, so scan for the lowest rank
+  Ptr<Neighbor> best = 0;
   for (NeighborList::iterator it = m_neighborList.begin ();
        it != m_neighborList.end (); it++)
     {
-        m_neighborList.erase (it);
+      if (it->GetReachable() &&
+          (!best || it->GetRank() < best->GetRank()))
+      {
+        best = &(*it);
+      }
     }
+  return best;
+} 
+
+Ptr<Neighbor> RplNeighborSet::SelectParent(Ipv6Address dodagId)
+{
+  NS_LOG_FUNCTION (this << dodagId);
+  // the list is kept in recency order, so scan for the lowest rank
+  Ptr<Neighbor> best = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetReachable() && it->GetDodagId() == dodagId &&
+          (!best || it->GetRank() < best->GetRank()))
+      {
+        best = &(*it);
+      }
+    }
+  return best;
 }
 
-Ptr<Neighbor> RplNeighborSet::SelectParent()
+Ptr<Neighbor> RplNeighborSet::SelectParent(Ipv6Address dodagId, uint32_t maxPathLatency)
 {
-  NS_LOG_FUNCTION (this);
-  m_neighborList.sort(SortByRank);
+  NS_LOG_FUNCTION (this << dodagId << maxPathLatency);
+  // the list is kept in recency order, so scan for the lowest rank
+  Ptr<Neighbor> best = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetReachable() && it->GetDodagId() == dodagId &&
+          it->GetPathLatency() <= maxPathLatency &&
+          (!best || it->GetRank() < best->GetRank()))
+      {
+        best = &(*it);
+      }
+    }
+  return best;
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectParent(Ipv6Address currentDodag, uint16_t loadWeight, uint16_t hysteresis)
+{
+  NS_LOG_FUNCTION (this << currentDodag << loadWeight << hysteresis);
+  NeighborList::iterator current = m_neighborList.end ();
+  NeighborList::iterator other = m_neighborList.end ();
+  uint32_t currentCost = 0;
+  uint32_t otherCost = 0;
+
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (!it->GetReachable() || it->GetRank() == 0xffff)
+        {
+          continue;
+        }
+      uint32_t cost = it->GetRank() + (uint32_t)it->GetRootLoad() * loadWeight / 255;
+      if (it->GetDodagId() == currentDodag)
+        {
+          if (current == m_neighborList.end () || cost < currentCost)
+            {
+              current = it;
+              currentCost = cost;
+            }
+        }
+      else if (other == m_neighborList.end () || cost < otherCost)
+        {
+          other = it;
+          otherCost = cost;
+        }
+    }
+
+  if (other != m_neighborList.end () &&
+      (current == m_neighborList.end () || otherCost + hysteresis < currentCost))
+    {
+      current = other;
+    }
+  if (current == m_neighborList.end ())
+    {
+      return NULL;
+    }
+  Ptr<Neighbor> neighbor = &(*current);
+  return neighbor;
+}
+
+void RplNeighborSet::UpdateParentSet(Ipv6Address dodagId, uint16_t rank, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << dodagId << rank << size);
+  m_parentSet.clear ();
+  std::vector<std::pair<uint16_t, Ipv6Address> > eligible;
   for (NeighborList::iterator it = m_neighborList.begin ();
        it != m_neighborList.end (); it++)
     {
-      if (it->GetReachable())
+      if (it->GetReachable() && it->GetDodagId() == dodagId && it->GetRank() < rank)
       {
-        Ptr<Neighbor> neighbor = &(*it);
-        return neighbor;
+        eligible.push_back (std::make_pair (it->GetRank(), it->GetNeighborAddress()));
       }
     }
+  std::stable_sort (eligible.begin (), eligible.end (), SortByRank);
+  for (uint32_t i = 0; i < eligible.size () && i < size; i++)
+    {
+      m_parentSet.push_back (eligible[i].second);
+    }
+}
+
+uint32_t RplNeighborSet::GetNParents() const
+{
+  return m_parentSet.size ();
+}
+
+Ptr<Neighbor> RplNeighborSet::GetParent(uint32_t index)
+{
+  NS_ASSERT (index < m_parentSet.size ());
+  return FindNeighbor (m_parentSet[index]);
+}
+
+Ipv6Address RplNeighborSet::GetParentAddress(uint32_t index) const
+{
+  NS_ASSERT (index < m_parentSet.size ());
+  return m_parentSet[index];
+}
+
+void RplNeighborSet::SetInterfaceDown(uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (it->GetInterface() == interface)
+      {
+        it->SetReachable(false);
+      }
+    }
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectParent(Ipv6Address dodagId, uint32_t maxPathLatency, uint16_t congestionWeight, uint16_t maxRank)
+{
+  NS_LOG_FUNCTION (this << dodagId << maxPathLatency << congestionWeight << maxRank);
+  Ptr<Neighbor> best = 0;
+  uint32_t bestCost = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (!it->GetReachable() || it->GetDodagId() != dodagId ||
+          it->GetPathLatency() > maxPathLatency || it->GetRank() > maxRank)
+        {
+          continue;
+        }
+      uint32_t cost = RplObjectiveFunction::ComputeCongestionCost (it->GetRank(), it->GetQueueLoad(), congestionWeight);
+      if (!best || cost < bestCost || (cost == bestCost && it->GetRank() < best->GetRank()))
+        {
+          best = &(*it);
+          bestCost = cost;
+        }
+    }
+  return best;
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectEnergyParent(Ipv6Address dodagId, uint32_t maxPathLatency, uint16_t energyWeight, uint16_t maxRank)
+{
+  NS_LOG_FUNCTION (this << dodagId << maxPathLatency << energyWeight << maxRank);
+  Ptr<Neighbor> best = 0;
+  uint32_t bestCost = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (!it->GetReachable() || it->GetDodagId() != dodagId ||
+          it->GetPathLatency() > maxPathLatency || it->GetRank() > maxRank)
+        {
+          continue;
+        }
+      uint32_t cost = RplObjectiveFunction::ComputeEnergyCost (it->GetRank(), it->GetEnergy(), energyWeight);
+      if (!best || cost < bestCost || (cost == bestCost && it->GetRank() < best->GetRank()))
+        {
+          best = &(*it);
+          bestCost = cost;
+        }
+    }
+  return best;
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectHandoverParent(Ipv6Address dodagId, Ipv6Address current, uint16_t maxRank,
+                                                   double rssiThreshold, uint16_t etxThreshold, Time horizon)
+{
+  NS_LOG_FUNCTION (this << dodagId << current << maxRank << rssiThreshold << etxThreshold << horizon);
+  Ptr<Neighbor> best = 0;
+  for (NeighborList::iterator it = m_neighborList.begin ();
+       it != m_neighborList.end (); it++)
+    {
+      if (!it->GetReachable() || it->GetDodagId() != dodagId || it->GetNeighborAddress() == current ||
+          it->GetRank() > maxRank || it->IsDegrading (rssiThreshold, etxThreshold, horizon))
+        {
+          continue;
+        }
+      if (!best || it->GetRank() < best->GetRank() ||
+          (it->GetRank() == best->GetRank() && it->GetRssi() > best->GetRssi()))
+        {
+          best = &(*it);
+        }
+    }
+  return best;
+}
+
+Ptr<Neighbor> RplNeighborSet::SelectMultipathParent(Ipv6Address preferredParent, uint32_t flowHash)
+{
+  Ptr<Neighbor> preferred = FindNeighbor (preferredParent);
+  if (!preferred)
+    {
+      return 0;
+    }
+
+  std::vector<Ptr<Neighbor> > candidates;
+  std::vector<uint32_t> weights;
+  uint32_t totalWeight = 0;
+  candidates.push_back (preferred);
+  for (std::vector<Ipv6Address>::const_iterator it = m_parentSet.begin ();
+       it != m_parentSet.end (); it++)
+    {
+      Ptr<Neighbor> parent = FindNeighbor (*it);
+      if (parent && parent != preferred && parent->GetReachable() &&
+          parent->GetRank() == preferred->GetRank())
+        {
+          candidates.push_back (parent);
+        }
+    }
+  if (candidates.size () == 1)
+    {
+      return preferred;
+    }
+
+  for (uint32_t i = 0; i < candidates.size (); i++)
+    {
+      // ETX is scaled by 128, so a perfect link weighs 128
+      uint32_t etx = std::max<uint32_t> (candidates[i]->GetEtx(), 128);
+      weights.push_back (128 * 128 / etx);
+      totalWeight += weights.back ();
+    }
+
+  uint32_t pick = flowHash % totalWeight;
+  for (uint32_t i = 0; i < candidates.size (); i++)
+    {
+      if (pick < weights[i])
+        {
+          return candidates[i];
+        }
+      pick -= weights[i];
+    }
+  return preferred;
+}
+
+Ptr<Neighbor> RplNeighborSet::NextParent(Ipv6Address failedParent)
+{
+  NS_LOG_FUNCTION (this << failedParent);
+  Ptr<Neighbor> failed = FindNeighbor (failedParent);
+  if (failed)
+    {
+      failed->SetReachable (false);
+    }
+
+  std::vector<Ipv6Address>::iterator it = m_parentSet.begin ();
+  while (it != m_parentSet.end ())
+    {
+      Ptr<Neighbor> parent = FindNeighbor (*it);
+      if (!parent || !parent->GetReachable ())
+        {
+          it = m_parentSet.erase (it);
+          continue;
+        }
+      return parent;
+    }
   return NULL;
-} 
+}
 
 }
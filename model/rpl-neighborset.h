@@ -2,6 +2,7 @@
 #define RPL_NEIGHBOR_SET_H
 
 #include <list>
+#include <vector>
 
 #include "ns3/ipv6-routing-protocol.h"
 #include "ns3/ipv6-interface.h"
@@ -9,6 +10,20 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup rpl
+ *
+ * \brief Which neighbor leaves a full neighbor set to make room for a new one.
+ *
+ * Unreachable neighbors are always evicted first.
+ */
+enum RplEvictionPolicy
+{
+  RPL_EVICT_LRU = 0,         ///< the neighbor heard from least recently
+  RPL_EVICT_WORST_RANK = 1,  ///< the neighbor with the highest rank, if worse than the new one
+  RPL_EVICT_PIN_PARENTS = 2  ///< the least recently heard neighbor outside the parent set
+};
+
 class RplNeighborSet
 {
 public:
@@ -46,10 +61,14 @@ public:
 //  void AddNeighbor(Ipv6Address address, Ipv6Address dodagId, uint8_t dtsn, uint16_t rank, uint32_t interface);
 
   /**
-   * \brief Add neighbor to neighborlist.
+   * \brief Add neighbor to neighborlist, or replace the entry with the same address.
+   *
+   * When the set is full a neighbor is evicted according to the eviction
+   * policy; if the policy finds none the new neighbor is rejected.
    * \param neighbor neighbor struct.
+   * \return the stored neighbor, or 0 if it was rejected
    */
-  void AddNeighbor(Neighbor neighbor);
+  Ptr<Neighbor> AddNeighbor(Neighbor neighbor);
 
   /**
    * \brief delete neighbor from neighborlist.
@@ -68,6 +87,56 @@ public:
    */
   Ptr<Neighbor> FindNeighbor (Ipv6Address address);
 
+  /**
+   * \brief find neighbor in neighborlist by its link-layer address.
+   * \param address link-layer address of the neighbor
+   * \return the neighbor, or 0 if no neighbor has this address recorded
+   */
+  Ptr<Neighbor> FindNeighborByMac (const Address &address);
+
+  /**
+   * \brief get the neighbors whose link-layer address is not known yet.
+   * \return the neighbors without link-layer address
+   */
+  std::vector<Ptr<Neighbor> > GetUnresolvedNeighbors();
+
+  /**
+   * \brief Bound the neighbor set.
+   * \param capacity maximum number of neighbors, 0 for unbounded
+   * \param policy how to make room when the set is full
+   */
+  void SetCapacity(uint32_t capacity, RplEvictionPolicy policy);
+
+  /**
+   * \brief get the maximum number of neighbors.
+   * \return the capacity, 0 if unbounded
+   */
+  uint32_t GetCapacity() const;
+
+  /**
+   * \brief get the number of neighbors.
+   * \return the number of neighbors
+   */
+  uint32_t GetNNeighbors() const;
+
+  /**
+   * \brief get the number of neighbors evicted to make room.
+   * \return the eviction count
+   */
+  uint32_t GetEvictions() const;
+
+  /**
+   * \brief get the number of new neighbors rejected by a full set.
+   * \return the rejection count
+   */
+  uint32_t GetRejections() const;
+
+  /**
+   * \brief get the number of neighbors that entered or left the set.
+   * \return the churn count
+   */
+  uint32_t GetChurn() const;
+
   /**
    * \brief Update neighbor in neighborlist.
    * \param address neighbor address
@@ -83,9 +152,154 @@ public:
    */
   Ptr<Neighbor> SelectParent();
 
+  /**
+   * \brief select parent node among the neighbors of a given DODAG.
+   * \param dodagId the DODAG the parent must belong to
+   */
+  Ptr<Neighbor> SelectParent(Ipv6Address dodagId);
+
+  /**
+   * \brief select parent node of a given DODAG within a latency bound.
+   * \param dodagId the DODAG the parent must belong to
+   * \param maxPathLatency highest path latency advertised by an eligible parent
+   */
+  Ptr<Neighbor> SelectParent(Ipv6Address dodagId, uint32_t maxPathLatency);
+
+  /**
+   * \brief select the least congested parent of a given DODAG.
+   *
+   * Neighbors are compared by rank plus their path queue occupancy scaled
+   * to congestionWeight rank units, lower rank first on a tie.
+   * \param dodagId the DODAG the parent must belong to
+   * \param maxPathLatency highest path latency advertised by an eligible parent
+   * \param congestionWeight rank units added at full occupancy
+   * \param maxRank highest rank of an eligible parent
+   */
+  Ptr<Neighbor> SelectParent(Ipv6Address dodagId, uint32_t maxPathLatency, uint16_t congestionWeight, uint16_t maxRank);
+
+  /**
+   * \brief select the parent of a given DODAG with the most residual energy.
+   *
+   * Neighbors are compared by rank plus the energy spent on their path to
+   * the root scaled to energyWeight rank units, lower rank first on a tie.
+   * \param dodagId the DODAG the parent must belong to
+   * \param maxPathLatency highest path latency advertised by an eligible parent
+   * \param energyWeight rank units added when the path energy is exhausted
+   * \param maxRank highest rank of an eligible parent
+   */
+  Ptr<Neighbor> SelectEnergyParent(Ipv6Address dodagId, uint32_t maxPathLatency, uint16_t energyWeight, uint16_t maxRank);
+
+  /**
+   * \brief select the parent to hand over to before the current link breaks.
+   *
+   * Neighbors whose link is degrading as well are left out. The lowest
+   * rank wins, then the strongest RSSI.
+   * \param dodagId the DODAG the parent must belong to
+   * \param current the parent being left
+   * \param maxRank highest rank of an eligible parent
+   * \param rssiThreshold lowest usable RSSI, in dBm
+   * \param etxThreshold highest usable ETX, ETX * 128
+   * \param horizon how far ahead the RSSI is extrapolated
+   */
+  Ptr<Neighbor> SelectHandoverParent(Ipv6Address dodagId, Ipv6Address current, uint16_t maxRank,
+                                     double rssiThreshold, uint16_t etxThreshold, Time horizon);
+
+  /**
+   * \brief select parent node across DODAGs, weighting rank by root load.
+   *
+   * The cost of a neighbor is its rank plus its root load scaled to
+   * loadWeight rank units. A neighbor of another DODAG is only chosen when
+   * its cost beats the best neighbor of the current DODAG by more than
+   * hysteresis.
+   * \param currentDodag the DODAG the node currently belongs to
+   * \param loadWeight rank units added at full root load
+   * \param hysteresis rank units required to switch DODAG
+   */
+  Ptr<Neighbor> SelectParent(Ipv6Address currentDodag, uint16_t loadWeight, uint16_t hysteresis);
+
+  /**
+   * \brief rebuild the ordered parent set.
+   *
+   * The set holds, lowest rank first, up to size reachable neighbors of the
+   * DODAG whose rank is below the rank of this node.
+   * \param dodagId the DODAG the parents must belong to
+   * \param rank the rank of this node
+   * \param size the maximum number of parents
+   */
+  void UpdateParentSet(Ipv6Address dodagId, uint16_t rank, uint32_t size);
+
+  /**
+   * \brief get the number of parents in the parent set.
+   * \return the number of parents
+   */
+  uint32_t GetNParents() const;
+
+  /**
+   * \brief get a parent of the parent set.
+   * \param index position in the set, 0 being the best parent
+   * \return the parent, or 0 if it left the neighbor set
+   */
+  Ptr<Neighbor> GetParent(uint32_t index);
+
+  /**
+   * \brief get the address of a parent of the parent set.
+   * \param index position in the set, 0 being the best parent
+   * \return the parent address
+   */
+  Ipv6Address GetParentAddress(uint32_t index) const;
+
+  /**
+   * \brief spread flows over the parents with the rank of the preferred parent.
+   *
+   * Each reachable equal-rank parent is weighted by the inverse of its ETX,
+   * and the flow hash picks one of them in proportion to its weight.
+   * \param preferredParent address of the preferred parent
+   * \param flowHash hash of the flow being routed
+   * \return the parent for this flow, or 0 if the preferred parent is unknown
+   */
+  Ptr<Neighbor> SelectMultipathParent(Ipv6Address preferredParent, uint32_t flowHash);
+
+  /**
+   * \brief drop a failed parent and get the next viable one.
+   * \param failedParent address of the parent that failed
+   * \return the best remaining reachable parent, or 0 if the set is exhausted
+   */
+  Ptr<Neighbor> NextParent(Ipv6Address failedParent);
+
+  /**
+   * \brief mark every neighbor reached through an interface unreachable.
+   * \param interface the interface that went down
+   */
+  void SetInterfaceDown(uint32_t interface);
+
 private:
-  // Container for neighbors
+  /**
+   * \brief pick the neighbor to evict in favour of a new one.
+   * \param candidate the neighbor to be added
+   * \return the victim, or m_neighborList.end () to reject the candidate
+   */
+  NeighborList::iterator FindVictim(const Neighbor &candidate);
+
+  /**
+   * \brief check if a neighbor belongs to the parent set.
+   * \param address neighbor address
+   */
+  bool IsParent(Ipv6Address address) const;
+
+  // Container for neighbors, least recently heard first
   NeighborList m_neighborList;
+  // Maximum number of neighbors, 0 for unbounded
+  uint32_t m_capacity;
+  // Eviction policy of a full set
+  RplEvictionPolicy m_policy;
+  // Neighbors evicted to make room
+  uint32_t m_evictions;
+  // New neighbors rejected by a full set
+  uint32_t m_rejections;
+  // Neighbors that entered or left the set
+  uint32_t m_churn;
+  // Ordered parent set, best first
+  std::vector<Ipv6Address> m_parentSet;
 };
 
 
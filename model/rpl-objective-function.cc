@@ -28,6 +28,7 @@
 #define MAXIMUM_RANK_FACTOR 4
 #define DEFAULT_MIN_HOP_RANK_INCREASE 256
 
+#include <algorithm>
 #include <stdint.h>
 
 #include "ns3/log.h"
@@ -52,6 +53,48 @@ uint16_t RplObjectiveFunction::ComputeRank (uint16_t parentRank)
   return parentRank;
 }
 
+bool RplObjectiveFunction::MeetsConstraints (const RplMetricContainerOption &metricContainer, uint32_t linkLatency)
+{
+  RplMetricObject constraint;
+  uint32_t bound;
+  uint32_t value;
+
+  if (metricContainer.FindConstraint (RPL_METRIC_LATENCY, constraint) &&
+      constraint.GetAggregatedValue (bound) &&
+      metricContainer.GetMetricValue (RPL_METRIC_LATENCY, value) &&
+      (uint64_t)value + linkLatency > bound)
+    {
+      return false;
+    }
+
+  if (metricContainer.FindConstraint (RPL_METRIC_HC, constraint) &&
+      constraint.GetAggregatedValue (bound) &&
+      metricContainer.GetMetricValue (RPL_METRIC_HC, value) &&
+      value + 1 > bound)
+    {
+      return false;
+    }
+
+  return true;
+}
+
+void RplObjectiveFunction::UpdateMetrics (RplMetricContainerOption &metricContainer, uint32_t linkLatency, uint16_t linkEtx)
+{
+  metricContainer.AccumulateMetric (RPL_METRIC_HC, 1);
+  metricContainer.AccumulateMetric (RPL_METRIC_LATENCY, linkLatency);
+  metricContainer.AccumulateMetric (RPL_METRIC_ETX, linkEtx);
+}
+
+uint32_t RplObjectiveFunction::ComputeCongestionCost (uint16_t parentRank, uint8_t queueLoad, uint16_t weight)
+{
+  return parentRank + (uint32_t)queueLoad * weight / 255;
+}
+
+uint32_t RplObjectiveFunction::ComputeEnergyCost (uint16_t parentRank, uint8_t energy, uint16_t weight)
+{
+  return parentRank + (uint32_t)(100 - std::min<uint8_t> (energy, 100)) * weight / 100;
+}
+
 RplObjectiveFunctionOf0::RplObjectiveFunctionOf0 ()
 { 
 }
@@ -23,6 +23,7 @@
 
 #include <stdint.h> 
 #include <ns3/log.h>
+#include <ns3/rpl-option.h>
 
 namespace ns3 {
 
@@ -46,6 +47,53 @@ public:
    */
   static uint16_t ComputeRank (uint16_t parentRank);
 
+  /**
+   * \brief Check the constraints of a DAG Metric Container through a parent.
+   *
+   * Latency and hop count constraints are compared with the path metrics
+   * advertised by the parent plus the link to it. Constraints without a
+   * matching metric are considered met.
+   * \param metricContainer the container advertised by the parent
+   * \param linkLatency latency of the link to the parent, in microseconds
+   * \return true if the path through the parent meets every constraint
+   */
+  static bool MeetsConstraints (const RplMetricContainerOption &metricContainer, uint32_t linkLatency);
+
+  /**
+   * \brief Extend the path metrics advertised by a parent with the link to it.
+   *
+   * Objects without a local value (node energy, link quality) are left as
+   * advertised.
+   * \param metricContainer the container advertised by the parent, updated in place
+   * \param linkLatency latency of the link to the parent, in microseconds
+   * \param linkEtx ETX of the link to the parent, ETX * 128
+   */
+  static void UpdateMetrics (RplMetricContainerOption &metricContainer, uint32_t linkLatency, uint16_t linkEtx);
+
+  /**
+   * \brief Cost of a parent once its path queue occupancy is accounted for.
+   *
+   * Only used to compare parents; the advertised rank is left unchanged so
+   * that congestion does not ripple through the DODAG.
+   * \param parentRank the rank of the parent
+   * \param queueLoad the queue occupancy advertised by the parent, 0 to 255
+   * \param weight rank units added at full occupancy
+   * \return the cost, in rank units
+   */
+  static uint32_t ComputeCongestionCost (uint16_t parentRank, uint8_t queueLoad, uint16_t weight);
+
+  /**
+   * \brief Cost of a parent once the residual energy of its path is accounted for.
+   *
+   * Like the congestion cost, it only orders parents and leaves the
+   * advertised rank unchanged.
+   * \param parentRank the rank of the parent
+   * \param energy the lowest residual energy on the parent's path, in percent
+   * \param weight rank units added when that energy is exhausted
+   * \return the cost, in rank units
+   */
+  static uint32_t ComputeEnergyCost (uint16_t parentRank, uint8_t energy, uint16_t weight);
+
 };
 
 class RplObjectiveFunctionOf0 : public RplObjectiveFunction
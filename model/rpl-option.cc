@@ -1,10 +1,15 @@
 
+#include <algorithm>
+#include "ns3/abort.h"
 #include "ns3/header.h"
 #include "ns3/ipv6-address.h"   
 #include "ns3/log.h"
 #include "ns3/rpl-option.h"
 #include "rpl-header.h"
 
+/* P2P Route Discovery Option: the option length must fit in a byte */
+#define P2P_RDO_MAX_ADDRESSES 14
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RplHeaderOptions");
@@ -459,7 +464,8 @@ RplTargetOption::RplTargetOption ()
   NS_LOG_FUNCTION (this);
   SetType (5);
   SetFlags (0);
-  SetPrefixLength (0);
+  SetPrefixLength (128);
+  SetTarget (Ipv6Address::GetAny ());
 }
 
 
@@ -505,40 +511,68 @@ uint8_t RplTargetOption::GetPrefixLength () const
 void RplTargetOption::SetPrefixLength (uint8_t prefixLength)
 {
   NS_LOG_FUNCTION (this << prefixLength);
+  NS_ASSERT_MSG (prefixLength <= 128, "Target prefix length must not exceed 128");
   m_prefixLength = prefixLength;
+  SetLength (GetSerializedSize () - 2);
+}
+
+Ipv6Address RplTargetOption::GetTarget () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_target;
+}
+
+void RplTargetOption::SetTarget (Ipv6Address target)
+{
+  NS_LOG_FUNCTION (this << target);
+  m_target = target;
 }
 
 void RplTargetOption::Print (std::ostream& os) const
 {
   NS_LOG_FUNCTION (this << &os);
-  os << "( type = " << (uint32_t)GetType () << " length = " << (uint32_t)GetLength () << ")";
+  os << "( type = " << (uint32_t)GetType () << " length = " << (uint32_t)GetLength ()
+     << " target = " << m_target << "/" << (uint32_t)m_prefixLength << ")";
 }
 
 uint32_t RplTargetOption::GetSerializedSize () const
 {
   NS_LOG_FUNCTION (this);
-  return 20;
+  // only the significant bytes of the prefix are sent
+  return 4 + (m_prefixLength + 7) / 8;
 }
 
 void RplTargetOption::Serialize (Buffer::Iterator start) const
 {
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
+  uint8_t buf[16];
+
   i.WriteU8 (GetType ());
   i.WriteU8 (GetLength ());
-  i.WriteU8 (m_prefixLength);
   i.WriteU8 (m_flags);
-
+  i.WriteU8 (m_prefixLength);
+  m_target.GetBytes (buf);
+  i.Write (buf, (m_prefixLength + 7) / 8);
 }
 
 uint32_t RplTargetOption::Deserialize (Buffer::Iterator start)
 {
   NS_LOG_FUNCTION (this << &start);
   Buffer::Iterator i = start;
+  uint8_t buf[16];
+
+  memset (buf, 0x00, sizeof (buf));
+
   SetType (i.ReadU8 ());
-  SetLength (i.ReadU8 ());
-  SetPrefixLength (i.ReadU8 ());
+  uint8_t length = i.ReadU8 ();
   SetFlags (i.ReadU8 ());
+  SetPrefixLength (std::min<uint8_t> (i.ReadU8 (), 128));
+  i.Read (buf, (m_prefixLength + 7) / 8);
+  SetLength (length);
+
+  Ipv6Address target (buf);
+  SetTarget (target);
 
   return GetSerializedSize ();
 }
@@ -578,6 +612,7 @@ RplTransitInformationOption::RplTransitInformationOption ()
 {
   NS_LOG_FUNCTION (this);
   SetType (6);
+  SetFlagE (false);
   SetFlags (0);
   SetPathControl (0);
   SetPathSequence (0);
@@ -676,6 +711,7 @@ void RplTransitInformationOption::SetParentAddress (Ipv6Address parentAddress)
 {
   NS_LOG_FUNCTION (this << parentAddress);
   m_parentAddress = parentAddress;
+  SetLength (GetSerializedSize () - 2);
 }
 
 void RplTransitInformationOption::Print (std::ostream& os) const
@@ -687,7 +723,8 @@ void RplTransitInformationOption::Print (std::ostream& os) const
 uint32_t RplTransitInformationOption::GetSerializedSize () const
 {
   NS_LOG_FUNCTION (this);
-  return 22;
+  // the parent address is only carried in non-storing mode
+  return m_parentAddress.IsAny () ? 6 : 22;
 }
 
 
@@ -701,12 +738,15 @@ void RplTransitInformationOption::Serialize (Buffer::Iterator start) const
 
   i.WriteU8 (GetType ());
   i.WriteU8 (GetLength ());
-  i.WriteU8 (m_flags);
+  i.WriteU8 (m_flagE ? (m_flags | (1 << 7)) : (m_flags & 0x7f));
   i.WriteU8 (m_pathControl);
   i.WriteU8 (m_pathSequence);
   i.WriteU8 (m_pathLifetime);
-  m_parentAddress.GetBytes (buf);
-  i.Write (buf, 16);
+  if (!m_parentAddress.IsAny ())
+    {
+      m_parentAddress.GetBytes (buf);
+      i.Write (buf, 16);
+    }
 
 }
 
@@ -717,15 +757,23 @@ uint32_t RplTransitInformationOption::Deserialize (Buffer::Iterator start)
   uint8_t buf[16];
 
   SetType (i.ReadU8 ());
-  SetLength (i.ReadU8 ());
-  SetFlags (i.ReadU8 ());
+  uint8_t length = i.ReadU8 ();
+  uint8_t flags = i.ReadU8 ();
+  SetFlagE ((flags & (1 << 7)) != 0);
+  SetFlags (flags & 0x7f);
   SetPathControl (i.ReadU8 ());
   SetPathSequence (i.ReadU8 ());
-  SetPathLifetime (i.ReadU8 ());  
-  i.Read (buf, 16);
-
-  Ipv6Address parentAddress (buf);
-  SetParentAddress (parentAddress);
+  SetPathLifetime (i.ReadU8 ());
+  if (length >= 20)
+    {
+      i.Read (buf, 16);
+      Ipv6Address parentAddress (buf);
+      SetParentAddress (parentAddress);
+    }
+  else
+    {
+      SetParentAddress (Ipv6Address::GetAny ());
+    }
   return GetSerializedSize ();
 }
 
@@ -875,6 +923,9 @@ uint32_t RplOption::Deserialize (Buffer::Iterator start)
 NS_OBJECT_ENSURE_REGISTERED (RplSolicitedInformationOption);
 
 RplSolicitedInformationOption::RplSolicitedInformationOption ()
+  : m_flagV (false),
+    m_flagI (false),
+    m_flagD (false)
 {
   NS_LOG_FUNCTION (this);
   SetType (7);
@@ -1010,6 +1061,7 @@ void RplSolicitedInformationOption::Serialize (Buffer::Iterator start) const
 
   i.WriteU8 (GetType ());
   i.WriteU8 (GetLength ());
+  i.WriteU8 (m_rplInstanceId);
 
   if (m_flagV)
     {
@@ -1027,10 +1079,9 @@ void RplSolicitedInformationOption::Serialize (Buffer::Iterator start) const
     }
 
   i.WriteU8 (flags);
-  i.WriteU8 (m_rplInstanceId);
-  i.WriteU8 (m_versionNumber);
   m_dodagId.Serialize (buff_dodagId);
   i.Write (buff_dodagId, 16);
+  i.WriteU8 (m_versionNumber);
 }
 
 uint32_t RplSolicitedInformationOption::Deserialize (Buffer::Iterator start)
@@ -1041,13 +1092,859 @@ uint32_t RplSolicitedInformationOption::Deserialize (Buffer::Iterator start)
 
   SetType (i.ReadU8 ());
   SetLength (i.ReadU8 ());
-  m_flags = i.ReadU8 ();
   m_rplInstanceId = i.ReadU8 ();
-  m_versionNumber = i.ReadU8 ();
+  m_flags = i.ReadU8 ();
+  m_flagV = (m_flags & (1 << 7)) != 0;
+  m_flagI = (m_flags & (1 << 6)) != 0;
+  m_flagD = (m_flags & (1 << 5)) != 0;
   i.Read (buf, 16);
   m_dodagId.Set (buf);
+  m_versionNumber = i.ReadU8 ();
 
   return GetSerializedSize ();
 }
 
+NS_OBJECT_ENSURE_REGISTERED (RplP2pRouteDiscoveryOption);
+
+RplP2pRouteDiscoveryOption::RplP2pRouteDiscoveryOption ()
+  : m_flagR (false),
+    m_flagH (true),
+    m_lifetime (0),
+    m_maxRank (0)
+{
+  NS_LOG_FUNCTION (this);
+  SetType (10);
+  SetLength (18);
+}
+
+RplP2pRouteDiscoveryOption::~RplP2pRouteDiscoveryOption ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId RplP2pRouteDiscoveryOption::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RplP2pRouteDiscoveryOption")
+    .SetParent<Icmpv6OptionHeader> ()
+    .SetGroupName ("Rpl")
+    .AddConstructor<RplP2pRouteDiscoveryOption> ()
+  ;
+  return tid;
+}
+
+TypeId RplP2pRouteDiscoveryOption::GetInstanceTypeId () const
+{
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+bool RplP2pRouteDiscoveryOption::GetFlagR () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_flagR;
+}
+
+void RplP2pRouteDiscoveryOption::SetFlagR (bool r)
+{
+  NS_LOG_FUNCTION (this << r);
+  m_flagR = r;
+}
+
+bool RplP2pRouteDiscoveryOption::GetFlagH () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_flagH;
+}
+
+void RplP2pRouteDiscoveryOption::SetFlagH (bool h)
+{
+  NS_LOG_FUNCTION (this << h);
+  m_flagH = h;
+}
+
+uint8_t RplP2pRouteDiscoveryOption::GetLifetime () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_lifetime;
+}
+
+void RplP2pRouteDiscoveryOption::SetLifetime (uint8_t lifetime)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)lifetime);
+  m_lifetime = lifetime & 0x03;
+}
+
+Time RplP2pRouteDiscoveryOption::GetLifetimeDuration () const
+{
+  NS_LOG_FUNCTION (this);
+  return Seconds (1 << (2 * m_lifetime));
+}
+
+uint8_t RplP2pRouteDiscoveryOption::GetMaxRank () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_maxRank;
+}
+
+void RplP2pRouteDiscoveryOption::SetMaxRank (uint8_t maxRank)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)maxRank);
+  m_maxRank = maxRank & 0x3f;
+}
+
+uint8_t RplP2pRouteDiscoveryOption::GetNextHopIndex () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_maxRank;
+}
+
+void RplP2pRouteDiscoveryOption::SetNextHopIndex (uint8_t index)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)index);
+  m_maxRank = index & 0x3f;
+}
+
+Ipv6Address RplP2pRouteDiscoveryOption::GetTarget () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_target;
+}
+
+void RplP2pRouteDiscoveryOption::SetTarget (Ipv6Address target)
+{
+  NS_LOG_FUNCTION (this << target);
+  m_target = target;
+}
+
+bool RplP2pRouteDiscoveryOption::AddAddress (Ipv6Address address)
+{
+  NS_LOG_FUNCTION (this << address);
+  if (m_addresses.size () >= P2P_RDO_MAX_ADDRESSES)
+    {
+      return false;
+    }
+  m_addresses.push_back (address);
+  SetLength (18 + 16 * m_addresses.size ());
+  return true;
+}
+
+const std::vector<Ipv6Address> & RplP2pRouteDiscoveryOption::GetAddresses () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_addresses;
+}
+
+void RplP2pRouteDiscoveryOption::SetAddresses (const std::vector<Ipv6Address> &addresses)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (addresses.size () > P2P_RDO_MAX_ADDRESSES, "Too many addresses for a P2P-RDO");
+  m_addresses = addresses;
+  SetLength (18 + 16 * m_addresses.size ());
+}
+
+void RplP2pRouteDiscoveryOption::Print (std::ostream& os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "( type = " << (uint32_t)GetType () << " length = " << (uint32_t)GetLength () << ")";
+}
+
+uint32_t RplP2pRouteDiscoveryOption::GetSerializedSize () const
+{
+  NS_LOG_FUNCTION (this);
+  return 20 + 16 * m_addresses.size ();
+}
+
+void RplP2pRouteDiscoveryOption::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this << &start);
+  uint8_t buf[16];
+  Buffer::Iterator i = start;
+  uint8_t flags = 0;
+
+  i.WriteU8 (GetType ());
+  i.WriteU8 (GetLength ());
+
+  if (m_flagR)
+    {
+      flags |= (uint8_t)(1 << 7);
+    }
+
+  if (m_flagH)
+    {
+      flags |= (uint8_t)(1 << 6);
+    }
+
+  // N = 0: a single target; Compr = 0: full addresses
+  i.WriteU8 (flags);
+  i.WriteU8 ((m_lifetime << 6) | m_maxRank);
+  m_target.Serialize (buf);
+  i.Write (buf, 16);
+  for (std::vector<Ipv6Address>::const_iterator it = m_addresses.begin (); it != m_addresses.end (); it++)
+    {
+      it->Serialize (buf);
+      i.Write (buf, 16);
+    }
+}
+
+uint32_t RplP2pRouteDiscoveryOption::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this << &start);
+  uint8_t buf[16];
+  Buffer::Iterator i = start;
+
+  SetType (i.ReadU8 ());
+  SetLength (i.ReadU8 ());
+  uint8_t flags = i.ReadU8 ();
+  m_flagR = (flags & (1 << 7)) != 0;
+  m_flagH = (flags & (1 << 6)) != 0;
+  uint8_t lifetimeRank = i.ReadU8 ();
+  m_lifetime = lifetimeRank >> 6;
+  m_maxRank = lifetimeRank & 0x3f;
+  i.Read (buf, 16);
+  m_target.Set (buf);
+
+  m_addresses.clear ();
+  uint8_t nAddresses = GetLength () > 18 ? (GetLength () - 18) / 16 : 0;
+  for (uint8_t n = 0; n < nAddresses; n++)
+    {
+      i.Read (buf, 16);
+      m_addresses.push_back (Ipv6Address (buf));
+    }
+
+  return GetSerializedSize ();
+}
+
+RplMetricObject::RplMetricObject ()
+  : m_type (0),
+    m_flags (0),
+    m_aggregation (0),
+    m_precedence (0),
+    m_nValues (0),
+    m_nTlvs (0)
+{
+}
+
+uint8_t RplMetricObject::GetType () const
+{
+  return m_type;
+}
+
+void RplMetricObject::SetType (uint8_t type)
+{
+  m_type = type;
+}
+
+bool RplMetricObject::GetFlagP () const
+{
+  return m_flags & 0x08;
+}
+
+void RplMetricObject::SetFlagP (bool p)
+{
+  m_flags = p ? (m_flags | 0x08) : (m_flags & ~0x08);
+}
+
+bool RplMetricObject::GetFlagC () const
+{
+  return m_flags & 0x04;
+}
+
+void RplMetricObject::SetFlagC (bool c)
+{
+  m_flags = c ? (m_flags | 0x04) : (m_flags & ~0x04);
+}
+
+bool RplMetricObject::GetFlagO () const
+{
+  return m_flags & 0x02;
+}
+
+void RplMetricObject::SetFlagO (bool o)
+{
+  m_flags = o ? (m_flags | 0x02) : (m_flags & ~0x02);
+}
+
+bool RplMetricObject::GetFlagR () const
+{
+  return m_flags & 0x01;
+}
+
+void RplMetricObject::SetFlagR (bool r)
+{
+  m_flags = r ? (m_flags | 0x01) : (m_flags & ~0x01);
+}
+
+uint8_t RplMetricObject::GetAggregation () const
+{
+  return m_aggregation;
+}
+
+void RplMetricObject::SetAggregation (uint8_t aggregation)
+{
+  m_aggregation = aggregation & 0x07;
+}
+
+uint8_t RplMetricObject::GetPrecedence () const
+{
+  return m_precedence;
+}
+
+void RplMetricObject::SetPrecedence (uint8_t precedence)
+{
+  m_precedence = precedence & 0x0f;
+}
+
+uint8_t RplMetricObject::GetNValues () const
+{
+  return m_nValues;
+}
+
+uint32_t RplMetricObject::GetValue (uint8_t index) const
+{
+  NS_ASSERT (index < m_nValues);
+  return m_values[index];
+}
+
+bool RplMetricObject::AddValue (uint32_t value)
+{
+  if (m_nValues == MAX_VALUES)
+    {
+      return false;
+    }
+  m_values[m_nValues++] = value;
+  return true;
+}
+
+void RplMetricObject::ClearValues ()
+{
+  m_nValues = 0;
+}
+
+uint32_t RplMetricObject::GetEntryValue (uint8_t type, uint32_t entry)
+{
+  switch (type)
+    {
+    case RPL_METRIC_NE:
+      return entry & 0xff;
+    case RPL_METRIC_LQL:
+      return (entry >> 5) & 0x07;
+    default:
+      return entry;
+    }
+}
+
+bool RplMetricObject::Accumulate (uint32_t entry)
+{
+  if (GetFlagR () || m_nValues == 0)
+    {
+      return AddValue (entry);
+    }
+
+  uint32_t current = GetEntryValue (m_type, m_values[0]);
+  uint32_t value = GetEntryValue (m_type, entry);
+  uint64_t combined;
+  switch (m_aggregation)
+    {
+    case RPL_AGGREGATION_MAXIMUM:
+      if (value > current)
+        {
+          m_values[0] = entry;
+        }
+      return true;
+    case RPL_AGGREGATION_MINIMUM:
+      if (value < current)
+        {
+          m_values[0] = entry;
+        }
+      return true;
+    case RPL_AGGREGATION_MULTIPLICATIVE:
+      combined = (uint64_t)m_values[0] * entry;
+      break;
+    default:
+      combined = (uint64_t)m_values[0] + entry;
+      break;
+    }
+
+  // saturate to the width of the field on the wire
+  uint64_t limit = 0xffffffff;
+  if (m_type == RPL_METRIC_HC)
+    {
+      limit = 0xff;
+    }
+  else if (m_type == RPL_METRIC_ETX || m_type == RPL_METRIC_NE)
+    {
+      limit = 0xffff;
+    }
+  else if (m_type == RPL_METRIC_LQL)
+    {
+      limit = 0xff;
+    }
+  m_values[0] = (uint32_t)std::min (combined, limit);
+  return true;
+}
+
+bool RplMetricObject::GetAggregatedValue (uint32_t &value) const
+{
+  if (m_nValues == 0)
+    {
+      return false;
+    }
+
+  uint64_t result = GetEntryValue (m_type, m_values[0]);
+  for (uint8_t j = 1; j < m_nValues; j++)
+    {
+      uint32_t next = GetEntryValue (m_type, m_values[j]);
+      switch (m_aggregation)
+        {
+        case RPL_AGGREGATION_MAXIMUM:
+          result = std::max<uint64_t> (result, next);
+          break;
+        case RPL_AGGREGATION_MINIMUM:
+          result = std::min<uint64_t> (result, next);
+          break;
+        case RPL_AGGREGATION_MULTIPLICATIVE:
+          result = std::min<uint64_t> (result * next, 0xffffffff);
+          break;
+        default:
+          result = std::min<uint64_t> (result + next, 0xffffffff);
+          break;
+        }
+    }
+  value = (uint32_t)result;
+  return true;
+}
+
+bool RplMetricObject::SetTlv (uint8_t type, uint8_t value)
+{
+  for (uint8_t j = 0; j < m_nTlvs; j++)
+    {
+      if (m_tlvTypes[j] == type)
+        {
+          m_tlvValues[j] = value;
+          return true;
+        }
+    }
+  if (m_nTlvs == MAX_TLVS)
+    {
+      return false;
+    }
+  m_tlvTypes[m_nTlvs] = type;
+  m_tlvValues[m_nTlvs] = value;
+  m_nTlvs++;
+  return true;
+}
+
+bool RplMetricObject::GetTlv (uint8_t type, uint8_t &value) const
+{
+  for (uint8_t j = 0; j < m_nTlvs; j++)
+    {
+      if (m_tlvTypes[j] == type)
+        {
+          value = m_tlvValues[j];
+          return true;
+        }
+    }
+  return false;
+}
+
+uint8_t RplMetricObject::GetBodySize () const
+{
+  switch (m_type)
+    {
+    case RPL_METRIC_NSA:
+      // reserved, flags and 3-byte TLVs
+      return 2 + 3 * m_nTlvs;
+    case RPL_METRIC_NE:
+    case RPL_METRIC_HC:
+    case RPL_METRIC_ETX:
+      return 2 * m_nValues;
+    case RPL_METRIC_LQL:
+      // reserved byte, then one byte per entry
+      return 1 + m_nValues;
+    default:
+      return 4 * m_nValues;
+    }
+}
+
+uint32_t RplMetricObject::GetSerializedSize () const
+{
+  return 4 + GetBodySize ();
+}
+
+void RplMetricObject::Serialize (Buffer::Iterator &i) const
+{
+  i.WriteU8 (m_type);
+  i.WriteHtonU16 (((uint16_t)(m_flags & 0x0f) << 7) | ((uint16_t)m_aggregation << 4) | m_precedence);
+  i.WriteU8 (GetBodySize ());
+
+  switch (m_type)
+    {
+    case RPL_METRIC_NSA:
+      i.WriteU8 (0);
+      i.WriteU8 (0);
+      for (uint8_t j = 0; j < m_nTlvs; j++)
+        {
+          i.WriteU8 (m_tlvTypes[j]);
+          i.WriteU8 (1);
+          i.WriteU8 (m_tlvValues[j]);
+        }
+      break;
+    case RPL_METRIC_NE:
+    case RPL_METRIC_ETX:
+      for (uint8_t j = 0; j < m_nValues; j++)
+        {
+          i.WriteHtonU16 (m_values[j]);
+        }
+      break;
+    case RPL_METRIC_HC:
+      // 4 reserved bits, 4 flag bits, hop count
+      for (uint8_t j = 0; j < m_nValues; j++)
+        {
+          i.WriteU8 (0);
+          i.WriteU8 (m_values[j]);
+        }
+      break;
+    case RPL_METRIC_LQL:
+      i.WriteU8 (0);
+      for (uint8_t j = 0; j < m_nValues; j++)
+        {
+          i.WriteU8 (m_values[j]);
+        }
+      break;
+    default:
+      for (uint8_t j = 0; j < m_nValues; j++)
+        {
+          i.WriteHtonU32 (m_values[j]);
+        }
+      break;
+    }
+}
+
+bool RplMetricObject::Deserialize (Buffer::Iterator &i)
+{
+  m_type = i.ReadU8 ();
+  uint16_t field = i.ReadNtohU16 ();
+  m_flags = (field >> 7) & 0x0f;
+  m_aggregation = (field >> 4) & 0x07;
+  m_precedence = field & 0x0f;
+  uint8_t length = i.ReadU8 ();
+  m_nValues = 0;
+  m_nTlvs = 0;
+
+  switch (m_type)
+    {
+    case RPL_METRIC_NSA:
+      {
+        if (length < 2)
+          {
+            i.Next (length);
+            return false;
+          }
+        i.Next (2);
+        uint8_t left = length - 2;
+        while (left >= 2)
+          {
+            uint8_t type = i.ReadU8 ();
+            uint8_t tlvLength = i.ReadU8 ();
+            left -= 2;
+            if (tlvLength > left)
+              {
+                i.Next (left);
+                return true;
+              }
+            if (tlvLength == 1 && m_nTlvs < MAX_TLVS)
+              {
+                m_tlvTypes[m_nTlvs] = type;
+                m_tlvValues[m_nTlvs] = i.ReadU8 ();
+                m_nTlvs++;
+              }
+            else
+              {
+                i.Next (tlvLength);
+              }
+            left -= tlvLength;
+          }
+        i.Next (left);
+        return true;
+      }
+    case RPL_METRIC_NE:
+    case RPL_METRIC_ETX:
+      for (; length >= 2 && m_nValues < MAX_VALUES; length -= 2)
+        {
+          m_values[m_nValues++] = i.ReadNtohU16 ();
+        }
+      i.Next (length);
+      return true;
+    case RPL_METRIC_HC:
+      for (; length >= 2 && m_nValues < MAX_VALUES; length -= 2)
+        {
+          i.Next (1);
+          m_values[m_nValues++] = i.ReadU8 ();
+        }
+      i.Next (length);
+      return true;
+    case RPL_METRIC_LATENCY:
+      for (; length >= 4 && m_nValues < MAX_VALUES; length -= 4)
+        {
+          m_values[m_nValues++] = i.ReadNtohU32 ();
+        }
+      i.Next (length);
+      return true;
+    case RPL_METRIC_LQL:
+      if (length == 0)
+        {
+          return false;
+        }
+      i.Next (1);
+      for (length--; length >= 1 && m_nValues < MAX_VALUES; length--)
+        {
+          m_values[m_nValues++] = i.ReadU8 ();
+        }
+      i.Next (length);
+      return true;
+    default:
+      i.Next (length);
+      return false;
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (RplMetricContainerOption);
+
+RplMetricContainerOption::RplMetricContainerOption ()
+  : m_nObjects (0)
+{
+  NS_LOG_FUNCTION (this);
+  SetType (2);
+  SetLength (0);
+}
+
+RplMetricContainerOption::~RplMetricContainerOption ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId RplMetricContainerOption::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RplMetricContainerOption")
+    .SetParent<Icmpv6OptionHeader> ()
+    .SetGroupName ("Rpl")
+    .AddConstructor<RplMetricContainerOption> ()
+  ;
+  return tid;
+}
+
+TypeId RplMetricContainerOption::GetInstanceTypeId () const
+{
+  NS_LOG_FUNCTION (this);
+  return GetTypeId ();
+}
+
+uint8_t RplMetricContainerOption::FindIndex (uint8_t type, bool constraint) const
+{
+  for (uint8_t j = 0; j < m_nObjects; j++)
+    {
+      if (m_objects[j].GetType () == type && m_objects[j].GetFlagC () == constraint)
+        {
+          return j;
+        }
+    }
+  return MAX_OBJECTS;
+}
+
+bool RplMetricContainerOption::AddMetricObject (const RplMetricObject &object)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)object.GetType ());
+  uint8_t index = FindIndex (object.GetType (), object.GetFlagC ());
+  if (index == MAX_OBJECTS)
+    {
+      if (m_nObjects == MAX_OBJECTS)
+        {
+          return false;
+        }
+      index = m_nObjects++;
+    }
+  m_objects[index] = object;
+  SetLength (GetSerializedSize () - 2);
+  return true;
+}
+
+uint8_t RplMetricContainerOption::GetNMetricObjects () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_nObjects;
+}
+
+const RplMetricObject &RplMetricContainerOption::GetMetricObject (uint8_t index) const
+{
+  NS_LOG_FUNCTION (this << (uint32_t)index);
+  NS_ASSERT (index < m_nObjects);
+  return m_objects[index];
+}
+
+bool RplMetricContainerOption::FindMetricObject (uint8_t type, RplMetricObject &object) const
+{
+  NS_LOG_FUNCTION (this << (uint32_t)type);
+  uint8_t index = FindIndex (type, false);
+  if (index == MAX_OBJECTS)
+    {
+      return false;
+    }
+  object = m_objects[index];
+  return true;
+}
+
+bool RplMetricContainerOption::FindConstraint (uint8_t type, RplMetricObject &object) const
+{
+  NS_LOG_FUNCTION (this << (uint32_t)type);
+  uint8_t index = FindIndex (type, true);
+  if (index == MAX_OBJECTS)
+    {
+      return false;
+    }
+  object = m_objects[index];
+  return true;
+}
+
+bool RplMetricContainerOption::GetMetricValue (uint8_t type, uint32_t &value) const
+{
+  NS_LOG_FUNCTION (this << (uint32_t)type);
+  uint8_t index = FindIndex (type, false);
+  return index != MAX_OBJECTS && m_objects[index].GetAggregatedValue (value);
+}
+
+bool RplMetricContainerOption::AccumulateMetric (uint8_t type, uint32_t entry)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)type << entry);
+  uint8_t index = FindIndex (type, false);
+  if (index == MAX_OBJECTS)
+    {
+      return false;
+    }
+  m_objects[index].Accumulate (entry);
+  SetLength (GetSerializedSize () - 2);
+  return true;
+}
+
+void RplMetricContainerOption::SetRootLoad (uint8_t load)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)load);
+  RplMetricObject nsa;
+  FindMetricObject (RPL_METRIC_NSA, nsa);
+  nsa.SetType (RPL_METRIC_NSA);
+  nsa.SetTlv (RPL_NSA_TLV_ROOT_LOAD, load);
+  AddMetricObject (nsa);
+}
+
+bool RplMetricContainerOption::GetRootLoad (uint8_t &load) const
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t index = FindIndex (RPL_METRIC_NSA, false);
+  return index != MAX_OBJECTS && m_objects[index].GetTlv (RPL_NSA_TLV_ROOT_LOAD, load);
+}
+
+void RplMetricContainerOption::SetQueueLoad (uint8_t load)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)load);
+  RplMetricObject nsa;
+  FindMetricObject (RPL_METRIC_NSA, nsa);
+  nsa.SetType (RPL_METRIC_NSA);
+  nsa.SetTlv (RPL_NSA_TLV_QUEUE_LOAD, load);
+  AddMetricObject (nsa);
+}
+
+bool RplMetricContainerOption::GetQueueLoad (uint8_t &load) const
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t index = FindIndex (RPL_METRIC_NSA, false);
+  return index != MAX_OBJECTS && m_objects[index].GetTlv (RPL_NSA_TLV_QUEUE_LOAD, load);
+}
+
+void RplMetricContainerOption::SetNodeEnergy (uint8_t energy)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)energy);
+  RplMetricObject ne;
+  ne.SetType (RPL_METRIC_NE);
+  ne.SetAggregation (RPL_AGGREGATION_MINIMUM);
+  // I set, T battery, E set: the estimation in E_E is valid
+  ne.AddValue (RPL_NE_FLAG_I | RPL_NE_TYPE_BATTERY | RPL_NE_FLAG_E | std::min<uint8_t> (energy, 100));
+  AddMetricObject (ne);
+}
+
+bool RplMetricContainerOption::GetNodeEnergy (uint8_t &energy) const
+{
+  NS_LOG_FUNCTION (this);
+  uint8_t index = FindIndex (RPL_METRIC_NE, false);
+  if (index == MAX_OBJECTS || m_objects[index].GetNValues () == 0 ||
+      !(m_objects[index].GetValue (0) & RPL_NE_FLAG_E))
+    {
+      return false;
+    }
+  uint32_t value;
+  m_objects[index].GetAggregatedValue (value);
+  energy = (uint8_t)value;
+  return true;
+}
+
+void RplMetricContainerOption::Print (std::ostream& os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "( type = " << (uint32_t)GetType () << " length = " << (uint32_t)GetLength () << " objects = " << (uint32_t)m_nObjects << ")";
+}
+
+uint32_t RplMetricContainerOption::GetSerializedSize () const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t size = 2;
+  for (uint8_t j = 0; j < m_nObjects; j++)
+    {
+      size += m_objects[j].GetSerializedSize ();
+    }
+  return size;
+}
+
+void RplMetricContainerOption::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this << &start);
+  Buffer::Iterator i = start;
+
+  i.WriteU8 (GetType ());
+  i.WriteU8 (GetSerializedSize () - 2);
+
+  for (uint8_t j = 0; j < m_nObjects; j++)
+    {
+      m_objects[j].Serialize (i);
+    }
+}
+
+uint32_t RplMetricContainerOption::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this << &start);
+  Buffer::Iterator i = start;
+
+  SetType (i.ReadU8 ());
+  uint8_t length = i.ReadU8 ();
+  SetLength (length);
+  m_nObjects = 0;
+
+  uint32_t left = length;
+  while (left >= 4)
+    {
+      RplMetricObject object;
+      Buffer::Iterator objectStart = i;
+      bool known = object.Deserialize (i);
+      uint32_t read = i.GetDistanceFrom (objectStart);
+      if (read > left)
+        {
+          break;
+        }
+      left -= read;
+      if (known && FindIndex (object.GetType (), object.GetFlagC ()) == MAX_OBJECTS && m_nObjects < MAX_OBJECTS)
+        {
+          m_objects[m_nObjects++] = object;
+        }
+    }
+
+  return 2 + length;
+}
+
 }
@@ -2,10 +2,12 @@
 #define RPL_HEADER_OPTION_H
 
 #include <list>
+#include <vector>
 #include "ns3/header.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/packet.h"
 #include "ns3/icmpv6-header.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
@@ -550,6 +552,19 @@ public:
    */
   void SetPrefixLength (uint8_t prefixLength);
 
+  /**
+   * \brief Get the target prefix.
+   * \return the target prefix
+   */
+  Ipv6Address GetTarget () const;
+
+  /**
+   * \brief Set the target prefix. Only the first prefix length bits are
+   * carried on the wire.
+   * \param target the target prefix
+   */
+  void SetTarget (Ipv6Address target);
+
   /**
    * \brief Print informations.
    * \param os output stream
@@ -587,6 +602,11 @@ private:
    */
   uint8_t m_prefixLength;
 
+  /**
+   * \brief The target prefix
+   */
+  Ipv6Address m_target;
+
 
 };
 
@@ -1155,6 +1175,733 @@ private:
 };
 
 
+/**
+ * \ingroup rpl
+ *
+ * \brief P2P Route Discovery Option (RFC 6997)
+ *
+ * Carried in the DIOs of a temporary DODAG, where the address vector
+ * accumulates the routers crossed from the origin, and in the DRO, where it
+ * holds the route found from the origin to the target. The addresses are
+ * always carried in full (Compr = 0), and a single target is supported
+ * (N = 0).
+ */
+
+/*
+*  \brief (P2P Route Discovery Option) Format
+   \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |  Type = 0x0A  | Option Length |R|H| N | Compr | L |MaxRank/NH |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                                                               |
+  +                                                               +
+  |                                                               |
+  +                           TargetAddr                          +
+  |                                                               |
+  +                                                               +
+  |                                                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                                                               |
+  .                                                               .
+  .                        Address[1..n]                          .
+  .                                                               .
+  |                                                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+
+class RplP2pRouteDiscoveryOption: public Icmpv6OptionHeader
+{
+public:
+  /**
+   * \brief Constructor.
+   */
+  RplP2pRouteDiscoveryOption ();
+
+  /**
+   * \brief Destructor.
+   */
+  virtual ~RplP2pRouteDiscoveryOption ();
+
+  /**
+   * \brief Get the UID of this class.
+   * \return UID
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief Get the instance type ID.
+   * \return instance type ID
+   */
+  virtual TypeId GetInstanceTypeId () const;
+
+  /**
+   * \brief Get the r (reply) flag.
+   * \return r flag
+   */
+  bool GetFlagR () const;
+
+  /**
+   * \brief Set the r (reply) flag.
+   * \param r value, true if the target must answer with a DRO
+   */
+  void SetFlagR (bool r);
+
+  /**
+   * \brief Get the h (hop-by-hop) flag.
+   * \return h flag
+   */
+  bool GetFlagH () const;
+
+  /**
+   * \brief Set the h (hop-by-hop) flag.
+   * \param h value, true for a hop-by-hop route, false for a source route
+   */
+  void SetFlagH (bool h);
+
+  /**
+   * \brief Get the lifetime of the temporary DODAG.
+   * \return the L field, 0 to 3
+   */
+  uint8_t GetLifetime () const;
+
+  /**
+   * \brief Set the lifetime of the temporary DODAG.
+   * \param lifetime the L field: 1 s, 4 s, 16 s or 64 s for 0 to 3
+   */
+  void SetLifetime (uint8_t lifetime);
+
+  /**
+   * \brief Get the lifetime of the temporary DODAG.
+   * \return the time encoded by the L field
+   */
+  Time GetLifetimeDuration () const;
+
+  /**
+   * \brief Get the highest rank a router may have in the temporary DODAG (DIO).
+   * \return the MaxRank field, in DAGRank units
+   */
+  uint8_t GetMaxRank () const;
+
+  /**
+   * \brief Set the highest rank a router may have in the temporary DODAG (DIO).
+   * \param maxRank the MaxRank field, in DAGRank units, 0 to 63
+   */
+  void SetMaxRank (uint8_t maxRank);
+
+  /**
+   * \brief Get the index of the next hop in the address vector (DRO).
+   * \return the NH field
+   */
+  uint8_t GetNextHopIndex () const;
+
+  /**
+   * \brief Set the index of the next hop in the address vector (DRO).
+   * \param index the NH field, 0 to 63
+   */
+  void SetNextHopIndex (uint8_t index);
+
+  /**
+   * \brief Get the target address.
+   * \return the target
+   */
+  Ipv6Address GetTarget () const;
+
+  /**
+   * \brief Set the target address.
+   * \param target the target
+   */
+  void SetTarget (Ipv6Address target);
+
+  /**
+   * \brief Append an address to the address vector.
+   * \param address the address
+   * \return false if the option is full
+   */
+  bool AddAddress (Ipv6Address address);
+
+  /**
+   * \brief Get the address vector.
+   * \return the addresses, from the origin side
+   */
+  const std::vector<Ipv6Address> & GetAddresses () const;
+
+  /**
+   * \brief Replace the address vector.
+   * \param addresses the addresses, from the origin side
+   */
+  void SetAddresses (const std::vector<Ipv6Address> &addresses);
+
+  /**
+   * \brief Print informations.
+   * \param os output stream
+   */
+  virtual void Print (std::ostream& os) const;
+
+  /**
+   * \brief Get the serialized size.
+   * \return serialized size
+   */
+  virtual uint32_t GetSerializedSize () const;
+
+  /**
+   * \brief Serialize the packet.
+   * \param start start offset
+   */
+  virtual void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Deserialize the packet.
+   * \param start start offset
+   * \return length of packet
+   */
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  /**
+   * \brief The R flag.
+   */
+  bool m_flagR;
+
+  /**
+   * \brief The H flag.
+   */
+  bool m_flagH;
+
+  /**
+   * \brief The L field.
+   */
+  uint8_t m_lifetime;
+
+  /**
+   * \brief The MaxRank/NH field.
+   */
+  uint8_t m_maxRank;
+
+  /**
+   * \brief The target address.
+   */
+  Ipv6Address m_target;
+
+  /**
+   * \brief The address vector.
+   */
+  std::vector<Ipv6Address> m_addresses;
+
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Routing metric/constraint object types (RFC 6551).
+ */
+enum RplMetricType
+{
+  RPL_METRIC_NSA = 1,      ///< Node State and Attribute object
+  RPL_METRIC_NE = 2,       ///< Node Energy object
+  RPL_METRIC_HC = 3,       ///< Hop Count object
+  RPL_METRIC_LATENCY = 5,  ///< Latency object, in microseconds
+  RPL_METRIC_LQL = 6,      ///< Link Quality Level object
+  RPL_METRIC_ETX = 7       ///< ETX object, ETX * 128
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief How a routing metric is aggregated along the path (A field).
+ */
+enum RplMetricAggregation
+{
+  RPL_AGGREGATION_ADDITIVE = 0,
+  RPL_AGGREGATION_MAXIMUM = 1,
+  RPL_AGGREGATION_MINIMUM = 2,
+  RPL_AGGREGATION_MULTIPLICATIVE = 3
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief TLVs carried in the Node State and Attribute object.
+ */
+enum RplNsaTlvType
+{
+  RPL_NSA_TLV_ROOT_LOAD = 1,  ///< DODAG root load, 0 (idle) to 255 (saturated)
+  RPL_NSA_TLV_QUEUE_LOAD = 2  ///< highest queue occupancy on the path to the root, 0 (empty) to 255 (full)
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Flags of a Node Energy entry, above the 8-bit E_E field.
+ */
+enum RplNodeEnergyFlags
+{
+  RPL_NE_FLAG_E = 0x0100,        ///< E_E holds a valid estimation
+  RPL_NE_TYPE_MAINS = 0x0000,    ///< T: mains-powered
+  RPL_NE_TYPE_BATTERY = 0x0200,  ///< T: battery-powered
+  RPL_NE_TYPE_SCAVENGER = 0x0400, ///< T: energy scavenger
+  RPL_NE_FLAG_I = 0x0800         ///< the T field is meaningful
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Routing metric/constraint object carried in a DAG Metric Container.
+ *
+ * Values and TLVs are kept in fixed arrays so that encoding and decoding
+ * a container never allocates. An aggregated object (R flag clear) holds a
+ * single value; a recorded object (R flag set) holds one entry per hop.
+ *
+ * Entries are stored in their wire format: a Node Energy entry is the
+ * 16-bit flags and E_E field, a Link Quality Level entry is the 3-bit
+ * value followed by the 5-bit counter, the other objects store the metric
+ * itself.
+ */
+
+/*
+*  \brief (Routing Metric/Constraint Object) Format
+   \verbatim
+   0                   1                   2                   3
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |Routing-MC-Type|Res Flags|P|C|O|R| A   |  Prec |    Length     |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  |                                                               |
+  //                        (object body)                        //
+  |                                                               |
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+  \endverbatim
+ */
+
+class RplMetricObject
+{
+public:
+  /**
+   * \brief Maximum number of values (recorded entries) per object.
+   */
+  static const uint8_t MAX_VALUES = 8;
+
+  /**
+   * \brief Maximum number of single-octet TLVs per object.
+   */
+  static const uint8_t MAX_TLVS = 4;
+
+  /**
+   * \brief Constructor.
+   */
+  RplMetricObject ();
+
+  /**
+   * \brief Get the Routing-MC-Type.
+   * \return the object type
+   */
+  uint8_t GetType () const;
+
+  /**
+   * \brief Set the Routing-MC-Type.
+   * \param type the object type
+   */
+  void SetType (uint8_t type);
+
+  /**
+   * \brief Get the p flag.
+   * \return p flag
+   */
+  bool GetFlagP () const;
+
+  /**
+   * \brief Set the p flag.
+   * \param p value
+   */
+  void SetFlagP (bool p);
+
+  /**
+   * \brief Get the c flag (constraint when set, metric otherwise).
+   * \return c flag
+   */
+  bool GetFlagC () const;
+
+  /**
+   * \brief Set the c flag.
+   * \param c value
+   */
+  void SetFlagC (bool c);
+
+  /**
+   * \brief Get the o flag.
+   * \return o flag
+   */
+  bool GetFlagO () const;
+
+  /**
+   * \brief Set the o flag.
+   * \param o value
+   */
+  void SetFlagO (bool o);
+
+  /**
+   * \brief Get the r flag (recorded when set, aggregated otherwise).
+   * \return r flag
+   */
+  bool GetFlagR () const;
+
+  /**
+   * \brief Set the r flag.
+   * \param r value
+   */
+  void SetFlagR (bool r);
+
+  /**
+   * \brief Get the A (aggregation) field.
+   * \return the aggregation value
+   */
+  uint8_t GetAggregation () const;
+
+  /**
+   * \brief Set the A (aggregation) field.
+   * \param aggregation the aggregation value
+   */
+  void SetAggregation (uint8_t aggregation);
+
+  /**
+   * \brief Get the precedence field.
+   * \return the precedence value
+   */
+  uint8_t GetPrecedence () const;
+
+  /**
+   * \brief Set the precedence field.
+   * \param precedence the precedence value
+   */
+  void SetPrecedence (uint8_t precedence);
+
+  /**
+   * \brief Get the number of values.
+   * \return the number of values
+   */
+  uint8_t GetNValues () const;
+
+  /**
+   * \brief Get a value.
+   * \param index the value index
+   * \return the value
+   */
+  uint32_t GetValue (uint8_t index) const;
+
+  /**
+   * \brief Append a value.
+   * \param value the value
+   * \return false if the object is full
+   */
+  bool AddValue (uint32_t value);
+
+  /**
+   * \brief Remove all values.
+   */
+  void ClearValues ();
+
+  /**
+   * \brief Add the contribution of one hop to the object.
+   *
+   * A recorded object appends the entry, an aggregated one combines it
+   * with its current value according to the A field.
+   * \param entry the entry of the hop
+   * \return false if a recorded object is full
+   */
+  bool Accumulate (uint32_t entry);
+
+  /**
+   * \brief Get the path value of the object.
+   *
+   * A recorded object is folded according to the A field.
+   * \param value the path value, if the object has any entry
+   * \return true if the object has at least one entry
+   */
+  bool GetAggregatedValue (uint32_t &value) const;
+
+  /**
+   * \brief Get the metric value of an entry.
+   * \param type the object type
+   * \param entry the entry, in wire format
+   * \return E_E for Node Energy, the level for Link Quality Level, the entry otherwise
+   */
+  static uint32_t GetEntryValue (uint8_t type, uint32_t entry);
+
+  /**
+   * \brief Set a single-octet TLV, replacing any previous one of the same type.
+   * \param type the TLV type
+   * \param value the TLV value
+   * \return false if the object is full
+   */
+  bool SetTlv (uint8_t type, uint8_t value);
+
+  /**
+   * \brief Get a single-octet TLV.
+   * \param type the TLV type
+   * \param value the TLV value, if found
+   * \return true if the TLV is present
+   */
+  bool GetTlv (uint8_t type, uint8_t &value) const;
+
+  /**
+   * \brief Get the serialized size, object header included.
+   * \return serialized size
+   */
+  uint32_t GetSerializedSize () const;
+
+  /**
+   * \brief Serialize the object.
+   * \param i buffer iterator, advanced past the object
+   */
+  void Serialize (Buffer::Iterator &i) const;
+
+  /**
+   * \brief Deserialize the object.
+   * \param i buffer iterator, advanced past the object
+   * \return false if the object type is not supported (its body is skipped)
+   */
+  bool Deserialize (Buffer::Iterator &i);
+
+private:
+  /**
+   * \brief Get the size of the object body.
+   * \return body size
+   */
+  uint8_t GetBodySize () const;
+
+  /**
+   * \brief The Routing-MC-Type.
+   */
+  uint8_t m_type;
+
+  /**
+   * \brief The P, C, O and R flags.
+   */
+  uint8_t m_flags;
+
+  /**
+   * \brief The A field.
+   */
+  uint8_t m_aggregation;
+
+  /**
+   * \brief The precedence field.
+   */
+  uint8_t m_precedence;
+
+  /**
+   * \brief The number of values.
+   */
+  uint8_t m_nValues;
+
+  /**
+   * \brief The values.
+   */
+  uint32_t m_values[MAX_VALUES];
+
+  /**
+   * \brief The number of TLVs.
+   */
+  uint8_t m_nTlvs;
+
+  /**
+   * \brief The TLV types.
+   */
+  uint8_t m_tlvTypes[MAX_TLVS];
+
+  /**
+   * \brief The TLV values.
+   */
+  uint8_t m_tlvValues[MAX_TLVS];
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief DAG Metric Container option.
+ */
+
+/*
+*  \brief (DAG Metric Container) Format
+   \verbatim
+   0                   1                   2
+   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-
+  |  Type = 0x02  | Option Length | Metric Data
+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-
+  \endverbatim
+ */
+
+class RplMetricContainerOption: public Icmpv6OptionHeader
+{
+public:
+  /**
+   * \brief Maximum number of metric objects in a container.
+   */
+  static const uint8_t MAX_OBJECTS = 6;
+
+  /**
+   * \brief Constructor.
+   */
+
+  RplMetricContainerOption ();
+
+  /**
+   * \brief Destructor.
+   */
+  virtual ~RplMetricContainerOption ();
+
+  /**
+   * \brief Get the UID of this class.
+   * \return UID
+   */
+  static TypeId GetTypeId ();
+
+  /**
+   * \brief Get the instance type ID.
+   * \return instance type ID
+   */
+  virtual TypeId GetInstanceTypeId () const;
+
+  /**
+   * \brief Add a metric object, replacing any previous one of the same type
+   * and kind (metric or constraint).
+   * \param object the metric object
+   * \return false if the container is full
+   */
+  bool AddMetricObject (const RplMetricObject &object);
+
+  /**
+   * \brief Get the number of metric objects.
+   * \return the number of metric objects
+   */
+  uint8_t GetNMetricObjects () const;
+
+  /**
+   * \brief Get a metric object.
+   * \param index the object index
+   * \return the metric object
+   */
+  const RplMetricObject &GetMetricObject (uint8_t index) const;
+
+  /**
+   * \brief Find a metric object by type.
+   * \param type the object type
+   * \param object the metric object, if found
+   * \return true if the object is present
+   */
+  bool FindMetricObject (uint8_t type, RplMetricObject &object) const;
+
+  /**
+   * \brief Find a constraint object (C flag set) by type.
+   * \param type the object type
+   * \param object the constraint object, if found
+   * \return true if the constraint is present
+   */
+  bool FindConstraint (uint8_t type, RplMetricObject &object) const;
+
+  /**
+   * \brief Get the path value of a metric object.
+   * \param type the object type
+   * \param value the path value, if found
+   * \return true if the metric is present and has a value
+   */
+  bool GetMetricValue (uint8_t type, uint32_t &value) const;
+
+  /**
+   * \brief Add the contribution of one hop to a metric object.
+   * \param type the object type
+   * \param entry the entry of the hop
+   * \return true if the metric is present
+   */
+  bool AccumulateMetric (uint8_t type, uint32_t entry);
+
+  /**
+   * \brief Set the DODAG root load (NSA object TLV).
+   * \param load the root load, 0 (idle) to 255 (saturated)
+   */
+  void SetRootLoad (uint8_t load);
+
+  /**
+   * \brief Get the DODAG root load.
+   * \param load the root load, if present
+   * \return true if the root load is present
+   */
+  bool GetRootLoad (uint8_t &load) const;
+
+  /**
+   * \brief Set the path queue occupancy (NSA object TLV).
+   * \param load the occupancy, 0 (empty) to 255 (full)
+   */
+  void SetQueueLoad (uint8_t load);
+
+  /**
+   * \brief Get the path queue occupancy.
+   * \param load the occupancy, if present
+   * \return true if the occupancy is present
+   */
+  bool GetQueueLoad (uint8_t &load) const;
+
+  /**
+   * \brief Set the path residual energy (Node Energy object, minimum aggregation).
+   * \param energy the lowest residual energy on the path, in percent
+   */
+  void SetNodeEnergy (uint8_t energy);
+
+  /**
+   * \brief Get the path residual energy.
+   * \param energy the E_E field, in percent, if present and valid
+   * \return true if the energy is present
+   */
+  bool GetNodeEnergy (uint8_t &energy) const;
+
+  /**
+   * \brief Print informations.
+   * \param os output stream
+   */
+  virtual void Print (std::ostream& os) const;
+
+  /**
+   * \brief Get the serialized size.
+   * \return serialized size
+   */
+  virtual uint32_t GetSerializedSize () const;
+
+  /**
+   * \brief Serialize the packet.
+   * \param start start offset
+   */
+  virtual void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Deserialize the packet.
+   * \param start start offset
+   * \return length of packet
+   */
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  /**
+   * \brief Find the index of a metric or constraint object.
+   * \param type the object type
+   * \param constraint true to look for a constraint object
+   * \return the index, or MAX_OBJECTS if not present
+   */
+  uint8_t FindIndex (uint8_t type, bool constraint) const;
+
+  /**
+   * \brief The number of metric objects.
+   */
+  uint8_t m_nObjects;
+
+  /**
+   * \brief The metric objects.
+   */
+  RplMetricObject m_objects[MAX_OBJECTS];
+};
+
 }
 
 #endif
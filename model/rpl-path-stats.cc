@@ -0,0 +1,84 @@
+#include "rpl-path-stats.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RplPathStats");
+
+RplPathStats::RplPathStats()
+  : m_next (0),
+    m_size (0),
+    m_overwritten (0)
+{
+}
+
+void RplPathStats::SetCapacity(uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+  std::vector<RplPathRecord> (capacity).swap (m_records);
+  m_next = 0;
+  m_size = 0;
+  m_overwritten = 0;
+}
+
+uint32_t RplPathStats::GetCapacity() const
+{
+  return m_records.size ();
+}
+
+void RplPathStats::Record(const RplPathRecord &record)
+{
+  NS_ASSERT (IsEnabled ());
+  m_records[m_next] = record;
+  m_next = (m_next + 1) % m_records.size ();
+  if (m_size < m_records.size ())
+    {
+      m_size++;
+    }
+  else
+    {
+      m_overwritten++;
+    }
+}
+
+uint32_t RplPathStats::GetNRecords() const
+{
+  return m_size;
+}
+
+const RplPathRecord &RplPathStats::GetRecord(uint32_t index) const
+{
+  NS_ASSERT (index < m_size);
+  // the oldest record is the one written next, once the buffer is full
+  uint32_t oldest = (m_size < m_records.size ()) ? 0 : m_next;
+  return m_records[(oldest + index) % m_records.size ()];
+}
+
+uint64_t RplPathStats::GetNOverwritten() const
+{
+  return m_overwritten;
+}
+
+uint32_t RplPathStats::FlowKey(Ipv6Address source, Ipv6Address destination, uint8_t protocol,
+                               uint16_t sourcePort, uint16_t destinationPort)
+{
+  uint8_t buf[37];
+  source.GetBytes (buf);
+  destination.GetBytes (buf + 16);
+  buf[32] = protocol;
+  buf[33] = sourcePort >> 8;
+  buf[34] = sourcePort & 0xff;
+  buf[35] = destinationPort >> 8;
+  buf[36] = destinationPort & 0xff;
+
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < sizeof (buf); i++)
+    {
+      hash = (hash ^ buf[i]) * 16777619u;
+    }
+  return hash;
+}
+
+}
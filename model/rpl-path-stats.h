@@ -0,0 +1,133 @@
+#ifndef RPL_PATH_STATS_H
+#define RPL_PATH_STATS_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/ipv6-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup rpl
+ *
+ * \brief A packet forwarded by a node, as recorded for path statistics.
+ *
+ * The records of the nodes a packet went through, matched by packet UID and
+ * ordered by time, give its hop path and the rank of each hop.
+ */
+struct RplPathRecord
+{
+  uint64_t packetUid;        ///< UID of the packet
+  int64_t time;              ///< time it was forwarded, in nanoseconds
+  uint32_t flow;             ///< flow key, see RplPathStats::FlowKey
+  uint16_t rank;             ///< rank of the node when it forwarded the packet
+  uint16_t parentSwitches;   ///< parent switches of the node so far, wrapping
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief The paths of a flow, joined from the records of all nodes.
+ */
+struct RplFlowPaths
+{
+  uint32_t packets;                ///< packets traced
+  double meanHops;                 ///< mean hop count of the packets traced
+  uint32_t paths;                  ///< distinct paths taken
+  uint32_t parentSwitches;         ///< parent switches of the forwarders while the flow went through them
+  std::vector<uint32_t> lastPath;  ///< forwarders of the last packet traced, as node IDs
+  std::vector<uint16_t> lastRanks; ///< ranks of the forwarders of the last packet traced
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Ring buffer of the packets forwarded by a node.
+ *
+ * Holds the last records up to its capacity, overwriting the oldest ones.
+ * With a capacity of 0, the default, nothing is allocated or recorded.
+ */
+class RplPathStats
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  RplPathStats();
+
+  /**
+   * \brief set the number of records kept, dropping the current ones.
+   * \param capacity the number of records, 0 to disable recording
+   */
+  void SetCapacity(uint32_t capacity);
+
+  /**
+   * \brief get the number of records kept.
+   * \return the capacity
+   */
+  uint32_t GetCapacity() const;
+
+  /**
+   * \brief check if packets are recorded.
+   * \return true if the capacity is not 0
+   */
+  bool IsEnabled() const
+  {
+    return !m_records.empty ();
+  }
+
+  /**
+   * \brief record a forwarded packet, overwriting the oldest record if full.
+   * \param record the record
+   */
+  void Record(const RplPathRecord &record);
+
+  /**
+   * \brief get the number of records held.
+   * \return the number of records, up to the capacity
+   */
+  uint32_t GetNRecords() const;
+
+  /**
+   * \brief get a record.
+   * \param index position among the records held, 0 being the oldest
+   * \return the record
+   */
+  const RplPathRecord &GetRecord(uint32_t index) const;
+
+  /**
+   * \brief get the number of records overwritten since recording started.
+   * \return the number of records lost to the ring buffer
+   */
+  uint64_t GetNOverwritten() const;
+
+  /**
+   * \brief key a flow the way FlowMonitor classifies it.
+   *
+   * The same five-tuple as Ipv6FlowClassifier, the ports being 0 for
+   * protocols other than TCP and UDP, hashed with FNV-1a.
+   * \param source source address
+   * \param destination destination address
+   * \param protocol next header
+   * \param sourcePort source port
+   * \param destinationPort destination port
+   * \return the flow key
+   */
+  static uint32_t FlowKey(Ipv6Address source, Ipv6Address destination, uint8_t protocol,
+                          uint16_t sourcePort, uint16_t destinationPort);
+
+private:
+  // Records, m_next being the slot written next
+  std::vector<RplPathRecord> m_records;
+  // Slot written next
+  uint32_t m_next;
+  // Number of records held
+  uint32_t m_size;
+  // Records overwritten
+  uint64_t m_overwritten;
+};
+
+}
+
+#endif /* RPL_PATH_STATS_H */
@@ -21,9 +21,21 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/ipv6-route.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
 #include "rpl-routing-table.h"
 
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
+
+/* Routing table dump */
+#define ROUTE_RECORD_SIZE 40
+#define ROUTE_DEFAULT 0
+#define ROUTE_HOST 1
+#define ROUTE_DOWNWARD 2
+#define ROUTE_P2P 3
+#define ROUTE_MULTICAST 4
 
 namespace ns3 {
 
@@ -41,7 +53,8 @@ RplRoutingTableEntry::RplRoutingTableEntry ()
 }
 
 RplRoutingTableEntry::RplRoutingTableEntry (Ipv6Address network, uint32_t interface, Ipv6Address nextHop, Ipv6Address dest, Ipv6Prefix destPrefix)
-  : m_daoSender(network), m_nextHop(nextHop), m_dest(dest), m_prefix(destPrefix), m_interface(interface)
+  : m_daoSender(network), m_nextHop(nextHop), m_dest(dest), m_prefix(destPrefix), m_interface(interface),
+    m_pathSeqNo(0), m_daoSeqNo(0), m_daoLifetime(0), m_pathControl(0), m_retryCounter(0)
 {
 }
 
@@ -140,13 +153,18 @@ uint8_t RplRoutingTableEntry::GetRetryCounter () const
  */
 
 RplRoutingTable::RplRoutingTable ()
-  : m_ipv6 (0), m_rplInstanceId(0), m_dodagId("::"), m_version(0), m_rank(0), m_ocp(0), m_nodeType(true), m_dtsn(0), m_flagG(true)
+  : m_defaultRoute (0), m_ipv6 (0), m_rplInstanceId(0), m_dodagId("::"), m_version(0), m_rank(0), m_ocp(0), m_nodeType(true), m_dtsn(0), m_flagG(true), m_rootLoad(0), m_mop(0)
 {
 
 }
 
 RplRoutingTable::~RplRoutingTable ()
-{	
+{
+  ClearP2pRoutes ();
+  for (RoutesI j = m_multicastRoutes.begin (); j != m_multicastRoutes.end (); j = m_multicastRoutes.erase (j))
+    {
+      delete j->first;
+    }
 }
 
 void RplRoutingTable::SetRplInstanceId (uint8_t rplInstanceId)
@@ -229,6 +247,36 @@ bool RplRoutingTable::GetFlagG ()
   return m_flagG;
 }
 
+void RplRoutingTable::SetMop (uint8_t mop)
+{
+  m_mop = mop;
+}
+
+uint8_t RplRoutingTable::GetMop () const
+{
+  return m_mop;
+}
+
+void RplRoutingTable::SetRootLoad (uint8_t load)
+{
+  m_rootLoad = load;
+}
+
+uint8_t RplRoutingTable::GetRootLoad () const
+{
+  return m_rootLoad;
+}
+
+void RplRoutingTable::SetMetricContainer (const RplMetricContainerOption &metricContainer)
+{
+  m_metricContainer = metricContainer;
+}
+
+const RplMetricContainerOption &RplRoutingTable::GetMetricContainer () const
+{
+  return m_metricContainer;
+}
+
 void RplRoutingTable::SetIpv6 (Ptr<Ipv6> ipv6)
 {
   m_ipv6 = ipv6;
@@ -257,12 +305,51 @@ Ptr<Ipv6Route> RplRoutingTable::Lookup (Ipv6Address dst, Ptr<NetDevice> interfac
       return rtentry;      
     }
 
+  // link-local destinations are on-link, through the interface asked for
+  if (dst.IsLinkLocal () && interface)
+    {
+      rtentry = Create<Ipv6Route> ();
+      rtentry->SetSource (m_ipv6->SourceAddressSelection (m_ipv6->GetInterfaceForDevice (interface), dst));
+      rtentry->SetDestination (dst);
+      rtentry->SetGateway (Ipv6Address::GetZero ());
+      rtentry->SetOutputDevice (interface);
+      return rtentry;
+    }
+
   std::cout << "Unicast Lookup\n";
+  // host routes found by a route discovery beat any downward prefix
+  for (RoutesI it = m_p2pRoutes.begin (); it != m_p2pRoutes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetDest () == dst)
+        {
+          uint32_t interfaceIdx = j->GetInterface ();
+          rtentry = Create<Ipv6Route> ();
+
+          rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, dst));
+          rtentry->SetDestination (dst);
+          rtentry->SetGateway (j->GetNextHop ());
+          rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
+          return rtentry;
+        }
+    }
+
+  RplRoutingTableEntry* downward = 0;
   for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
     {
       RplRoutingTableEntry* j = it->first;
 
-      if (j->GetDest () == dst)
+      if (j->GetNextHop () != Ipv6Address::GetZero ())
+        {
+          // downward route: longest prefix match
+          Ipv6Prefix prefix = j->GetDestNetworkPrefix ();
+          if (prefix.IsMatch (j->GetDest (), dst) &&
+              (!downward || prefix.GetPrefixLength () > downward->GetDestNetworkPrefix ().GetPrefixLength ()))
+            {
+              downward = j;
+            }
+        }
+      else if (j->GetDest () == dst)
         { 
           RplRoutingTableEntry* route = j;
           uint32_t interfaceIdx = route->GetInterface ();
@@ -274,6 +361,28 @@ Ptr<Ipv6Route> RplRoutingTable::Lookup (Ipv6Address dst, Ptr<NetDevice> interfac
         }
     }
 
+  if (!rtentry && downward)
+    {
+      uint32_t interfaceIdx = downward->GetInterface ();
+      rtentry = Create<Ipv6Route> ();
+
+      rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, dst));
+      rtentry->SetDestination (dst);
+      rtentry->SetGateway (downward->GetNextHop ());
+      rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
+    }
+
+  if (!rtentry && m_defaultRoute)
+    {
+      uint32_t interfaceIdx = m_defaultRoute->GetInterface ();
+      rtentry = Create<Ipv6Route> ();
+
+      rtentry->SetSource (m_ipv6->SourceAddressSelection (interfaceIdx, dst));
+      rtentry->SetDestination (dst);
+      rtentry->SetGateway (m_defaultRoute->GetDodagParent ());
+      rtentry->SetOutputDevice (m_ipv6->GetNetDevice (interfaceIdx));
+    }
+
   if (rtentry)
     {
       NS_LOG_LOGIC ("Matching route via " << rtentry->GetDestination ());
@@ -296,12 +405,601 @@ bool RplRoutingTable::AddNetworkRouteTo (Ipv6Address network, uint32_t interface
 {
   NS_LOG_FUNCTION (this << network << interface);
 
+  for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetNextHop () == Ipv6Address::GetZero () && j->GetDest () == network && j->GetInterface () == interface)
+        {
+          return true;
+        }
+    }
+
   RplRoutingTableEntry* route = new RplRoutingTableEntry (network, interface);
 
   m_routes.push_back (std::make_pair (route, EventId ()));
   return true;
 }
 
+bool RplRoutingTable::AddDownwardRoute (Ipv6Address target, uint8_t prefixLength, Ipv6Address nextHop, uint32_t interface,
+                                        uint8_t pathSequence, uint8_t lifetime)
+{
+  NS_LOG_FUNCTION (this << target << (uint32_t)prefixLength << nextHop << interface << (uint32_t)pathSequence);
+
+  Ipv6Prefix prefix (prefixLength);
+  Ipv6Address dest = target.CombinePrefix (prefix);
+  RoutesI exact = FindDownwardRoute (dest, prefixLength);
+  if (exact != m_routes.end ())
+    {
+      // older path sequence (serial number arithmetic): stale announcement
+      RplRoutingTableEntry* j = exact->first;
+      if (j->GetNextHop () != nextHop && (int8_t)(pathSequence - j->GetPathSequence ()) < 0)
+        {
+          return false;
+        }
+      delete j;
+      m_routes.erase (exact);
+    }
+  else
+    {
+      // an exception inside an aggregate through another child
+      RoutesI covering = FindCoveringRoute (dest, prefixLength);
+      if (covering != m_routes.end () && covering->first->GetNextHop () != nextHop)
+        {
+          SplitDownwardRoute (covering, dest, prefixLength);
+        }
+    }
+
+  RplRoutingTableEntry* route = new RplRoutingTableEntry (nextHop, interface, nextHop, dest, prefix);
+  route->SetPathSequence (pathSequence);
+  route->SetDaoLifetime (lifetime);
+  m_routes.push_back (std::make_pair (route, EventId ()));
+  return true;
+}
+
+bool RplRoutingTable::RemoveDownwardRoute (Ipv6Address target, uint8_t prefixLength, Ipv6Address nextHop)
+{
+  NS_LOG_FUNCTION (this << target << (uint32_t)prefixLength << nextHop);
+
+  if (nextHop == Ipv6Address::GetZero ())
+    {
+      return false;
+    }
+
+  // the withdrawn prefix, and the more specific ones inside it
+  Ipv6Prefix prefix (prefixLength);
+  Ipv6Address dest = target.CombinePrefix (prefix);
+  bool removed = false;
+  for (RoutesI it = m_routes.begin (); it != m_routes.end (); )
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetNextHop () == nextHop && j->GetDestNetworkPrefix ().GetPrefixLength () >= prefixLength &&
+          prefix.IsMatch (dest, j->GetDest ()))
+        {
+          delete j;
+          it = m_routes.erase (it);
+          removed = true;
+        }
+      else
+        {
+          it++;
+        }
+    }
+
+  // covering aggregates through the child keep the siblings of the prefix
+  for (RoutesI covering = FindCoveringRoute (dest, prefixLength);
+       covering != m_routes.end () && covering->first->GetNextHop () == nextHop;
+       covering = FindCoveringRoute (dest, prefixLength))
+    {
+      SplitDownwardRoute (covering, dest, prefixLength);
+      removed = true;
+    }
+  return removed;
+}
+
+uint32_t RplRoutingTable::AggregateDownwardRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+
+  typedef std::map<std::pair<Ipv6Address, uint8_t>, RoutesI> DownwardIndex;
+  DownwardIndex index;
+  for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetNextHop () != Ipv6Address::GetZero ())
+        {
+          index[std::make_pair (j->GetDest (), j->GetDestNetworkPrefix ().GetPrefixLength ())] = it;
+        }
+    }
+
+  // a route inside a covering one through the same child adds nothing
+  uint32_t removed = 0;
+  for (DownwardIndex::iterator iter = index.begin (); iter != index.end (); )
+    {
+      RplRoutingTableEntry* j = iter->second->first;
+      RoutesI covering = FindCoveringRoute (j->GetDest (), iter->first.second);
+      if (covering != m_routes.end () && covering->first->GetNextHop () == j->GetNextHop () &&
+          covering->first->GetInterface () == j->GetInterface ())
+        {
+          delete j;
+          m_routes.erase (iter->second);
+          index.erase (iter++);
+          removed++;
+        }
+      else
+        {
+          iter++;
+        }
+    }
+
+  // bottom-up, siblings through the same child become their common prefix
+  for (uint8_t length = 128; length > 0; length--)
+    {
+      std::vector<std::pair<Ipv6Address, uint8_t> > keys;
+      for (DownwardIndex::iterator iter = index.begin (); iter != index.end (); iter++)
+        {
+          if (iter->first.second == length)
+            {
+              keys.push_back (iter->first);
+            }
+        }
+
+      for (std::vector<std::pair<Ipv6Address, uint8_t> >::iterator key = keys.begin (); key != keys.end (); key++)
+        {
+          DownwardIndex::iterator first = index.find (*key);
+          if (first == index.end ())
+            {
+              continue;
+            }
+
+          uint8_t bytes[16];
+          key->first.GetBytes (bytes);
+          bytes[(length - 1) / 8] ^= 0x80 >> ((length - 1) % 8);
+          DownwardIndex::iterator second = index.find (std::make_pair (Ipv6Address (bytes), length));
+          if (second == index.end ())
+            {
+              continue;
+            }
+
+          RplRoutingTableEntry* a = first->second->first;
+          RplRoutingTableEntry* b = second->second->first;
+          if (a->GetNextHop () != b->GetNextHop () || a->GetInterface () != b->GetInterface () ||
+              a->GetDaoLifetime () != b->GetDaoLifetime ())
+            {
+              continue;
+            }
+
+          std::pair<Ipv6Address, uint8_t> parent = std::make_pair (key->first.CombinePrefix (Ipv6Prefix (length - 1)), length - 1);
+          RplRoutingTableEntry* route = new RplRoutingTableEntry (a->GetNextHop (), a->GetInterface (), a->GetNextHop (),
+                                                                   parent.first, Ipv6Prefix (length - 1));
+          bool newer = (int8_t)(b->GetPathSequence () - a->GetPathSequence ()) > 0;
+          route->SetPathSequence (newer ? b->GetPathSequence () : a->GetPathSequence ());
+          route->SetDaoLifetime (a->GetDaoLifetime ());
+
+          delete a;
+          delete b;
+          m_routes.erase (first->second);
+          m_routes.erase (second->second);
+          index.erase (first);
+          index.erase (second);
+          removed++;
+
+          // a route to the common prefix was shadowed by both halves
+          DownwardIndex::iterator shadowed = index.find (parent);
+          if (shadowed != index.end ())
+            {
+              delete shadowed->second->first;
+              m_routes.erase (shadowed->second);
+              index.erase (shadowed);
+              removed++;
+            }
+          m_routes.push_back (std::make_pair (route, EventId ()));
+          index[parent] = --m_routes.end ();
+        }
+    }
+
+  NS_LOG_LOGIC ("RPL: " << removed << " downward routes aggregated, " << index.size () << " left");
+  return removed;
+}
+
+bool RplRoutingTable::AddP2pRoute (Ipv6Address target, Ipv6Address nextHop, uint32_t interface, Time lifetime)
+{
+  NS_LOG_FUNCTION (this << target << nextHop << interface << lifetime);
+
+  RemoveP2pRoute (target);
+  RplRoutingTableEntry* route = new RplRoutingTableEntry (nextHop, interface, nextHop, target, Ipv6Prefix (128));
+  EventId expiration = Simulator::Schedule (lifetime, &RplRoutingTable::RemoveP2pRoute, this, target);
+  m_p2pRoutes.push_back (std::make_pair (route, expiration));
+  return true;
+}
+
+bool RplRoutingTable::RemoveP2pRoute (Ipv6Address target)
+{
+  NS_LOG_FUNCTION (this << target);
+
+  for (RoutesI it = m_p2pRoutes.begin (); it != m_p2pRoutes.end (); it++)
+    {
+      if (it->first->GetDest () == target)
+        {
+          it->second.Cancel ();
+          delete it->first;
+          m_p2pRoutes.erase (it);
+          return true;
+        }
+    }
+  return false;
+}
+
+void RplRoutingTable::ClearP2pRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (RoutesI it = m_p2pRoutes.begin (); it != m_p2pRoutes.end (); it = m_p2pRoutes.erase (it))
+    {
+      it->second.Cancel ();
+      delete it->first;
+    }
+}
+
+uint32_t RplRoutingTable::GetNP2pRoutes () const
+{
+  return m_p2pRoutes.size ();
+}
+
+bool RplRoutingTable::AddMulticastRoute (Ipv6Address group, Ipv6Address nextHop, uint32_t interface,
+                                         uint8_t pathSequence, uint8_t lifetime)
+{
+  NS_LOG_FUNCTION (this << group << nextHop << interface << (uint32_t)pathSequence);
+
+  for (RoutesI it = m_multicastRoutes.begin (); it != m_multicastRoutes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetDest () == group && j->GetNextHop () == nextHop)
+        {
+          // older path sequence (serial number arithmetic): stale announcement
+          if ((int8_t)(pathSequence - j->GetPathSequence ()) < 0)
+            {
+              return false;
+            }
+          j->SetPathSequence (pathSequence);
+          j->SetDaoLifetime (lifetime);
+          return true;
+        }
+    }
+
+  RplRoutingTableEntry* route = new RplRoutingTableEntry (nextHop, interface, nextHop, group, Ipv6Prefix (128));
+  route->SetPathSequence (pathSequence);
+  route->SetDaoLifetime (lifetime);
+  m_multicastRoutes.push_back (std::make_pair (route, EventId ()));
+  return true;
+}
+
+bool RplRoutingTable::RemoveMulticastRoute (Ipv6Address group, Ipv6Address nextHop)
+{
+  NS_LOG_FUNCTION (this << group << nextHop);
+
+  for (RoutesI it = m_multicastRoutes.begin (); it != m_multicastRoutes.end (); it++)
+    {
+      if (it->first->GetDest () == group && it->first->GetNextHop () == nextHop)
+        {
+          delete it->first;
+          m_multicastRoutes.erase (it);
+          return true;
+        }
+    }
+  return false;
+}
+
+std::vector<RplRoutingTableEntry> RplRoutingTable::GetMulticastRoutes (Ipv6Address group) const
+{
+  std::vector<RplRoutingTableEntry> routes;
+  for (RoutesCI it = m_multicastRoutes.begin (); it != m_multicastRoutes.end (); it++)
+    {
+      if (group == Ipv6Address::GetAny () || it->first->GetDest () == group)
+        {
+          routes.push_back (*it->first);
+        }
+    }
+  return routes;
+}
+
+uint32_t RplRoutingTable::GetNMulticastRoutes () const
+{
+  return m_multicastRoutes.size ();
+}
+
+RplRoutingTable::RoutesI RplRoutingTable::FindDownwardRoute (Ipv6Address dest, uint8_t prefixLength)
+{
+  for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      if (j->GetNextHop () != Ipv6Address::GetZero () && j->GetDest () == dest &&
+          j->GetDestNetworkPrefix ().GetPrefixLength () == prefixLength)
+        {
+          return it;
+        }
+    }
+  return m_routes.end ();
+}
+
+RplRoutingTable::RoutesI RplRoutingTable::FindCoveringRoute (Ipv6Address dest, uint8_t prefixLength)
+{
+  RoutesI best = m_routes.end ();
+  uint8_t bestLength = 0;
+  for (RoutesI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      RplRoutingTableEntry* j = it->first;
+      uint8_t length = j->GetDestNetworkPrefix ().GetPrefixLength ();
+      if (j->GetNextHop () != Ipv6Address::GetZero () && length < prefixLength &&
+          (best == m_routes.end () || length > bestLength) && j->GetDestNetworkPrefix ().IsMatch (j->GetDest (), dest))
+        {
+          best = it;
+          bestLength = length;
+        }
+    }
+  return best;
+}
+
+void RplRoutingTable::SplitDownwardRoute (RoutesI route, Ipv6Address dest, uint8_t prefixLength)
+{
+  RplRoutingTableEntry* j = route->first;
+  uint8_t length = j->GetDestNetworkPrefix ().GetPrefixLength ();
+  NS_LOG_LOGIC ("RPL: splitting " << j->GetDest () << "/" << (uint32_t)length << " around " << dest);
+
+  // the siblings along the path down to the prefix; existing, more specific
+  // routes to a sibling prefix already shadowed the aggregate there
+  uint8_t bytes[16];
+  for (uint8_t bit = length; bit < prefixLength; bit++)
+    {
+      dest.CombinePrefix (Ipv6Prefix (bit + 1)).GetBytes (bytes);
+      bytes[bit / 8] ^= 0x80 >> (bit % 8);
+      Ipv6Address sibling (bytes);
+      if (FindDownwardRoute (sibling, bit + 1) != m_routes.end ())
+        {
+          continue;
+        }
+      RplRoutingTableEntry* route = new RplRoutingTableEntry (j->GetNextHop (), j->GetInterface (), j->GetNextHop (),
+                                                               sibling, Ipv6Prefix (bit + 1));
+      route->SetPathSequence (j->GetPathSequence ());
+      route->SetDaoLifetime (j->GetDaoLifetime ());
+      m_routes.push_back (std::make_pair (route, EventId ()));
+    }
+  delete j;
+  m_routes.erase (route);
+}
+
+Ipv6Address RplRoutingTable::GetDownwardNextHop (Ipv6Address dest) const
+{
+  const RplRoutingTableEntry* best = 0;
+  for (RoutesCI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      const RplRoutingTableEntry* j = it->first;
+      Ipv6Prefix prefix = j->GetDestNetworkPrefix ();
+      if (j->GetNextHop () != Ipv6Address::GetZero () && prefix.IsMatch (j->GetDest (), dest) &&
+          (!best || prefix.GetPrefixLength () > best->GetDestNetworkPrefix ().GetPrefixLength ()))
+        {
+          best = j;
+        }
+    }
+  return best ? best->GetNextHop () : Ipv6Address::GetAny ();
+}
+
+std::vector<RplRoutingTableEntry> RplRoutingTable::GetDownwardRoutes () const
+{
+  std::vector<RplRoutingTableEntry> routes;
+  for (RoutesCI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      if (it->first->GetNextHop () != Ipv6Address::GetZero ())
+        {
+          routes.push_back (*it->first);
+        }
+    }
+  return routes;
+}
+
+uint32_t RplRoutingTable::GetNDownwardRoutes () const
+{
+  uint32_t count = 0;
+  for (RoutesCI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      if (it->first->GetNextHop () != Ipv6Address::GetZero ())
+        {
+          count++;
+        }
+    }
+  return count;
+}
+
+uint32_t RplRoutingTable::GetNRoutes () const
+{
+  return m_routes.size () + m_p2pRoutes.size () + m_multicastRoutes.size () + (m_defaultRoute ? 1 : 0);
+}
+
+// the type, destination, prefix length and next hop under which a route is printed and dumped
+static void ClassifyRoute (const RplRoutingTableEntry *route, bool defaultRoute, uint8_t table, uint8_t &type,
+                           Ipv6Address &dest, uint8_t &prefixLength, Ipv6Address &nextHop)
+{
+  if (table == ROUTE_P2P || table == ROUTE_MULTICAST)
+    {
+      type = table;
+      dest = route->GetDest ();
+      prefixLength = 128;
+      nextHop = route->GetNextHop ();
+    }
+  else if (defaultRoute)
+    {
+      type = ROUTE_DEFAULT;
+      dest = Ipv6Address::GetZero ();
+      prefixLength = 0;
+      nextHop = route->GetDodagParent ();
+    }
+  else if (route->GetNextHop () == Ipv6Address::GetZero ())
+    {
+      type = ROUTE_HOST;
+      dest = route->GetDest ();
+      prefixLength = 128;
+      nextHop = Ipv6Address::GetZero ();
+    }
+  else
+    {
+      type = ROUTE_DOWNWARD;
+      dest = route->GetDest ();
+      prefixLength = route->GetDestNetworkPrefix ().GetPrefixLength ();
+      nextHop = route->GetNextHop ();
+    }
+}
+
+static void PrintRoute (std::ostream &os, const RplRoutingTableEntry *route, bool defaultRoute,
+                        uint8_t table = ROUTE_DOWNWARD)
+{
+  uint8_t type;
+  Ipv6Address dest;
+  uint8_t prefixLength;
+  Ipv6Address nextHop;
+  ClassifyRoute (route, defaultRoute, table, type, dest, prefixLength, nextHop);
+
+  std::ostringstream destination;
+  destination << dest << "/" << (uint32_t)prefixLength;
+  std::ostringstream gateway;
+  gateway << nextHop;
+  os << std::setiosflags (std::ios::left) << std::setw (31) << destination.str ()
+     << std::setw (27) << gateway.str ()
+     << std::setw (5) << (type == ROUTE_HOST ? "UH" : type == ROUTE_P2P ? "UGH" : type == ROUTE_MULTICAST ? "UGM" : "UG")
+     << std::setw (4) << (uint32_t)route->GetPathSequence ()
+     << std::setw (5) << (uint32_t)route->GetDaoLifetime ()
+     << route->GetInterface () << std::endl;
+}
+
+void RplRoutingTable::Print (std::ostream &os) const
+{
+  os << "Destination                    Next Hop                   Flag Seq Life If" << std::endl;
+  if (m_defaultRoute)
+    {
+      PrintRoute (os, m_defaultRoute, true);
+    }
+  for (RoutesCI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      PrintRoute (os, it->first, false);
+    }
+  for (RoutesCI it = m_p2pRoutes.begin (); it != m_p2pRoutes.end (); it++)
+    {
+      PrintRoute (os, it->first, false, ROUTE_P2P);
+    }
+  for (RoutesCI it = m_multicastRoutes.begin (); it != m_multicastRoutes.end (); it++)
+    {
+      PrintRoute (os, it->first, false, ROUTE_MULTICAST);
+    }
+}
+
+static void SerializeRoute (Buffer::Iterator &i, const RplRoutingTableEntry *route, bool defaultRoute,
+                            uint8_t table = ROUTE_DOWNWARD)
+{
+  uint8_t type;
+  Ipv6Address dest;
+  uint8_t prefixLength;
+  Ipv6Address nextHop;
+  ClassifyRoute (route, defaultRoute, table, type, dest, prefixLength, nextHop);
+
+  uint8_t address[16];
+  i.WriteU8 (type);
+  dest.Serialize (address);
+  i.Write (address, 16);
+  i.WriteU8 (prefixLength);
+  nextHop.Serialize (address);
+  i.Write (address, 16);
+  i.WriteHtonU32 (route->GetInterface ());
+  i.WriteU8 (route->GetPathSequence ());
+  i.WriteU8 (route->GetDaoLifetime ());
+}
+
+uint32_t RplRoutingTable::GetSerializedSize () const
+{
+  return 4 + GetNRoutes () * ROUTE_RECORD_SIZE;
+}
+
+void RplRoutingTable::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU32 (GetNRoutes ());
+  if (m_defaultRoute)
+    {
+      SerializeRoute (i, m_defaultRoute, true);
+    }
+  for (RoutesCI it = m_routes.begin (); it != m_routes.end (); it++)
+    {
+      SerializeRoute (i, it->first, false);
+    }
+  for (RoutesCI it = m_p2pRoutes.begin (); it != m_p2pRoutes.end (); it++)
+    {
+      SerializeRoute (i, it->first, false, ROUTE_P2P);
+    }
+  for (RoutesCI it = m_multicastRoutes.begin (); it != m_multicastRoutes.end (); it++)
+    {
+      SerializeRoute (i, it->first, false, ROUTE_MULTICAST);
+    }
+}
+
+uint32_t RplRoutingTable::ConvertToCsv (Buffer::Iterator start, uint32_t size, std::ostream &csv, const std::string &rowPrefix)
+{
+  if (size < 4)
+    {
+      return 0;
+    }
+  Buffer::Iterator i = start;
+  uint32_t nRoutes = i.ReadNtohU32 ();
+  if ((size - 4) / ROUTE_RECORD_SIZE < nRoutes)
+    {
+      return 0;
+    }
+
+  static const char *types[] = { "default", "host", "downward", "p2p", "multicast" };
+  uint8_t address[16];
+  for (uint32_t n = 0; n < nRoutes; n++)
+    {
+      uint8_t type = i.ReadU8 ();
+      i.Read (address, 16);
+      Ipv6Address dest = Ipv6Address::Deserialize (address);
+      uint8_t prefixLength = i.ReadU8 ();
+      i.Read (address, 16);
+      Ipv6Address nextHop = Ipv6Address::Deserialize (address);
+      uint32_t interface = i.ReadNtohU32 ();
+      uint8_t pathSequence = i.ReadU8 ();
+      uint8_t lifetime = i.ReadU8 ();
+      if (type > ROUTE_MULTICAST)
+        {
+          return 0;
+        }
+      csv << rowPrefix << types[type] << "," << dest << "," << (uint32_t)prefixLength << "," << nextHop << ","
+          << interface << "," << (uint32_t)pathSequence << "," << (uint32_t)lifetime << "\n";
+    }
+  return 4 + nRoutes * ROUTE_RECORD_SIZE;
+}
+
+bool RplRoutingTable::SetDodagParent (Ipv6Address dodagParent, uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << dodagParent << interface);
+
+  delete m_defaultRoute;
+  m_defaultRoute = new RplRoutingTableEntry (dodagParent, interface);
+  return true;
+}
+
+Ipv6Address RplRoutingTable::GetDodagParent () const
+{
+  if (m_defaultRoute)
+    {
+      return m_defaultRoute->GetDodagParent ();
+    }
+  return Ipv6Address::GetZero ();
+}
+
+void RplRoutingTable::RemoveDodagParent ()
+{
+  NS_LOG_FUNCTION (this);
+
+  delete m_defaultRoute;
+  m_defaultRoute = 0;
+}
+
 bool RplRoutingTable::DeleteRoute (RplRoutingTableEntry *route)
 {
   //NS_LOG_FUNCTION (this << *route);
@@ -326,14 +1024,24 @@ bool RplRoutingTable::ClearRoutingTable ()
       delete j->first;
     }
   m_routes.clear();
+
+  for (RoutesI j = m_multicastRoutes.begin (); j != m_multicastRoutes.end (); j = m_multicastRoutes.erase (j))
+    {
+      delete j->first;
+    }
+
+  delete m_defaultRoute;
+  m_defaultRoute = 0;
   
   SetRplInstanceId (0);
   SetDodagId ("::");
   SetVersionNumber (0);
   SetRank (0);
   SetObjectiveCodePoint (0);
-  SetNodeType (true);
   SetDtsn (0);
+  SetRootLoad (0);
+  SetMop (0);
+  SetMetricContainer (RplMetricContainerOption ());
 
   return true;
 }
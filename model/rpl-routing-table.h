@@ -22,8 +22,12 @@
 #define RPL_ROUTING_TABLE_H
 
 #include <list>
+#include <vector>
 #include <ostream>
+#include <string>
+#include <ns3/buffer.h>
 #include <ns3/event-id.h>
+#include <ns3/nstime.h>
 #include <ns3/ipv6-routing-protocol.h>
 #include <ns3/ipv6-interface.h>
 #include <ns3/inet6-socket-address.h>
@@ -33,6 +37,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-header.h"
 #include <ns3/log.h>
+#include <ns3/rpl-option.h>
 
 namespace ns3 {
 
@@ -265,6 +270,191 @@ public:
    */
   bool AddNetworkRouteTo (Ipv6Address network, uint32_t interface);
 
+  /**
+   * \brief Add or refresh a downward route learned from a DAO (storing mode).
+   * \param target the target prefix
+   * \param prefixLength length of the target prefix
+   * \param nextHop the child that announced the target
+   * \param interface interface index towards the child
+   * \param pathSequence the path sequence of the announcement
+   * \param lifetime the path lifetime of the announcement
+   * \return false if a fresher route to the same prefix is already installed
+   */
+  bool AddDownwardRoute (Ipv6Address target, uint8_t prefixLength, Ipv6Address nextHop, uint32_t interface,
+                         uint8_t pathSequence, uint8_t lifetime);
+
+  /**
+   * \brief Remove the downward routes to a target prefix through a child (No-Path DAO).
+   *
+   * Routes to more specific prefixes are removed as well. A route to a
+   * covering aggregate is split into the sibling prefixes that remain
+   * reachable through the child.
+   *
+   * \param target the target prefix
+   * \param prefixLength length of the target prefix
+   * \param nextHop the child that withdrew the target
+   * \return true if any route was removed
+   */
+  bool RemoveDownwardRoute (Ipv6Address target, uint8_t prefixLength, Ipv6Address nextHop);
+
+  /**
+   * \brief Collapse downward routes into covering prefixes.
+   *
+   * Routes inside a covering route through the same child are dropped, and
+   * sibling prefixes through the same child are merged into their common
+   * prefix, bottom-up. Longest prefix match gives the same next hop for
+   * every destination before and after.
+   *
+   * \return the number of routes removed
+   */
+  uint32_t AggregateDownwardRoutes ();
+
+  /**
+   * \brief Add or refresh a point-to-point route found by a route discovery (RFC 6997).
+   *
+   * The route is a hop-by-hop host route that takes precedence over the
+   * downward and default routes, until it expires.
+   * \param target the target of the discovery
+   * \param nextHop link-local address of the next hop towards the target
+   * \param interface interface index towards the next hop
+   * \param lifetime time after which the route is removed
+   * \return true if succesful
+   */
+  bool AddP2pRoute (Ipv6Address target, Ipv6Address nextHop, uint32_t interface, Time lifetime);
+
+  /**
+   * \brief Remove the point-to-point route to a target.
+   * \param target the target
+   * \return true if a route was removed
+   */
+  bool RemoveP2pRoute (Ipv6Address target);
+
+  /**
+   * \brief Remove every point-to-point route.
+   */
+  void ClearP2pRoutes ();
+
+  /**
+   * \brief Get the number of point-to-point routes.
+   * \return the number of routes found by route discoveries
+   */
+  uint32_t GetNP2pRoutes () const;
+
+  /**
+   * \brief Add or refresh a downstream neighbor subscribed to a multicast group (MOP 3).
+   *
+   * A group may have several downstream neighbors: a multicast packet is
+   * forwarded to each of them, and only to them.
+   * \param group the multicast group announced as a DAO target
+   * \param nextHop link-local address of the child that announced it
+   * \param interface interface index towards the child
+   * \param pathSequence the path sequence of the announcement
+   * \param lifetime the path lifetime of the announcement
+   * \return false if a fresher announcement from the child is already installed
+   */
+  bool AddMulticastRoute (Ipv6Address group, Ipv6Address nextHop, uint32_t interface, uint8_t pathSequence,
+                          uint8_t lifetime);
+
+  /**
+   * \brief Remove a downstream neighbor from a multicast group (No-Path DAO).
+   * \param group the multicast group
+   * \param nextHop the child that withdrew the group
+   * \return true if the neighbor was subscribed
+   */
+  bool RemoveMulticastRoute (Ipv6Address group, Ipv6Address nextHop);
+
+  /**
+   * \brief Get the downstream neighbors subscribed to a multicast group.
+   * \param group the multicast group, or the any address for every group
+   * \return copies of the multicast route entries
+   */
+  std::vector<RplRoutingTableEntry> GetMulticastRoutes (Ipv6Address group = Ipv6Address::GetAny ()) const;
+
+  /**
+   * \brief Get the number of multicast routes.
+   * \return the number of group and downstream neighbor pairs
+   */
+  uint32_t GetNMulticastRoutes () const;
+
+  /**
+   * \brief Get the child whose sub-DODAG holds an address.
+   * \param dest the address
+   * \return the next hop of the longest matching downward route, or the any address
+   */
+  Ipv6Address GetDownwardNextHop (Ipv6Address dest) const;
+
+  /**
+   * \brief Get the downward routes learned from DAOs.
+   * \return copies of the downward route entries
+   */
+  std::vector<RplRoutingTableEntry> GetDownwardRoutes () const;
+
+  /**
+   * \brief Get the number of downward routes learned from DAOs.
+   * \return the number of downward routes
+   */
+  uint32_t GetNDownwardRoutes () const;
+
+  /**
+   * \brief Get the number of routes held, the default route included.
+   * \return the number of route entries
+   */
+  uint32_t GetNRoutes () const;
+
+  /**
+   * \brief Print the routes, one per line, the default route first.
+   * \param os the output stream
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief Get the size of the routes in binary form.
+   * \return the number of bytes written by Serialize
+   */
+  uint32_t GetSerializedSize () const;
+
+  /**
+   * \brief Write the routes in binary form.
+   *
+   * A route count (32 bits) is followed by a fixed size record per route:
+   * type (0 default, 1 host, 2 downward, 3 p2p, 4 multicast), destination, prefix length, next
+   * hop, interface (32 bits), path sequence and lifetime, in network order.
+   * \param start where to write, GetSerializedSize bytes
+   */
+  void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Convert routes written by Serialize into CSV rows.
+   *
+   * Each row is rowPrefix followed by the type, destination, prefix length,
+   * next hop, interface, path sequence and lifetime of a route.
+   * \param start the routes in binary form
+   * \param size the number of bytes available from start
+   * \param csv the output stream
+   * \param rowPrefix the leading columns of every row
+   * \return the number of bytes read, or 0 if size is too small
+   */
+  static uint32_t ConvertToCsv (Buffer::Iterator start, uint32_t size, std::ostream &csv, const std::string &rowPrefix);
+
+  /**
+   * \brief Set the preferred DODAG parent, used as the default (upward) route.
+   * \param dodagParent address of the preferred parent
+   * \param interface interface index towards the parent
+   * \return true if succesful
+   */
+  bool SetDodagParent (Ipv6Address dodagParent, uint32_t interface);
+
+  /**
+   * \brief Get the preferred DODAG parent.
+   * \return the parent address, or the zero address if none is set
+   */
+  Ipv6Address GetDodagParent () const;
+
+  /**
+   * \brief Remove the preferred DODAG parent, and the default route with it.
+   */
+  void RemoveDodagParent ();
+
   /**
    * \brief Delete a route.
    * \param route the route to be removed
@@ -274,6 +464,10 @@ public:
 
   /**
    * \brief Clears the routing table
+   *
+   * The routes and the DODAG state go; the node type, which is configured
+   * rather than learned, is kept, and so are the point-to-point routes,
+   * which belong to temporary DODAGs of their own.
    * \return true if succesful
    */
   bool ClearRoutingTable ();
@@ -381,6 +575,42 @@ public:
    */
   bool GetFlagG ();
 
+  /**
+   * \brief Set the Mode of Operation of the DODAG.
+   * \param mop the MOP value
+   */
+  void SetMop (uint8_t mop);
+
+  /**
+   * \brief Get the Mode of Operation of the DODAG.
+   * \return the MOP value
+   */
+  uint8_t GetMop () const;
+
+  /**
+   * \brief Set the DODAG root load.
+   * \param load the root load, 0 (idle) to 255 (saturated)
+   */
+  void SetRootLoad (uint8_t load);
+
+  /**
+   * \brief Get the DODAG root load.
+   * \return the root load
+   */
+  uint8_t GetRootLoad () const;
+
+  /**
+   * \brief Set the path metrics advertised by this node.
+   * \param metricContainer the DAG Metric Container of the path through the preferred parent
+   */
+  void SetMetricContainer (const RplMetricContainerOption &metricContainer);
+
+  /**
+   * \brief Get the path metrics advertised by this node.
+   * \return the DAG Metric Container
+   */
+  const RplMetricContainerOption &GetMetricContainer () const;
+
   /**
    * \brief Set IPv6 reference
    * \param the ipv6 reference
@@ -403,11 +633,50 @@ private:
   /// Iterator for container for the network routes
   typedef std::list<std::pair <RplRoutingTableEntry *, EventId> >::iterator RoutesI;
   
+  /**
+   * \brief Find the downward route to a prefix.
+   * \param dest the prefix
+   * \param prefixLength length of the prefix
+   * \return the route, or the end of the routes
+   */
+  RoutesI FindDownwardRoute (Ipv6Address dest, uint8_t prefixLength);
+
+  /**
+   * \brief Find the longest downward route strictly covering a prefix.
+   * \param dest the prefix
+   * \param prefixLength length of the prefix
+   * \return the route, or the end of the routes
+   */
+  RoutesI FindCoveringRoute (Ipv6Address dest, uint8_t prefixLength);
+
+  /**
+   * \brief Replace a covering route by its sibling prefixes along the path to a prefix.
+   * \param route the covering route
+   * \param dest the prefix left out
+   * \param prefixLength length of the prefix
+   */
+  void SplitDownwardRoute (RoutesI route, Ipv6Address dest, uint8_t prefixLength);
+
   /**
    * \brief the forwarding table for network
    */
   Routes m_routes;
 
+  /**
+   * \brief the point-to-point routes, with their expiration events
+   */
+  Routes m_p2pRoutes;
+
+  /**
+   * \brief the downstream neighbors of the multicast groups, one entry per pair
+   */
+  Routes m_multicastRoutes;
+
+  /**
+   * \brief the default route through the preferred DODAG parent
+   */
+  RplRoutingTableEntry *m_defaultRoute;
+
   /**
    * \brief the IPv6 reference
    */
@@ -453,6 +722,21 @@ private:
    */
   bool m_flagG;
 
+  /**
+   * \brief the DODAG root load
+   */
+  uint8_t m_rootLoad;
+
+  /**
+   * \brief the Mode of Operation
+   */
+  uint8_t m_mop;
+
+  /**
+   * \brief the path metrics and constraints advertised in DIOs
+   */
+  RplMetricContainerOption m_metricContainer;
+
 };
 
 }
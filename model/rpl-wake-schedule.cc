@@ -0,0 +1,130 @@
+#include "rpl-wake-schedule.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RplWakeSchedule");
+
+NS_OBJECT_ENSURE_REGISTERED (RplWakeSchedule);
+NS_OBJECT_ENSURE_REGISTERED (RplDutyCycle);
+
+TypeId RplWakeSchedule::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RplWakeSchedule")
+    .SetParent<Object> ()
+    .SetGroupName ("Rpl")
+  ;
+  return tid;
+}
+
+RplWakeSchedule::~RplWakeSchedule ()
+{
+}
+
+bool RplWakeSchedule::IsAwake (Time t) const
+{
+  Time start, end;
+  GetNextWake (t, start, end);
+  return start == t;
+}
+
+Time RplWakeSchedule::AlignTransmission (Time t, Time earliest, Time latest, double u) const
+{
+  NS_LOG_FUNCTION (this << t << earliest << latest << u);
+  Time start, end;
+  GetNextWake (t, start, end);
+  if (start >= latest)
+    {
+      GetNextWake (earliest, start, end);
+      if (start >= latest)
+        {
+          // no window in the range: the radio has to wake up for it
+          return t;
+        }
+    }
+  end = Min (end, latest);
+  return start + NanoSeconds ((uint64_t)((end - start).GetNanoSeconds () * u));
+}
+
+TypeId RplDutyCycle::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RplDutyCycle")
+    .SetParent<RplWakeSchedule> ()
+    .SetGroupName ("Rpl")
+    .AddConstructor<RplDutyCycle> ()
+    .AddAttribute ("Period", "Time between the start of two wake windows",
+                   TimeValue (MilliSeconds (500)),
+                   MakeTimeAccessor (&RplDutyCycle::m_period),
+                   MakeTimeChecker ())
+    .AddAttribute ("WakeDuration", "Length of a wake window",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&RplDutyCycle::m_wakeDuration),
+                   MakeTimeChecker ())
+    .AddAttribute ("Phase", "Start of the first wake window",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&RplDutyCycle::m_phase),
+                   MakeTimeChecker ())
+    .AddAttribute ("WakeupCost", "Radio-on time of a transmission outside the wake windows",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&RplDutyCycle::m_wakeupCost),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RplDutyCycle::RplDutyCycle ()
+  : m_period (MilliSeconds (500)),
+    m_wakeDuration (MilliSeconds (10)),
+    m_phase (Seconds (0)),
+    m_wakeupCost (MilliSeconds (5))
+{
+}
+
+RplDutyCycle::~RplDutyCycle ()
+{
+}
+
+void RplDutyCycle::SetSchedule (Time period, Time wakeDuration, Time phase)
+{
+  NS_LOG_FUNCTION (this << period << wakeDuration << phase);
+  NS_ABORT_MSG_IF (!period.IsStrictlyPositive () || wakeDuration > period, "Invalid wake schedule");
+  m_period = period;
+  m_wakeDuration = wakeDuration;
+  m_phase = phase;
+}
+
+Time RplDutyCycle::GetWakeupCost () const
+{
+  return m_wakeupCost;
+}
+
+Time RplDutyCycle::GetRadioOnTime (Time duration, uint32_t extraWakeups) const
+{
+  double windows = duration.GetSeconds () / m_period.GetSeconds ();
+  return Seconds (windows * m_wakeDuration.GetSeconds () + extraWakeups * m_wakeupCost.GetSeconds ());
+}
+
+void RplDutyCycle::GetNextWake (Time t, Time &start, Time &end) const
+{
+  int64_t period = m_period.GetTimeStep ();
+  int64_t offset = (t - m_phase).GetTimeStep () % period;
+  if (offset < 0)
+    {
+      offset += period;
+    }
+  Time windowStart = t - Time (offset);
+  if (offset < m_wakeDuration.GetTimeStep ())
+    {
+      start = t;
+      end = windowStart + m_wakeDuration;
+    }
+  else
+    {
+      start = windowStart + m_period;
+      end = start + m_wakeDuration;
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+#ifndef RPL_WAKE_SCHEDULE_H
+#define RPL_WAKE_SCHEDULE_H
+
+#include <stdint.h>
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Wake schedule of a duty-cycled radio, as published to RPL.
+ *
+ * A duty-cycled MAC, or a stand-in for one, implements GetNextWake and is
+ * either aggregated to the node or given to Rpl::SetWakeSchedule. RPL then
+ * moves its Trickle DIOs into the wake windows.
+ */
+class RplWakeSchedule : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~RplWakeSchedule ();
+
+  /**
+   * \brief get the wake window in progress at a time, or the next one.
+   * \param t the time
+   * \param start t if the radio is awake at t, else the start of the next window
+   * \param end the end of that window
+   */
+  virtual void GetNextWake (Time t, Time &start, Time &end) const = 0;
+
+  /**
+   * \brief check if the radio is awake.
+   * \param t the time
+   * \return true if t is within a wake window
+   */
+  bool IsAwake (Time t) const;
+
+  /**
+   * \brief move a transmission into a wake window of a time range.
+   *
+   * The window in progress at t, or the next one, is used if it starts
+   * before latest, otherwise the first window after earliest. The time is
+   * drawn within the part of the window in the range, so that nodes
+   * sharing a schedule do not all send at the start of a window.
+   * \param t the time chosen for the transmission
+   * \param earliest earliest time allowed, no later than t
+   * \param latest the transmission must happen before this time
+   * \param u uniform draw in [0, 1)
+   * \return a time in [earliest, latest) when the radio is awake, or t if there is none
+   */
+  Time AlignTransmission (Time t, Time earliest, Time latest, double u) const;
+};
+
+/**
+ * \ingroup rpl
+ *
+ * \brief Periodic wake schedule standing in for a duty-cycled MAC.
+ *
+ * The radio is awake for WakeDuration at the start of every Period, shifted
+ * by Phase. Nodes given the same schedule wake together, as with a
+ * synchronized MAC. Sending outside a window costs an extra wakeup of
+ * WakeupCost.
+ */
+class RplDutyCycle : public RplWakeSchedule
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Constructor
+   */
+  RplDutyCycle ();
+
+  /**
+   * \brief Destructor
+   */
+  virtual ~RplDutyCycle ();
+
+  /**
+   * \brief set the schedule.
+   * \param period time between the start of two windows
+   * \param wakeDuration length of a window, no longer than the period
+   * \param phase start of the first window
+   */
+  void SetSchedule (Time period, Time wakeDuration, Time phase);
+
+  /**
+   * \brief get the radio-on time of an extra wakeup.
+   * \return the cost of a transmission outside the windows
+   */
+  Time GetWakeupCost () const;
+
+  /**
+   * \brief get the time the radio is on.
+   * \param duration time elapsed since the start of the schedule
+   * \param extraWakeups transmissions made outside the windows
+   * \return the time spent in the windows plus the extra wakeups
+   */
+  Time GetRadioOnTime (Time duration, uint32_t extraWakeups) const;
+
+  // inherited from RplWakeSchedule
+  virtual void GetNextWake (Time t, Time &start, Time &end) const;
+
+private:
+  /**
+   * \brief time between the start of two windows
+   */
+  Time m_period;
+
+  /**
+   * \brief length of a window
+   */
+  Time m_wakeDuration;
+
+  /**
+   * \brief start of the first window
+   */
+  Time m_phase;
+
+  /**
+   * \brief radio-on time of a transmission outside the windows
+   */
+  Time m_wakeupCost;
+};
+
+}
+
+#endif /* RPL_WAKE_SCHEDULE_H */
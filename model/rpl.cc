@@ -25,6 +25,15 @@
 #define RPL_DEFAULT_INSTANCE 0
 #define DEFAULT_PATH_CONTROL_SIZE 0
 #define DEFAULT_DAO_DELAY 1
+#define DEFAULT_DAO_LIFETIME 0xff
+#define DEFAULT_ROUTE_AGGREGATION_INTERVAL 10
+#define DEFAULT_LOCAL_REPAIR_DELAY 1
+#define SEQUENCE_WINDOW 16
+#define DEFAULT_DIS_START_DELAY 1
+#define DEFAULT_DIS_INTERVAL 1
+#define DEFAULT_DIS_MAX_INTERVAL 32
+#define DEFAULT_DIS_RESPONSE_RATE 1
+#define DEFAULT_DIS_RESPONSE_BURST 3
 
 #define DEFAULT_STEP_OF_RANK 3
 #define MINIMUM_STEP_OF_RANK 1
@@ -42,20 +51,57 @@
 #define RPL_PORT 521
 #define ROOT_RANK 1 
 #define INFINITE_RANK 0xffff
-#define ROOT_ADDRESS "2001:1::200:ff:fe00:1"
 
-#define MOP 0
+#define MOP_NO_DOWNWARD 0
+#define MOP_STORING 2
+#define MOP_STORING_MULTICAST 3
+#define MOP_P2P 4
 #define OCP 0
 
+#define DEFAULT_LOAD_WEIGHT 768
+#define DEFAULT_LOAD_HYSTERESIS 256
+#define ROOT_LOAD_CHANGE 32
+#define DEFAULT_LINK_ETX 128
+#define DEFAULT_PARENT_SET_SIZE 3
+#define DEFAULT_MAX_TX_FAILURES 1
+#define DEFAULT_MAX_PROBES 3
+#define DEFAULT_NEIGHBOR_TABLE_SIZE 32
+#define DEFAULT_CONGESTION_WEIGHT 512
+#define DEFAULT_CONGESTION_HYSTERESIS 128
+#define QUEUE_LOAD_ALPHA 0.875
+#define DEFAULT_ENERGY_WEIGHT 512
+#define DEFAULT_ENERGY_HYSTERESIS 64
+#define ENERGY_FULL 100
+#define ENERGY_CHANGE 5
+#define DEFAULT_HANDOVER_RSSI -90.0
+#define DEFAULT_HANDOVER_ETX 384
+#define P2P_LOCAL_INSTANCE 0x80
+#define DEFAULT_P2P_MAX_RANK 8
+#define DEFAULT_P2P_DODAG_LIFETIME 2
+#define DEFAULT_P2P_ROUTE_LIFETIME 300
+#define P2P_FORWARD_JITTER 0.05
+#define MULTICAST_SEEN_SIZE 32
+
 #include <iostream>
+#include <algorithm>
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/assert.h"
 #include "ns3/node.h"
-
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/trace-source-accessor.h"
+
+#include "ns3/traffic-control-layer.h"
+#include "ns3/queue-disc.h"
 #include "ns3/ipv6-route.h"
 #include "ns3/ipv6-packet-info-tag.h"
 #include "ns3/icmpv6-header.h"
+#include "ns3/loopback-net-device.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/ndisc-cache.h"
 #include "rpl.h"
 #include "rpl-header.h"
 #include "rpl-option.h"
@@ -69,7 +115,23 @@ NS_LOG_COMPONENT_DEFINE ("Rpl");
 NS_OBJECT_ENSURE_REGISTERED (Rpl);
 
 Rpl::Rpl ()
-  : m_k(DEFAULT_DIO_REDUNDANCY_CONSTANT), m_counter(0), m_dioReceived(0)
+  : m_isRoot(false), m_leaf(false), m_grounded(true), m_loadBalancing(false), m_loadWeight(DEFAULT_LOAD_WEIGHT),
+    m_loadHysteresis(DEFAULT_LOAD_HYSTERESIS), m_rootCapacity(100), m_rootRxCount(0), m_rootRate(0),
+    m_pathMetrics(false), m_parentSetSize(DEFAULT_PARENT_SET_SIZE), m_rerouted(false), m_parentLost(false),
+    m_mobilityMode(false), m_handoverRssi(DEFAULT_HANDOVER_RSSI), m_handoverEtx(DEFAULT_HANDOVER_ETX),
+    m_handoverPending(false), m_p2pMaxRank(DEFAULT_P2P_MAX_RANK), m_p2pDodagLifetime(DEFAULT_P2P_DODAG_LIFETIME),
+    m_p2pInstance(0), m_multicast(false),
+    m_congestionAware(false), m_congestionWeight(DEFAULT_CONGESTION_WEIGHT),
+    m_congestionHysteresis(DEFAULT_CONGESTION_HYSTERESIS), m_queueLoad(0), m_energyAware(false),
+    m_energyWeight(DEFAULT_ENERGY_WEIGHT), m_energyHysteresis(DEFAULT_ENERGY_HYSTERESIS),
+    m_advertisedEnergy(ENERGY_FULL), m_multipath(false),
+    m_pathStatsSize(0), m_parentSwitches(0),
+    m_maxTxFailures(DEFAULT_MAX_TX_FAILURES), m_maxProbes(DEFAULT_MAX_PROBES), m_probesPerInterval(1),
+    m_neighborTableSize(DEFAULT_NEIGHBOR_TABLE_SIZE), m_evictionPolicy(RPL_EVICT_PIN_PARENTS),
+    m_downwardRoutes(false), m_daoAggregation(true), m_floatingDodag(false), m_floating(false),
+    m_detached(false), m_daoSequence(0), m_pathSequence(0), m_wakeAlignment(true), m_dioWakeups(0),
+    m_k(DEFAULT_DIO_REDUNDANCY_CONSTANT), m_counter(0), m_dioReceived(0), m_disMaxAttempts(0), m_disAttempts(0),
+    m_disResponseRate(DEFAULT_DIS_RESPONSE_RATE), m_disResponseBurst(DEFAULT_DIS_RESPONSE_BURST)
 {
   m_rng = CreateObject<UniformRandomVariable> ();
 }
@@ -85,13 +147,260 @@ TypeId Rpl::GetTypeId (void)
     .SetGroupName ("Rpl")
     .AddConstructor<Rpl> ()
     .AddAttribute ("MinimumIntervalSize", "Minimum Interval Size",
-                   TimeValue (MilliSeconds(2 ^ DEFAULT_DIO_INTERVAL_MIN)),
+                   TimeValue (MilliSeconds(1 << DEFAULT_DIO_INTERVAL_MIN)),
                    MakeTimeAccessor (&Rpl::m_iMin),
                    MakeTimeChecker ())
     .AddAttribute ("MaximumIntervalSize", "Maximum Interval Size",
-                   TimeValue (MilliSeconds((2 ^ DEFAULT_DIO_INTERVAL_DOUBLINGS) * (2 ^ DEFAULT_DIO_INTERVAL_MIN))),
+                   TimeValue (MilliSeconds((uint64_t (1) << DEFAULT_DIO_INTERVAL_DOUBLINGS) * (1 << DEFAULT_DIO_INTERVAL_MIN))),
                    MakeTimeAccessor (&Rpl::m_iMax),
                    MakeTimeChecker ())
+    .AddAttribute ("Root", "True if this node is a DODAG root",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_isRoot),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Leaf", "True if this node joins a DODAG as a leaf, never advertising it nor storing routes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_leaf),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DodagId", "DODAG ID advertised by a root (zero: the root's first global address)",
+                   Ipv6AddressValue (Ipv6Address::GetZero ()),
+                   MakeIpv6AddressAccessor (&Rpl::m_rootDodagId),
+                   MakeIpv6AddressChecker ())
+    .AddAttribute ("Grounded", "True if the DODAG started by a root is grounded",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Rpl::m_grounded),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LoadBalancing", "Take the DODAG root load into account when choosing among DODAGs",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_loadBalancing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LoadWeight", "Rank units added to a neighbor whose root is fully loaded",
+                   UintegerValue (DEFAULT_LOAD_WEIGHT),
+                   MakeUintegerAccessor (&Rpl::m_loadWeight),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("LoadHysteresis", "Rank units another DODAG must be better by before switching to it",
+                   UintegerValue (DEFAULT_LOAD_HYSTERESIS),
+                   MakeUintegerAccessor (&Rpl::m_loadHysteresis),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("RootCapacity", "Packets per second delivered to a root at full load",
+                   DoubleValue (100),
+                   MakeDoubleAccessor (&Rpl::m_rootCapacity),
+                   MakeDoubleChecker<double> (0.001))
+    .AddAttribute ("LoadUpdateInterval", "Period of the root load computation",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&Rpl::m_loadUpdateInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("PathMetrics", "Advertise hop count, latency and ETX path metrics in DIOs",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_pathMetrics),
+                   MakeBooleanChecker ())
+    .AddAttribute ("HopLatency", "Estimated latency of a link, added to the path latency at each hop",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&Rpl::m_hopLatency),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxPathLatency", "Path latency constraint advertised by a root (zero: unconstrained)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Rpl::m_maxPathLatency),
+                   MakeTimeChecker ())
+    .AddAttribute ("ParentSetSize", "Maximum number of parents kept for fast local reroute",
+                   UintegerValue (DEFAULT_PARENT_SET_SIZE),
+                   MakeUintegerAccessor (&Rpl::m_parentSetSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxTxFailures", "Consecutive unicast losses after which a neighbor is unreachable",
+                   UintegerValue (DEFAULT_MAX_TX_FAILURES),
+                   MakeUintegerAccessor (&Rpl::m_maxTxFailures),
+                   MakeUintegerChecker<uint8_t> (1))
+    .AddAttribute ("NeighborFreshness", "Time after which a silent candidate parent is probed",
+                   TimeValue (Seconds (30)),
+                   MakeTimeAccessor (&Rpl::m_neighborFreshness),
+                   MakeTimeChecker ())
+    .AddAttribute ("ProbeInterval", "Period of the neighbor unreachability check (zero: disabled)",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&Rpl::m_probeInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxProbes", "Unanswered probes after which a neighbor is unreachable",
+                   UintegerValue (DEFAULT_MAX_PROBES),
+                   MakeUintegerAccessor (&Rpl::m_maxProbes),
+                   MakeUintegerChecker<uint8_t> (1))
+    .AddAttribute ("ProbesPerInterval", "Maximum number of probes sent per check",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&Rpl::m_probesPerInterval),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("NeighborTableSize", "Maximum number of neighbors kept (zero: unbounded)",
+                   UintegerValue (DEFAULT_NEIGHBOR_TABLE_SIZE),
+                   MakeUintegerAccessor (&Rpl::m_neighborTableSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("NeighborEviction", "Which neighbor to evict when the neighbor table is full",
+                   EnumValue (RPL_EVICT_PIN_PARENTS),
+                   MakeEnumAccessor (&Rpl::m_evictionPolicy),
+                   MakeEnumChecker (RPL_EVICT_LRU, "Lru",
+                                    RPL_EVICT_WORST_RANK, "WorstRank",
+                                    RPL_EVICT_PIN_PARENTS, "PinParents"))
+    .AddAttribute ("CongestionAware", "Take the path queue occupancy into account when choosing a parent",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_congestionAware),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CongestionWeight", "Rank units added to a parent whose path is fully congested",
+                   UintegerValue (DEFAULT_CONGESTION_WEIGHT),
+                   MakeUintegerAccessor (&Rpl::m_congestionWeight),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("CongestionHysteresis", "Cost units another parent must be better by before switching to it",
+                   UintegerValue (DEFAULT_CONGESTION_HYSTERESIS),
+                   MakeUintegerAccessor (&Rpl::m_congestionHysteresis),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("QueueSampleInterval", "Period of the queue occupancy sampling",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&Rpl::m_queueSampleInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("EnergyAware", "Take the residual energy of the path into account when choosing a parent, not with CongestionAware",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_energyAware),
+                   MakeBooleanChecker ())
+    .AddAttribute ("EnergyWeight", "Rank units added to a parent whose path energy is exhausted",
+                   UintegerValue (DEFAULT_ENERGY_WEIGHT),
+                   MakeUintegerAccessor (&Rpl::m_energyWeight),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("EnergyHysteresis", "Cost units another parent must be better by before switching to it",
+                   UintegerValue (DEFAULT_ENERGY_HYSTERESIS),
+                   MakeUintegerAccessor (&Rpl::m_energyHysteresis),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("EnergySampleInterval", "Period of the residual energy sampling",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&Rpl::m_energySampleInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("WakeAlignment", "Send Trickle DIOs in the wake windows of the radio, when it has a wake schedule",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Rpl::m_wakeAlignment),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MobilityMode", "Hand over to another parent when the RSSI or ETX of the parent link degrades",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_mobilityMode),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MobilityCheckInterval", "Period of the parent link check in mobility mode",
+                   TimeValue (MilliSeconds (500)),
+                   MakeTimeAccessor (&Rpl::m_mobilityCheckInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("HandoverRssi", "Lowest usable RSSI of a parent link (dBm)",
+                   DoubleValue (DEFAULT_HANDOVER_RSSI),
+                   MakeDoubleAccessor (&Rpl::m_handoverRssi),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("HandoverEtx", "Highest usable ETX of a parent link, ETX * 128",
+                   UintegerValue (DEFAULT_HANDOVER_ETX),
+                   MakeUintegerAccessor (&Rpl::m_handoverEtx),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("HandoverHorizon", "How far ahead the RSSI trend of a link is extrapolated",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&Rpl::m_handoverHorizon),
+                   MakeTimeChecker ())
+    .AddAttribute ("Multipath", "Spread upward flows over the parents with the rank of the preferred parent",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_multipath),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PathStatsSize", "Forwarded packets recorded for per-flow path statistics, 0 to record none",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Rpl::m_pathStatsSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DownwardRoutes", "Advertise storing mode when root, so that nodes announce themselves in DAOs",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_downwardRoutes),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Multicast", "Advertise storing mode with multicast when root, so that routers forward multicast packets only towards subscribers",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_multicast),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DaoDelay", "Time a DAO target is held to be sent along with others",
+                   TimeValue (Seconds (DEFAULT_DAO_DELAY)),
+                   MakeTimeAccessor (&Rpl::m_daoDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("DaoAggregation", "Merge pending DAO targets into as few DAOs and prefixes as possible",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Rpl::m_daoAggregation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RouteAggregationInterval", "Interval between two passes collapsing downward routes into covering prefixes, zero to disable",
+                   TimeValue (Seconds (DEFAULT_ROUTE_AGGREGATION_INTERVAL)),
+                   MakeTimeAccessor (&Rpl::m_routeAggregationInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("GlobalRepairInterval", "Interval between two global repairs started by the root, zero to disable",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Rpl::m_globalRepairInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("LocalRepairDelay", "Time a detached node waits for its poisoned sub-DODAG before looking for a parent",
+                   TimeValue (Seconds (DEFAULT_LOCAL_REPAIR_DELAY)),
+                   MakeTimeAccessor (&Rpl::m_localRepairDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("DisStartDelay", "Maximum random delay before the first multicast DIS",
+                   TimeValue (Seconds (DEFAULT_DIS_START_DELAY)),
+                   MakeTimeAccessor (&Rpl::m_disStartDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("DisInterval", "Interval between the first two multicast DISs, doubled after each DIS",
+                   TimeValue (Seconds (DEFAULT_DIS_INTERVAL)),
+                   MakeTimeAccessor (&Rpl::m_disInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("DisMaxInterval", "Maximum interval between two multicast DISs",
+                   TimeValue (Seconds (DEFAULT_DIS_MAX_INTERVAL)),
+                   MakeTimeAccessor (&Rpl::m_disMaxInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("DisMaxAttempts", "Multicast DISs sent before giving up, 0 for no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Rpl::m_disMaxAttempts),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DisResponseRate", "DIS responses allowed per second and interface, 0 for no limit",
+                   DoubleValue (DEFAULT_DIS_RESPONSE_RATE),
+                   MakeDoubleAccessor (&Rpl::m_disResponseRate),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("DisResponseBurst", "DIS responses allowed in a burst on an interface",
+                   UintegerValue (DEFAULT_DIS_RESPONSE_BURST),
+                   MakeUintegerAccessor (&Rpl::m_disResponseBurst),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FloatingDodag", "Form a floating DODAG when a detached node finds no parent",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Rpl::m_floatingDodag),
+                   MakeBooleanChecker ())
+    .AddAttribute ("P2pMaxRank", "Highest DAGRank, in hops, of a router in the temporary DODAG of a route discovery",
+                   UintegerValue (DEFAULT_P2P_MAX_RANK),
+                   MakeUintegerAccessor (&Rpl::m_p2pMaxRank),
+                   MakeUintegerChecker<uint8_t> (1, 63))
+    .AddAttribute ("P2pDodagLifetime", "Lifetime of the temporary DODAG of a route discovery: 1 s, 4 s, 16 s or 64 s for 0 to 3",
+                   UintegerValue (DEFAULT_P2P_DODAG_LIFETIME),
+                   MakeUintegerAccessor (&Rpl::m_p2pDodagLifetime),
+                   MakeUintegerChecker<uint8_t> (0, 3))
+    .AddAttribute ("P2pRouteLifetime", "Lifetime of a route found by a route discovery",
+                   TimeValue (Seconds (DEFAULT_P2P_ROUTE_LIFETIME)),
+                   MakeTimeAccessor (&Rpl::m_p2pRouteLifetime),
+                   MakeTimeChecker ())
+    .AddTraceSource ("Reroute", "Switched to a backup parent after losing the preferred one",
+                     MakeTraceSourceAccessor (&Rpl::m_rerouteTrace),
+                     "ns3::Rpl::RerouteTracedCallback")
+    .AddTraceSource ("Handover", "Switched parent in mobility mode before the link to the old one broke",
+                     MakeTraceSourceAccessor (&Rpl::m_handoverTrace),
+                     "ns3::Rpl::RerouteTracedCallback")
+    .AddTraceSource ("PacketSaved", "Packet routed through a backup parent before a DIO confirmed it",
+                     MakeTraceSourceAccessor (&Rpl::m_packetSavedTrace),
+                     "ns3::Rpl::PacketSavedTracedCallback")
+    .AddTraceSource ("Upward", "Packet routed towards the root, with the parent it is handed to",
+                     MakeTraceSourceAccessor (&Rpl::m_upwardTrace),
+                     "ns3::Rpl::UpwardTracedCallback")
+    .AddTraceSource ("DaoTx", "DAO sent to a parent, with the number of targets it carries",
+                     MakeTraceSourceAccessor (&Rpl::m_daoTxTrace),
+                     "ns3::Rpl::DaoTxTracedCallback")
+    .AddTraceSource ("RepairStart", "Global repair started by the root, or node detached from its DODAG",
+                     MakeTraceSourceAccessor (&Rpl::m_repairStartTrace),
+                     "ns3::Rpl::RepairStartTracedCallback")
+    .AddTraceSource ("Repaired", "Node attached again after a global or local repair",
+                     MakeTraceSourceAccessor (&Rpl::m_repairedTrace),
+                     "ns3::Rpl::RepairedTracedCallback")
+    .AddTraceSource ("ControlTx", "RPL control message sent, with its ICMPv6 code",
+                     MakeTraceSourceAccessor (&Rpl::m_controlTxTrace),
+                     "ns3::Rpl::ControlTxTracedCallback")
+    .AddTraceSource ("DisRx", "DIS received, and whether it was answered at once",
+                     MakeTraceSourceAccessor (&Rpl::m_disRxTrace),
+                     "ns3::Rpl::DisRxTracedCallback")
+    .AddTraceSource ("P2pRoute", "Route found by a route discovery started here",
+                     MakeTraceSourceAccessor (&Rpl::m_p2pRouteTrace),
+                     "ns3::Rpl::P2pRouteTracedCallback")
+    .AddTraceSource ("MulticastTx", "Multicast data packet sent or forwarded, with the neighbor it is sent to",
+                     MakeTraceSourceAccessor (&Rpl::m_multicastTxTrace),
+                     "ns3::Rpl::MulticastTxTracedCallback")
     ;
 
   return tid;
@@ -101,7 +410,21 @@ void Rpl::DoInitialize ()
 {
   NS_LOG_FUNCTION (this);
 
-  bool isRoot = 0;
+  NS_ABORT_MSG_IF (m_isRoot && m_leaf, "A DODAG root cannot be a leaf");
+  NS_ABORT_MSG_IF (m_energyAware && m_congestionAware,
+                   "EnergyAware and CongestionAware parent selection cannot be combined");
+  m_routingTable.SetNodeType (!m_leaf);
+
+  // a leaf only remembers its parent, replaced when a lower rank is heard
+  if (m_leaf)
+    {
+      m_neighborSet.SetCapacity (1, RPL_EVICT_WORST_RANK);
+    }
+  else
+    {
+      m_neighborSet.SetCapacity (m_neighborTableSize, m_evictionPolicy);
+    }
+  m_pathStats.SetCapacity (m_pathStatsSize);
 
   for (uint32_t i = 0 ; i < m_routingTable.GetIpv6()->GetNInterfaces (); i++)
   {
@@ -109,49 +432,17 @@ void Rpl::DoInitialize ()
       {
          Ipv6InterfaceAddress address = m_routingTable.GetIpv6()->GetAddress (i, j);
 
-         if (address.GetScope() == Ipv6InterfaceAddress::LINKLOCAL)
+         if (address.GetScope() == Ipv6InterfaceAddress::LINKLOCAL && !GetSocket (i))
           {
-            NS_LOG_LOGIC ("RPL: adding socket to " << address.GetAddress ());
-            TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-            Ptr<Node> theNode = GetObject<Node> ();
-            Ptr<Socket> socket = Socket::CreateSocket (theNode, tid);
-            Inet6SocketAddress local = Inet6SocketAddress (address.GetAddress (), RPL_PORT);
-
-            int ret = socket->Bind (local);
-            NS_ASSERT_MSG (ret == 0, "Bind unsuccessful");
-            socket->BindToNetDevice (m_routingTable.GetIpv6()->GetNetDevice (i));
-            socket->SetRecvCallback (MakeCallback (&Rpl::Receive, this));
-            socket->SetIpv6RecvHopLimit (true);
-            socket->SetRecvPktInfo (true);
-            m_sendSocketList[socket] = i;
+            OpenSocket (i, address.GetAddress ());
           }
       }
   }
 
-  for (uint32_t i = 0 ; i < m_routingTable.GetIpv6 ()->GetNInterfaces (); i++)
+  if (m_isRoot)
     {
-      for (uint32_t j = 0; j < m_routingTable.GetIpv6 ()->GetNAddresses (i); j++)
-        {
-          Ipv6InterfaceAddress address =  m_routingTable.GetIpv6 ()->GetAddress (i, j);
-          Ipv6Prefix networkMask = address.GetPrefix ();
-          Ipv6Address networkAddress = address.GetAddress ().CombinePrefix (networkMask);
-          //cout << "addr" << address << std:endl;  
-          if (address.GetAddress() == (ROOT_ADDRESS))
-            {
-              m_routingTable.SetRank (ROOT_RANK);
-              m_routingTable.SetNodeType (true);
-              m_routingTable.SetRplInstanceId (RPL_DEFAULT_INSTANCE);
-              m_routingTable.SetDtsn (1);
-              m_routingTable.SetVersionNumber (1);
-              m_routingTable.SetDodagId ("2002:1::"); //Di pa ko sure kung paano nag-aaddressing.
-              m_routingTable.SetFlagG (true);
-              //std::cout << "Root" << std::endl;
-              //SendDio (ALL_RPL_NODES);
-              isRoot = 1;
-              break;
-            }
-        }
-  }
+      BecomeRoot ();
+    }
 
   if (!m_recvSocket) 
     {
@@ -166,15 +457,298 @@ void Rpl::DoInitialize ()
       m_recvSocket->SetRecvPktInfo (true);
     }
 
-  if (!isRoot)
+  if (!m_isRoot)
   {
     Join ();
   }
 
+  if (!m_wakeSchedule)
+    {
+      m_wakeSchedule = GetObject<Node> ()->GetObject<RplWakeSchedule> ();
+    }
   StartTrickle ();
+
+  if (m_congestionAware && !m_isRoot && !m_leaf)
+    {
+      m_queueSample = Simulator::Schedule (m_queueSampleInterval, &Rpl::SampleQueue, this);
+    }
+
+  if (m_energyAware && !m_leaf)
+    {
+      m_energySample = Simulator::Schedule (m_energySampleInterval, &Rpl::SampleEnergy, this);
+    }
+
+  if (m_isRoot && !m_globalRepairInterval.IsZero ())
+    {
+      m_globalRepair = Simulator::Schedule (m_globalRepairInterval, &Rpl::GlobalRepair, this);
+    }
+
+  if (!m_routeAggregationInterval.IsZero () && !m_leaf)
+    {
+      m_routeAggregation = Simulator::Schedule (m_routeAggregationInterval, &Rpl::AggregateRoutes, this);
+    }
+
+  if (!m_isRoot && !m_probeInterval.IsZero ())
+    {
+      m_nudTimer = Simulator::Schedule (Seconds (m_rng->GetValue (0, m_probeInterval.GetSeconds ())),
+                                        &Rpl::NudCheck, this);
+    }
+
+  if (m_mobilityMode && !m_isRoot)
+    {
+      m_mobilityCheck = Simulator::Schedule (Seconds (m_rng->GetValue (0, m_mobilityCheckInterval.GetSeconds ())),
+                                             &Rpl::MobilityCheck, this);
+    }
+
   Ipv6RoutingProtocol::DoInitialize ();
 }
 
+RplTokenBucket::RplTokenBucket ()
+  : m_rate (0),
+    m_burst (1),
+    m_tokens (1)
+{
+}
+
+void RplTokenBucket::SetRate (double rate, uint32_t burst)
+{
+  m_rate = rate;
+  m_burst = burst;
+  m_tokens = burst;
+  m_lastRefill = Simulator::Now ();
+}
+
+void RplTokenBucket::Refill (Time now)
+{
+  m_tokens = std::min<double> (m_burst, m_tokens + (now - m_lastRefill).GetSeconds () * m_rate);
+  m_lastRefill = now;
+}
+
+bool RplTokenBucket::Consume (Time now)
+{
+  if (m_rate == 0)
+    {
+      return true;
+    }
+  Refill (now);
+  if (m_tokens < 1)
+    {
+      return false;
+    }
+  m_tokens -= 1;
+  return true;
+}
+
+Time RplTokenBucket::GetDelay (Time now)
+{
+  if (m_rate == 0)
+    {
+      return Seconds (0);
+    }
+  Refill (now);
+  if (m_tokens >= 1)
+    {
+      return Seconds (0);
+    }
+  return Seconds ((1 - m_tokens) / m_rate);
+}
+
+void Rpl::BecomeRoot ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Ipv6Address dodagId = m_rootDodagId;
+  if (dodagId == Ipv6Address::GetZero ())
+    {
+      dodagId = GetGlobalAddress ();
+    }
+  NS_ABORT_MSG_IF (dodagId == Ipv6Address::GetZero (), "RPL root without a global address and no DodagId set");
+
+  m_routingTable.SetRank (ROOT_RANK);
+  m_routingTable.SetNodeType (true);
+  m_routingTable.SetRplInstanceId (RPL_DEFAULT_INSTANCE);
+  m_routingTable.SetDtsn (1);
+  m_routingTable.SetVersionNumber (1);
+  m_routingTable.SetDodagId (dodagId);
+  m_routingTable.SetFlagG (m_grounded);
+  m_routingTable.SetMop (m_downwardRoutes ? (m_multicast ? MOP_STORING_MULTICAST : MOP_STORING) : MOP_NO_DOWNWARD);
+  NS_LOG_LOGIC ("RPL: root of DODAG " << dodagId);
+
+  RplMetricContainerOption metricContainer;
+  if (m_pathMetrics)
+    {
+      uint8_t types[] = { RPL_METRIC_HC, RPL_METRIC_LATENCY, RPL_METRIC_ETX };
+      for (uint8_t j = 0; j < sizeof (types); j++)
+        {
+          RplMetricObject metric;
+          metric.SetType (types[j]);
+          metric.SetAggregation (RPL_AGGREGATION_ADDITIVE);
+          metric.AddValue (0);
+          metricContainer.AddMetricObject (metric);
+        }
+    }
+  if (m_maxPathLatency.IsStrictlyPositive ())
+    {
+      RplMetricObject constraint;
+      constraint.SetType (RPL_METRIC_LATENCY);
+      constraint.SetFlagC (true);
+      constraint.AddValue (m_maxPathLatency.GetMicroSeconds ());
+      metricContainer.AddMetricObject (constraint);
+    }
+  m_routingTable.SetMetricContainer (metricContainer);
+
+  if (m_loadBalancing)
+    {
+      Ptr<Ipv6L3Protocol> ipv6 = m_routingTable.GetIpv6 ()->GetObject<Ipv6L3Protocol> ();
+      bool connected = ipv6->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&Rpl::RootLocalDeliver, this));
+      NS_ASSERT_MSG (connected, "Unable to trace local delivery for the root load");
+      m_loadUpdate = Simulator::Schedule (m_loadUpdateInterval, &Rpl::UpdateRootLoad, this);
+    }
+}
+
+void Rpl::GlobalRepair ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (!m_isRoot, "RPL: only the DODAG root can start a global repair");
+
+  m_routingTable.SetVersionNumber (NextVersion (m_routingTable.GetVersionNumber ()));
+  m_routingTable.SetDtsn (m_routingTable.GetDtsn () + 1);
+  NS_LOG_LOGIC ("RPL: global repair, version " << (uint32_t)m_routingTable.GetVersionNumber ());
+  m_repairStartTrace (true, m_routingTable.GetVersionNumber ());
+  ResetTrickle ();
+
+  m_globalRepair.Cancel ();
+  if (!m_globalRepairInterval.IsZero ())
+    {
+      m_globalRepair = Simulator::Schedule (m_globalRepairInterval, &Rpl::GlobalRepair, this);
+    }
+}
+
+bool Rpl::IsNewerVersion (uint8_t a, uint8_t b)
+{
+  // 128 to 255 is the linear part of the lollipop, 0 to 127 the circular one
+  bool aLinear = a > 127;
+  bool bLinear = b > 127;
+  if (a == b)
+    {
+      return false;
+    }
+  if (aLinear == bLinear)
+    {
+      return (a > b && a - b <= SEQUENCE_WINDOW) || (a < b && b - a > SEQUENCE_WINDOW);
+    }
+  if (aLinear)
+    {
+      return 256 + b - a > SEQUENCE_WINDOW;
+    }
+  return 256 + a - b <= SEQUENCE_WINDOW;
+}
+
+uint8_t Rpl::NextVersion (uint8_t version)
+{
+  if (version == 127 || version == 255)
+    {
+      return 1;
+    }
+  return version + 1;
+}
+
+Ipv6Address Rpl::GetGlobalAddress ()
+{
+  for (uint32_t i = 0 ; i < m_routingTable.GetIpv6 ()->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < m_routingTable.GetIpv6 ()->GetNAddresses (i); j++)
+        {
+          Ipv6InterfaceAddress address = m_routingTable.GetIpv6 ()->GetAddress (i, j);
+          if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL)
+            {
+              return address.GetAddress ();
+            }
+        }
+    }
+  return Ipv6Address::GetZero ();
+}
+
+void Rpl::RootLocalDeliver (const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  Ipv6Address destination = header.GetDestinationAddress ();
+  if (!destination.IsMulticast () && !destination.IsLinkLocal ())
+    {
+      m_rootRxCount++;
+    }
+}
+
+void Rpl::UpdateRootLoad ()
+{
+  NS_LOG_FUNCTION (this);
+  double rate = m_rootRxCount / m_loadUpdateInterval.GetSeconds ();
+  m_rootRxCount = 0;
+  m_rootRate = (m_rootRate + rate) / 2;
+
+  uint8_t load = (uint8_t) std::min (255.0, m_rootRate * 255 / m_rootCapacity);
+  uint8_t advertised = m_routingTable.GetRootLoad ();
+  m_routingTable.SetRootLoad (load);
+  NS_LOG_LOGIC ("RPL: root load " << (uint32_t)load);
+
+  // let the new load reach the DODAG quickly when it changed noticeably
+  if (std::abs ((int)load - (int)advertised) >= ROOT_LOAD_CHANGE)
+    {
+      ResetTrickle ();
+    }
+
+  m_loadUpdate = Simulator::Schedule (m_loadUpdateInterval, &Rpl::UpdateRootLoad, this);
+}
+
+bool Rpl::IsRoot () const
+{
+  return m_isRoot;
+}
+
+bool Rpl::IsLeaf () const
+{
+  return m_leaf;
+}
+
+Ipv6Address Rpl::GetDodagId () const
+{
+  return m_routingTable.GetDodagId ();
+}
+
+const RplNeighborSet & Rpl::GetNeighborSet () const
+{
+  return m_neighborSet;
+}
+
+const RplRoutingTable & Rpl::GetRoutingTable () const
+{
+  return m_routingTable;
+}
+
+const RplPathStats & Rpl::GetPathStats () const
+{
+  return m_pathStats;
+}
+
+uint16_t Rpl::GetRank () const
+{
+  return m_routingTable.GetRank ();
+}
+
+Ipv6Address Rpl::GetPreferredParent () const
+{
+  return m_routingTable.GetDodagParent ();
+}
+
+uint32_t Rpl::GetNDownwardRoutes () const
+{
+  return m_routingTable.GetNDownwardRoutes ();
+}
+
+uint32_t Rpl::GetNRoutes () const
+{
+  return m_routingTable.GetNRoutes ();
+}
+
 int64_t Rpl::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
@@ -191,21 +765,21 @@ Ptr<Ipv6Route> Rpl::RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<Ne
   std::cout << "This node's address is: " << m_routingTable.GetIpv6()->GetAddress(1,0) << std::endl;
 
   Ptr<Ipv6Route> rtentry = 0;
-  if (destination.IsMulticast ())
+  if (destination.IsMulticast () && !destination.IsLinkLocalMulticast ())
     {
       NS_LOG_LOGIC ("RouteOutput (): Multicast destination");
-      uint32_t outgoingInterface = m_routingTable.GetIpv6 ()->GetInterfaceForDevice (oif);
-      Ptr<Ipv6MulticastRoute> multicastEntry = Create<Ipv6MulticastRoute> ();
-
-      multicastEntry->SetGroup (destination);
-      multicastEntry->SetOrigin (header.GetSourceAddress ());
-      multicastEntry->SetOutputTtl (outgoingInterface, 255);
+      return RouteMulticastOutput (p, header, oif, sockerr);
     }
-  
+
     rtentry = m_routingTable.Lookup (destination, oif);
     if (rtentry)
       {
         sockerr = Socket::ERROR_NOTERROR;
+        if (m_rerouted && rtentry->GetGateway () == m_routingTable.GetDodagParent ())
+          {
+            m_packetSavedTrace (p, rtentry->GetGateway ());
+          }
+        rtentry = SelectUpwardRoute (rtentry, header, p);
       }
     else
       {
@@ -217,6 +791,51 @@ Ptr<Ipv6Route> Rpl::RouteOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<Ne
   return rtentry;
 }
 
+Ptr<Ipv6Route> Rpl::RouteMulticastOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif,
+                                          Socket::SocketErrno &sockerr)
+{
+  NS_LOG_FUNCTION (this << header << oif);
+
+  Ptr<Ipv6> ipv6 = m_routingTable.GetIpv6 ();
+  Ipv6Address group = header.GetDestinationAddress ();
+  Ipv6Address source = header.GetSourceAddress ();
+  if (source.IsAny ())
+    {
+      source = GetGlobalAddress ();
+    }
+
+  Ptr<Ipv6Route> route = Create<Ipv6Route> ();
+  route->SetSource (source);
+  route->SetDestination (group);
+  route->SetGateway (Ipv6Address::GetAny ());
+
+  if (m_routingTable.GetMop () == MOP_STORING_MULTICAST)
+    {
+      if (GetMulticastNextHops (group, source).empty ())
+        {
+          sockerr = Socket::ERROR_NOROUTETOHOST;
+          return 0;
+        }
+      // through the loopback, back into RouteInput, which sends a copy to each neighbor
+      route->SetOutputDevice (ipv6->GetNetDevice (0));
+      sockerr = Socket::ERROR_NOTERROR;
+      return route;
+    }
+
+  // flooded: sent to every neighbor, and not forwarded when heard back
+  uint32_t interface = oif ? ipv6->GetInterfaceForDevice (oif) : 1;
+  if (interface >= ipv6->GetNInterfaces ())
+    {
+      sockerr = Socket::ERROR_NOROUTETOHOST;
+      return 0;
+    }
+  IsMulticastDuplicate (p);
+  route->SetOutputDevice (ipv6->GetNetDevice (interface));
+  m_multicastTxTrace (p, group, Ipv6Address::GetAny ());
+  sockerr = Socket::ERROR_NOTERROR;
+  return route;
+}
+
 bool Rpl::RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const NetDevice> idev, UnicastForwardCallback ucb, MulticastForwardCallback mcb,
                         LocalDeliverCallback lcb, ErrorCallback ecb)
 {
@@ -238,419 +857,2251 @@ bool Rpl::RouteInput (Ptr<const Packet> p, const Ipv6Header &header, Ptr<const N
       multicastEntry->SetOrigin (header.GetSourceAddress ());
       multicastEntry->SetParent (iif);
 
-      mcb (idev, multicastEntry, p, header);
-      return true; 
+      // beyond link-local scope, routers pass the packet on, once; the
+      // local delivery to the group members is done by Ipv6L3Protocol.
+      // The packets of this node come back through the loopback.
+      bool local = DynamicCast<const LoopbackNetDevice> (idev) != 0;
+      if (dst.IsLinkLocalMulticast () || (!local && (m_leaf || !m_routingTable.GetIpv6 ()->IsForwarding (iif))) ||
+          IsMulticastDuplicate (p))
+        {
+          mcb (idev, multicastEntry, p, header);
+          return true;
+        }
+
+      if (m_routingTable.GetMop () == MOP_STORING_MULTICAST)
+        {
+          std::vector<std::pair<Ipv6Address, uint32_t> > nextHops = GetMulticastNextHops (dst, header.GetSourceAddress ());
+          for (std::vector<std::pair<Ipv6Address, uint32_t> >::iterator iter = nextHops.begin ();
+               iter != nextHops.end (); iter++)
+            {
+              Ptr<Ipv6Route> route = Create<Ipv6Route> ();
+              route->SetSource (header.GetSourceAddress ());
+              route->SetDestination (dst);
+              route->SetGateway (iter->first);
+              route->SetOutputDevice (m_routingTable.GetIpv6 ()->GetNetDevice (iter->second));
+              m_multicastTxTrace (p, dst, iter->first);
+              ucb (idev, route, p, header);
+            }
+          return true;
+        }
+
+      // without group state, every router floods the packet to its neighbors
+      multicastEntry->SetOutputTtl (iif, 255);
+      m_multicastTxTrace (p, dst, Ipv6Address::GetAny ());
+      mcb (idev, multicastEntry, p, header);
+      return true;
+    }
+
+  if (header.GetDestinationAddress ().IsLinkLocal () ||
+      header.GetSourceAddress ().IsLinkLocal ())
+    {
+      NS_LOG_LOGIC ("Dropping packet not for me and with src or dst LinkLocal");
+      if (!ecb.IsNull ())
+        {
+          ecb (p, header, Socket::ERROR_NOROUTETOHOST);
+        }
+      return false;
+    }
+
+  if (m_routingTable.GetIpv6 ()->IsForwarding (iif) == false)
+    {
+      NS_LOG_LOGIC ("Forwarding disabled for this interface");
+      if (!ecb.IsNull ())
+        {
+          ecb (p, header, Socket::ERROR_NOROUTETOHOST);
+        }
+      return true;
+    }
+
+  NS_LOG_LOGIC ("Unicast destination");
+  //std::cout << "Unicast destination." <<std::endl;
+  Ptr<Ipv6Route> rtentry = m_routingTable.Lookup (header.GetDestinationAddress ());
+  if (rtentry != 0)
+    {
+      NS_LOG_LOGIC ("Found unicast destination - calling unicast callback");
+      if (m_rerouted && rtentry->GetGateway () == m_routingTable.GetDodagParent ())
+        {
+          m_packetSavedTrace (p, rtentry->GetGateway ());
+        }
+      rtentry = SelectUpwardRoute (rtentry, header, p);
+      if (m_pathStats.IsEnabled ())
+        {
+          RecordPath (header, p);
+        }
+      ucb (idev, rtentry, p, header);
+      return true;
+    }
+  else
+    {
+      NS_LOG_LOGIC ("Did not find unicast destination - returning false");
+      return false;
+    }
+}
+
+void Rpl::SampleQueue ()
+{
+  Ptr<Node> node = GetObject<Node> ();
+  Ptr<TrafficControlLayer> tc = node->GetObject<TrafficControlLayer> ();
+  double occupancy = 0;
+  for (uint32_t i = 0; tc && i < node->GetNDevices (); i++)
+    {
+      Ptr<QueueDisc> root = tc->GetRootQueueDiscOnDevice (node->GetDevice (i));
+      if (!root)
+        {
+          continue;
+        }
+      // a classful root such as mq has no limit of its own, its children do
+      occupancy = std::max (occupancy, GetQueueOccupancy (root));
+      for (std::size_t c = 0; c < root->GetNQueueDiscClasses (); c++)
+        {
+          occupancy = std::max (occupancy, GetQueueOccupancy (root->GetQueueDiscClass (c)->GetQueueDisc ()));
+        }
+    }
+
+  // smoothed so that a burst does not move the parent choice by itself
+  m_queueLoad = QUEUE_LOAD_ALPHA * m_queueLoad + (1 - QUEUE_LOAD_ALPHA) * occupancy;
+  m_queueSample = Simulator::Schedule (m_queueSampleInterval, &Rpl::SampleQueue, this);
+}
+
+double Rpl::GetQueueOccupancy (Ptr<QueueDisc> queue) const
+{
+  uint32_t capacity = queue->GetMaxSize ().GetValue ();
+  return capacity > 0 ? 255.0 * queue->GetNPackets () / capacity : 0;
+}
+
+uint8_t Rpl::GetPathQueueLoad ()
+{
+  uint8_t load = (uint8_t) std::min (255.0, m_queueLoad);
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if (parent && !m_isRoot)
+    {
+      load = std::max (load, parent->GetQueueLoad ());
+    }
+  return load;
+}
+
+uint8_t Rpl::GetResidualEnergy () const
+{
+  if (m_residualEnergy.IsNull ())
+    {
+      return ENERGY_FULL;
+    }
+  double fraction = std::min (1.0, m_residualEnergy ());
+  return (uint8_t) std::max (0.0, fraction * ENERGY_FULL);
+}
+
+void Rpl::SetResidualEnergyCallback (Callback<double> energy)
+{
+  NS_LOG_FUNCTION (this);
+  m_residualEnergy = energy;
+}
+
+void Rpl::SetWakeSchedule (Ptr<RplWakeSchedule> schedule)
+{
+  NS_LOG_FUNCTION (this << schedule);
+  m_wakeSchedule = schedule;
+}
+
+uint32_t Rpl::GetNDioWakeups () const
+{
+  return m_dioWakeups;
+}
+
+void Rpl::SampleEnergy ()
+{
+  NS_LOG_FUNCTION (this);
+  // let the children move away from a draining path before it is exhausted
+  uint8_t energy = GetPathEnergy ();
+  if ((int)m_advertisedEnergy - (int)energy >= ENERGY_CHANGE)
+    {
+      NS_LOG_LOGIC ("RPL: path energy down to " << (uint32_t)energy << "%");
+      ResetTrickle ();
+    }
+  m_energySample = Simulator::Schedule (m_energySampleInterval, &Rpl::SampleEnergy, this);
+}
+
+uint8_t Rpl::GetPathEnergy ()
+{
+  uint8_t energy = GetResidualEnergy ();
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if (parent && !m_isRoot)
+    {
+      energy = std::min (energy, parent->GetEnergy ());
+    }
+  return energy;
+}
+
+uint32_t Rpl::GetParentCost (Ptr<Neighbor> parent) const
+{
+  if (m_energyAware)
+    {
+      return RplObjectiveFunction::ComputeEnergyCost (parent->GetRank (), parent->GetEnergy (), m_energyWeight);
+    }
+  return RplObjectiveFunction::ComputeCongestionCost (parent->GetRank (), parent->GetQueueLoad (), m_congestionWeight);
+}
+
+uint32_t Rpl::FlowHash (const Ipv6Header &header, Ptr<const Packet> p) const
+{
+  // FNV-1a, seeded with the node id so that hops do not all make the same choice
+  uint32_t hash = 2166136261u ^ GetObject<Node> ()->GetId ();
+  uint8_t buf[40];
+  uint32_t size = 0;
+
+  uint32_t flowLabel = header.GetFlowLabel ();
+  header.GetSourceAddress ().GetBytes (buf);
+  header.GetDestinationAddress ().GetBytes (buf + 16);
+  size = 32;
+  if (flowLabel != 0)
+    {
+      buf[size++] = (flowLabel >> 16) & 0xff;
+      buf[size++] = (flowLabel >> 8) & 0xff;
+      buf[size++] = flowLabel & 0xff;
+    }
+  else
+    {
+      uint8_t nextHeader = header.GetNextHeader ();
+      buf[size++] = nextHeader;
+      // TCP and UDP both start with the source and destination ports
+      if (p && (nextHeader == 6 || nextHeader == 17) && p->GetSize () >= 4)
+        {
+          size += p->CopyData (buf + size, 4);
+        }
+    }
+
+  for (uint32_t i = 0; i < size; i++)
+    {
+      hash = (hash ^ buf[i]) * 16777619u;
+    }
+  return hash;
+}
+
+void Rpl::RecordPath (const Ipv6Header &header, Ptr<const Packet> p)
+{
+  // the ports FlowMonitor classifies TCP and UDP flows by
+  uint8_t protocol = header.GetNextHeader ();
+  uint8_t ports[4] = { 0, 0, 0, 0 };
+  if ((protocol == 6 || protocol == 17) && p->GetSize () >= 4)
+    {
+      p->CopyData (ports, 4);
+    }
+
+  RplPathRecord record;
+  record.packetUid = p->GetUid ();
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.flow = RplPathStats::FlowKey (header.GetSourceAddress (), header.GetDestinationAddress (), protocol,
+                                       (ports[0] << 8) | ports[1], (ports[2] << 8) | ports[3]);
+  record.rank = m_routingTable.GetRank ();
+  record.parentSwitches = m_parentSwitches;
+  m_pathStats.Record (record);
+}
+
+Ptr<Ipv6Route> Rpl::SelectUpwardRoute (Ptr<Ipv6Route> route, const Ipv6Header &header, Ptr<const Packet> p)
+{
+  Ipv6Address parent = m_routingTable.GetDodagParent ();
+  if (route->GetGateway () != parent || parent == Ipv6Address::GetZero ())
+    {
+      return route;
+    }
+
+  if (m_multipath)
+    {
+      Ptr<Neighbor> nextHop = m_neighborSet.SelectMultipathParent (parent, FlowHash (header, p));
+      if (nextHop && nextHop->GetNeighborAddress () != parent)
+        {
+          Ptr<Ipv6> ipv6 = m_routingTable.GetIpv6 ();
+          uint32_t interface = nextHop->GetInterface ();
+          route = Create<Ipv6Route> ();
+          route->SetSource (ipv6->SourceAddressSelection (interface, header.GetDestinationAddress ()));
+          route->SetDestination (header.GetDestinationAddress ());
+          route->SetGateway (nextHop->GetNeighborAddress ());
+          route->SetOutputDevice (ipv6->GetNetDevice (interface));
+        }
+    }
+
+  if (p)
+    {
+      m_upwardTrace (p, route->GetGateway ());
+    }
+  return route;
+}
+
+void Rpl::Receive (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  //std::cout <<"Entering Receive." <<std::endl;
+  
+  Address sender;
+  Ptr<Packet> packet = socket->RecvFrom (sender);
+  Inet6SocketAddress senderAddr = Inet6SocketAddress::ConvertFrom (sender);
+
+  Ipv6Address senderAddress = senderAddr.GetIpv6 ();
+  uint16_t senderPort = senderAddr.GetPort ();
+
+  Ipv6PacketInfoTag interfaceInfo;
+  if (!packet->RemovePacketTag (interfaceInfo))
+    {
+      NS_ABORT_MSG ("No incoming interface on RPL message, aborting...");
+    }
+
+  uint32_t incomingIf = interfaceInfo.GetRecvIf ();
+  Ptr<Node> node = this->GetObject<Node> ();
+  Ptr<NetDevice> dev = node->GetDevice (incomingIf);
+  uint32_t ipInterfaceIndex = m_routingTable.GetIpv6 ()->GetInterfaceForDevice (dev);
+
+  int32_t interfaceForAddress = m_routingTable.GetIpv6 ()->GetInterfaceForAddress (senderAddress);
+  if (interfaceForAddress != -1)
+    {
+      NS_LOG_LOGIC ("Ignoring a packet sent by myself.");
+      return;
+    }
+
+  Icmpv6Header rplMessage;
+  packet->RemoveHeader (rplMessage);
+  //std::cout << rplMessage << std::endl << "Code is: " << (uint32_t)rplMessage.GetCode() << std::endl;
+  
+  if (rplMessage.GetType () == 155)
+    {
+      if ( (uint32_t)rplMessage.GetCode () == 0) 
+        {
+          RplDisMessage disMessage;
+          RplSolicitedInformationOption solicitedInformation;
+          packet->RemoveHeader (disMessage);
+
+          // without a Solicited Information option every DODAG is solicited
+          uint8_t optionType;
+          if (packet->GetSize () > 0 && packet->CopyData (&optionType, 1) == 1 && optionType == 7)
+            {
+              packet->RemoveHeader (solicitedInformation);
+            }
+
+          RecvDis (disMessage, solicitedInformation, senderAddress, ipInterfaceIndex, senderPort,
+                   socket == m_recvSocket);
+        }
+      else if ((uint32_t)rplMessage.GetCode () == 1)
+        {
+          RplDioMessage dioMessage;
+          RplDodagConfigurationOption dodagConfiguration;
+          RplMetricContainerOption metricContainer;
+          packet->RemoveHeader (dioMessage);
+
+          // temporary DODAG of a route discovery: no DODAG configuration
+          if (dioMessage.GetMop () == MOP_P2P)
+            {
+              uint8_t optionType;
+              if (packet->GetSize () > 0 && packet->CopyData (&optionType, 1) == 1 && optionType == 10)
+                {
+                  RplP2pRouteDiscoveryOption routeDiscovery;
+                  packet->RemoveHeader (routeDiscovery);
+                  RecvP2pDio (dioMessage, routeDiscovery, senderAddress, ipInterfaceIndex);
+                }
+              return;
+            }
+
+          packet->RemoveHeader (dodagConfiguration);
+
+          uint8_t optionType;
+          if (packet->GetSize () > 0 && packet->CopyData (&optionType, 1) == 1 && optionType == 2)
+            {
+              packet->RemoveHeader (metricContainer);
+            }
+
+          if (m_dioReceived == 1)
+            {
+              m_multicastDis.Cancel ();
+              m_multicastDis = EventId ();
+              m_dioReceived = 0;
+            }
+
+          RecvDio (dioMessage, dodagConfiguration, metricContainer, senderAddress, ipInterfaceIndex);
+        }
+      else if ((uint32_t)rplMessage.GetCode () == 2)
+        {
+          RplDaoMessage daoMessage;
+          packet->RemoveHeader (daoMessage);
+
+          // each Transit Information option applies to the targets before it
+          std::vector<RplTargetOption> targets;
+          std::vector<RplTransitInformationOption> transits;
+          uint32_t described = 0;
+          uint8_t optionType;
+          while (packet->GetSize () > 0 && packet->CopyData (&optionType, 1) == 1)
+            {
+              if (optionType == 5)
+                {
+                  RplTargetOption target;
+                  packet->RemoveHeader (target);
+                  targets.push_back (target);
+                }
+              else if (optionType == 6)
+                {
+                  RplTransitInformationOption transit;
+                  packet->RemoveHeader (transit);
+                  for (; described < targets.size (); described++)
+                    {
+                      transits.push_back (transit);
+                    }
+                }
+              else
+                {
+                  break;
+                }
+            }
+          targets.resize (described);
+
+          RecvDao (daoMessage, targets, transits, senderAddress, ipInterfaceIndex);
+        }
+      else if ((uint32_t)rplMessage.GetCode () == 4)
+        {
+          RplDroMessage droMessage;
+          packet->RemoveHeader (droMessage);
+
+          uint8_t optionType;
+          if (packet->GetSize () > 0 && packet->CopyData (&optionType, 1) == 1 && optionType == 10)
+            {
+              RplP2pRouteDiscoveryOption routeDiscovery;
+              packet->RemoveHeader (routeDiscovery);
+              RecvDro (droMessage, routeDiscovery, senderAddress, ipInterfaceIndex);
+            }
+        }
+    }
+  else
+    {
+      NS_ABORT_MSG ("Not a RPL message, aborting...");
+    }  
+
+  return;
+}
+
+void Rpl::Join ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // nodes switched on together must not solicit in lockstep
+  m_dioReceived = 1;
+  m_disAttempts = 0;
+  m_disBackoff = m_disInterval;
+  m_multicastDis.Cancel ();
+  m_multicastDis = Simulator::Schedule (Seconds (m_rng->GetValue (0, m_disStartDelay.GetSeconds ())),
+                                        &Rpl::SendMulticastDis, this);
+}
+
+bool Rpl::IsSolicited (const RplSolicitedInformationOption &solicitedInformation) const
+{
+  if (solicitedInformation.GetFlagV () &&
+      solicitedInformation.GetVersionNumber () != m_routingTable.GetVersionNumber ())
+    {
+      return false;
+    }
+  if (solicitedInformation.GetFlagI () &&
+      solicitedInformation.GetRplInstanceId () != m_routingTable.GetRplInstanceId ())
+    {
+      return false;
+    }
+  if (solicitedInformation.GetFlagD () &&
+      solicitedInformation.GetDodagId () != m_routingTable.GetDodagId ())
+    {
+      return false;
+    }
+  return true;
+}
+
+void Rpl::RecvDis (RplDisMessage disMessage, RplSolicitedInformationOption solicitedInformation, Ipv6Address senderAddress, uint32_t incomingInterface, uint16_t senderPort, bool multicast)
+{
+  NS_LOG_FUNCTION (this << senderAddress << incomingInterface << multicast);
+
+  // leaves never advertise a DODAG, and only the solicited DODAGs answer
+  if (!m_routingTable.GetNodeType () || m_routingTable.GetVersionNumber () == 0 ||
+      !IsSolicited (solicitedInformation))
+    {
+      m_disRxTrace (senderAddress, multicast, false);
+      return;
+    }
+
+  std::map<uint32_t, RplTokenBucket>::iterator bucket = m_disTokens.find (incomingInterface);
+  if (bucket == m_disTokens.end ())
+    {
+      bucket = m_disTokens.insert (std::make_pair (incomingInterface, RplTokenBucket ())).first;
+      bucket->second.SetRate (m_disResponseRate, m_disResponseBurst);
+    }
+  RplTokenBucket &tokens = bucket->second;
+  if (m_coalescedDio[incomingInterface].IsRunning ())
+    {
+      m_disRxTrace (senderAddress, multicast, false);
+      return;
+    }
+  if (!tokens.Consume (Simulator::Now ()))
+    {
+      // one multicast DIO answers the whole burst
+      NS_LOG_LOGIC ("RPL: DIS from " << senderAddress << " coalesced");
+      m_coalescedDio[incomingInterface] = Simulator::Schedule (tokens.GetDelay (Simulator::Now ()),
+                                                               &Rpl::SendCoalescedDio, this, incomingInterface);
+      m_disRxTrace (senderAddress, multicast, false);
+      return;
+    }
+
+  // a unicast DIS is a reachability probe, the unicast DIO answers it
+  if (multicast)
+    {
+      ResetTrickle ();
+    }
+  else
+    {
+      SendDio (senderAddress, incomingInterface, senderPort);
+    }
+  m_disRxTrace (senderAddress, multicast, true);
+}
+
+void Rpl::SendCoalescedDio (uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+  m_disTokens[interface].Consume (Simulator::Now ());
+  SendDio (ALL_RPL_NODES, interface);
+}
+
+void Rpl::RecvDio (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, RplMetricContainerOption metricContainer, Ipv6Address senderAddress, uint32_t incomingInterface)
+{
+  std::cout << "Received DIO from " << senderAddress << "Rank is " << dioMessage.GetRank() << "\n";
+
+  // a neighbor still in an older version of the DODAG is no parent
+  bool sameDodag = (dioMessage.GetDodagId () == m_routingTable.GetDodagId ());
+  bool stale = sameDodag && IsNewerVersion (m_routingTable.GetVersionNumber (), dioMessage.GetVersionNumber ());
+  uint8_t rootLoad = 0;
+  metricContainer.GetRootLoad (rootLoad);
+  InsertNeighbor (senderAddress, dioMessage.GetDodagId (), dioMessage.GetDtsn (),
+                  stale ? INFINITE_RANK : dioMessage.GetRank (), incomingInterface, rootLoad);
+
+  uint32_t pathLatency = 0;
+  uint8_t queueLoad = 0;
+  uint8_t energy = ENERGY_FULL;
+  metricContainer.GetMetricValue (RPL_METRIC_LATENCY, pathLatency);
+  metricContainer.GetQueueLoad (queueLoad);
+  metricContainer.GetNodeEnergy (energy);
+  Ptr<Neighbor> sender = m_neighborSet.FindNeighbor (senderAddress);
+  if (sender)
+    {
+      sender->SetPathLatency (pathLatency);
+      sender->SetQueueLoad (queueLoad);
+      sender->SetEnergy (energy);
+    }
+  bool admissible = RplObjectiveFunction::MeetsConstraints (metricContainer, m_hopLatency.GetMicroSeconds ());
+
+  //non storing mode
+  if (!m_leaf)
+    {
+      m_routingTable.AddNetworkRouteTo (senderAddress, incomingInterface);
+    }
+
+  if (dioMessage.GetDodagId () == m_routingTable.GetDodagId () &&
+      dioMessage.GetVersionNumber () == m_routingTable.GetVersionNumber () &&
+      dioMessage.GetRank () != INFINITE_RANK)
+    {
+      m_counter++;
+    }
+
+  // a floating root only looks for a grounded DODAG to join
+  if (m_isRoot || (m_floating && sameDodag))
+    {
+      return;
+    }
+
+  // the parent detached: its sub-DODAG, this node included, is poisoned
+  if (sameDodag && !stale && senderAddress == m_routingTable.GetDodagParent () &&
+      dioMessage.GetRank () == INFINITE_RANK)
+    {
+      NS_LOG_LOGIC ("RPL: poisoned by parent " << senderAddress);
+      NotifyLinkFailure (senderAddress);
+    }
+
+  if (dioMessage.GetDodagId () == m_routingTable.GetDodagId () &&
+      senderAddress == m_routingTable.GetDodagParent ())
+    {
+      // regular DIO processing would have found this parent as well
+      m_rerouted = false;
+
+      uint8_t advertised = m_routingTable.GetRootLoad ();
+      m_routingTable.SetRootLoad (rootLoad);
+      if (std::abs ((int)rootLoad - (int)advertised) >= ROOT_LOAD_CHANGE)
+        {
+          ResetTrickle ();
+        }
+    }
+
+  if (dioMessage.GetRank () == INFINITE_RANK)
+    {
+      // a poisoned neighbor is never a parent
+    }
+  else if (m_routingTable.GetRank () == 0 || dioMessage.GetDodagId () != m_routingTable.GetDodagId ())
+    {
+      if (admissible && IsPreferredDodag (dioMessage, senderAddress))
+        {
+          JoinDodag (dioMessage, dodagConfiguration, senderAddress, incomingInterface);
+        }
+    }
+  else if (dioMessage.GetVersionNumber () != m_routingTable.GetVersionNumber ())
+    {
+      // global repair: the new version is joined afresh, whatever the rank
+      if (admissible && !stale)
+        {
+          JoinDodag (dioMessage, dodagConfiguration, senderAddress, incomingInterface);
+        }
+    }
+  else
+    {
+      // a new DTSN from the parent asks for the downward routes again
+      if (dioMessage.GetDtsn () != m_routingTable.GetDtsn () && senderAddress == m_routingTable.GetDodagParent ())
+        {
+          m_routingTable.SetDtsn (dioMessage.GetDtsn ());
+          if (IsStoring ())
+            {
+              AnnounceDaoTargets ();
+            }
+        }
+      // a detached node waits for the poison to reach its sub-DODAG
+      if (!m_localRepair.IsRunning ())
+        {
+          UpdatePreferredParent ();
+        }
+      // the DIO may come from a parent to hand over to
+      if (m_handoverPending)
+        {
+          Handover (false);
+        }
+    }
+
+  // path metrics follow the preferred parent
+  if (senderAddress == m_routingTable.GetDodagParent () &&
+      dioMessage.GetDodagId () == m_routingTable.GetDodagId ())
+    {
+      RplMetricContainerOption pathMetrics = metricContainer;
+      Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (senderAddress);
+      uint16_t linkEtx = parent ? parent->GetEtx () : DEFAULT_LINK_ETX;
+      RplObjectiveFunction::UpdateMetrics (pathMetrics, m_hopLatency.GetMicroSeconds (), linkEtx);
+      m_routingTable.SetMetricContainer (pathMetrics);
+    }
+
+  if (!m_detached)
+    {
+      m_neighborSet.UpdateParentSet (m_routingTable.GetDodagId (), m_routingTable.GetRank (), m_parentSetSize);
+    }
+
+  std::cout << "DODAG ID (after recv DIS): " << m_routingTable.GetDodagId () << "\n";
+  std::cout << "This node's address is: " << m_routingTable.GetIpv6()->GetAddress(1,0) << std::endl;
+  std::cout << "This node's rank is " << m_routingTable.GetRank() << std::endl;
+}
+
+bool Rpl::IsPreferredDodag (RplDioMessage dioMessage, Ipv6Address senderAddress)
+{
+  // a detached node takes any other DODAG, its sub-DODAG is not part of it
+  if (m_routingTable.GetRank () == 0 || m_detached)
+    {
+      return true;
+    }
+
+  // RFC 6550 8.2.2.2: grounded DODAGs first, then the lowest resulting rank
+  if (dioMessage.GetFlagG () != m_routingTable.GetFlagG ())
+    {
+      return dioMessage.GetFlagG ();
+    }
+
+  // move only when the sender is the cheapest parent once root loads are
+  // accounted for, and beats the current DODAG by the hysteresis margin
+  if (m_loadBalancing)
+    {
+      Ptr<Neighbor> parent = m_neighborSet.SelectParent (m_routingTable.GetDodagId (), m_loadWeight, m_loadHysteresis);
+      return parent && parent->GetNeighborAddress () == senderAddress;
+    }
+
+  return RplObjectiveFunctionOf0::ComputeRank (dioMessage.GetRank ()) < m_routingTable.GetRank ();
+}
+
+void Rpl::JoinDodag (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, Ipv6Address senderAddress, uint32_t incomingInterface)
+{
+  NS_LOG_FUNCTION (this << dioMessage.GetDodagId () << senderAddress);
+  bool joined = (m_routingTable.GetVersionNumber () != 0);
+  bool migrated = joined && dioMessage.GetDodagId () == m_routingTable.GetDodagId () &&
+    IsNewerVersion (dioMessage.GetVersionNumber (), m_routingTable.GetVersionNumber ());
+
+  m_routingTable.ClearRoutingTable ();
+  //m_neighborSet.ClearNeighborSet ();
+
+  m_routingTable.SetRplInstanceId (dioMessage.GetRplInstanceId ());
+  m_routingTable.SetDodagId (dioMessage.GetDodagId ());
+  m_routingTable.SetObjectiveCodePoint (dodagConfiguration.GetObjectiveCodePoint ());
+  m_routingTable.SetDtsn (dioMessage.GetDtsn ());
+  m_routingTable.SetVersionNumber (dioMessage.GetVersionNumber ());
+  m_routingTable.SetFlagG (dioMessage.GetFlagG ());
+  m_routingTable.SetMop (dioMessage.GetMop ());
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (senderAddress);
+  m_routingTable.SetRootLoad (parent ? parent->GetRootLoad () : 0);
+
+  if (dodagConfiguration.GetObjectiveCodePoint () == 0)
+    {
+      uint16_t computedRank = RplObjectiveFunctionOf0::ComputeRank (dioMessage.GetRank ());
+      m_routingTable.SetRank (computedRank);
+      std::cout << "Rank changed: " << m_routingTable.GetRank() << std::endl;
+    }
+
+  m_routingTable.SetDodagParent (senderAddress, incomingInterface);
+  if (!m_leaf)
+    {
+      m_routingTable.AddNetworkRouteTo (senderAddress, incomingInterface);
+    }
+
+  if (m_parentLost)
+    {
+      m_parentLost = false;
+      m_rerouteTrace (Ipv6Address::GetZero (), senderAddress, Simulator::Now () - m_parentLossTime);
+    }
+  m_rerouted = false;
+  m_floating = false;
+  Reattach ();
+  if (migrated)
+    {
+      m_repairedTrace (true, dioMessage.GetVersionNumber ());
+    }
+
+  // the routes announced in the previous DODAG are gone with it
+  m_daoTimer.Cancel ();
+  m_daoPending.clear ();
+  m_daoAnnounced.clear ();
+  if (IsStoring ())
+    {
+      AnnounceDaoTargets ();
+    }
+
+  if (joined)
+    {
+      ResetTrickle ();
+    }
+  else
+    {
+      StartTrickle ();
+    }
+}
+
+void Rpl::UpdatePreferredParent ()
+{
+  if (m_congestionAware || m_energyAware)
+    {
+      // stay among the parents ranked no worse than the current one, so the
+      // rank of this node never grows because of congestion or energy
+      Ptr<Neighbor> current = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+      bool lost = m_parentLost || !current || !current->GetReachable ();
+      uint16_t maxRank = lost ? INFINITE_RANK - 1 : current->GetRank ();
+      Ptr<Neighbor> candidate;
+      if (m_energyAware)
+        {
+          candidate = m_neighborSet.SelectEnergyParent (m_routingTable.GetDodagId (), GetMaxParentLatency (),
+                                                        m_energyWeight, maxRank);
+        }
+      else
+        {
+          candidate = m_neighborSet.SelectParent (m_routingTable.GetDodagId (), GetMaxParentLatency (),
+                                                  m_congestionWeight, maxRank);
+        }
+      if (!candidate || candidate == current)
+        {
+          return;
+        }
+
+      if (lost)
+        {
+          SwitchParent (candidate);
+          m_rerouted = false;
+          return;
+        }
+
+      uint32_t currentCost = GetParentCost (current);
+      uint32_t candidateCost = GetParentCost (candidate);
+      uint16_t hysteresis = m_energyAware ? m_energyHysteresis : m_congestionHysteresis;
+      if (candidateCost + hysteresis < currentCost)
+        {
+          NS_LOG_LOGIC ("RPL: parent cost " << currentCost << " against " << candidateCost << ", switching");
+          SwitchParent (candidate);
+        }
+      return;
+    }
+
+  Ptr<Neighbor> parent = m_neighborSet.SelectParent (m_routingTable.GetDodagId (), GetMaxParentLatency ());
+  if (!parent || parent->GetRank () == INFINITE_RANK)
+    {
+      return;
+    }
+
+  // in mobility mode, a better rank behind a link about to break is not worth it
+  if (m_mobilityMode && !m_parentLost && parent->IsDegrading (m_handoverRssi, m_handoverEtx, m_handoverHorizon))
+    {
+      return;
+    }
+
+  // after losing the parent with no backup, any parent is better than none
+  uint16_t computedRank = RplObjectiveFunctionOf0::ComputeRank (parent->GetRank ());
+  if (computedRank < m_routingTable.GetRank () || m_parentLost)
+    {
+      SwitchParent (parent);
+      m_rerouted = false;
+    }
+}
+
+void Rpl::SwitchParent (Ptr<Neighbor> parent)
+{
+  uint16_t computedRank = RplObjectiveFunctionOf0::ComputeRank (parent->GetRank ());
+  NS_LOG_LOGIC ("RPL: new preferred parent " << parent->GetNeighborAddress () << " rank " << computedRank);
+  Ipv6Address oldParent = m_routingTable.GetDodagParent ();
+  if (oldParent != parent->GetNeighborAddress ())
+    {
+      m_parentSwitches++;
+    }
+  m_routingTable.SetRank (computedRank);
+  m_routingTable.SetDodagParent (parent->GetNeighborAddress (), parent->GetInterface ());
+  if (!m_leaf)
+    {
+      m_routingTable.AddNetworkRouteTo (parent->GetNeighborAddress (), parent->GetInterface ());
+    }
+
+  if (IsStoring () && oldParent != parent->GetNeighborAddress ())
+    {
+      // withdraw what the old parent was told, if it can still hear it
+      Ptr<Neighbor> old = m_neighborSet.FindNeighbor (oldParent);
+      if (old && old->GetReachable () && !m_parentLost && !m_daoAnnounced.empty ())
+        {
+          RplDaoTargets noPath;
+          for (std::set<std::pair<Ipv6Address, uint8_t> >::iterator iter = m_daoAnnounced.begin ();
+               iter != m_daoAnnounced.end (); iter++)
+            {
+              RplDaoTarget target;
+              target.pathSequence = m_pathSequence;
+              target.pathLifetime = 0;
+              noPath[*iter] = target;
+            }
+          SendDao (noPath, oldParent, old->GetInterface ());
+        }
+
+      // pending No-Paths were meant for the old parent, announcements still hold
+      for (RplDaoTargets::iterator iter = m_daoPending.begin (); iter != m_daoPending.end (); )
+        {
+          if (iter->second.pathLifetime == 0)
+            {
+              m_daoPending.erase (iter++);
+            }
+          else
+            {
+              iter++;
+            }
+        }
+      m_daoAnnounced.clear ();
+      AnnounceDaoTargets ();
+    }
+
+  if (m_handoverPending && oldParent != parent->GetNeighborAddress ())
+    {
+      // a handover overtaken by the loss of the parent is a reroute
+      m_handoverPending = false;
+      if (!m_parentLost)
+        {
+          m_handoverTrace (oldParent, parent->GetNeighborAddress (), Simulator::Now () - m_handoverStart);
+        }
+    }
+  if (m_parentLost)
+    {
+      m_parentLost = false;
+      m_rerouteTrace (oldParent, parent->GetNeighborAddress (), Simulator::Now () - m_parentLossTime);
+    }
+  Reattach ();
+  ResetTrickle ();
+}
+
+void Rpl::NotifyLinkFailure (Ipv6Address neighbor)
+{
+  NS_LOG_FUNCTION (this << neighbor);
+  if (m_isRoot || neighbor != m_routingTable.GetDodagParent ())
+    {
+      Ptr<Neighbor> failed = m_neighborSet.FindNeighbor (neighbor);
+      if (failed)
+        {
+          failed->SetReachable (false);
+        }
+      return;
+    }
+
+  if (!m_parentLost)
+    {
+      m_parentLost = true;
+      m_parentLossTime = Simulator::Now ();
+    }
+
+  Ptr<Neighbor> backup = m_neighborSet.NextParent (neighbor);
+  if (backup)
+    {
+      SwitchParent (backup);
+      m_rerouted = true;
+    }
+  else
+    {
+      NS_LOG_LOGIC ("RPL: parent " << neighbor << " lost and no backup parent");
+      Detach ();
+    }
+}
+
+void Rpl::Detach ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_detached)
+    {
+      return;
+    }
+
+  // an infinite rank tells the sub-DODAG to find other parents, so that
+  // none of its nodes is picked as parent when this node looks for one
+  m_detached = true;
+  m_routingTable.SetRank (INFINITE_RANK);
+  m_repairStartTrace (false, m_routingTable.GetVersionNumber ());
+  SendMulticastDio ();
+  ResetTrickle ();
+
+  m_localRepair.Cancel ();
+  m_localRepair = Simulator::Schedule (m_localRepairDelay, &Rpl::LocalRepair, this);
+}
+
+void Rpl::LocalRepair ()
+{
+  NS_LOG_FUNCTION (this);
+  UpdatePreferredParent ();
+  if (!m_detached)
+    {
+      return;
+    }
+
+  if (m_floatingDodag && !m_leaf)
+    {
+      BecomeFloatingRoot ();
+    }
+  else
+    {
+      Join ();
+    }
+}
+
+void Rpl::BecomeFloatingRoot ()
+{
+  NS_LOG_FUNCTION (this);
+  Ipv6Address dodagId = GetGlobalAddress ();
+  if (dodagId == Ipv6Address::GetZero ())
+    {
+      Join ();
+      return;
+    }
+
+  // the sub-DODAG stays connected under this node until a grounded DODAG is heard
+  NS_LOG_LOGIC ("RPL: root of floating DODAG " << dodagId);
+  m_floating = true;
+  m_parentLost = false;
+  m_routingTable.RemoveDodagParent ();
+  m_routingTable.SetDodagId (dodagId);
+  m_routingTable.SetRank (ROOT_RANK);
+  m_routingTable.SetFlagG (false);
+  m_daoTimer.Cancel ();
+  m_daoPending.clear ();
+  m_daoAnnounced.clear ();
+  Reattach ();
+  ResetTrickle ();
+}
+
+void Rpl::Reattach ()
+{
+  if (!m_detached)
+    {
+      return;
+    }
+  m_detached = false;
+  m_localRepair.Cancel ();
+  m_repairedTrace (false, m_routingTable.GetVersionNumber ());
+}
+
+void Rpl::NotifyTxResult (Ipv6Address neighbor, uint32_t attempts, bool acked)
+{
+  NS_LOG_FUNCTION (this << neighbor << attempts << acked);
+  Ptr<Neighbor> known = m_neighborSet.FindNeighbor (neighbor);
+  if (!known)
+    {
+      return;
+    }
+
+  known->SetTxRetries (0);
+  known->UpdateEtx (attempts, acked);
+  if (acked)
+    {
+      known->SetLastHeard (Simulator::Now ());
+      known->SetTxFailures (0);
+      known->SetProbes (0);
+      known->SetReachable (true);
+      return;
+    }
+
+  if (known->GetTxFailures () < 0xff)
+    {
+      known->SetTxFailures (known->GetTxFailures () + 1);
+    }
+  if (known->GetTxFailures () >= m_maxTxFailures)
+    {
+      NotifyLinkFailure (neighbor);
+    }
+}
+
+void Rpl::NotifyTxRetry (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+  Ptr<Neighbor> known = FindNeighborByMac (address);
+  if (known && known->GetTxRetries () < 0xff)
+    {
+      known->SetTxRetries (known->GetTxRetries () + 1);
+    }
+}
+
+void Rpl::NotifyTxResult (const Address &address, bool acked)
+{
+  NS_LOG_FUNCTION (this << address << acked);
+  Ptr<Neighbor> known = FindNeighborByMac (address);
+  if (known)
+    {
+      NotifyTxResult (known->GetNeighborAddress (), known->GetTxRetries () + 1, acked);
+    }
+}
+
+Ptr<Neighbor> Rpl::FindNeighborByMac (const Address &address)
+{
+  Ptr<Neighbor> known = m_neighborSet.FindNeighborByMac (address);
+  if (known)
+    {
+      return known;
+    }
+
+  // the neighbor cache holds every neighbor a unicast packet was sent to
+  Ptr<Ipv6L3Protocol> ipv6 = m_routingTable.GetIpv6 ()->GetObject<Ipv6L3Protocol> ();
+  std::vector<Ptr<Neighbor> > unresolved = m_neighborSet.GetUnresolvedNeighbors ();
+  for (std::vector<Ptr<Neighbor> >::iterator it = unresolved.begin (); it != unresolved.end (); it++)
+    {
+      Ptr<NdiscCache> cache = ipv6->GetInterface ((*it)->GetInterface ())->GetNdiscCache ();
+      NdiscCache::Entry *entry = cache ? cache->Lookup ((*it)->GetNeighborAddress ()) : 0;
+      if (entry && !entry->IsIncomplete ())
+        {
+          (*it)->SetMacAddress (entry->GetMacAddress ());
+          if (entry->GetMacAddress () == address)
+            {
+              known = *it;
+            }
+        }
+    }
+
+  // a neighbor heard only through multicast is matched by its EUI-64 link-local address
+  if (!known && Mac48Address::IsMatchingType (address))
+    {
+      known = m_neighborSet.FindNeighbor (
+        Ipv6Address::MakeAutoconfiguredLinkLocalAddress (Mac48Address::ConvertFrom (address)));
+      if (known && known->GetMacAddress ().IsInvalid ())
+        {
+          known->SetMacAddress (address);
+        }
+      else
+        {
+          known = 0;
+        }
+    }
+  return known;
+}
+
+void Rpl::NotifyRssi (const Address &address, double rssi)
+{
+  NS_LOG_FUNCTION (this << address << rssi);
+  Ptr<Neighbor> known = FindNeighborByMac (address);
+  if (known)
+    {
+      known->UpdateRssi (rssi, Simulator::Now ());
+    }
+}
+
+void Rpl::MobilityCheck ()
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if (parent && !m_detached && !m_parentLost &&
+      parent->IsDegrading (m_handoverRssi, m_handoverEtx, m_handoverHorizon))
+    {
+      if (!m_handoverPending)
+        {
+          NS_LOG_LOGIC ("RPL: link to parent " << parent->GetNeighborAddress () << " degrading, RSSI "
+                        << parent->GetRssi () << " dBm, trend " << parent->GetRssiTrend () << " dB/s, ETX "
+                        << parent->GetEtx ());
+          m_handoverPending = true;
+          m_handoverStart = Simulator::Now ();
+        }
+      Handover (true);
+    }
+  else
+    {
+      m_handoverPending = false;
+    }
+
+  m_mobilityCheck = Simulator::Schedule (m_mobilityCheckInterval, &Rpl::MobilityCheck, this);
+}
+
+bool Rpl::Handover (bool solicit)
+{
+  NS_LOG_FUNCTION (this << solicit);
+  // no deeper than this node, so that none of its descendants is picked
+  Ptr<Neighbor> candidate = m_neighborSet.SelectHandoverParent (m_routingTable.GetDodagId (), m_routingTable.GetDodagParent (),
+                                                                m_routingTable.GetRank (), m_handoverRssi,
+                                                                m_handoverEtx, m_handoverHorizon);
+  if (!candidate)
+    {
+      if (solicit)
+        {
+          // look for parents the node moved towards
+          for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+            {
+              if (m_sendSockets[i])
+                {
+                  SendUnicastDis (ALL_RPL_NODES, i);
+                }
+            }
+        }
+      return false;
+    }
+
+  if (Simulator::Now () - candidate->GetLastHeard () > m_mobilityCheckInterval)
+    {
+      // its DIO answer confirms it is still in range, with its current rank
+      if (solicit)
+        {
+          SendUnicastDis (candidate->GetNeighborAddress (), candidate->GetInterface ());
+        }
+      return false;
+    }
+
+  SwitchParent (candidate);
+  return true;
+}
+
+void Rpl::NudCheck ()
+{
+  NS_LOG_FUNCTION (this);
+
+  // candidate parents: the parent set, plus the preferred parent
+  std::vector<Ipv6Address> candidates;
+  for (uint32_t i = 0; i < m_neighborSet.GetNParents (); i++)
+    {
+      candidates.push_back (m_neighborSet.GetParent (i)->GetNeighborAddress ());
+    }
+  Ipv6Address parent = m_routingTable.GetDodagParent ();
+  if (std::find (candidates.begin (), candidates.end (), parent) == candidates.end ())
+    {
+      candidates.push_back (parent);
+    }
+
+  uint32_t probesSent = 0;
+  for (std::vector<Ipv6Address>::iterator iter = candidates.begin (); iter != candidates.end (); iter++)
+    {
+      Ptr<Neighbor> candidate = m_neighborSet.FindNeighbor (*iter);
+      if (!candidate || !candidate->GetReachable () ||
+          Simulator::Now () - candidate->GetLastHeard () < m_neighborFreshness)
+        {
+          continue;
+        }
+
+      if (candidate->GetProbes () >= m_maxProbes)
+        {
+          NS_LOG_LOGIC ("RPL: neighbor " << *iter << " did not answer " << (uint32_t)m_maxProbes << " probes");
+          NotifyLinkFailure (*iter);
+        }
+      else if (probesSent < m_probesPerInterval)
+        {
+          SendUnicastDis (*iter, candidate->GetInterface ());
+          candidate->SetProbes (candidate->GetProbes () + 1);
+          probesSent++;
+        }
+    }
+
+  double jitter = m_rng->GetValue (0.75, 1.25);
+  m_nudTimer = Simulator::Schedule (Seconds (m_probeInterval.GetSeconds () * jitter), &Rpl::NudCheck, this);
+}
+
+uint32_t Rpl::GetMaxParentLatency () const
+{
+  RplMetricObject constraint;
+  uint32_t bound;
+  if (!m_routingTable.GetMetricContainer ().FindConstraint (RPL_METRIC_LATENCY, constraint) ||
+      !constraint.GetAggregatedValue (bound))
+    {
+      return 0xffffffff;
+    }
+
+  uint32_t hopLatency = m_hopLatency.GetMicroSeconds ();
+  return (bound > hopLatency) ? bound - hopLatency : 0;
+}
+
+void Rpl::SendMulticastDis ()
+{
+  NS_LOG_FUNCTION (this << m_disAttempts);
+
+  // a DIO ends the solicitation, and so does joining or giving up
+  if (m_dioReceived != 1 || m_isRoot || (m_routingTable.GetRank () != 0 && !m_detached))
+    {
+      return;
+    }
+  if (m_disMaxAttempts != 0 && m_disAttempts >= m_disMaxAttempts)
+    {
+      NS_LOG_LOGIC ("RPL: no DIO after " << m_disAttempts << " DISs, giving up");
+      m_dioReceived = 0;
+      return;
+    }
+
+  Icmpv6Header dis;
+  dis.SetType (155);
+  dis.SetCode (0);
+
+  RplDisMessage disMessage;
+  RplSolicitedInformationOption solicitedInformation;
+
+  for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+    {
+      if (!m_sendSockets[i])
+        {
+          continue;
+        }
+      Ptr<Packet> p = Create<Packet>();
+      p->AddHeader (solicitedInformation);
+      p->AddHeader (disMessage);
+      p->AddHeader (dis);
+
+      m_controlTxTrace (p, 0);
+      m_sendSockets[i]->SendTo (p, 0, Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT));
+    }
+  m_disAttempts++;
+
+  // exponential backoff, jittered over the second half of the interval
+  Time delay = Seconds (m_rng->GetValue (m_disBackoff.GetSeconds () / 2, m_disBackoff.GetSeconds ()));
+  m_disBackoff = std::min (m_disBackoff + m_disBackoff, m_disMaxInterval);
+  m_multicastDis = Simulator::Schedule (delay, &Rpl::SendMulticastDis, this);
+}
+
+void Rpl::SendUnicastDis (Ipv6Address destAddress, uint32_t interface)
+{
+  Ptr<Socket> sendingSocket = GetSocket (interface);
+  if (!sendingSocket)
+    {
+      return;
+    }
+
+  Ptr<Packet> p = Create<Packet>();
+  Icmpv6Header dis;
+  dis.SetType (155);
+  dis.SetCode (0);
+
+  RplDisMessage disMessage;
+  RplSolicitedInformationOption solicitedInformation;
+
+  p->AddHeader (solicitedInformation);
+  p->AddHeader (disMessage);
+  p->AddHeader (dis);
+
+  m_controlTxTrace (p, 0);
+  sendingSocket->SendTo (p, 0, Inet6SocketAddress (destAddress, RPL_PORT));
+}
+
+Ptr<Packet> Rpl::BuildDio (uint32_t interface)
+{
+  Ptr<Packet> p = Create<Packet>();
+
+  Icmpv6Header dio;
+  dio.SetType (155);
+  dio.SetCode (1);
+
+  RplDioMessage dioMessage;
+  dioMessage.SetFlagG (m_routingTable.GetFlagG ());
+  dioMessage.SetMop (m_routingTable.GetMop ());
+  dioMessage.SetPrf (0);
+  dioMessage.SetRplInstanceId (m_routingTable.GetRplInstanceId ());
+  dioMessage.SetDtsn (m_routingTable.GetDtsn ());
+  dioMessage.SetVersionNumber (m_routingTable.GetVersionNumber ());
+  dioMessage.SetRank (GetAdvertisedRank (interface));
+  dioMessage.SetDodagId (m_routingTable.GetDodagId ());
+
+  RplDodagConfigurationOption dodagConfiguration;
+  dodagConfiguration.SetPathControlSize (DEFAULT_PATH_CONTROL_SIZE);
+  dodagConfiguration.SetDioIntervalDoublings (DEFAULT_DIO_INTERVAL_DOUBLINGS);
+  dodagConfiguration.SetDioIntervalMin (DEFAULT_DIO_INTERVAL_MIN);
+  dodagConfiguration.SetDioRedundancyConstant (DEFAULT_DIO_REDUNDANCY_CONSTANT);
+  dodagConfiguration.SetMaxRankIncrease (0);
+  dodagConfiguration.SetMinHopRankIncrease (DEFAULT_MIN_HOP_RANK_INCREASE);
+  dodagConfiguration.SetObjectiveCodePoint (OCP);
+  //dodagConfiguration.SetDefaultLifetime ();
+  //dodagConfiguration.SetLifetimeUnit ();
+
+  RplMetricContainerOption metricContainer = m_routingTable.GetMetricContainer ();
+  if (m_loadBalancing)
+    {
+      metricContainer.SetRootLoad (m_routingTable.GetRootLoad ());
+    }
+  if (m_congestionAware)
+    {
+      metricContainer.SetQueueLoad (GetPathQueueLoad ());
+    }
+  if (m_energyAware)
+    {
+      m_advertisedEnergy = GetPathEnergy ();
+      metricContainer.SetNodeEnergy (m_advertisedEnergy);
+    }
+  if (metricContainer.GetNMetricObjects () > 0)
+    {
+      p->AddHeader (metricContainer);
+    }
+  p->AddHeader (dodagConfiguration);
+  p->AddHeader (dioMessage);
+  p->AddHeader (dio);
+
+  return p;
+}
+
+void Rpl::SendDio (Ipv6Address destAddress, uint32_t incomingInterface, uint16_t senderPort) 
+{
+  if (m_leaf)
+    {
+      return;
+    }
+  if (m_routingTable.GetVersionNumber () !=0) 
+    {
+      Ptr<Socket> sendingSocket = GetSocket (incomingInterface);
+      if (!sendingSocket)
+        {
+          NS_LOG_LOGIC ("RPL: not running on interface " << incomingInterface);
+          return;
+        }
+
+      Ptr<Packet> p = BuildDio (incomingInterface);
+      NS_LOG_DEBUG ("SendTo: " << *p);
+      m_controlTxTrace (p, 1);
+      sendingSocket->SendTo (p, 0, Inet6SocketAddress (destAddress, senderPort));
+    }
+  else 
+    {
+      std::cout << "Not yet in DODAG\n";
+    }
+}
+
+void Rpl::SendDio (Ipv6Address destAddress, uint32_t incomingInterface) 
+{
+  SendDio (destAddress, incomingInterface, RPL_PORT);
+}
+
+void Rpl::SendMulticastDio ()
+{
+  for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+    {
+      if (m_sendSockets[i])
+        {
+          SendDio (ALL_RPL_NODES, i);
+        }
+    }
+}
+
+void Rpl::OpenSocket (uint32_t interface, Ipv6Address address)
+{
+  NS_LOG_LOGIC ("RPL: adding socket to " << address);
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<Node> theNode = GetObject<Node> ();
+  Ptr<Socket> socket = Socket::CreateSocket (theNode, tid);
+  Inet6SocketAddress local = Inet6SocketAddress (address, RPL_PORT);
+
+  int ret = socket->Bind (local);
+  NS_ASSERT_MSG (ret == 0, "Bind unsuccessful");
+  socket->BindToNetDevice (m_routingTable.GetIpv6 ()->GetNetDevice (interface));
+  socket->SetRecvCallback (MakeCallback (&Rpl::Receive, this));
+  socket->SetIpv6RecvHopLimit (true);
+  socket->SetRecvPktInfo (true);
+
+  if (interface >= m_sendSockets.size ())
+    {
+      m_sendSockets.resize (interface + 1);
+    }
+  m_sendSockets[interface] = socket;
+}
+
+void Rpl::CloseSocket (uint32_t interface)
+{
+  if (interface < m_sendSockets.size () && m_sendSockets[interface])
+    {
+      NS_LOG_LOGIC ("RPL: closing socket of interface " << interface);
+      m_sendSockets[interface]->Close ();
+      m_sendSockets[interface] = 0;
+    }
+}
+
+Ptr<Socket> Rpl::GetSocket (uint32_t interface) const
+{
+  if (interface < m_sendSockets.size ())
+    {
+      return m_sendSockets[interface];
+    }
+  return 0;
+}
+
+uint32_t Rpl::GetNRplInterfaces () const
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+    {
+      if (m_sendSockets[i])
+        {
+          n++;
+        }
+    }
+  return n;
+}
+
+void Rpl::SetInterfaceCost (uint32_t interface, uint16_t cost)
+{
+  NS_LOG_FUNCTION (this << interface << cost);
+  if (interface >= m_interfaceCosts.size ())
+    {
+      m_interfaceCosts.resize (interface + 1, 0);
+    }
+  m_interfaceCosts[interface] = cost;
+}
+
+uint16_t Rpl::GetInterfaceCost (uint32_t interface) const
+{
+  if (interface < m_interfaceCosts.size ())
+    {
+      return m_interfaceCosts[interface];
+    }
+  return 0;
+}
+
+uint16_t Rpl::GetAdvertisedRank (uint32_t interface) const
+{
+  uint16_t rank = m_routingTable.GetRank ();
+  if (rank == 0 || rank == INFINITE_RANK)
+    {
+      return rank;
+    }
+  return std::min<uint32_t> (uint32_t (rank) + GetInterfaceCost (interface), INFINITE_RANK);
+}
+
+void Rpl::RecvDao (RplDaoMessage daoMessage, const std::vector<RplTargetOption> &targets,
+                   const std::vector<RplTransitInformationOption> &transits, Ipv6Address senderAddress,
+                   uint32_t incomingInterface)
+{
+  NS_LOG_FUNCTION (this << senderAddress << targets.size ());
+
+  // a DAO from the parent would make a loop; one from another DODAG does not
+  // concern us; a leaf has no sub-DODAG to store routes for
+  if (m_leaf || !IsStoring () || senderAddress == m_routingTable.GetDodagParent () ||
+      daoMessage.GetRplInstanceId () != m_routingTable.GetRplInstanceId () ||
+      (daoMessage.GetFlagD () && daoMessage.GetDodagId () != m_routingTable.GetDodagId ()))
+    {
+      return;
+    }
+
+  for (uint32_t i = 0; i < targets.size (); i++)
+    {
+      Ipv6Address target = targets[i].GetTarget ();
+      uint8_t prefixLength = targets[i].GetPrefixLength ();
+      uint8_t pathSequence = transits[i].GetPathSequence ();
+      uint8_t pathLifetime = transits[i].GetPathLifetime ();
+
+      bool changed;
+      if (target.IsMulticast ())
+        {
+          if (m_routingTable.GetMop () != MOP_STORING_MULTICAST)
+            {
+              continue;
+            }
+          // the group is withdrawn above once no subscriber is left here
+          if (pathLifetime == 0)
+            {
+              changed = m_routingTable.RemoveMulticastRoute (target, senderAddress) &&
+                m_routingTable.GetMulticastRoutes (target).empty () && !IsGroupMember (target);
+            }
+          else
+            {
+              changed = m_routingTable.AddMulticastRoute (target, senderAddress, incomingInterface, pathSequence,
+                                                          pathLifetime);
+            }
+        }
+      else if (pathLifetime == 0)
+        {
+          changed = m_routingTable.RemoveDownwardRoute (target, prefixLength, senderAddress);
+        }
+      else
+        {
+          changed = m_routingTable.AddDownwardRoute (target, prefixLength, senderAddress, incomingInterface,
+                                                     pathSequence, pathLifetime);
+        }
+
+      if (changed && !m_isRoot && !m_floating)
+        {
+          EnqueueDaoTarget (target, prefixLength, pathSequence, pathLifetime);
+        }
+    }
+}
+
+bool Rpl::DiscoverRoute (Ipv6Address target)
+{
+  NS_LOG_FUNCTION (this << target);
+
+  Ipv6Address origin = GetGlobalAddress ();
+  if (origin == Ipv6Address::GetZero ())
+    {
+      NS_LOG_LOGIC ("RPL: no global address to start a route discovery from");
+      return false;
+    }
+
+  // a local instance, whose DODAG ID is the origin
+  std::pair<uint8_t, Ipv6Address> key (P2P_LOCAL_INSTANCE | (m_p2pInstance++ & 0x3f), origin);
+  LeaveP2pDodag (key);
+
+  RplP2pDodag &dodag = m_p2pDodags[key];
+  dodag.rank = DEFAULT_MIN_HOP_RANK_INCREASE;
+  dodag.version = 0;
+  dodag.replied = false;
+  dodag.start = Simulator::Now ();
+  dodag.routeDiscovery.SetFlagR (true);
+  dodag.routeDiscovery.SetFlagH (true);
+  dodag.routeDiscovery.SetLifetime (m_p2pDodagLifetime);
+  dodag.routeDiscovery.SetMaxRank (m_p2pMaxRank);
+  dodag.routeDiscovery.SetTarget (target);
+  dodag.expiration = Simulator::Schedule (dodag.routeDiscovery.GetLifetimeDuration (), &Rpl::LeaveP2pDodag, this, key);
+
+  NS_LOG_LOGIC ("RPL: route discovery towards " << target << ", instance " << (uint32_t)key.first);
+  SendP2pDio (key);
+  return true;
+}
+
+void Rpl::RecvP2pDio (RplDioMessage dioMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address senderAddress,
+                      uint32_t incomingInterface)
+{
+  NS_LOG_FUNCTION (this << senderAddress << incomingInterface);
+
+  Ptr<Ipv6> ipv6 = m_routingTable.GetIpv6 ();
+  Ipv6Address origin = dioMessage.GetDodagId ();
+  const std::vector<Ipv6Address> &addresses = routeDiscovery.GetAddresses ();
+  if (ipv6->GetInterfaceForAddress (origin) != -1)
+    {
+      return;
+    }
+  for (std::vector<Ipv6Address>::const_iterator it = addresses.begin (); it != addresses.end (); it++)
+    {
+      if (ipv6->GetInterfaceForAddress (*it) != -1)
+        {
+          NS_LOG_LOGIC ("RPL: DIO of a temporary DODAG already through this node");
+          return;
+        }
+    }
+
+  std::pair<uint8_t, Ipv6Address> key (dioMessage.GetRplInstanceId (), origin);
+  RplP2pDodags::iterator iter = m_p2pDodags.find (key);
+  if (iter == m_p2pDodags.end ())
+    {
+      RplP2pDodag &dodag = m_p2pDodags[key];
+      dodag.rank = INFINITE_RANK;
+      dodag.version = dioMessage.GetVersionNumber ();
+      dodag.replied = false;
+      dodag.expiration = Simulator::Schedule (routeDiscovery.GetLifetimeDuration (), &Rpl::LeaveP2pDodag, this, key);
+      iter = m_p2pDodags.find (key);
+    }
+  RplP2pDodag &dodag = iter->second;
+
+  // the DRO goes back through the sender of the route it answers
+  Ipv6Address previous = addresses.empty () ? origin : addresses.back ();
+  dodag.previousHops[previous] = std::make_pair (senderAddress, incomingInterface);
+
+  if (ipv6->GetInterfaceForAddress (routeDiscovery.GetTarget ()) != -1)
+    {
+      // the first DIO to arrive came along the quickest route
+      if (dodag.replied || !routeDiscovery.GetFlagR ())
+        {
+          return;
+        }
+      dodag.replied = true;
+
+      RplDroMessage droMessage;
+      droMessage.SetRplInstanceId (key.first);
+      droMessage.SetVersionNumber (dodag.version);
+      droMessage.SetDodagId (origin);
+      droMessage.SetFlagS (true);
+
+      RplP2pRouteDiscoveryOption route;
+      route.SetFlagH (routeDiscovery.GetFlagH ());
+      route.SetLifetime (routeDiscovery.GetLifetime ());
+      route.SetTarget (routeDiscovery.GetTarget ());
+      route.SetAddresses (addresses);
+      route.SetNextHopIndex (addresses.empty () ? 0 : addresses.size () - 1);
+
+      NS_LOG_LOGIC ("RPL: route discovery from " << origin << " reached this node in " << addresses.size () + 1 << " hops");
+      SendDro (droMessage, route, senderAddress, incomingInterface);
+      return;
+    }
+
+  // hosts take no part in temporary DODAGs
+  if (m_leaf)
+    {
+      return;
+    }
+
+  // a sender with an infinite rank left the temporary DODAG, and a rank
+  // close to it must not wrap to a low one
+  if (dioMessage.GetRank () == INFINITE_RANK)
+    {
+      return;
+    }
+  uint32_t rank = std::min<uint32_t> ((uint32_t) dioMessage.GetRank () + DEFAULT_MIN_HOP_RANK_INCREASE, INFINITE_RANK);
+  if (rank / DEFAULT_MIN_HOP_RANK_INCREASE > routeDiscovery.GetMaxRank () || rank >= dodag.rank)
+    {
+      return;
+    }
+
+  RplP2pRouteDiscoveryOption advertised = routeDiscovery;
+  Ipv6Address address = GetGlobalAddress ();
+  if (address == Ipv6Address::GetZero () || !advertised.AddAddress (address))
+    {
+      return;
+    }
+  dodag.rank = rank;
+  dodag.routeDiscovery = advertised;
+
+  // a better rank found before the DIO left is sent in its place
+  if (!dodag.forward.IsRunning ())
+    {
+      dodag.forward = Simulator::Schedule (Seconds (m_rng->GetValue (0, P2P_FORWARD_JITTER)), &Rpl::SendP2pDio,
+                                           this, key);
+    }
+}
+
+void Rpl::RecvDro (RplDroMessage droMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address senderAddress,
+                   uint32_t incomingInterface)
+{
+  NS_LOG_FUNCTION (this << senderAddress << incomingInterface);
+
+  std::pair<uint8_t, Ipv6Address> key (droMessage.GetRplInstanceId (), droMessage.GetDodagId ());
+  RplP2pDodags::iterator iter = m_p2pDodags.find (key);
+  if (iter == m_p2pDodags.end ())
+    {
+      NS_LOG_LOGIC ("RPL: DRO for a temporary DODAG already gone");
+      return;
+    }
+
+  Ptr<Ipv6> ipv6 = m_routingTable.GetIpv6 ();
+  Ipv6Address target = routeDiscovery.GetTarget ();
+  const std::vector<Ipv6Address> &addresses = routeDiscovery.GetAddresses ();
+  if (ipv6->GetInterfaceForAddress (key.second) != -1)
+    {
+      m_routingTable.AddP2pRoute (target, senderAddress, incomingInterface, m_p2pRouteLifetime);
+      m_p2pRouteTrace (target, addresses.size () + 1, Simulator::Now () - iter->second.start);
+      if (droMessage.GetFlagS ())
+        {
+          LeaveP2pDodag (key);
+        }
+      return;
+    }
+
+  uint8_t index = routeDiscovery.GetNextHopIndex ();
+  if (index >= addresses.size () || ipv6->GetInterfaceForAddress (addresses[index]) == -1)
+    {
+      return;
+    }
+
+  Ipv6Address previous = index == 0 ? key.second : addresses[index - 1];
+  std::map<Ipv6Address, std::pair<Ipv6Address, uint32_t> >::iterator hop = iter->second.previousHops.find (previous);
+  if (hop == iter->second.previousHops.end ())
+    {
+      return;
+    }
+
+  m_routingTable.AddP2pRoute (target, senderAddress, incomingInterface, m_p2pRouteLifetime);
+  if (droMessage.GetFlagS ())
+    {
+      iter->second.forward.Cancel ();
+    }
+  routeDiscovery.SetNextHopIndex (index == 0 ? 0 : index - 1);
+  SendDro (droMessage, routeDiscovery, hop->second.first, hop->second.second);
+}
+
+void Rpl::SendP2pDio (std::pair<uint8_t, Ipv6Address> dodag)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)dodag.first << dodag.second);
+
+  RplP2pDodags::iterator iter = m_p2pDodags.find (dodag);
+  if (iter == m_p2pDodags.end ())
+    {
+      return;
+    }
+
+  for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+    {
+      if (!m_sendSockets[i])
+        {
+          continue;
+        }
+
+      Ptr<Packet> p = Create<Packet> ();
+      Icmpv6Header dio;
+      dio.SetType (155);
+      dio.SetCode (1);
+
+      RplDioMessage dioMessage;
+      dioMessage.SetFlagG (false);
+      dioMessage.SetMop (MOP_P2P);
+      dioMessage.SetPrf (0);
+      dioMessage.SetRplInstanceId (dodag.first);
+      dioMessage.SetVersionNumber (iter->second.version);
+      dioMessage.SetRank (iter->second.rank);
+      dioMessage.SetDodagId (dodag.second);
+
+      p->AddHeader (iter->second.routeDiscovery);
+      p->AddHeader (dioMessage);
+      p->AddHeader (dio);
+
+      m_controlTxTrace (p, 1);
+      m_sendSockets[i]->SendTo (p, 0, Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT));
+    }
+}
+
+void Rpl::SendDro (RplDroMessage droMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address neighbor,
+                   uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << neighbor << interface);
+
+  Ptr<Socket> sendingSocket = GetSocket (interface);
+  if (!sendingSocket)
+    {
+      return;
+    }
+
+  Ptr<Packet> p = Create<Packet> ();
+  Icmpv6Header dro;
+  dro.SetType (155);
+  dro.SetCode (4);
+
+  p->AddHeader (routeDiscovery);
+  p->AddHeader (droMessage);
+  p->AddHeader (dro);
+
+  m_controlTxTrace (p, 4);
+  sendingSocket->SendTo (p, 0, Inet6SocketAddress (neighbor, RPL_PORT));
+}
+
+void Rpl::LeaveP2pDodag (std::pair<uint8_t, Ipv6Address> dodag)
+{
+  NS_LOG_FUNCTION (this << (uint32_t)dodag.first << dodag.second);
+
+  RplP2pDodags::iterator iter = m_p2pDodags.find (dodag);
+  if (iter != m_p2pDodags.end ())
+    {
+      iter->second.forward.Cancel ();
+      iter->second.expiration.Cancel ();
+      m_p2pDodags.erase (iter);
+    }
+}
+
+uint32_t Rpl::AggregateDaoTargets (RplDaoTargets &targets)
+{
+  uint32_t merges = 0;
+  bool merged = true;
+  while (merged)
+    {
+      merged = false;
+      for (RplDaoTargets::iterator iter = targets.begin (); iter != targets.end (); iter++)
+        {
+          uint8_t length = iter->first.second;
+          if (length == 0 || iter->first.first.IsMulticast ())
+            {
+              continue;
+            }
+
+          // the sibling differs in the last bit of the prefix only
+          uint8_t bytes[16];
+          iter->first.first.GetBytes (bytes);
+          bytes[(length - 1) / 8] ^= 0x80 >> ((length - 1) % 8);
+          RplDaoTargets::iterator sibling = targets.find (std::make_pair (Ipv6Address (bytes), length));
+          if (sibling == targets.end () || sibling->second.pathLifetime != iter->second.pathLifetime)
+            {
+              continue;
+            }
+
+          RplDaoTarget target = iter->second;
+          if ((int8_t)(sibling->second.pathSequence - target.pathSequence) > 0)
+            {
+              target.pathSequence = sibling->second.pathSequence;
+            }
+          Ipv6Address prefix = iter->first.first.CombinePrefix (Ipv6Prefix (length - 1));
+          targets.erase (sibling);
+          targets.erase (iter);
+          targets[std::make_pair (prefix, length - 1)] = target;
+          merges++;
+          merged = true;
+          break;
+        }
+    }
+  return merges;
+}
+
+void Rpl::AnnounceDaoTargets ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_isRoot || m_floating)
+    {
+      return;
     }
 
-  if (header.GetDestinationAddress ().IsLinkLocal () ||
-      header.GetSourceAddress ().IsLinkLocal ())
+  m_pathSequence++;
+  for (uint32_t i = 0; i < m_routingTable.GetIpv6 ()->GetNInterfaces (); i++)
     {
-      NS_LOG_LOGIC ("Dropping packet not for me and with src or dst LinkLocal");
-      if (!ecb.IsNull ())
+      for (uint32_t j = 0; j < m_routingTable.GetIpv6 ()->GetNAddresses (i); j++)
         {
-          ecb (p, header, Socket::ERROR_NOROUTETOHOST);
+          Ipv6InterfaceAddress address = m_routingTable.GetIpv6 ()->GetAddress (i, j);
+          if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL)
+            {
+              EnqueueDaoTarget (address.GetAddress (), 128, m_pathSequence, DEFAULT_DAO_LIFETIME);
+            }
         }
-      return false;
     }
 
-  if (m_routingTable.GetIpv6 ()->IsForwarding (iif) == false)
+  std::vector<RplRoutingTableEntry> routes = m_routingTable.GetDownwardRoutes ();
+  for (std::vector<RplRoutingTableEntry>::iterator iter = routes.begin (); iter != routes.end (); iter++)
     {
-      NS_LOG_LOGIC ("Forwarding disabled for this interface");
-      if (!ecb.IsNull ())
-        {
-          ecb (p, header, Socket::ERROR_NOROUTETOHOST);
-        }
-      return true;
+      EnqueueDaoTarget (iter->GetDest (), iter->GetDestNetworkPrefix ().GetPrefixLength (),
+                        iter->GetPathSequence (), iter->GetDaoLifetime ());
     }
 
-  NS_LOG_LOGIC ("Unicast destination");
-  //std::cout << "Unicast destination." <<std::endl;
-  Ptr<Ipv6Route> rtentry = m_routingTable.Lookup (header.GetDestinationAddress ());
-  if (rtentry != 0)
+  if (m_routingTable.GetMop () != MOP_STORING_MULTICAST)
     {
-      NS_LOG_LOGIC ("Found unicast destination - calling unicast callback");
-      ucb (idev, rtentry, p, header);
-      return true;
+      return;
     }
-  else
+  std::set<Ipv6Address> groups = m_groups;
+  std::vector<RplRoutingTableEntry> multicastRoutes = m_routingTable.GetMulticastRoutes ();
+  for (std::vector<RplRoutingTableEntry>::iterator iter = multicastRoutes.begin (); iter != multicastRoutes.end (); iter++)
     {
-      NS_LOG_LOGIC ("Did not find unicast destination - returning false");
-      return false;
+      groups.insert (iter->GetDest ());
+    }
+  for (std::set<Ipv6Address>::iterator iter = groups.begin (); iter != groups.end (); iter++)
+    {
+      EnqueueDaoTarget (*iter, 128, m_pathSequence, DEFAULT_DAO_LIFETIME);
     }
 }
 
-void Rpl::Receive (Ptr<Socket> socket)
+void Rpl::JoinGroup (Ipv6Address group)
 {
-  NS_LOG_FUNCTION (this << socket);
-  //std::cout <<"Entering Receive." <<std::endl;
-  
-  Address sender;
-  Ptr<Packet> packet = socket->RecvFrom (sender);
-  Inet6SocketAddress senderAddr = Inet6SocketAddress::ConvertFrom (sender);
-
-  Ipv6Address senderAddress = senderAddr.GetIpv6 ();
-  uint16_t senderPort = senderAddr.GetPort ();
+  NS_LOG_FUNCTION (this << group);
+  NS_ABORT_MSG_IF (!group.IsMulticast () || group.IsLinkLocalMulticast (),
+                   "RPL: " << group << " is not a multicast group beyond link-local scope");
 
-  Ipv6PacketInfoTag interfaceInfo;
-  if (!packet->RemovePacketTag (interfaceInfo))
+  if (!m_groups.insert (group).second)
     {
-      NS_ABORT_MSG ("No incoming interface on RPL message, aborting...");
+      return;
+    }
+  if (m_routingTable.GetMop () == MOP_STORING_MULTICAST && !m_isRoot && !m_floating)
+    {
+      EnqueueDaoTarget (group, 128, ++m_pathSequence, DEFAULT_DAO_LIFETIME);
     }
+}
 
-  uint32_t incomingIf = interfaceInfo.GetRecvIf ();
-  Ptr<Node> node = this->GetObject<Node> ();
-  Ptr<NetDevice> dev = node->GetDevice (incomingIf);
-  uint32_t ipInterfaceIndex = m_routingTable.GetIpv6 ()->GetInterfaceForDevice (dev);
+void Rpl::LeaveGroup (Ipv6Address group)
+{
+  NS_LOG_FUNCTION (this << group);
 
-  int32_t interfaceForAddress = m_routingTable.GetIpv6 ()->GetInterfaceForAddress (senderAddress);
-  if (interfaceForAddress != -1)
+  if (m_groups.erase (group) == 0)
     {
-      NS_LOG_LOGIC ("Ignoring a packet sent by myself.");
       return;
     }
-
-  Icmpv6Header rplMessage;
-  packet->RemoveHeader (rplMessage);
-  //std::cout << rplMessage << std::endl << "Code is: " << (uint32_t)rplMessage.GetCode() << std::endl;
-  
-  if (rplMessage.GetType () == 155)
+  if (m_routingTable.GetMop () == MOP_STORING_MULTICAST && !m_isRoot && !m_floating &&
+      m_routingTable.GetMulticastRoutes (group).empty ())
     {
-      if ( (uint32_t)rplMessage.GetCode () == 0) 
-        {
-          RplDisMessage disMessage;
-          RplSolicitedInformationOption solicitedInformation;
-          packet->RemoveHeader (disMessage);
-          packet->RemoveHeader (solicitedInformation);
-
-          RecvDis (disMessage, solicitedInformation, senderAddress, ipInterfaceIndex, senderPort);
-        }
-      else if ((uint32_t)rplMessage.GetCode () == 1)
-        {
-          RplDioMessage dioMessage;
-          RplDodagConfigurationOption dodagConfiguration;
-          packet->RemoveHeader (dioMessage);
-          packet->RemoveHeader (dodagConfiguration);
-
-          if (m_dioReceived == 1)
-            {
-              m_multicastDis.Cancel ();
-              m_multicastDis = EventId ();
-              m_dioReceived = 0;
-            }
-
-          RecvDio (dioMessage, dodagConfiguration, senderAddress, ipInterfaceIndex);
-        }
+      EnqueueDaoTarget (group, 128, ++m_pathSequence, 0);
     }
-  else
-    {
-      NS_ABORT_MSG ("Not a RPL message, aborting...");
-    }  
+}
 
-  return;
+bool Rpl::IsGroupMember (Ipv6Address group) const
+{
+  return m_groups.find (group) != m_groups.end ();
 }
 
-void Rpl::Join ()
+bool Rpl::IsStoring () const
 {
-  std::cout << "Join" << (uint32_t)m_dioReceived << "\n";
-  Time delay = Seconds (1);
-  m_dioReceived = 1;
-  SendMulticastDis ();
+  uint8_t mop = m_routingTable.GetMop ();
+  return mop == MOP_STORING || mop == MOP_STORING_MULTICAST;
 }
 
-void Rpl::RecvDis (RplDisMessage disMessage, RplSolicitedInformationOption solicitedInformation, Ipv6Address senderAddress, uint32_t incomingInterface, uint16_t senderPort)
+std::vector<std::pair<Ipv6Address, uint32_t> > Rpl::GetMulticastNextHops (Ipv6Address group, Ipv6Address source)
 {
-  std::cout << "Recv DIS: sender" << senderAddress << "\n";
-  if (m_routingTable.GetNodeType () == true) //Only routers can receive DIS messages
-    {
-      m_routingTable.AddNetworkRouteTo (senderAddress, incomingInterface);
-      SendDio(senderAddress, incomingInterface, senderPort);
-      ResetTrickle ();
+  NS_LOG_FUNCTION (this << group << source);
+
+  std::vector<std::pair<Ipv6Address, uint32_t> > nextHops;
+  bool local = source.IsAny () || m_routingTable.GetIpv6 ()->GetInterfaceForAddress (source) != -1;
+  Ipv6Address child = local ? Ipv6Address::GetAny () : m_routingTable.GetDownwardNextHop (source);
 
-      InsertNeighbor (diffDodag);
+  std::vector<RplRoutingTableEntry> routes = m_routingTable.GetMulticastRoutes (group);
+  for (std::vector<RplRoutingTableEntry>::iterator iter = routes.begin (); iter != routes.end (); iter++)
+    {
+      if (iter->GetNextHop () != child)
+        {
+          nextHops.push_back (std::make_pair (iter->GetNextHop (), iter->GetInterface ()));
+        }
     }
-  else
+
+  // up towards the root, for the subscribers outside this sub-DODAG
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if ((local || child != Ipv6Address::GetAny ()) && !m_isRoot && parent)
     {
-      NS_ABORT_MSG ("Node Type: Leaf");
+      nextHops.push_back (std::make_pair (parent->GetNeighborAddress (), parent->GetInterface ()));
     }
+  return nextHops;
 }
 
-void Rpl::RecvDio (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, Ipv6Address senderAddress, uint32_t incomingInterface)
+bool Rpl::IsMulticastDuplicate (Ptr<const Packet> packet)
 {
-  std::cout << "Received DIO from " << senderAddress << "Rank is " << dioMessage.GetRank() << "\n";
-  //Not included yung poison na DIO for disjoin
-  if (dioMessage.GetVersionNumber () == m_routingTable.GetVersionNumber ())
+  uint64_t uid = packet->GetUid ();
+  if (std::find (m_multicastSeen.begin (), m_multicastSeen.end (), uid) != m_multicastSeen.end ())
     {
-      if (dioMessage.GetDtsn () != m_routingTable.GetDtsn ())
-        {
-          //Schedule DAO
-        }
+      return true;
     }
-  else
+  m_multicastSeen.push_back (uid);
+  if (m_multicastSeen.size () > MULTICAST_SEEN_SIZE)
     {
-      if (dioMessage.GetRank() < m_routingTable.GetRank() || m_routingTable.GetRank () == 0)
-       {
-        m_routingTable.ClearRoutingTable ();
-        //m_neighborSet.ClearNeighborSet ();
-        
-        m_routingTable.SetRplInstanceId (dioMessage.GetRplInstanceId ());
-        m_routingTable.SetDodagId (dioMessage.GetDodagId ());
-        m_routingTable.SetObjectiveCodePoint (dodagConfiguration.GetObjectiveCodePoint ());
-        m_routingTable.SetDtsn (dioMessage.GetDtsn ()); 
-
-        if (dodagConfiguration.GetObjectiveCodePoint () == 0)
-          {
-            uint16_t computedRank = RplObjectiveFunctionOf0::ComputeRank (dioMessage.GetRank ());
-            m_routingTable.SetRank (computedRank);
-            std::cout << "Rank changed: " << m_routingTable.GetRank() << std::endl;
-          }
-
-        //Assume all nodes are routers (no leaf nodes)
-
-        if (m_routingTable.GetVersionNumber () != 0)
-          {
-            ResetTrickle ();
-          }
-        else
-          { 
-            StartTrickle ();
-            m_routingTable.SetVersionNumber (dioMessage.GetVersionNumber ());
-          }
-        }
+      m_multicastSeen.pop_front ();
     }
-
-  InsertNeighbor (senderAddress, dioMessage.GetDodagId (), dioMessage.GetDtsn (), dioMessage.GetRank (), incomingInterface);
-  m_neighborSet.SelectParent ();
-
-  //non storing mode
-  m_routingTable.AddNetworkRouteTo (senderAddress, incomingInterface);
-  
-  std::cout << "DODAG ID (after recv DIS): " << m_routingTable.GetDodagId () << "\n";
-  std::cout << "This node's address is: " << m_routingTable.GetIpv6()->GetAddress(1,0) << std::endl;
-  std::cout << "This node's rank is " << m_routingTable.GetRank() << std::endl;
+  return false;
 }
 
-void Rpl::SendMulticastDis ()
+bool Rpl::IsDaoAnnounced (const std::pair<Ipv6Address, uint8_t> &target) const
 {
-  if (m_dioReceived == 1)
+  for (std::set<std::pair<Ipv6Address, uint8_t> >::const_iterator iter = m_daoAnnounced.begin ();
+       iter != m_daoAnnounced.end (); iter++)
     {
-      Ptr<Packet> p = Create<Packet>();
-      Ptr<Socket> sendingSocket;
-      
-      Icmpv6Header dis;
-      std::cout << "Sending DIS." << std::endl;
-      std::cout << "This node's address is: " << m_routingTable.GetIpv6()->GetAddress(1,0) << std::endl;
-      dis.SetType (155);
-      dis.SetCode (0);
+      if (iter->second <= target.second && Ipv6Prefix (iter->second).IsMatch (iter->first, target.first))
+        {
+          return true;
+        }
+    }
+  return false;
+}
 
-      RplDisMessage disMessage;
-      RplSolicitedInformationOption solicitedInformation;
+void Rpl::EnqueueDaoTarget (Ipv6Address target, uint8_t prefixLength, uint8_t pathSequence, uint8_t pathLifetime)
+{
+  NS_LOG_FUNCTION (this << target << (uint32_t)prefixLength << (uint32_t)pathSequence << (uint32_t)pathLifetime);
 
-      p->AddHeader (solicitedInformation);
-      p->AddHeader (disMessage);
-      p->AddHeader (dis);
+  std::pair<Ipv6Address, uint8_t> key = std::make_pair (target.CombinePrefix (Ipv6Prefix (prefixLength)), prefixLength);
+  RplDaoTarget info;
+  info.pathSequence = pathSequence;
+  info.pathLifetime = pathLifetime;
 
-      for (SocketListI iter = m_sendSocketList.begin (); iter != m_sendSocketList.end (); iter++ )
+  if (!m_daoAggregation)
+    {
+      Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+      if (parent)
         {
-          sendingSocket = iter->first;
+          RplDaoTargets single;
+          single[key] = info;
+          SendDao (single, parent->GetNeighborAddress (), parent->GetInterface ());
         }
+      return;
+    }
 
-      sendingSocket->SendTo(p, 0, Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT));
+  RplDaoTargets::iterator pending = m_daoPending.find (key);
+  if (pending != m_daoPending.end () && pathLifetime == 0 && pending->second.pathLifetime != 0 &&
+      !IsDaoAnnounced (key))
+    {
+      // the parent never heard of the target: drop both
+      m_daoPending.erase (pending);
+      return;
+    }
+  m_daoPending[key] = info;
 
-      Time delay = Seconds (1);
-      m_multicastDis = Simulator::Schedule (delay, &Rpl::SendMulticastDis, this);
-    } 
+  if (!m_daoTimer.IsRunning ())
+    {
+      m_daoTimer = Simulator::Schedule (m_daoDelay, &Rpl::FlushDao, this);
+    }
 }
 
-void Rpl::SendDio (Ipv6Address destAddress, uint32_t incomingInterface, uint16_t senderPort) 
+void Rpl::AggregateRoutes ()
 {
-  if (m_routingTable.GetVersionNumber () !=0) 
+  NS_LOG_FUNCTION (this);
+
+  // only storing mode routers hold downward routes
+  if (IsStoring ())
     {
-      Ptr<Packet> p = Create<Packet>();
-      Ptr<Socket> sendingSocket;
-      SocketIpv6HopLimitTag tag;
-      tag.SetHopLimit (255);
+      m_routingTable.AggregateDownwardRoutes ();
+    }
+  m_routeAggregation = Simulator::Schedule (m_routeAggregationInterval, &Rpl::AggregateRoutes, this);
+}
 
-      Icmpv6Header dio;
-      dio.SetType (155);
-      dio.SetCode (1);
+void Rpl::FlushDao ()
+{
+  NS_LOG_FUNCTION (this << m_daoPending.size ());
 
-      RplDioMessage dioMessage;
-      dioMessage.SetFlagG (m_routingTable.GetFlagG ());
-      dioMessage.SetMop (MOP);
-      dioMessage.SetPrf (0);
-      dioMessage.SetRplInstanceId (m_routingTable.GetRplInstanceId ());
-      dioMessage.SetDtsn (m_routingTable.GetDtsn ());
-      dioMessage.SetVersionNumber (m_routingTable.GetVersionNumber ());
-      dioMessage.SetRank (m_routingTable.GetRank ());
-      dioMessage.SetDodagId (m_routingTable.GetDodagId ());
-      
-      RplDodagConfigurationOption dodagConfiguration;
-      dodagConfiguration.SetPathControlSize (DEFAULT_PATH_CONTROL_SIZE);
-      dodagConfiguration.SetDioIntervalDoublings (DEFAULT_DIO_INTERVAL_DOUBLINGS);
-      dodagConfiguration.SetDioIntervalMin (DEFAULT_DIO_INTERVAL_MIN);
-      dodagConfiguration.SetDioRedundancyConstant (DEFAULT_DIO_REDUNDANCY_CONSTANT);
-      dodagConfiguration.SetMaxRankIncrease (0);
-      dodagConfiguration.SetMinHopRankIncrease (DEFAULT_MIN_HOP_RANK_INCREASE);
-      dodagConfiguration.SetObjectiveCodePoint (OCP);
-      //dodagConfiguration.SetDefaultLifetime ();
-      //dodagConfiguration.SetLifetimeUnit ();
-      
-      p->AddHeader (dodagConfiguration);
-      p->AddHeader (dioMessage);
-      p->AddHeader (dio);
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if (!parent || m_daoPending.empty ())
+    {
+      m_daoPending.clear ();
+      return;
+    }
+
+  AggregateDaoTargets (m_daoPending);
+  SendDao (m_daoPending, parent->GetNeighborAddress (), parent->GetInterface ());
 
-      if (!m_recvSocket) 
+  for (RplDaoTargets::iterator iter = m_daoPending.begin (); iter != m_daoPending.end (); iter++)
+    {
+      if (iter->second.pathLifetime != 0)
         {
-          NS_LOG_LOGIC ("RPL: adding receiving socket");
-          TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-          Ptr<Node> theNode = GetObject<Node> ();
-          m_recvSocket = Socket::CreateSocket (theNode, tid);
-          Inet6SocketAddress local = Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT);
-          m_recvSocket->Bind (local);
-          m_recvSocket->SetRecvCallback (MakeCallback (&Rpl::Receive, this));
-          m_recvSocket->SetIpv6RecvHopLimit (true);
-          m_recvSocket->SetRecvPktInfo (true);
+          m_daoAnnounced.insert (iter->first);
+          continue;
         }
 
-      for (SocketListI iter = m_sendSocketList.begin (); iter != m_sendSocketList.end (); iter++ )
+      Ipv6Prefix prefix (iter->first.second);
+      for (std::set<std::pair<Ipv6Address, uint8_t> >::iterator announced = m_daoAnnounced.begin ();
+           announced != m_daoAnnounced.end (); )
         {
-          if (iter->second == incomingInterface)
+          if (announced->second >= iter->first.second && prefix.IsMatch (iter->first.first, announced->first))
             {
-              sendingSocket = iter->first;
+              m_daoAnnounced.erase (announced++);
             }
           else
             {
-              sendingSocket = m_recvSocket;
+              announced++;
             }
         }
-
-      std::cout << "Proceed to send DIO. " << std::endl;
-      NS_LOG_DEBUG ("SendTo: " << *p);
-      sendingSocket->SendTo (p, 0, Inet6SocketAddress (destAddress, senderPort));
-    }
-  else 
-    {
-      std::cout << "Not yet in DODAG\n";
     }
+  m_daoPending.clear ();
 }
 
-void Rpl::SendDio (Ipv6Address destAddress, uint32_t incomingInterface) 
+void Rpl::SendDao (const RplDaoTargets &targets, Ipv6Address parent, uint32_t interface)
 {
-  if (m_routingTable.GetVersionNumber () !=0) 
+  Ptr<Socket> sendingSocket = GetSocket (interface);
+  if (!sendingSocket)
     {
-      Ptr<Packet> p = Create<Packet>();
-      Ptr<Socket> sendingSocket;
-      SocketIpv6HopLimitTag tag;
-      tag.SetHopLimit (255);
+      return;
+    }
 
-      Icmpv6Header dio;
-      dio.SetType (155);
-      dio.SetCode (1);
+  // what is left of the link MTU after the IPv6, UDP, ICMPv6 and DAO headers
+  RplDaoMessage daoMessage;
+  uint32_t mtu = m_routingTable.GetIpv6 ()->GetMtu (interface);
+  uint32_t budget = mtu - 40 - 8 - 4 - daoMessage.GetSerializedSize ();
 
-      RplDioMessage dioMessage;
-      dioMessage.SetFlagG (m_routingTable.GetFlagG ());
-      dioMessage.SetMop (MOP);
-      dioMessage.SetPrf (0);
-      dioMessage.SetRplInstanceId (m_routingTable.GetRplInstanceId ());
-      dioMessage.SetDtsn (m_routingTable.GetDtsn ());
-      dioMessage.SetVersionNumber (m_routingTable.GetVersionNumber ());
-      dioMessage.SetRank (m_routingTable.GetRank ());
-      dioMessage.SetDodagId (m_routingTable.GetDodagId ());
-      
-      RplDodagConfigurationOption dodagConfiguration;
-      dodagConfiguration.SetPathControlSize (DEFAULT_PATH_CONTROL_SIZE);
-      dodagConfiguration.SetDioIntervalDoublings (DEFAULT_DIO_INTERVAL_DOUBLINGS);
-      dodagConfiguration.SetDioIntervalMin (DEFAULT_DIO_INTERVAL_MIN);
-      dodagConfiguration.SetDioRedundancyConstant (DEFAULT_DIO_REDUNDANCY_CONSTANT);
-      dodagConfiguration.SetMaxRankIncrease (0);
-      dodagConfiguration.SetMinHopRankIncrease (DEFAULT_MIN_HOP_RANK_INCREASE);
-      dodagConfiguration.SetObjectiveCodePoint (OCP);
-      //dodagConfiguration.SetDefaultLifetime ();
-      //dodagConfiguration.SetLifetimeUnit ();
-      
-      p->AddHeader (dodagConfiguration);
-      p->AddHeader (dioMessage);
-      p->AddHeader (dio);
+  // targets sharing a path sequence and lifetime share a Transit Information option
+  typedef std::map<std::pair<uint8_t, uint8_t>, std::vector<std::pair<Ipv6Address, uint8_t> > > DaoGroups;
+  DaoGroups groups;
+  for (RplDaoTargets::const_iterator iter = targets.begin (); iter != targets.end (); iter++)
+    {
+      groups[std::make_pair (iter->second.pathSequence, iter->second.pathLifetime)].push_back (iter->first);
+    }
 
-      if (!m_recvSocket) 
+  Ptr<Packet> options = Create<Packet> ();
+  uint32_t used = 0;
+  uint32_t count = 0;
+  for (DaoGroups::iterator group = groups.begin (); group != groups.end (); group++)
+    {
+      RplTransitInformationOption transit;
+      transit.SetPathSequence (group->first.first);
+      transit.SetPathLifetime (group->first.second);
+      transit.SetParentAddress (Ipv6Address::GetAny ());
+      Ptr<Packet> transitOption = Create<Packet> ();
+      transitOption->AddHeader (transit);
+
+      uint32_t described = 0;
+      for (std::vector<std::pair<Ipv6Address, uint8_t> >::iterator iter = group->second.begin ();
+           iter != group->second.end (); iter++)
         {
-          NS_LOG_LOGIC ("RPL: adding receiving socket");
-          TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
-          Ptr<Node> theNode = GetObject<Node> ();
-          m_recvSocket = Socket::CreateSocket (theNode, tid);
-          Inet6SocketAddress local = Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT);
-          m_recvSocket->Bind (local);
-          m_recvSocket->SetRecvCallback (MakeCallback (&Rpl::Receive, this));
-          m_recvSocket->SetIpv6RecvHopLimit (true);
-          m_recvSocket->SetRecvPktInfo (true);
-        }
+          RplTargetOption target;
+          target.SetTarget (iter->first);
+          target.SetPrefixLength (iter->second);
 
-      for (SocketListI iter = m_sendSocketList.begin (); iter != m_sendSocketList.end (); iter++ )
-        {
-          if (iter->second == incomingInterface)
-            {
-              sendingSocket = iter->first;
-            }
-          else
+          if (count > 0 && used + target.GetSerializedSize () + transit.GetSerializedSize () > budget)
             {
-              sendingSocket = m_recvSocket;
+              if (described > 0)
+                {
+                  options->AddAtEnd (transitOption);
+                }
+              TransmitDao (options, count, parent, sendingSocket);
+
+              options = Create<Packet> ();
+              used = 0;
+              count = 0;
+              described = 0;
             }
-        }
 
-      NS_LOG_DEBUG ("SendTo: " << *p);
+          Ptr<Packet> targetOption = Create<Packet> ();
+          targetOption->AddHeader (target);
+          options->AddAtEnd (targetOption);
+          used += target.GetSerializedSize ();
+          count++;
+          described++;
+        }
 
-      sendingSocket->SendTo (p, 0, Inet6SocketAddress (ALL_RPL_NODES, RPL_PORT));
+      options->AddAtEnd (transitOption);
+      used += transit.GetSerializedSize ();
     }
-  else 
+
+  if (count > 0)
     {
-      std::cout << "Not yet in DODAG\n";
+      TransmitDao (options, count, parent, sendingSocket);
     }
 }
 
+void Rpl::TransmitDao (Ptr<Packet> options, uint32_t targets, Ipv6Address parent, Ptr<Socket> socket)
+{
+  Icmpv6Header dao;
+  dao.SetType (155);
+  dao.SetCode (2);
+
+  RplDaoMessage daoMessage;
+  daoMessage.SetRplInstanceId (m_routingTable.GetRplInstanceId ());
+  daoMessage.SetDaoSequence (m_daoSequence++);
+  daoMessage.SetFlagD (true);
+  daoMessage.SetDodagId (m_routingTable.GetDodagId ());
+
+  Ptr<Packet> p = options;
+  p->AddHeader (daoMessage);
+  p->AddHeader (dao);
+
+  m_daoTxTrace (p, parent, targets);
+  m_controlTxTrace (p, 2);
+  socket->SendTo (p, 0, Inet6SocketAddress (parent, RPL_PORT));
+}
+
 
 void Rpl::InsertNeighbor (Ipv6Address neighborAddress, Ipv6Address dodagID, uint8_t dtsn, uint16_t rank, 
-                          uint32_t incomingInterface)
+                          uint32_t incomingInterface, uint8_t rootLoad)
 {
+  Ptr<Neighbor> known = m_neighborSet.FindNeighbor (neighborAddress);
+  if (known)
+    {
+      m_neighborSet.UpdateNeighbor (neighborAddress, dodagID, dtsn, rank, incomingInterface);
+      known->SetRootLoad (rootLoad);
+      known->SetReachable (true);
+      known->SetLastHeard (Simulator::Now ());
+      known->SetProbes (0);
+      return;
+    }
+
   Neighbor neighbor;
   neighbor.SetNeighborAddress (neighborAddress);
   neighbor.SetDodagId (dodagID);
   neighbor.SetDtsn (dtsn);
   neighbor.SetRank (rank);
   neighbor.SetInterface (incomingInterface);
+  neighbor.SetReachable (true);
+  neighbor.SetRootLoad (rootLoad);
+  neighbor.SetLastHeard (Simulator::Now ());
 
   m_neighborSet.AddNeighbor(neighbor);
 }
 
-void Rpl::InsertNeighbor (neighborType type)
+void Rpl::StartTrickle ()
 {
-  Neighbor neighbor;
-  neighbor.SetNeighborType (type);
+  NS_LOG_FUNCTION (this);
+  // leaves have no DIO to send
+  if (m_leaf)
+    {
+      return;
+    }
+  m_interval = m_iMin;
+  RestartInterval ();
+}
 
-  m_neighborSet.AddNeighbor(neighbor);
+void Rpl::RestartInterval ()
+{
+  m_counter = 0;
+  m_t = Seconds (m_rng->GetValue (m_interval.GetSeconds () / 2, m_interval.GetSeconds ()));
+  if (m_wakeSchedule && m_wakeAlignment)
+    {
+      // staying in [I/2, I) keeps the suppression of plain Trickle
+      Time now = Simulator::Now ();
+      m_t = m_wakeSchedule->AlignTransmission (now + m_t, now + Seconds (m_interval.GetSeconds () / 2),
+                                               now + m_interval, m_rng->GetValue ()) - now;
+    }
+
+  m_dioSchedule.Cancel ();
+  m_restartInterval.Cancel ();
+  m_dioSchedule = Simulator::Schedule (m_t, &Rpl::TrickleTransmit, this);
+  m_restartInterval = Simulator::Schedule (m_interval, &Rpl::IntervalExpired, this);
+}
+
+void Rpl::IntervalExpired ()
+{
+  m_interval = m_interval + m_interval;
+  if (m_interval > m_iMax)
+    {
+      m_interval = m_iMax;
+    }
+  RestartInterval ();
+}
+
+void Rpl::TrickleTransmit ()
+{
+  if (m_counter < m_k)
+    {
+      if (m_wakeSchedule && !m_wakeSchedule->IsAwake (Simulator::Now ()))
+        {
+          m_dioWakeups++;
+        }
+      SendMulticastDio ();
+    }
 }
 
 void Rpl::ResetTrickle ()
 {
-  
+  if (!m_leaf && m_interval != m_iMin)
+    {
+      m_interval = m_iMin;
+      RestartInterval ();
+    }
 }
 
 void Rpl::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_routingTable.ClearRoutingTable ();
+  m_dioSchedule.Cancel ();
+  m_restartInterval.Cancel ();
+  m_multicastDis.Cancel ();
+  m_loadUpdate.Cancel ();
+  m_nudTimer.Cancel ();
+  m_queueSample.Cancel ();
+  m_energySample.Cancel ();
+  m_mobilityCheck.Cancel ();
+  m_daoTimer.Cancel ();
+  m_routeAggregation.Cancel ();
+  m_globalRepair.Cancel ();
+  m_localRepair.Cancel ();
+  for (std::map<uint32_t, EventId>::iterator iter = m_coalescedDio.begin (); iter != m_coalescedDio.end (); iter++)
+    {
+      iter->second.Cancel ();
+    }
 
-  for (SocketListI iter = m_sendSocketList.begin (); iter != m_sendSocketList.end (); iter++ )
+  for (RplP2pDodags::iterator iter = m_p2pDodags.begin (); iter != m_p2pDodags.end (); iter++)
     {
-      iter->first->Close ();
+      iter->second.forward.Cancel ();
+      iter->second.expiration.Cancel ();
     }
+  m_p2pDodags.clear ();
+  m_multicastSeen.clear ();
+
+  m_routingTable.ClearRoutingTable ();
+  m_routingTable.ClearP2pRoutes ();
 
-  m_sendSocketList.clear ();
+  for (uint32_t i = 0; i < m_sendSockets.size (); i++)
+    {
+      CloseSocket (i);
+    }
+  m_sendSockets.clear ();
 
-  m_recvSocket->Close ();
-  m_recvSocket = 0;
+  if (m_recvSocket)
+    {
+      m_recvSocket->Close ();
+      m_recvSocket = 0;
+    }
 
   m_routingTable.SetIpv6 (0);
+  m_wakeSchedule = 0;
 
   Ipv6RoutingProtocol::DoDispose ();
 }
@@ -667,7 +3118,7 @@ void Rpl::NotifyInterfaceUp (uint32_t i)
       Ipv6Address networkAddress = address.GetAddress ().CombinePrefix (networkMask);
       std::cout << "Address #" << j << ": " << address <<" Mask: " <<networkMask << std::endl;
 
-      if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL)
+      if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL && !m_leaf)
         {
           m_routingTable.AddNetworkRouteTo (networkAddress, i);
         }   
@@ -678,6 +3129,13 @@ void Rpl::NotifyInterfaceUp (uint32_t i)
 void Rpl::NotifyInterfaceDown (uint32_t interface)
 {
   std::cout <<"Interface down." << std::endl;
+  m_neighborSet.SetInterfaceDown (interface);
+
+  Ptr<Neighbor> parent = m_neighborSet.FindNeighbor (m_routingTable.GetDodagParent ());
+  if (parent && parent->GetInterface () == interface)
+    {
+      NotifyLinkFailure (parent->GetNeighborAddress ());
+    }
 }
 
 void Rpl::NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address)
@@ -693,17 +3151,41 @@ void Rpl::NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address)
   Ipv6Address networkAddress = address.GetAddress ().CombinePrefix (address.GetPrefix ());
   Ipv6Prefix networkMask = address.GetPrefix ();
 
-  if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL)
+  if (address.GetScope () == Ipv6InterfaceAddress::GLOBAL && !m_leaf)
     {
       m_routingTable.AddNetworkRouteTo (networkAddress, interface);
     }
   std::cout << "Address added: " << networkAddress << std::endl;
 
+  // interfaces brought up after the start get their socket here; before
+  // it, DoInitialize opens one on every interface
+  if (m_recvSocket && address.GetScope () == Ipv6InterfaceAddress::LINKLOCAL && !GetSocket (interface))
+    {
+      OpenSocket (interface, address.GetAddress ());
+    }
+
 }
 
 void Rpl::NotifyRemoveAddress (uint32_t interface, Ipv6InterfaceAddress address)
 {
   std::cout <<"Remove address." << std::endl;
+  NS_LOG_FUNCTION (this << interface << address);
+  if (address.GetScope () != Ipv6InterfaceAddress::LINKLOCAL || !GetSocket (interface))
+    {
+      return;
+    }
+
+  // move the socket to another link-local address of the interface, if any
+  CloseSocket (interface);
+  for (uint32_t j = 0; j < m_routingTable.GetIpv6 ()->GetNAddresses (interface); j++)
+    {
+      Ipv6InterfaceAddress other = m_routingTable.GetIpv6 ()->GetAddress (interface, j);
+      if (other.GetScope () == Ipv6InterfaceAddress::LINKLOCAL && other.GetAddress () != address.GetAddress ())
+        {
+          OpenSocket (interface, other.GetAddress ());
+          break;
+        }
+    }
 }
 
 void Rpl::NotifyAddRoute (Ipv6Address dst, Ipv6Prefix mask, Ipv6Address nextHop, uint32_t interface, Ipv6Address prefixToUse)
@@ -745,7 +3227,15 @@ void Rpl::SetIpv6 (Ptr<Ipv6> ipv6)
 
 void Rpl::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 {
-
+  std::ostream* os = stream->GetStream ();
+  Ptr<Node> node = GetObject<Node> ();
+
+  *os << "Node: " << (node ? node->GetId () : 0)
+      << ", Time: " << Simulator::Now ().GetSeconds () << "s"
+      << ", RPL table (DODAG " << m_routingTable.GetDodagId ()
+      << ", rank " << m_routingTable.GetRank () << ")" << std::endl;
+  m_routingTable.Print (*os);
+  *os << std::endl;
 }
 
 
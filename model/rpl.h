@@ -29,12 +29,99 @@
 #include <ns3/rpl-routing-table.h>
 #include <ns3/rpl-neighbor.h>
 #include <ns3/rpl-neighborset.h>
+#include <ns3/rpl-path-stats.h>
+#include <ns3/rpl-wake-schedule.h>
 #include <ns3/rpl-header.h>
 #include <ns3/rpl-option.h>
 #include <ns3/random-variable-stream.h>
+#include <ns3/traced-callback.h>
+#include <ns3/mac48-address.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
 
 namespace ns3 {
 
+class QueueDisc;
+
+/**
+ * \ingroup rpl
+ * \brief Path information of a DAO target waiting to be sent.
+ */
+struct RplDaoTarget
+{
+  uint8_t pathSequence; //!< path sequence of the announcement
+  uint8_t pathLifetime; //!< path lifetime, 0 for a No-Path
+};
+
+/// DAO targets, keyed by target prefix and prefix length
+typedef std::map<std::pair<Ipv6Address, uint8_t>, RplDaoTarget> RplDaoTargets;
+
+/**
+ * \ingroup rpl
+ * \brief State of a node in the temporary DODAG of a P2P route discovery (RFC 6997).
+ */
+struct RplP2pDodag
+{
+  uint16_t rank; //!< rank in the temporary DODAG, INFINITE_RANK if not joined
+  uint8_t version; //!< version number of the temporary DODAG
+  RplP2pRouteDiscoveryOption routeDiscovery; //!< P2P-RDO advertised, this node last in its address vector
+  /// link-local address and interface of the DIO senders, by the last address of their vector
+  std::map<Ipv6Address, std::pair<Ipv6Address, uint32_t> > previousHops;
+  bool replied; //!< the target answered with a DRO
+  Time start; //!< start of the discovery, on the origin
+  EventId forward; //!< pending DIO
+  EventId expiration; //!< end of the temporary DODAG
+};
+
+/// temporary DODAGs, keyed by local RPL Instance ID and DODAG ID (the origin)
+typedef std::map<std::pair<uint8_t, Ipv6Address>, RplP2pDodag> RplP2pDodags;
+
+/**
+ * \ingroup rpl
+ * \brief Token bucket limiting the responses to DIS messages on an interface.
+ */
+class RplTokenBucket
+{
+public:
+  RplTokenBucket ();
+
+  /**
+   * \brief Set the rate and depth of the bucket, which starts full.
+   * \param rate tokens added per second, 0 for no limit
+   * \param burst maximum number of tokens
+   */
+  void SetRate (double rate, uint32_t burst);
+
+  /**
+   * \brief Take a token if there is one.
+   * \param now the current time
+   * \return true if a token was taken
+   */
+  bool Consume (Time now);
+
+  /**
+   * \brief Get the time until the next token.
+   * \param now the current time
+   * \return zero if a token is available
+   */
+  Time GetDelay (Time now);
+
+private:
+  /**
+   * \brief Add the tokens earned since the last refill.
+   * \param now the current time
+   */
+  void Refill (Time now);
+
+  double m_rate;      //!< tokens added per second, 0 for no limit
+  uint32_t m_burst;   //!< maximum number of tokens
+  double m_tokens;    //!< tokens available
+  Time m_lastRefill;  //!< time of the last refill
+};
+
 class Rpl : public Ipv6RoutingProtocol
 {
 public:
@@ -55,6 +142,85 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * TracedCallback signature for a local reroute.
+   * \param oldParent the parent that failed
+   * \param newParent the backup parent now in use
+   * \param latency time from the failure to the switch
+   */
+  typedef void (* RerouteTracedCallback) (Ipv6Address oldParent, Ipv6Address newParent, Time latency);
+
+  /**
+   * TracedCallback signature for a packet routed through a backup parent
+   * before a DIO from that parent confirmed it.
+   * \param packet the packet
+   * \param parent the backup parent
+   */
+  typedef void (* PacketSavedTracedCallback) (Ptr<const Packet> packet, Ipv6Address parent);
+
+  /**
+   * TracedCallback signature for a packet routed towards the root.
+   * \param packet the packet
+   * \param nextHop the parent the packet is handed to
+   */
+  typedef void (* UpwardTracedCallback) (Ptr<const Packet> packet, Ipv6Address nextHop);
+
+  /**
+   * TracedCallback signature for a DAO sent to a parent.
+   * \param packet the DAO, ICMPv6 header included
+   * \param parent the parent the DAO is sent to
+   * \param targets number of Target options in the DAO
+   */
+  typedef void (* DaoTxTracedCallback) (Ptr<const Packet> packet, Ipv6Address parent, uint32_t targets);
+
+  /**
+   * TracedCallback signature for the start of a repair.
+   * \param global true for a global repair started by the root, false for
+   *        a node detaching from its DODAG
+   * \param version the DODAG version number after the repair started
+   */
+  typedef void (* RepairStartTracedCallback) (bool global, uint8_t version);
+
+  /**
+   * TracedCallback signature for a node attached again after a repair.
+   * \param global true when the node joined the new version of its DODAG,
+   *        false when a detached node found a parent or formed a floating DODAG
+   * \param version the DODAG version number the node is now in
+   */
+  typedef void (* RepairedTracedCallback) (bool global, uint8_t version);
+
+  /**
+   * TracedCallback signature for an RPL control message sent.
+   * \param packet the message, ICMPv6 header included
+   * \param code the ICMPv6 code: 0 for DIS, 1 for DIO, 2 for DAO, 4 for DRO
+   */
+  typedef void (* ControlTxTracedCallback) (Ptr<const Packet> packet, uint8_t code);
+
+  /**
+   * TracedCallback signature for a DIS received.
+   * \param sender the sender of the DIS
+   * \param multicast true if the DIS was sent to all RPL nodes
+   * \param answered true if a DIO or a Trickle reset answered it at once,
+   *        false if it was ignored or coalesced with an earlier one
+   */
+  typedef void (* DisRxTracedCallback) (Ipv6Address sender, bool multicast, bool answered);
+
+  /**
+   * TracedCallback signature for a point-to-point route found by a route discovery.
+   * \param target the target of the discovery
+   * \param hops number of hops of the route
+   * \param latency time from the start of the discovery to the DRO
+   */
+  typedef void (* P2pRouteTracedCallback) (Ipv6Address target, uint32_t hops, Time latency);
+
+  /**
+   * TracedCallback signature for a multicast data packet sent or forwarded.
+   * \param packet the packet
+   * \param group the multicast group
+   * \param nextHop the neighbor it is sent to, or the any address when sent to every neighbor
+   */
+  typedef void (* MulticastTxTracedCallback) (Ptr<const Packet> packet, Ipv6Address group, Ipv6Address nextHop);
+
   /**
    * \param stream first stream index to use
    * \return the number of stream indices assigned by this model
@@ -86,30 +252,347 @@ public:
 
   /**
    * \brief DODAG join
+   *
+   * Multicast DISs are sent on every RPL interface, after a random delay
+   * and then with exponential backoff, until a DIO is received.
    */
   void Join ();
 
+  /**
+   * \brief Report a unicast transmission failure towards a neighbor.
+   *
+   * If the neighbor is the preferred parent, the node switches at once to
+   * the next viable parent of its parent set.
+   * \param neighbor link-local address of the neighbor
+   */
+  void NotifyLinkFailure (Ipv6Address neighbor);
+
+  /**
+   * \brief Report the outcome of a unicast packet sent to a neighbor.
+   *
+   * Feeds the neighbor's ETX estimate; an acknowledged packet also
+   * refreshes its reachability, while MaxTxFailures consecutive losses
+   * mark it unreachable.
+   * \param neighbor link-local address of the neighbor
+   * \param attempts transmissions spent on the packet
+   * \param acked true if the packet was acknowledged
+   */
+  void NotifyTxResult (Ipv6Address neighbor, uint32_t attempts, bool acked);
+
+  /**
+   * \brief Report a failed attempt of a unicast packet that the device will retry.
+   *
+   * Device-agnostic hook for the MAC of any device; the attempts are
+   * counted until the outcome of the packet is reported.
+   * \param address link-layer address of the neighbor
+   */
+  void NotifyTxRetry (const Address &address);
+
+  /**
+   * \brief Report the outcome of a unicast packet given to a device.
+   *
+   * Device-agnostic hook for the MAC of any device, folding the attempts
+   * reported by NotifyTxRetry into the outcome.
+   * \param address link-layer address of the neighbor
+   * \param acked true if the packet was acknowledged
+   */
+  void NotifyTxResult (const Address &address, bool acked);
+
+  /**
+   * \brief Report the signal strength of a frame heard from a neighbor.
+   *
+   * Device-agnostic hook for the PHY of any device; the RSSI trend of the
+   * parent link drives the handovers of the mobility mode.
+   * \param address link-layer address of the sender
+   * \param rssi signal strength of the frame, in dBm
+   */
+  void NotifyRssi (const Address &address, double rssi);
+
+  /**
+   * \brief Check if this node is a DODAG root.
+   * \return true if this node is configured as a DODAG root
+   */
+  bool IsRoot () const;
+
+  /**
+   * \brief Check if this node is a leaf.
+   *
+   * A leaf (RFC 6550 8.5) joins a DODAG but never advertises it: it sends
+   * no DIOs, keeps a single neighbor, its preferred parent, and stores no
+   * route besides the default route towards that parent.
+   * \return true if this node is configured as a leaf
+   */
+  bool IsLeaf () const;
+
+  /**
+   * \brief Get the ID of the DODAG this node belongs to.
+   * \return the DODAG ID, or "::" if the node has not joined yet
+   */
+  Ipv6Address GetDodagId () const;
+
+  /**
+   * \brief Get the rank of this node.
+   * \return the rank, or 0 if the node has not joined yet
+   */
+  uint16_t GetRank () const;
+
+  /**
+   * \brief Get the preferred parent of this node.
+   * \return the link-local address of the preferred parent, or "::" if none
+   */
+  Ipv6Address GetPreferredParent () const;
+
+  /**
+   * \brief Set the rank cost of an interface.
+   * \param interface the interface index
+   * \param cost added to the rank advertised in DIOs sent on the interface
+   *
+   * A border router can advertise a low rank on a fast backhaul and a
+   * higher one on a lossy mesh, so that nodes hearing both prefer the
+   * backhaul. The cost defaults to 0 on every interface.
+   */
+  void SetInterfaceCost (uint32_t interface, uint16_t cost);
+
+  /**
+   * \brief Get the rank cost of an interface.
+   * \param interface the interface index
+   * \return the cost added to the rank advertised on the interface
+   */
+  uint16_t GetInterfaceCost (uint32_t interface) const;
+
+  /**
+   * \brief Get the rank advertised in DIOs sent on an interface.
+   * \param interface the interface index
+   * \return the rank plus the interface cost, capped at INFINITE_RANK
+   */
+  uint16_t GetAdvertisedRank (uint32_t interface) const;
+
+  /**
+   * \brief Get the number of interfaces RPL is running on.
+   * \return the number of interfaces with an RPL socket
+   */
+  uint32_t GetNRplInterfaces () const;
+
+  /**
+   * \brief Get the neighbor set of this node.
+   * \return the neighbor set, with its eviction and churn counters
+   */
+  const RplNeighborSet & GetNeighborSet () const;
+
+  /**
+   * \brief Get the routing table of this node.
+   * \return the routing table, to print or dump its routes
+   */
+  const RplRoutingTable & GetRoutingTable () const;
+
+  /**
+   * \brief Get the packets forwarded by this node.
+   *
+   * Recorded only when the PathStatsSize attribute is not 0.
+   * \return the path statistics ring buffer
+   */
+  const RplPathStats & GetPathStats () const;
+
+  /**
+   * \brief Get the residual energy of this node.
+   *
+   * Read through the residual energy callback. A node without one is
+   * taken as mains-powered.
+   * \return the residual energy, in percent
+   */
+  uint8_t GetResidualEnergy () const;
+
+  /**
+   * \brief Set the source of the residual energy of this node.
+   *
+   * The scenario wires the callback to the energy model of the node, for
+   * example the lowest GetEnergyFraction of its energy sources.
+   * \param energy callback returning the fraction of energy left, from 0 to 1
+   */
+  void SetResidualEnergyCallback (Callback<double> energy);
+
+  /**
+   * \brief Set the wake schedule of the radio.
+   *
+   * With the WakeAlignment attribute, Trickle DIOs are sent in the wake
+   * windows. Without a schedule set, one aggregated to the node is used.
+   * \param schedule the wake schedule, 0 for an always-on radio
+   */
+  void SetWakeSchedule (Ptr<RplWakeSchedule> schedule);
+
+  /**
+   * \brief Get the Trickle DIOs sent while the radio was asleep.
+   * \return the number of extra wakeups caused by DIOs
+   */
+  uint32_t GetNDioWakeups () const;
+
+  /**
+   * \brief Get the number of downward routes in the routing table.
+   * \return the number of downward routes, after aggregation
+   */
+  uint32_t GetNDownwardRoutes () const;
+
+  /**
+   * \brief Get the number of routes in the routing table.
+   * \return the number of routes, the default route included
+   */
+  uint32_t GetNRoutes () const;
+
+  /**
+   * \brief Check if the DODAG of this node matches the predicates of a DIS.
+   * \param solicitedInformation Solicited Information option of the DIS
+   * \return true if every predicate set in the option holds
+   */
+  bool IsSolicited (const RplSolicitedInformationOption &solicitedInformation) const;
+
   /**
    * \brief DIS receive
+   *
+   * Leaves and nodes outside the solicited DODAG stay silent. A multicast
+   * DIS resets the Trickle timer and a unicast one is answered by a unicast
+   * DIO, as long as the interface has response tokens left; otherwise the
+   * DIS is answered by a single multicast DIO once a token is available,
+   * along with any other DIS received meanwhile.
    * \param disMessage Received DIS message
    * \param solicitedInformation Solicited Information option
    * \param senderAddress sender adress
    * \param senderPort sender port
    * \param incomingInterface incoming interface
+   * \param multicast true if the DIS was sent to all RPL nodes
    */
-  void RecvDis (RplDisMessage disMessage, RplSolicitedInformationOption solicitedInformation, Ipv6Address senderAddress, uint32_t incomingInterface, uint16_t senderPort);
+  void RecvDis (RplDisMessage disMessage, RplSolicitedInformationOption solicitedInformation, Ipv6Address senderAddress, uint32_t incomingInterface, uint16_t senderPort, bool multicast = true);
 
   /**
    * \brief DIO receive
    * \param dioMessage Received DIO message
    * \param dodagConfiguration DODAG configuration option
+   * \param metricContainer DAG Metric Container option (may be empty)
+   * \param senderAddress sender adress
+   * \param incomingInterface incoming interface
+   */
+  void RecvDio (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, RplMetricContainerOption metricContainer, Ipv6Address senderAddress, uint32_t incomingInterface);
+
+  /**
+   * \brief DAO receive
+   * \param daoMessage Received DAO message
+   * \param targets Target options, in order
+   * \param transits Transit Information option that applies to each target
+   * \param senderAddress sender adress
+   * \param incomingInterface incoming interface
+   */
+  void RecvDao (RplDaoMessage daoMessage, const std::vector<RplTargetOption> &targets,
+                const std::vector<RplTransitInformationOption> &transits, Ipv6Address senderAddress,
+                uint32_t incomingInterface);
+
+  /**
+   * \brief Start a point-to-point route discovery towards a target (RFC 6997).
+   *
+   * A temporary DODAG rooted at this node is flooded, no deeper than the
+   * P2pMaxRank attribute, until it reaches the target. The target answers
+   * with a DRO sent back along the route found, which installs a
+   * hop-by-hop route to the target on every router of the route and on
+   * this node, so that the traffic to the target no longer goes through
+   * the DODAG root.
+   * \param target global address of the target
+   * \return false if this node has no global address to root the temporary DODAG with
+   */
+  bool DiscoverRoute (Ipv6Address target);
+
+  /**
+   * \brief Subscribe this node to a multicast group.
+   *
+   * In a DODAG in storing mode with multicast (MOP 3) the group is
+   * announced as a DAO target, so that the routers above forward the
+   * packets of the group into this sub-DODAG. The packets are delivered
+   * to the applications that joined the group on their socket.
+   * \param group the multicast group, wider than link-local scope
+   */
+  void JoinGroup (Ipv6Address group);
+
+  /**
+   * \brief Unsubscribe this node from a multicast group.
+   *
+   * The group is withdrawn with a No-Path DAO, unless a child still
+   * announces it.
+   * \param group the multicast group
+   */
+  void LeaveGroup (Ipv6Address group);
+
+  /**
+   * \brief Check if this node subscribed to a multicast group.
+   * \param group the multicast group
+   * \return true if JoinGroup was called for the group
+   */
+  bool IsGroupMember (Ipv6Address group) const;
+
+  /**
+   * \brief DIO of a temporary DODAG receive
+   *
+   * The target answers the first DIO with a DRO; a router joins the
+   * temporary DODAG, or moves up in it, and forwards the DIO with its own
+   * address appended to the route.
+   * \param dioMessage Received DIO message
+   * \param routeDiscovery P2P Route Discovery option
+   * \param senderAddress sender adress
+   * \param incomingInterface incoming interface
+   */
+  void RecvP2pDio (RplDioMessage dioMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address senderAddress,
+                   uint32_t incomingInterface);
+
+  /**
+   * \brief DRO receive
+   *
+   * The router the DRO is addressed to installs a route to the target
+   * through the sender and passes the DRO on towards the origin.
+   * \param droMessage Received DRO message
+   * \param routeDiscovery P2P Route Discovery option, holding the route
    * \param senderAddress sender adress
    * \param incomingInterface incoming interface
    */
-  void RecvDio (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, Ipv6Address senderAddress, uint32_t incomingInterface);
+  void RecvDro (RplDroMessage droMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address senderAddress,
+                uint32_t incomingInterface);
+
+  /**
+   * \brief Merge sibling target prefixes with the same path lifetime.
+   *
+   * Two prefixes of the same length that differ only in their last bit are
+   * replaced by their common prefix, repeatedly, so that a contiguous block
+   * of targets is announced as a single prefix. The newest path sequence of
+   * the merged targets is kept.
+   * \param targets the targets, rewritten in place
+   * \return the number of merges
+   */
+  static uint32_t AggregateDaoTargets (RplDaoTargets &targets);
+
+  /**
+   * \brief Start a global repair of the DODAG rooted at this node.
+   *
+   * The version number is incremented, so that every node joins the new
+   * version afresh, and the DTSN with it so that downward routes are
+   * announced again.
+   */
+  void GlobalRepair ();
+
+  /**
+   * \brief Compare two DODAG version numbers (RFC 6550 7.2).
+   * \param a a version number
+   * \param b another version number
+   * \return true if a is newer than b
+   */
+  static bool IsNewerVersion (uint8_t a, uint8_t b);
+
+  /**
+   * \brief Get the version number following another one.
+   *
+   * Version numbers form a lollipop counter in which 0 is skipped, as it
+   * marks a node that has not joined a DODAG.
+   * \param version the version number
+   * \return the next version number
+   */
+  static uint8_t NextVersion (uint8_t version);
 
   /*
-   * \brief Send Multicast DIS messages
+   * \brief Send Multicast DIS messages, and schedule the next one
    */
   void SendMulticastDis ();
 
@@ -129,6 +612,11 @@ public:
    */
   void SendDio (Ipv6Address destAddress, uint32_t incomingInterface, uint16_t senderPort);
 
+  /**
+   * \brief Send a multicast DIO on every RPL interface, each with its own advertised rank.
+   */
+  void SendMulticastDio ();
+
 
   /*
    * \brief Insert to neighborSet
@@ -136,14 +624,9 @@ public:
    * \param dodagID DODAg ID
    * \param dtsn DTSN
    * \param rank rank
+   * \param rootLoad root load advertised by the neighbor
    */
-  void InsertNeighbor (Ipv6Address neighborAddress, Ipv6Address dodagID, uint8_t dtsn, uint16_t rank, uint32_t incomingInterface);
-
-  /*
-   * \brief Insert to neighborSet
-   * \param neighborType neighbor type
-   */
-  void InsertNeighbor (neighborType type);
+  void InsertNeighbor (Ipv6Address neighborAddress, Ipv6Address dodagID, uint8_t dtsn, uint16_t rank, uint32_t incomingInterface, uint8_t rootLoad = 0);
 
   /**
    * \brief Resets the timer
@@ -165,6 +648,11 @@ public:
    */
   void TrickleTransmit ();
 
+  /**
+   * \brief Doubles the interval at the end of the current one
+   */
+  void IntervalExpired ();
+
   virtual void NotifyInterfaceUp (uint32_t interface);
   virtual void NotifyInterfaceDown (uint32_t interface);
   virtual void NotifyAddAddress (uint32_t interface, Ipv6InterfaceAddress address);
@@ -177,86 +665,914 @@ public:
 private:
 
   /**
-   * \brief the Rng stream
+   * \brief Start a DODAG as its root.
    */
-  Ptr<UniformRandomVariable> m_rng;
-  
-  /// Socket list type
-  typedef std::map< Ptr<Socket>, uint32_t> SocketList;
-  /// Socket list type iterator
-  typedef std::map<Ptr<Socket>, uint32_t>::iterator SocketListI;
-  /// Socket list type const iterator
-  typedef std::map<Ptr<Socket>, uint32_t>::const_iterator SocketListCI;
+  void BecomeRoot ();
 
   /**
-   * \brief socket list
+   * \brief Check if the DODAG advertised in a DIO is better than the current one.
+   * \param dioMessage Received DIO message
+   * \param senderAddress sender adress
+   * \return true if the node should move to the advertised DODAG
    */
-  SocketList m_sendSocketList;
+  bool IsPreferredDodag (RplDioMessage dioMessage, Ipv6Address senderAddress);
 
-  /*
-   * \brief receive socket
+  /**
+   * \brief Join the DODAG advertised in a DIO through its sender.
+   * \param dioMessage Received DIO message
+   * \param dodagConfiguration DODAG configuration option
+   * \param senderAddress sender adress
+   * \param incomingInterface incoming interface
    */
-  Ptr<Socket> m_recvSocket;
+  void JoinDodag (RplDioMessage dioMessage, RplDodagConfigurationOption dodagConfiguration, Ipv6Address senderAddress, uint32_t incomingInterface);
 
-  /*
-   * \brief Routing Table
+  /**
+   * \brief Select the preferred parent in the current DODAG and update the rank.
    */
-  RplRoutingTable m_routingTable;
+  void UpdatePreferredParent ();
 
-  /*
-   * \brief Neighbor Set
+  /**
+   * \brief Make a neighbor the preferred parent and derive the rank from it.
+   * \param parent the new preferred parent
    */
-  RplNeighborSet m_neighborSet;
+  void SwitchParent (Ptr<Neighbor> parent);
 
   /**
-   * \brief the redundancy constant
+   * \brief Send the multicast DIO answering the DISs coalesced on an interface.
+   * \param interface the interface
    */
-  uint8_t m_k;
+  void SendCoalescedDio (uint32_t interface);
 
   /**
-   * \brief the maximum interval size
+   * \brief Leave the DODAG after losing every parent, poisoning the sub-DODAG.
    */
-  Time m_iMax;
+  void Detach ();
 
   /**
-   * \brief the minimum interval size
+   * \brief Look for a parent once the poison had time to reach the sub-DODAG.
    */
-  Time m_iMin;
+  void LocalRepair ();
 
   /**
-   * \brief the counter
+   * \brief Become the root of a floating DODAG for the sub-DODAG.
    */
-  uint8_t m_counter; //not sure sa size
+  void BecomeFloatingRoot ();
 
   /**
-   * \brief the current interval size
+   * \brief End the detached state after finding a parent or a DODAG.
    */
-  Time m_interval;
+  void Reattach ();
 
   /**
-   * \brief the callback time
+   * \brief Get the first global address of this node.
+   * \return the address, or "::" if there is none
    */
-  Time m_t; //not sure sa size
+  Ipv6Address GetGlobalAddress ();
 
   /**
-   * \brief DIO schedule event
+   * \brief Find a neighbor by its link-layer address.
+   *
+   * Addresses not recorded yet are learnt from the neighbor caches of the
+   * interfaces, then from the interface identifier of the link-local
+   * address for neighbors heard only through multicast.
+   * \param address link-layer address of the neighbor
+   * \return the neighbor, or 0 if unknown
    */
-  EventId m_dioSchedule;
+  Ptr<Neighbor> FindNeighborByMac (const Address &address);
 
   /**
-   * \brief Restart interval value
+   * \brief Sample the occupancy of the traffic control queue discs of all devices.
    */
-  EventId m_restartInterval;
+  void SampleQueue ();
 
   /**
-   * \brief DIO receive marker for Join ()
+   * \brief Get the occupancy of a queue disc.
+   * \param queue the queue disc
+   * \return the occupancy, 0 (empty) to 255 (full), 0 if the queue disc is unbounded
    */
-  uint8_t m_dioReceived;
+  double GetQueueOccupancy (Ptr<QueueDisc> queue) const;
 
   /**
-   * \brief DIS schedule event
+   * \brief Get the queue occupancy advertised in DIOs.
+   * \return the highest of the local occupancy and the preferred parent's, 0 to 255
    */
-  EventId m_multicastDis;
+  uint8_t GetPathQueueLoad ();
+
+  /**
+   * \brief Sample the residual energy, announcing a drop along the path.
+   */
+  void SampleEnergy ();
+
+  /**
+   * \brief Get the path residual energy advertised in DIOs.
+   * \return the lowest of the local energy and the preferred parent's, in percent
+   */
+  uint8_t GetPathEnergy ();
+
+  /**
+   * \brief Cost of a parent for the congestion or energy aware selection.
+   * \param parent the parent
+   * \return the cost, in rank units
+   */
+  uint32_t GetParentCost (Ptr<Neighbor> parent) const;
+
+  /**
+   * \brief Hash the flow a packet belongs to.
+   *
+   * Uses the flow label when set, otherwise the addresses, the next header
+   * and, when the packet starts with a TCP or UDP header, the ports.
+   * \param header IPv6 header of the packet
+   * \param p the packet, may be 0
+   * \return the flow hash
+   */
+  uint32_t FlowHash (const Ipv6Header &header, Ptr<const Packet> p) const;
+
+  /**
+   * \brief Record a forwarded packet in the path statistics.
+   * \param header IPv6 header of the packet
+   * \param p the packet
+   */
+  void RecordPath (const Ipv6Header &header, Ptr<const Packet> p);
+
+  /**
+   * \brief Pick the next hop of an upward route among equal-rank parents.
+   * \param route the route through the preferred parent
+   * \param header IPv6 header of the packet
+   * \param p the packet, may be 0
+   * \return the route to use
+   */
+  Ptr<Ipv6Route> SelectUpwardRoute (Ptr<Ipv6Route> route, const Ipv6Header &header, Ptr<const Packet> p);
+
+  /**
+   * \brief Probe stale candidate parents and expire unresponsive ones.
+   */
+  void NudCheck ();
+
+  /**
+   * \brief Hand over to another parent when the link to the parent degrades.
+   */
+  void MobilityCheck ();
+
+  /**
+   * \brief Switch to the best parent whose link is not degrading.
+   * \param solicit send a unicast DIS to the candidate if it was not heard recently
+   * \return true if the parent was switched
+   */
+  bool Handover (bool solicit);
+
+  /**
+   * \brief Send a unicast DIS.
+   * \param destAddress the neighbor to solicit
+   * \param interface outgoing interface
+   */
+  void SendUnicastDis (Ipv6Address destAddress, uint32_t interface);
+
+  /**
+   * \brief Send the DIO of a temporary DODAG on every RPL interface.
+   * \param dodag the local RPL Instance ID and the origin of the temporary DODAG
+   */
+  void SendP2pDio (std::pair<uint8_t, Ipv6Address> dodag);
+
+  /**
+   * \brief Send a DRO to the previous router of a route.
+   * \param droMessage the DRO message
+   * \param routeDiscovery the P2P Route Discovery option holding the route
+   * \param neighbor link-local address of the router
+   * \param interface interface towards the router
+   */
+  void SendDro (RplDroMessage droMessage, RplP2pRouteDiscoveryOption routeDiscovery, Ipv6Address neighbor,
+                uint32_t interface);
+
+  /**
+   * \brief Leave a temporary DODAG.
+   * \param dodag the local RPL Instance ID and the origin of the temporary DODAG
+   */
+  void LeaveP2pDodag (std::pair<uint8_t, Ipv6Address> dodag);
+
+  /**
+   * \brief Check if the DODAG stores downward routes (MOP 2 or 3).
+   * \return true in storing mode, with or without multicast
+   */
+  bool IsStoring () const;
+
+  /**
+   * \brief Route a multicast packet sent by this node.
+   *
+   * In storing mode with multicast the packet is looped back into
+   * RouteInput, which sends a copy to every neighbor given by
+   * GetMulticastNextHops. Otherwise it is sent to every neighbor, to be
+   * flooded.
+   * \param p the packet
+   * \param header the IPv6 header of the packet
+   * \param oif the output interface asked for, if any
+   * \param sockerr the error, if no route is returned
+   * \return the route, or 0 if the packet has nowhere to go
+   */
+  Ptr<Ipv6Route> RouteMulticastOutput (Ptr<Packet> p, const Ipv6Header &header, Ptr<NetDevice> oif,
+                                       Socket::SocketErrno &sockerr);
+
+  /**
+   * \brief Get the neighbors a multicast packet is passed on to, in storing mode with multicast.
+   *
+   * The packet goes down to every child subscribed to the group, except
+   * towards the sub-DODAG it came from, and up to the parent unless it
+   * came from there. A packet whose source is not in the sub-DODAG of this
+   * node came from the parent.
+   * \param group the multicast group
+   * \param source the source of the packet
+   * \return the link-local address and interface of each neighbor
+   */
+  std::vector<std::pair<Ipv6Address, uint32_t> > GetMulticastNextHops (Ipv6Address group, Ipv6Address source);
+
+  /**
+   * \brief Check a multicast packet against the recently forwarded ones, and remember it.
+   * \param packet the packet
+   * \return true if the packet was already sent or forwarded by this node
+   */
+  bool IsMulticastDuplicate (Ptr<const Packet> packet);
+
+  /**
+   * \brief Build a DIO packet advertising the current DODAG.
+   * \param interface the interface the DIO is sent on
+   * \return the DIO packet, ICMPv6 header included
+   */
+  Ptr<Packet> BuildDio (uint32_t interface);
+
+  /**
+   * \brief Open the RPL send socket of an interface.
+   * \param interface the interface index
+   * \param address the link-local address the socket is bound to
+   */
+  void OpenSocket (uint32_t interface, Ipv6Address address);
+
+  /**
+   * \brief Close the RPL send socket of an interface, if any.
+   * \param interface the interface index
+   */
+  void CloseSocket (uint32_t interface);
+
+  /**
+   * \brief Get the RPL send socket of an interface.
+   * \param interface the interface index
+   * \return the socket, or null if RPL is not running on the interface
+   */
+  Ptr<Socket> GetSocket (uint32_t interface) const;
+
+  /**
+   * \brief Announce the own addresses and the downward routes to the preferred parent.
+   */
+  void AnnounceDaoTargets ();
+
+  /**
+   * \brief Queue a target for the next DAO to the preferred parent.
+   *
+   * A pending target is superseded by a newer announcement or No-Path for
+   * the same prefix; an announcement that the parent never received is
+   * cancelled by a No-Path instead of being followed by it.
+   * \param target the target prefix
+   * \param prefixLength length of the target prefix
+   * \param pathSequence the path sequence
+   * \param pathLifetime the path lifetime, 0 for a No-Path
+   */
+  void EnqueueDaoTarget (Ipv6Address target, uint8_t prefixLength, uint8_t pathSequence, uint8_t pathLifetime);
+
+  /**
+   * \brief Send the pending targets to the preferred parent.
+   */
+  void FlushDao ();
+
+  /**
+   * \brief Aggregate the downward routes, and schedule the next pass.
+   */
+  void AggregateRoutes ();
+
+  /**
+   * \brief Send targets to a parent, in as few DAOs as the link MTU allows.
+   * \param targets the targets
+   * \param parent link-local address of the parent
+   * \param interface interface towards the parent
+   */
+  void SendDao (const RplDaoTargets &targets, Ipv6Address parent, uint32_t interface);
+
+  /**
+   * \brief Add the DAO headers to Target and Transit options and send them.
+   * \param options the options, in order
+   * \param targets number of Target options
+   * \param parent link-local address of the parent
+   * \param socket socket bound to the interface towards the parent
+   */
+  void TransmitDao (Ptr<Packet> options, uint32_t targets, Ipv6Address parent, Ptr<Socket> socket);
+
+  /**
+   * \brief Check if the preferred parent was sent a prefix covering a target.
+   * \param target the target key
+   * \return true if the target was announced
+   */
+  bool IsDaoAnnounced (const std::pair<Ipv6Address, uint8_t> &target) const;
+
+  /**
+   * \brief Count the packets delivered to a DODAG root.
+   * \param header IPv6 header of the packet
+   * \param packet the packet
+   * \param interface incoming interface
+   */
+  void RootLocalDeliver (const Ipv6Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+  /**
+   * \brief Recompute the root load from the delivered packet rate.
+   */
+  void UpdateRootLoad ();
+
+  /**
+   * \brief Get the highest path latency a parent may advertise.
+   * \return the bound, in microseconds, left by the DODAG latency constraint
+   */
+  uint32_t GetMaxParentLatency () const;
+
+  /**
+   * \brief true if this node is a DODAG root
+   */
+  bool m_isRoot;
+
+  /**
+   * \brief true if this node is a leaf
+   */
+  bool m_leaf;
+
+  /**
+   * \brief the DODAG ID advertised when root (zero: first global address)
+   */
+  Ipv6Address m_rootDodagId;
+
+  /**
+   * \brief true if the DODAG rooted here is grounded
+   */
+  bool m_grounded;
+
+  /**
+   * \brief true if DODAG selection takes the root load into account
+   */
+  bool m_loadBalancing;
+
+  /**
+   * \brief rank units added to a neighbor at full root load
+   */
+  uint16_t m_loadWeight;
+
+  /**
+   * \brief rank units another DODAG must win by before switching
+   */
+  uint16_t m_loadHysteresis;
+
+  /**
+   * \brief packets per second a root delivers at full load
+   */
+  double m_rootCapacity;
+
+  /**
+   * \brief root load sampling period
+   */
+  Time m_loadUpdateInterval;
+
+  /**
+   * \brief packets delivered to the root in the current sampling period
+   */
+  uint32_t m_rootRxCount;
+
+  /**
+   * \brief smoothed packet rate delivered to the root
+   */
+  double m_rootRate;
+
+  /**
+   * \brief root load update event
+   */
+  EventId m_loadUpdate;
+
+  /**
+   * \brief true if DIOs carry hop count, latency and ETX path metrics
+   */
+  bool m_pathMetrics;
+
+  /**
+   * \brief estimated latency of a link
+   */
+  Time m_hopLatency;
+
+  /**
+   * \brief latency constraint advertised by a root (zero: unconstrained)
+   */
+  Time m_maxPathLatency;
+
+  /**
+   * \brief maximum number of parents kept in the parent set
+   */
+  uint32_t m_parentSetSize;
+
+  /**
+   * \brief true while routing through a backup parent not yet confirmed by a DIO
+   */
+  bool m_rerouted;
+
+  /**
+   * \brief true from the loss of the preferred parent until a new one is in use
+   */
+  bool m_parentLost;
+
+  /**
+   * \brief time the preferred parent was lost
+   */
+  Time m_parentLossTime;
+
+  /**
+   * \brief trace fired when the node switches to a new parent after a failure
+   */
+  TracedCallback<Ipv6Address, Ipv6Address, Time> m_rerouteTrace;
+
+  /**
+   * \brief detect degrading parent links and hand over before they break
+   */
+  bool m_mobilityMode;
+
+  /**
+   * \brief period of the parent link check
+   */
+  Time m_mobilityCheckInterval;
+
+  /**
+   * \brief lowest usable RSSI, in dBm
+   */
+  double m_handoverRssi;
+
+  /**
+   * \brief highest usable ETX, ETX * 128
+   */
+  uint16_t m_handoverEtx;
+
+  /**
+   * \brief how far ahead the RSSI trend is extrapolated
+   */
+  Time m_handoverHorizon;
+
+  /**
+   * \brief the link to the parent is degrading and no other parent was found yet
+   */
+  bool m_handoverPending;
+
+  /**
+   * \brief time the degradation was detected
+   */
+  Time m_handoverStart;
+
+  /**
+   * \brief parent link check event
+   */
+  EventId m_mobilityCheck;
+
+  /**
+   * \brief trace fired when the node switches parent before the link to the old one breaks
+   */
+  TracedCallback<Ipv6Address, Ipv6Address, Time> m_handoverTrace;
+
+  /**
+   * \brief highest DAGRank of a router in a temporary DODAG
+   */
+  uint8_t m_p2pMaxRank;
+
+  /**
+   * \brief lifetime of a temporary DODAG, as the L field of the P2P-RDO
+   */
+  uint8_t m_p2pDodagLifetime;
+
+  /**
+   * \brief lifetime of a point-to-point route
+   */
+  Time m_p2pRouteLifetime;
+
+  /**
+   * \brief counter of the local RPL Instance IDs of the discoveries started here
+   */
+  uint8_t m_p2pInstance;
+
+  /**
+   * \brief the temporary DODAGs this node is in
+   */
+  RplP2pDodags m_p2pDodags;
+
+  /**
+   * \brief trace fired when a route discovery started here finds a route
+   */
+  TracedCallback<Ipv6Address, uint32_t, Time> m_p2pRouteTrace;
+
+  /**
+   * \brief advertise storing mode with multicast when root
+   */
+  bool m_multicast;
+
+  /**
+   * \brief the multicast groups this node subscribed to
+   */
+  std::set<Ipv6Address> m_groups;
+
+  /**
+   * \brief the multicast packets recently sent or forwarded, oldest first
+   */
+  std::deque<uint64_t> m_multicastSeen;
+
+  /**
+   * \brief trace fired for each transmission of a multicast data packet
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address, Ipv6Address> m_multicastTxTrace;
+
+  /**
+   * \brief trace fired for each packet routed through an unconfirmed backup parent
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address> m_packetSavedTrace;
+
+  /**
+   * \brief take the path queue occupancy into account when choosing a parent
+   */
+  bool m_congestionAware;
+
+  /**
+   * \brief rank units added to a parent whose path is fully congested
+   */
+  uint16_t m_congestionWeight;
+
+  /**
+   * \brief cost units a parent must be better by before switching to it
+   */
+  uint16_t m_congestionHysteresis;
+
+  /**
+   * \brief period of the queue occupancy sampling
+   */
+  Time m_queueSampleInterval;
+
+  /**
+   * \brief smoothed local queue occupancy, 0 to 255
+   */
+  double m_queueLoad;
+
+  /**
+   * \brief queue occupancy sampling event
+   */
+  EventId m_queueSample;
+
+  /**
+   * \brief take the residual energy of the path into account when choosing a parent
+   */
+  bool m_energyAware;
+
+  /**
+   * \brief rank units added to a parent whose path energy is exhausted
+   */
+  uint16_t m_energyWeight;
+
+  /**
+   * \brief cost units a parent must be better by before switching to it
+   */
+  uint16_t m_energyHysteresis;
+
+  /**
+   * \brief period of the residual energy sampling
+   */
+  Time m_energySampleInterval;
+
+  /**
+   * \brief path energy advertised in the last DIO, in percent
+   */
+  uint8_t m_advertisedEnergy;
+
+  /**
+   * \brief residual energy sampling event
+   */
+  EventId m_energySample;
+
+  /**
+   * \brief residual energy of this node, as a fraction
+   */
+  Callback<double> m_residualEnergy;
+
+  /**
+   * \brief spread upward flows over equal-rank parents
+   */
+  bool m_multipath;
+
+  /**
+   * \brief trace fired for each packet routed towards the root
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address> m_upwardTrace;
+
+  /**
+   * \brief records kept of the packets forwarded, 0 to keep none
+   */
+  uint32_t m_pathStatsSize;
+
+  /**
+   * \brief the packets forwarded, for per-flow path statistics
+   */
+  RplPathStats m_pathStats;
+
+  /**
+   * \brief number of changes of preferred parent, wrapping
+   */
+  uint16_t m_parentSwitches;
+
+  /**
+   * \brief consecutive losses after which a neighbor is unreachable
+   */
+  uint8_t m_maxTxFailures;
+
+  /**
+   * \brief time after which a silent candidate parent is probed
+   */
+  Time m_neighborFreshness;
+
+  /**
+   * \brief period of the NUD check
+   */
+  Time m_probeInterval;
+
+  /**
+   * \brief unanswered probes after which a neighbor is unreachable
+   */
+  uint8_t m_maxProbes;
+
+  /**
+   * \brief maximum number of probes sent per NUD check
+   */
+  uint32_t m_probesPerInterval;
+
+  /**
+   * \brief NUD check event
+   */
+  EventId m_nudTimer;
+
+  /**
+   * \brief maximum number of neighbors kept, 0 for unbounded
+   */
+  uint32_t m_neighborTableSize;
+
+  /**
+   * \brief eviction policy of a full neighbor table
+   */
+  RplEvictionPolicy m_evictionPolicy;
+
+  /**
+   * \brief advertise storing mode when root
+   */
+  bool m_downwardRoutes;
+
+  /**
+   * \brief time a DAO target is held to be merged with others
+   */
+  Time m_daoDelay;
+
+  /**
+   * \brief merge pending DAO targets into as few DAOs and prefixes as possible
+   */
+  bool m_daoAggregation;
+
+  /**
+   * \brief interval between two global repairs started by the root, zero to disable
+   */
+  Time m_globalRepairInterval;
+
+  /**
+   * \brief global repair event
+   */
+  EventId m_globalRepair;
+
+  /**
+   * \brief time a detached node waits for the poison to reach its sub-DODAG
+   */
+  Time m_localRepairDelay;
+
+  /**
+   * \brief local repair event
+   */
+  EventId m_localRepair;
+
+  /**
+   * \brief form a floating DODAG when no parent is found after detaching
+   */
+  bool m_floatingDodag;
+
+  /**
+   * \brief this node is the root of a floating DODAG
+   */
+  bool m_floating;
+
+  /**
+   * \brief this node advertises an infinite rank and has no parent
+   */
+  bool m_detached;
+
+  /**
+   * \brief trace fired when a repair starts
+   */
+  TracedCallback<bool, uint8_t> m_repairStartTrace;
+
+  /**
+   * \brief trace fired when a node is attached again after a repair
+   */
+  TracedCallback<bool, uint8_t> m_repairedTrace;
+
+  /**
+   * \brief trace fired for each RPL control message sent
+   */
+  TracedCallback<Ptr<const Packet>, uint8_t> m_controlTxTrace;
+
+  /**
+   * \brief interval between two downward route aggregation passes, zero to disable
+   */
+  Time m_routeAggregationInterval;
+
+  /**
+   * \brief downward route aggregation event
+   */
+  EventId m_routeAggregation;
+
+  /**
+   * \brief targets waiting for the next DAO
+   */
+  RplDaoTargets m_daoPending;
+
+  /**
+   * \brief prefixes announced to the preferred parent
+   */
+  std::set<std::pair<Ipv6Address, uint8_t> > m_daoAnnounced;
+
+  /**
+   * \brief DAO flush event
+   */
+  EventId m_daoTimer;
+
+  /**
+   * \brief the DAO sequence
+   */
+  uint8_t m_daoSequence;
+
+  /**
+   * \brief the path sequence of the own targets
+   */
+  uint8_t m_pathSequence;
+
+  /**
+   * \brief trace fired for each DAO sent
+   */
+  TracedCallback<Ptr<const Packet>, Ipv6Address, uint32_t> m_daoTxTrace;
+
+  /**
+   * \brief the Rng stream
+   */
+  Ptr<UniformRandomVariable> m_rng;
+
+  /**
+   * \brief wake schedule of the radio, 0 if always on
+   */
+  Ptr<RplWakeSchedule> m_wakeSchedule;
+
+  /**
+   * \brief send Trickle DIOs in the wake windows
+   */
+  bool m_wakeAlignment;
+
+  /**
+   * \brief Trickle DIOs sent while the radio was asleep
+   */
+  uint32_t m_dioWakeups;
+  
+  /**
+   * \brief the send sockets, indexed by interface (null: RPL not running on it)
+   */
+  std::vector<Ptr<Socket> > m_sendSockets;
+
+  /**
+   * \brief the rank cost of each interface, indexed by interface
+   */
+  std::vector<uint16_t> m_interfaceCosts;
+
+  /*
+   * \brief receive socket
+   */
+  Ptr<Socket> m_recvSocket;
+
+  /*
+   * \brief Routing Table
+   */
+  RplRoutingTable m_routingTable;
+
+  /*
+   * \brief Neighbor Set
+   */
+  RplNeighborSet m_neighborSet;
+
+  /**
+   * \brief the redundancy constant
+   */
+  uint8_t m_k;
+
+  /**
+   * \brief the maximum interval size
+   */
+  Time m_iMax;
+
+  /**
+   * \brief the minimum interval size
+   */
+  Time m_iMin;
+
+  /**
+   * \brief the counter
+   */
+  uint8_t m_counter; //not sure sa size
+
+  /**
+   * \brief the current interval size
+   */
+  Time m_interval;
+
+  /**
+   * \brief the callback time
+   */
+  Time m_t; //not sure sa size
+
+  /**
+   * \brief DIO schedule event
+   */
+  EventId m_dioSchedule;
+
+  /**
+   * \brief Restart interval value
+   */
+  EventId m_restartInterval;
+
+  /**
+   * \brief DIO receive marker for Join ()
+   */
+  uint8_t m_dioReceived;
+
+  /**
+   * \brief DIS schedule event
+   */
+  EventId m_multicastDis;
+
+  /**
+   * \brief maximum random delay before the first multicast DIS
+   */
+  Time m_disStartDelay;
+
+  /**
+   * \brief interval between the first two multicast DISs
+   */
+  Time m_disInterval;
+
+  /**
+   * \brief maximum interval between two multicast DISs
+   */
+  Time m_disMaxInterval;
+
+  /**
+   * \brief multicast DISs sent before giving up, 0 for no limit
+   */
+  uint32_t m_disMaxAttempts;
+
+  /**
+   * \brief current interval between two multicast DISs
+   */
+  Time m_disBackoff;
+
+  /**
+   * \brief multicast DISs sent since Join ()
+   */
+  uint32_t m_disAttempts;
+
+  /**
+   * \brief DIS responses allowed per second and interface, 0 for no limit
+   */
+  double m_disResponseRate;
+
+  /**
+   * \brief DIS responses allowed in a burst on an interface
+   */
+  uint32_t m_disResponseBurst;
+
+  /**
+   * \brief DIS response tokens, per interface
+   */
+  std::map<uint32_t, RplTokenBucket> m_disTokens;
+
+  /**
+   * \brief coalesced DIS responses, per interface
+   */
+  std::map<uint32_t, EventId> m_coalescedDio;
+
+  /**
+   * \brief trace fired for each DIS received
+   */
+  TracedCallback<Ipv6Address, bool, bool> m_disRxTrace;
 
 protected:
   /**
@@ -7,6 +7,7 @@
 #include "ns3/rpl-routing-table.h"
 #include "ns3/rpl-neighbor.h"
 #include "ns3/rpl-neighborset.h"
+#include "ns3/rpl-path-stats.h"
 #include "ns3/csma-module.h"
 
 // An essential include is test.h
@@ -17,6 +18,7 @@
 #include "ns3/simple-channel.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/drop-tail-queue.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/socket.h"
 #include "ns3/boolean.h"
 #include "ns3/enum.h"
@@ -39,9 +41,13 @@
 #include "ns3/ipv6.h"
 
 #include <stdint.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <limits>
+#include <vector>
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -123,6 +129,18 @@ struct DioHeaderTest : public TestCase
     RplDioMessage dio2;
     p->RemoveHeader (dio2);
     NS_TEST_EXPECT_MSG_EQ (dio2.GetCode (), 1, "RPL DIO Header Code");
+
+    RplDioMessage dio3;
+    dio3.SetFlagG (true);
+    dio3.SetMop (2);
+    dio3.SetDodagId ("2001:1::200:ff:fe00:1");
+    p = Create<Packet> ();
+    p->AddHeader (dio3);
+    RplDioMessage dio4;
+    p->RemoveHeader (dio4);
+    NS_TEST_EXPECT_MSG_EQ (dio4.GetFlagG (), true, "RPL DIO Grounded Flag");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)dio4.GetMop (), 2, "RPL DIO MOP");
+    NS_TEST_EXPECT_MSG_EQ (dio4.GetDodagId (), Ipv6Address ("2001:1::200:ff:fe00:1"), "RPL DIO DODAG ID");
   }
 };
 
@@ -164,6 +182,33 @@ struct DaoHeaderTest : public TestCase
   }
 };
 
+struct DroHeaderTest : public TestCase
+{
+  DroHeaderTest () : TestCase ("RPL Dro Header Tests")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplDroMessage dro;
+    NS_TEST_EXPECT_MSG_EQ (dro.GetCode (), 4, "RPL DRO Header Code");
+    dro.SetFlagS (true);
+    dro.SetSequence (2);
+    dro.SetRplInstanceId (0x81);
+    dro.SetDodagId ("2001:1::2");
+    NS_TEST_EXPECT_MSG_EQ (dro.GetSerializedSize (), 22, "Serialized Size");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (dro);
+    RplDroMessage dro2;
+    p->RemoveHeader (dro2);
+    NS_TEST_EXPECT_MSG_EQ (dro2.GetFlagS (), true, "Stop flag");
+    NS_TEST_EXPECT_MSG_EQ (dro2.GetFlagA (), false, "Ack flag");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)dro2.GetSequence (), 2, "Sequence");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)dro2.GetRplInstanceId (), 0x81, "Local instance");
+    NS_TEST_EXPECT_MSG_EQ (dro2.GetDodagId (), "2001:1::2", "Origin");
+  }
+};
+
 struct RplDodagConfigurationOptionTest : public TestCase
 {
   RplDodagConfigurationOptionTest () : TestCase ("Rpl Dodag Configuration Option Tests") 
@@ -201,6 +246,163 @@ struct RplSolicitedInformationOptionTest : public TestCase
   }
 };
 
+struct RplP2pRouteDiscoveryOptionTest : public TestCase
+{
+  RplP2pRouteDiscoveryOptionTest () : TestCase ("Rpl P2P Route Discovery Option Tests")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplP2pRouteDiscoveryOption h;
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h.GetLength (), 18, "Option Length");
+    h.SetFlagR (true);
+    h.SetLifetime (2);
+    h.SetMaxRank (8);
+    h.SetTarget ("2001:1::9");
+    NS_TEST_EXPECT_MSG_EQ (h.GetLifetimeDuration (), Seconds (16), "Lifetime of the temporary DODAG");
+    NS_TEST_EXPECT_MSG_EQ (h.AddAddress ("2001:1::3"), true, "Address added");
+    NS_TEST_EXPECT_MSG_EQ (h.AddAddress ("2001:1::4"), true, "Address added");
+    NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 20 + 2 * 16, "Serialized Size");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    RplP2pRouteDiscoveryOption h2;
+    p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h2.GetType (), 10, "Option Type Test");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetFlagR (), true, "Reply flag");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetFlagH (), true, "Hop-by-hop route");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h2.GetMaxRank (), 8, "Max rank");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetTarget (), "2001:1::9", "Target");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetAddresses ().size (), 2, "Address vector");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetAddresses ()[1], "2001:1::4", "Address order");
+
+    // the address vector is bounded by the option length
+    for (uint32_t i = 2; i < 14; i++)
+      {
+        h2.AddAddress ("2001:1::5");
+      }
+    NS_TEST_EXPECT_MSG_EQ (h2.AddAddress ("2001:1::6"), false, "Address vector full");
+  }
+};
+
+struct RplMetricContainerOptionTest : public TestCase
+{
+  RplMetricContainerOptionTest () : TestCase ("Rpl Metric Container Option Tests")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplMetricContainerOption h;
+    uint8_t load = 0;
+    NS_TEST_EXPECT_MSG_EQ (h.GetRootLoad (load), false, "No root load");
+
+    h.SetRootLoad (100);
+    h.SetRootLoad (200);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h.GetNMetricObjects (), 1, "Single NSA object");
+    NS_TEST_EXPECT_MSG_EQ (h.GetSerializedSize (), 2 + 4 + 2 + 3, "Serialized Size");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    RplMetricContainerOption h2;
+    p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (h2.GetType (), 2, "Option Type Test");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetRootLoad (load), true, "Root load present");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)load, 200, "Root load value");
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "Whole option consumed");
+  }
+};
+
+struct RplMetricObjectTest : public TestCase
+{
+  RplMetricObjectTest () : TestCase ("Rpl Metric Object Tests")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplMetricContainerOption h;
+
+    RplMetricObject hopCount;
+    hopCount.SetType (RPL_METRIC_HC);
+    hopCount.AddValue (3);
+    h.AddMetricObject (hopCount);
+
+    RplMetricObject latency;
+    latency.SetType (RPL_METRIC_LATENCY);
+    latency.SetFlagR (true);
+    latency.AddValue (1000);
+    latency.AddValue (2500);
+    h.AddMetricObject (latency);
+
+    RplMetricObject constraint;
+    constraint.SetType (RPL_METRIC_LATENCY);
+    constraint.SetFlagC (true);
+    constraint.AddValue (5000);
+    h.AddMetricObject (constraint);
+
+    RplMetricObject etx;
+    etx.SetType (RPL_METRIC_ETX);
+    etx.AddValue (384);
+    h.AddMetricObject (etx);
+
+    RplMetricObject lql;
+    lql.SetType (RPL_METRIC_LQL);
+    lql.SetFlagR (true);
+    lql.SetAggregation (RPL_AGGREGATION_MINIMUM);
+    lql.AddValue ((3 << 5) | 1);
+    lql.AddValue ((1 << 5) | 2);
+    h.AddMetricObject (lql);
+
+    RplMetricObject energy;
+    energy.SetType (RPL_METRIC_NE);
+    energy.SetAggregation (RPL_AGGREGATION_MINIMUM);
+    energy.SetPrecedence (2);
+    energy.AddValue (0x0180);
+    h.AddMetricObject (energy);
+
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h.GetNMetricObjects (), 6, "Metric and constraint of the same type");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (h);
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), h.GetSerializedSize (), "Serialized Size");
+    RplMetricContainerOption h2;
+    p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "Whole option consumed");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)h2.GetNMetricObjects (), 6, "Objects decoded");
+
+    uint32_t value = 0;
+    NS_TEST_EXPECT_MSG_EQ (h2.GetMetricValue (RPL_METRIC_HC, value), true, "Hop count present");
+    NS_TEST_EXPECT_MSG_EQ (value, 3, "Hop count");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetMetricValue (RPL_METRIC_LATENCY, value), true, "Latency present");
+    NS_TEST_EXPECT_MSG_EQ (value, 3500, "Recorded latency is summed");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetMetricValue (RPL_METRIC_ETX, value), true, "ETX present");
+    NS_TEST_EXPECT_MSG_EQ (value, 384, "ETX");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetMetricValue (RPL_METRIC_LQL, value), true, "LQL present");
+    NS_TEST_EXPECT_MSG_EQ (value, 1, "Worst link quality level");
+    NS_TEST_EXPECT_MSG_EQ (h2.GetMetricValue (RPL_METRIC_NE, value), true, "Energy present");
+    NS_TEST_EXPECT_MSG_EQ (value, 0x80, "Energy estimation");
+
+    RplMetricObject decoded;
+    NS_TEST_EXPECT_MSG_EQ (h2.FindMetricObject (RPL_METRIC_NE, decoded), true, "Energy object");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)decoded.GetPrecedence (), 2, "Precedence");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)decoded.GetAggregation (), RPL_AGGREGATION_MINIMUM, "Aggregation");
+    NS_TEST_EXPECT_MSG_EQ (decoded.GetValue (0), 0x0180, "Energy flags kept");
+    NS_TEST_EXPECT_MSG_EQ (h2.FindConstraint (RPL_METRIC_LATENCY, decoded), true, "Latency constraint");
+    NS_TEST_EXPECT_MSG_EQ (decoded.GetValue (0), 5000, "Latency bound");
+
+    // 3.5 ms advertised plus a 1 ms link fits a 5 ms bound, a 2 ms link does not
+    NS_TEST_EXPECT_MSG_EQ (RplObjectiveFunction::MeetsConstraints (h2, 1000), true, "Constraint met");
+    NS_TEST_EXPECT_MSG_EQ (RplObjectiveFunction::MeetsConstraints (h2, 2000), false, "Constraint violated");
+
+    RplObjectiveFunction::UpdateMetrics (h2, 1000, 128);
+    h2.GetMetricValue (RPL_METRIC_HC, value);
+    NS_TEST_EXPECT_MSG_EQ (value, 4, "Hop count updated");
+    h2.GetMetricValue (RPL_METRIC_LATENCY, value);
+    NS_TEST_EXPECT_MSG_EQ (value, 4500, "Latency recorded");
+    h2.GetMetricValue (RPL_METRIC_ETX, value);
+    NS_TEST_EXPECT_MSG_EQ (value, 512, "ETX updated");
+  }
+};
+
 struct RplObjectiveFunction0Test : public TestCase
 {
   RplObjectiveFunction0Test () : TestCase ("Objective Function 0 Test")
@@ -268,7 +470,11 @@ struct RplRoutingTableTest : public TestCase
     Ipv6Prefix destPrefix;
     NS_TEST_EXPECT_MSG_EQ (routingTable.AddNetworkRouteTo (daoSender, interface, nextHop, dest, destPrefix), true, "Add Network");
 
+    NS_TEST_EXPECT_MSG_EQ (routingTable.SetDodagParent ("fe80::200:ff:fe00:1", interface), true, "Set Dodag Parent");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDodagParent (), Ipv6Address ("fe80::200:ff:fe00:1"), "Dodag Parent");
+
     NS_TEST_EXPECT_MSG_EQ (routingTable.ClearRoutingTable (), true, "Clear Routing Table");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDodagParent (), Ipv6Address::GetZero (), "Dodag Parent cleared");
   }
 };
 
@@ -301,10 +507,1519 @@ struct RplNeighborSetTest : public TestCase
   }
   virtual void DoRun ()
   {
+    RplNeighborSet neighborSet;
 
+    Neighbor neighbor;
+    neighbor.SetNeighborAddress ("fe80::200:ff:fe00:2");
+    neighbor.SetDodagId ("2001:1::200:ff:fe00:1");
+    neighbor.SetRank (769);
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighborSet.AddNeighbor (neighbor);
+
+    neighbor.SetNeighborAddress ("fe80::200:ff:fe00:3");
+    neighbor.SetDodagId ("2001:1::200:ff:fe00:9");
+    neighbor.SetRank (1);
+    neighborSet.AddNeighbor (neighbor);
+
+    Ptr<Neighbor> parent = neighborSet.SelectParent ();
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:3"), "Lowest rank parent");
+
+    parent = neighborSet.SelectParent ("2001:1::200:ff:fe00:1");
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:2"), "Parent in DODAG");
+
+    parent = neighborSet.SelectParent ("2001:1::200:ff:fe00:5");
+    NS_TEST_EXPECT_MSG_EQ ((parent == 0), true, "No parent in unknown DODAG");
+
+    // a link-layer address is found once recorded, whatever the interface identifier
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetUnresolvedNeighbors ().size (), 2, "No link-layer address known");
+    neighborSet.FindNeighbor ("fe80::200:ff:fe00:3")->SetMacAddress (Mac48Address ("00:00:00:00:00:07"));
+    Ptr<Neighbor> known = neighborSet.FindNeighborByMac (Mac48Address ("00:00:00:00:00:07"));
+    NS_TEST_EXPECT_MSG_EQ ((known != 0), true, "Neighbor found by link-layer address");
+    NS_TEST_EXPECT_MSG_EQ (known->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:3"), "Recorded neighbor");
+    NS_TEST_EXPECT_MSG_EQ ((neighborSet.FindNeighborByMac (Mac48Address ("00:00:00:00:00:02")) == 0), true,
+                           "Unrecorded link-layer address");
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetUnresolvedNeighbors ().size (), 1, "One neighbor left to resolve");
   }
 };
 
+struct RplLoadBalancingTest : public TestCase
+{
+  RplLoadBalancingTest () : TestCase ("Rpl Load-Aware Parent Selection Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplNeighborSet neighborSet;
+
+    Neighbor neighbor;
+    neighbor.SetNeighborAddress ("fe80::200:ff:fe00:2");
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetRank (769);
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighbor.SetRootLoad (255);
+    neighborSet.AddNeighbor (neighbor);
+
+    neighbor.SetNeighborAddress ("fe80::200:ff:fe00:3");
+    neighbor.SetDodagId ("2001:1::2");
+    neighbor.SetRank (1025);
+    neighbor.SetRootLoad (0);
+    neighborSet.AddNeighbor (neighbor);
+
+    // 769 + 768 against 1025: the idle DODAG wins by 512
+    Ptr<Neighbor> parent = neighborSet.SelectParent ("2001:1::1", 768, 256);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:3"), "Switch to the idle DODAG");
+
+    // a 512 advantage does not clear a 600 hysteresis
+    parent = neighborSet.SelectParent ("2001:1::1", 768, 600);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:2"), "Hysteresis keeps the DODAG");
+
+    // without load weighting rank alone decides
+    parent = neighborSet.SelectParent ("2001:1::2", 0, 0);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:2"), "Lowest rank without load");
+
+    parent = neighborSet.SelectParent ("2001:1::3", 768, 256);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::200:ff:fe00:3"), "Leave an empty DODAG");
+  }
+};
+
+struct RplParentSetTest : public TestCase
+{
+  RplParentSetTest () : TestCase ("Rpl Parent Set Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplNeighborSet neighborSet;
+
+    Neighbor neighbor;
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+
+    const char *addresses[] = { "fe80::1", "fe80::2", "fe80::3", "fe80::4", "fe80::5" };
+    uint16_t ranks[] = { 1025, 769, 1793, 1281, 1537 };
+    for (uint32_t i = 0; i < 5; i++)
+      {
+        neighbor.SetNeighborAddress (addresses[i]);
+        neighbor.SetRank (ranks[i]);
+        neighborSet.AddNeighbor (neighbor);
+      }
+    neighbor.SetNeighborAddress ("fe80::6");
+    neighbor.SetDodagId ("2001:1::2");
+    neighbor.SetRank (1);
+    neighborSet.AddNeighbor (neighbor);
+
+    // own rank 1537: fe80::5 (equal rank) and fe80::3 (higher) are excluded
+    neighborSet.UpdateParentSet ("2001:1::1", 1537, 3);
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetNParents (), 3, "Parent set size");
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetParent (0)->GetNeighborAddress (), Ipv6Address ("fe80::2"), "Best parent first");
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetParent (2)->GetNeighborAddress (), Ipv6Address ("fe80::4"), "Ordered by rank");
+
+    neighborSet.UpdateParentSet ("2001:1::1", 1537, 2);
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetNParents (), 2, "Parent set bounded");
+
+    Ptr<Neighbor> next = neighborSet.NextParent ("fe80::2");
+    NS_TEST_EXPECT_MSG_EQ (next->GetNeighborAddress (), Ipv6Address ("fe80::1"), "Next viable parent");
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.FindNeighbor ("fe80::2")->GetReachable (), false, "Failed parent unreachable");
+
+    next = neighborSet.NextParent ("fe80::1");
+    NS_TEST_EXPECT_MSG_EQ ((next == 0), true, "Parent set exhausted");
+
+    neighborSet.SetInterfaceDown (1);
+    neighborSet.UpdateParentSet ("2001:1::1", 1537, 3);
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.GetNParents (), 0, "No parent behind a down interface");
+  }
+};
+
+struct RplNeighborEvictionTest : public TestCase
+{
+  RplNeighborEvictionTest () : TestCase ("Rpl Neighbor Eviction Test")
+  {
+  }
+  void Fill (RplNeighborSet &neighborSet)
+  {
+    Neighbor neighbor;
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+
+    const char *addresses[] = { "fe80::1", "fe80::2", "fe80::3" };
+    uint16_t ranks[] = { 769, 1281, 1025 };
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        neighbor.SetNeighborAddress (addresses[i]);
+        neighbor.SetRank (ranks[i]);
+        neighborSet.AddNeighbor (neighbor);
+      }
+  }
+  virtual void DoRun ()
+  {
+    Neighbor newcomer;
+    newcomer.SetNeighborAddress ("fe80::4");
+    newcomer.SetDodagId ("2001:1::1");
+    newcomer.SetRank (1537);
+    newcomer.SetReachable (true);
+
+    // upsert: the same address replaces its entry
+    RplNeighborSet lru;
+    lru.SetCapacity (3, RPL_EVICT_LRU);
+    Fill (lru);
+    Neighbor update;
+    update.SetNeighborAddress ("fe80::1");
+    update.SetRank (513);
+    update.SetReachable (true);
+    lru.AddNeighbor (update);
+    NS_TEST_EXPECT_MSG_EQ (lru.GetNNeighbors (), 3, "Upsert does not grow the set");
+    NS_TEST_EXPECT_MSG_EQ (lru.FindNeighbor ("fe80::1")->GetRank (), 513, "Upsert replaces");
+
+    // parent selection does not reorder the set
+    lru.SelectParent ("2001:1::1");
+    lru.UpdateParentSet ("2001:1::1", 1793, 3);
+    // fe80::1 was refreshed, fe80::2 is now the least recently heard
+    NS_TEST_EXPECT_MSG_EQ ((lru.AddNeighbor (newcomer) != 0), true, "LRU admits");
+    NS_TEST_EXPECT_MSG_EQ ((lru.FindNeighbor ("fe80::2") == 0), true, "LRU evicts the stalest");
+    NS_TEST_EXPECT_MSG_EQ (lru.GetNNeighbors (), 3, "Capacity kept");
+    NS_TEST_EXPECT_MSG_EQ (lru.GetEvictions (), 1, "One eviction");
+    NS_TEST_EXPECT_MSG_EQ (lru.GetChurn (), 5, "Four entries in, one out");
+
+    // a newcomer worse than every neighbor is rejected
+    RplNeighborSet worstRank;
+    worstRank.SetCapacity (3, RPL_EVICT_WORST_RANK);
+    Fill (worstRank);
+    NS_TEST_EXPECT_MSG_EQ ((worstRank.AddNeighbor (newcomer) == 0), true, "Worse newcomer rejected");
+    NS_TEST_EXPECT_MSG_EQ (worstRank.GetRejections (), 1, "One rejection");
+    newcomer.SetRank (513);
+    worstRank.AddNeighbor (newcomer);
+    NS_TEST_EXPECT_MSG_EQ ((worstRank.FindNeighbor ("fe80::2") == 0), true, "Worst rank evicted");
+
+    // unreachable neighbors go first whatever the policy
+    worstRank.FindNeighbor ("fe80::4")->SetReachable (false);
+    newcomer.SetNeighborAddress ("fe80::5");
+    newcomer.SetRank (1793);
+    worstRank.AddNeighbor (newcomer);
+    NS_TEST_EXPECT_MSG_EQ ((worstRank.FindNeighbor ("fe80::4") == 0), true, "Unreachable evicted first");
+
+    // parents are never evicted
+    RplNeighborSet pinned;
+    pinned.SetCapacity (3, RPL_EVICT_PIN_PARENTS);
+    Fill (pinned);
+    pinned.UpdateParentSet ("2001:1::1", 1281, 2);
+    newcomer.SetNeighborAddress ("fe80::6");
+    pinned.AddNeighbor (newcomer);
+    NS_TEST_EXPECT_MSG_EQ ((pinned.FindNeighbor ("fe80::2") == 0), true, "Non-parent evicted");
+    NS_TEST_EXPECT_MSG_EQ ((pinned.FindNeighbor ("fe80::1") != 0), true, "Parent pinned");
+
+    pinned.UpdateParentSet ("2001:1::1", 2049, 3);
+    newcomer.SetNeighborAddress ("fe80::7");
+    NS_TEST_EXPECT_MSG_EQ ((pinned.AddNeighbor (newcomer) == 0), true, "All pinned, newcomer rejected");
+  }
+};
+
+struct RplMultipathTest : public TestCase
+{
+  RplMultipathTest () : TestCase ("Rpl Multipath Parent Selection Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplNeighborSet neighborSet;
+
+    Neighbor neighbor;
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    const char *addresses[] = { "fe80::1", "fe80::2", "fe80::3" };
+    uint16_t ranks[] = { 769, 769, 1025 };
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        neighbor.SetNeighborAddress (addresses[i]);
+        neighbor.SetRank (ranks[i]);
+        neighbor.SetEtx (128);
+        neighborSet.AddNeighbor (neighbor);
+      }
+    neighborSet.UpdateParentSet ("2001:1::1", 1537, 3);
+
+    // equal ETX: an even split over the two rank 769 parents, never fe80::3
+    uint32_t count[3] = { 0, 0, 0 };
+    for (uint32_t hash = 0; hash < 1024; hash++)
+      {
+        Ptr<Neighbor> parent = neighborSet.SelectMultipathParent ("fe80::1", hash);
+        for (uint32_t i = 0; i < 3; i++)
+          {
+            if (parent->GetNeighborAddress () == Ipv6Address (addresses[i]))
+              {
+                count[i]++;
+              }
+          }
+      }
+    NS_TEST_EXPECT_MSG_EQ (count[0], 512, "Even split");
+    NS_TEST_EXPECT_MSG_EQ (count[2], 0, "Higher rank parent unused");
+
+    // ETX 3 on fe80::2 leaves it a quarter of the flows
+    neighborSet.FindNeighbor ("fe80::2")->SetEtx (384);
+    count[1] = 0;
+    for (uint32_t hash = 0; hash < 1024; hash++)
+      {
+        if (neighborSet.SelectMultipathParent ("fe80::1", hash)->GetNeighborAddress () == Ipv6Address ("fe80::2"))
+          {
+            count[1]++;
+          }
+      }
+    NS_TEST_EXPECT_MSG_EQ_TOL (count[1], 256, 20, "ETX weighted split");
+
+    neighborSet.FindNeighbor ("fe80::2")->SetReachable (false);
+    NS_TEST_EXPECT_MSG_EQ (neighborSet.SelectMultipathParent ("fe80::1", 1)->GetNeighborAddress (), Ipv6Address ("fe80::1"), "Unreachable parent skipped");
+    NS_TEST_EXPECT_MSG_EQ ((neighborSet.SelectMultipathParent ("fe80::9", 1) == 0), true, "Unknown preferred parent");
+  }
+};
+
+struct RplCongestionTest : public TestCase
+{
+  RplCongestionTest () : TestCase ("Rpl Congestion-Aware Parent Selection Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplMetricContainerOption metricContainer;
+    metricContainer.SetRootLoad (40);
+    metricContainer.SetQueueLoad (200);
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (metricContainer);
+    RplMetricContainerOption received;
+    p->RemoveHeader (received);
+    uint8_t load = 0;
+    NS_TEST_EXPECT_MSG_EQ (received.GetQueueLoad (load), true, "Queue load present");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)load, 200, "Queue load");
+    NS_TEST_EXPECT_MSG_EQ (received.GetRootLoad (load), true, "Root load kept");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)load, 40, "Root load");
+
+    RplNeighborSet neighborSet;
+    Neighbor neighbor;
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighbor.SetNeighborAddress ("fe80::1");
+    neighbor.SetRank (769);
+    neighbor.SetQueueLoad (255);
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::2");
+    neighbor.SetQueueLoad (0);
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::3");
+    neighbor.SetRank (513);
+    neighbor.SetQueueLoad (255);
+    neighborSet.AddNeighbor (neighbor);
+
+    // 769 beats 513 + 512 at full occupancy, but not at rank 769 or below
+    Ptr<Neighbor> parent = neighborSet.SelectParent ("2001:1::1", 0xffffffff, 512, 0xfffe);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::2"), "Least congested parent");
+    parent = neighborSet.SelectParent ("2001:1::1", 0xffffffff, 0, 0xfffe);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::3"), "Rank alone without weight");
+    parent = neighborSet.SelectParent ("2001:1::1", 0xffffffff, 512, 600);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::3"), "Rank bound");
+
+    NS_TEST_EXPECT_MSG_EQ (RplObjectiveFunction::ComputeCongestionCost (769, 128, 510), 1025, "Congestion cost");
+  }
+};
+
+struct RplEnergyTest : public TestCase
+{
+  RplEnergyTest () : TestCase ("Rpl Energy-Aware Parent Selection Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplMetricContainerOption metricContainer;
+    uint8_t energy = 0;
+    NS_TEST_EXPECT_MSG_EQ (metricContainer.GetNodeEnergy (energy), false, "No energy advertised");
+    metricContainer.SetQueueLoad (10);
+    metricContainer.SetNodeEnergy (60);
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (metricContainer);
+    RplMetricContainerOption received;
+    p->RemoveHeader (received);
+    NS_TEST_EXPECT_MSG_EQ (received.GetNodeEnergy (energy), true, "Energy present");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)energy, 60, "Energy");
+
+    // the path energy is the bottleneck of the path
+    received.AccumulateMetric (RPL_METRIC_NE, RPL_NE_FLAG_I | RPL_NE_TYPE_BATTERY | RPL_NE_FLAG_E | 30);
+    received.GetNodeEnergy (energy);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)energy, 30, "Lowest energy on the path");
+    received.SetNodeEnergy (200);
+    received.GetNodeEnergy (energy);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)energy, 100, "Energy is a percentage");
+
+    // no valid estimation without the E flag
+    RplMetricObject ne;
+    ne.SetType (RPL_METRIC_NE);
+    ne.AddValue (RPL_NE_TYPE_MAINS | 50);
+    RplMetricContainerOption noEstimation;
+    noEstimation.AddMetricObject (ne);
+    NS_TEST_EXPECT_MSG_EQ (noEstimation.GetNodeEnergy (energy), false, "E flag clear");
+
+    RplNeighborSet neighborSet;
+    Neighbor neighbor;
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)neighbor.GetEnergy (), 100, "Silent neighbor taken as mains-powered");
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighbor.SetNeighborAddress ("fe80::1");
+    neighbor.SetRank (769);
+    neighbor.SetEnergy (20);
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::2");
+    neighbor.SetEnergy (90);
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::3");
+    neighbor.SetRank (513);
+    neighbor.SetEnergy (0);
+    neighborSet.AddNeighbor (neighbor);
+
+    // 769 + 51 beats 513 + 512 with an exhausted path, but not at rank 769 or below
+    Ptr<Neighbor> parent = neighborSet.SelectEnergyParent ("2001:1::1", 0xffffffff, 512, 0xfffe);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::2"), "Parent with the most energy");
+    parent = neighborSet.SelectEnergyParent ("2001:1::1", 0xffffffff, 0, 0xfffe);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::3"), "Rank alone without weight");
+    parent = neighborSet.SelectEnergyParent ("2001:1::1", 0xffffffff, 512, 600);
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::3"), "Rank bound");
+
+    NS_TEST_EXPECT_MSG_EQ (RplObjectiveFunction::ComputeEnergyCost (769, 75, 512), 897, "Energy cost");
+    NS_TEST_EXPECT_MSG_EQ (RplObjectiveFunction::ComputeEnergyCost (769, 100, 512), 769, "Full energy costs nothing");
+
+    // the residual energy comes from the scenario, a node without it is mains-powered
+    Ptr<Rpl> rpl = CreateObject<Rpl> ();
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)rpl->GetResidualEnergy (), 100, "Mains-powered by default");
+    rpl->SetResidualEnergyCallback (MakeCallback (&HalfEnergy));
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)rpl->GetResidualEnergy (), 50, "Residual energy in percent");
+  }
+
+  static double HalfEnergy ()
+  {
+    return 0.5;
+  }
+};
+
+struct RplEtxTest : public TestCase
+{
+  RplEtxTest () : TestCase ("Rpl Etx Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Neighbor neighbor;
+    NS_TEST_EXPECT_MSG_EQ (neighbor.GetReachable (), false, "Unknown neighbor unreachable");
+    NS_TEST_EXPECT_MSG_EQ (neighbor.GetEtx (), 256, "Initial ETX 2");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)neighbor.GetProbes (), 0, "No probes");
+
+    // one attempt per packet converges towards ETX 1
+    for (uint32_t i = 0; i < 50; i++)
+      {
+        neighbor.UpdateEtx (1, true);
+      }
+    NS_TEST_EXPECT_MSG_LT (neighbor.GetEtx (), 130, "Good link");
+    NS_TEST_EXPECT_MSG_GT (neighbor.GetEtx (), 127, "ETX never below 1");
+
+    // a lost packet weighs at least the no-ack penalty
+    uint16_t before = neighbor.GetEtx ();
+    neighbor.UpdateEtx (1, false);
+    NS_TEST_EXPECT_MSG_EQ (neighbor.GetEtx (), (before * 90 + 12 * 128 * 10) / 100, "No-ack penalty");
+
+    neighbor.UpdateEtx (3, true);
+    NS_TEST_EXPECT_MSG_GT (neighbor.GetEtx (), before, "Retries raise ETX");
+  }
+};
+
+struct RplWakeScheduleTest : public TestCase
+{
+  RplWakeScheduleTest () : TestCase ("Rpl Wake Schedule Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    // awake from 100 ms to 110 ms, then every 500 ms
+    Ptr<RplDutyCycle> dutyCycle = CreateObject<RplDutyCycle> ();
+    dutyCycle->SetSchedule (MilliSeconds (500), MilliSeconds (10), MilliSeconds (100));
+    Time start, end;
+    dutyCycle->GetNextWake (MilliSeconds (105), start, end);
+    NS_TEST_EXPECT_MSG_EQ (start, MilliSeconds (105), "Awake in a window");
+    NS_TEST_EXPECT_MSG_EQ (end, MilliSeconds (110), "End of the window");
+    dutyCycle->GetNextWake (MilliSeconds (110), start, end);
+    NS_TEST_EXPECT_MSG_EQ (start, MilliSeconds (600), "Next window");
+    NS_TEST_EXPECT_MSG_EQ (end, MilliSeconds (610), "End of the next window");
+    dutyCycle->GetNextWake (MilliSeconds (50), start, end);
+    NS_TEST_EXPECT_MSG_EQ (start, MilliSeconds (100), "Window before the phase");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->IsAwake (MilliSeconds (1600)), true, "Awake");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->IsAwake (MilliSeconds (1610)), false, "Asleep");
+
+    // a transmission is drawn within the next window of the range
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (300), MilliSeconds (250), Seconds (1), 0),
+                           MilliSeconds (600), "Moved to the next window");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (300), MilliSeconds (250), Seconds (1), 0.5),
+                           MilliSeconds (605), "Spread over the window");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (102), Seconds (0), Seconds (1), 0),
+                           MilliSeconds (102), "Already awake");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (800), MilliSeconds (500), MilliSeconds (1000), 0),
+                           MilliSeconds (600), "Earlier window of the range");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (605), MilliSeconds (550), MilliSeconds (607), 0.5),
+                           MilliSeconds (606), "Window cut at the end of the range");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->AlignTransmission (MilliSeconds (300), MilliSeconds (200), MilliSeconds (400), 0),
+                           MilliSeconds (300), "No window in the range");
+
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->GetRadioOnTime (Seconds (10), 0), MilliSeconds (200), "Radio on in the windows");
+    NS_TEST_EXPECT_MSG_EQ (dutyCycle->GetRadioOnTime (Seconds (10), 4), MilliSeconds (220), "Extra wakeups");
+  }
+};
+
+struct RplMobilityTest : public TestCase
+{
+  RplMobilityTest () : TestCase ("Rpl Mobility Handover Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Neighbor fading;
+    NS_TEST_EXPECT_MSG_EQ (fading.HasRssi (), false, "No RSSI before a frame is heard");
+    NS_TEST_EXPECT_MSG_EQ (fading.IsDegrading (-90, 384, Seconds (2)), false, "Unknown link is not degrading");
+
+    // moving away: the RSSI falls by 4 dB/s, sampled every 100 ms
+    for (uint32_t i = 0; i <= 50; i++)
+      {
+        fading.UpdateRssi (-70 - 0.4 * i, MilliSeconds (100 * i));
+      }
+    NS_TEST_EXPECT_MSG_EQ (fading.HasRssi (), true, "RSSI heard");
+    NS_TEST_EXPECT_MSG_EQ_TOL (fading.GetRssiTrend (), -4, 0.1, "RSSI trend");
+    NS_TEST_EXPECT_MSG_GT (fading.GetRssi (), -90, "Still above the threshold");
+    NS_TEST_EXPECT_MSG_EQ (fading.IsDegrading (-90, 384, Seconds (0)), false, "Usable now");
+    NS_TEST_EXPECT_MSG_EQ (fading.IsDegrading (-90, 384, Seconds (2)), true, "About to break");
+
+    Neighbor steady;
+    for (uint32_t i = 0; i <= 50; i++)
+      {
+        steady.UpdateRssi (-75, MilliSeconds (100 * i));
+      }
+    NS_TEST_EXPECT_MSG_EQ_TOL (steady.GetRssiTrend (), 0, 0.001, "Steady RSSI");
+    NS_TEST_EXPECT_MSG_EQ (steady.IsDegrading (-90, 384, Seconds (2)), false, "Steady link");
+    steady.SetEtx (400);
+    NS_TEST_EXPECT_MSG_EQ (steady.IsDegrading (-90, 384, Seconds (2)), true, "Lossy link");
+
+    RplNeighborSet neighborSet;
+    Neighbor neighbor = fading;
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighbor.SetNeighborAddress ("fe80::1");
+    neighbor.SetRank (256);
+    neighborSet.AddNeighbor (neighbor);
+    neighbor = Neighbor ();
+    neighbor.SetDodagId ("2001:1::1");
+    neighbor.SetInterface (1);
+    neighbor.SetReachable (true);
+    neighbor.SetNeighborAddress ("fe80::2");
+    neighbor.SetRank (512);
+    neighbor.UpdateRssi (-80, Seconds (5));
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::3");
+    neighbor.UpdateRssi (-60, Seconds (5));
+    neighborSet.AddNeighbor (neighbor);
+    neighbor.SetNeighborAddress ("fe80::4");
+    neighbor.SetRank (768);
+    neighborSet.AddNeighbor (neighbor);
+
+    // the current parent fe80::5 is left, the fading fe80::1 is no better
+    Ptr<Neighbor> parent = neighborSet.SelectHandoverParent ("2001:1::1", "fe80::5", 512, -90, 384, Seconds (2));
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::3"), "Lowest rank, then strongest RSSI");
+    parent = neighborSet.SelectHandoverParent ("2001:1::1", "fe80::3", 512, -90, 384, Seconds (2));
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::2"), "Current parent left out");
+    parent = neighborSet.SelectHandoverParent ("2001:1::1", "fe80::5", 256, -90, 384, Seconds (2));
+    NS_TEST_EXPECT_MSG_EQ ((parent == 0), true, "No parent deeper than the node");
+    parent = neighborSet.SelectHandoverParent ("2001:1::1", "fe80::5", 512, -90, 384, Seconds (0));
+    NS_TEST_EXPECT_MSG_EQ (parent->GetNeighborAddress (), Ipv6Address ("fe80::1"), "Usable without the trend");
+  }
+};
+
+struct RplDaoTest : public TestCase
+{
+  RplDaoTest () : TestCase ("Rpl Dao Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    // only the significant bytes of a target prefix are carried
+    RplTargetOption target;
+    target.SetTarget (Ipv6Address ("2001:1::5"));
+    NS_TEST_EXPECT_MSG_EQ (target.GetSerializedSize (), 20, "Host target size");
+    target.SetTarget (Ipv6Address ("2001:1::"));
+    target.SetPrefixLength (62);
+    NS_TEST_EXPECT_MSG_EQ (target.GetSerializedSize (), 12, "Prefix target size");
+
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (target);
+    RplTargetOption target2;
+    p->RemoveHeader (target2);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)target2.GetPrefixLength (), 62, "Target prefix length");
+    NS_TEST_EXPECT_MSG_EQ (target2.GetTarget (), Ipv6Address ("2001:1::"), "Target prefix");
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "Whole target option read");
+
+    // storing mode transit information carries no parent address
+    RplTransitInformationOption transit;
+    transit.SetFlagE (true);
+    transit.SetPathSequence (7);
+    transit.SetPathLifetime (0xff);
+    NS_TEST_EXPECT_MSG_EQ (transit.GetSerializedSize (), 6, "Storing mode transit size");
+    p = Create<Packet> ();
+    p->AddHeader (transit);
+    RplTransitInformationOption transit2;
+    p->RemoveHeader (transit2);
+    NS_TEST_EXPECT_MSG_EQ (transit2.GetFlagE (), true, "Transit E flag");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)transit2.GetPathSequence (), 7, "Transit path sequence");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)transit2.GetPathLifetime (), 0xff, "Transit path lifetime");
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 0, "Whole transit option read");
+    transit.SetParentAddress (Ipv6Address ("2001:1::1"));
+    NS_TEST_EXPECT_MSG_EQ (transit.GetSerializedSize (), 22, "Non-storing mode transit size");
+
+    RplDaoMessage dao;
+    dao.SetFlagK (true);
+    dao.SetFlagD (true);
+    p = Create<Packet> ();
+    p->AddHeader (dao);
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 22, "DAO base size");
+    RplDaoMessage dao2;
+    p->RemoveHeader (dao2);
+    NS_TEST_EXPECT_MSG_EQ (dao2.GetFlagK (), true, "DAO K flag");
+    NS_TEST_EXPECT_MSG_EQ (dao2.GetFlagD (), true, "DAO D flag");
+
+    // a contiguous block of targets becomes a single prefix
+    RplDaoTarget announce;
+    announce.pathSequence = 3;
+    announce.pathLifetime = 0xff;
+    RplDaoTargets targets;
+    const char *hosts[] = { "2001:1::4", "2001:1::5", "2001:1::6", "2001:1::7", "2001:1::9" };
+    for (uint32_t i = 0; i < 5; i++)
+      {
+        targets[std::make_pair (Ipv6Address (hosts[i]), 128)] = announce;
+      }
+    targets[std::make_pair (Ipv6Address ("2001:1::6"), 128)].pathSequence = 4;
+    RplDaoTarget noPath;
+    noPath.pathSequence = 3;
+    noPath.pathLifetime = 0;
+    targets[std::make_pair (Ipv6Address ("2001:1::8"), 128)] = noPath;
+
+    NS_TEST_EXPECT_MSG_EQ (Rpl::AggregateDaoTargets (targets), 3, "Merges");
+    NS_TEST_EXPECT_MSG_EQ (targets.size (), 3, "Targets after aggregation");
+    RplDaoTargets::iterator block = targets.find (std::make_pair (Ipv6Address ("2001:1::4"), 126));
+    NS_TEST_ASSERT_MSG_EQ ((block != targets.end ()), true, "Block announced as a /126");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)block->second.pathSequence, 4, "Newest path sequence kept");
+    NS_TEST_EXPECT_MSG_EQ ((targets.count (std::make_pair (Ipv6Address ("2001:1::8"), 128))), 1, "No-Path not merged with an announcement");
+
+    // downward routes: longest prefix, stale announcements, No-Path splits aggregates
+    RplRoutingTable routingTable;
+    Ipv6Address childA ("fe80::a");
+    Ipv6Address childB ("fe80::b");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddDownwardRoute ("2001:1::4", 126, childA, 1, 4, 0xff), true, "Aggregate installed");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddDownwardRoute ("2001:1::9", 128, childA, 1, 10, 0xff), true, "Host installed");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddDownwardRoute ("2001:1::9", 128, childB, 1, 9, 0xff), false, "Stale path ignored");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddDownwardRoute ("2001:1::9", 128, childB, 1, 11, 0xff), true, "Newer path replaces");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNDownwardRoutes (), 2, "Two downward routes");
+
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveDownwardRoute ("2001:1::5", 128, childB), false, "No route through that child");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveDownwardRoute ("2001:1::5", 128, childA), true, "Aggregate split");
+    std::vector<RplRoutingTableEntry> routes = routingTable.GetDownwardRoutes ();
+    NS_TEST_EXPECT_MSG_EQ (routes.size (), 3, "Siblings of the withdrawn target remain");
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < routes.size (); i++)
+      {
+        uint8_t length = routes[i].GetDestNetworkPrefix ().GetPrefixLength ();
+        if ((routes[i].GetDest () == Ipv6Address ("2001:1::6") && length == 127) ||
+            (routes[i].GetDest () == Ipv6Address ("2001:1::4") && length == 128))
+          {
+            NS_TEST_EXPECT_MSG_EQ (routes[i].GetNextHop (), childA, "Sibling through the same child");
+            found++;
+          }
+      }
+    NS_TEST_EXPECT_MSG_EQ (found, 2, "2001:1::6/127 and 2001:1::4/128");
+  }
+};
+
+struct RplRouteAggregationTest : public TestCase
+{
+  RplRouteAggregationTest () : TestCase ("Rpl Route Aggregation Test")
+  {
+  }
+  // longest prefix match over the downward routes, "::" if none
+  Ipv6Address NextHop (const RplRoutingTable &routingTable, Ipv6Address dst)
+  {
+    std::vector<RplRoutingTableEntry> routes = routingTable.GetDownwardRoutes ();
+    Ipv6Address nextHop = Ipv6Address::GetZero ();
+    int32_t longest = -1;
+    for (uint32_t i = 0; i < routes.size (); i++)
+      {
+        Ipv6Prefix prefix = routes[i].GetDestNetworkPrefix ();
+        if (prefix.IsMatch (routes[i].GetDest (), dst) && prefix.GetPrefixLength () > longest)
+          {
+            nextHop = routes[i].GetNextHop ();
+            longest = prefix.GetPrefixLength ();
+          }
+      }
+    return nextHop;
+  }
+  Ipv6Address Host (uint8_t i)
+  {
+    uint8_t bytes[16];
+    Ipv6Address ("2001:1::1:0").GetBytes (bytes);
+    bytes[15] = i;
+    return Ipv6Address (bytes);
+  }
+  void CheckNextHops (const RplRoutingTable &routingTable, Ipv6Address exception, Ipv6Address exceptionHop,
+                      Ipv6Address nextHop)
+  {
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        Ipv6Address expected = (Host (i) == exception) ? exceptionHop : nextHop;
+        NS_TEST_EXPECT_MSG_EQ (NextHop (routingTable, Host (i)), expected, "Next hop of " << Host (i));
+      }
+  }
+  virtual void DoRun ()
+  {
+    // a /120 block behind childA, with one device behind childB
+    RplRoutingTable routingTable;
+    Ipv6Address childA ("fe80::a");
+    Ipv6Address childB ("fe80::b");
+    Ipv6Address childC ("fe80::c");
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        routingTable.AddDownwardRoute (Host (i), 128, (i == 5) ? childB : childA, 1, 1, 0xff);
+      }
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNDownwardRoutes (), 256, "One host route per device");
+
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AggregateDownwardRoutes (), 247, "Routes removed");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNDownwardRoutes (), 9, "Sibling prefixes around the exception");
+    CheckNextHops (routingTable, Host (5), childB, childA);
+
+    // the exception leaves, nothing covers it any more
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveDownwardRoute (Host (5), 128, childB), true, "Exception withdrawn");
+    NS_TEST_EXPECT_MSG_EQ (NextHop (routingTable, Host (5)), Ipv6Address::GetZero (), "Withdrawn host unreachable");
+
+    // and comes back through childA: the block collapses into one prefix
+    routingTable.AddDownwardRoute (Host (5), 128, childA, 1, 2, 0xff);
+    routingTable.AggregateDownwardRoutes ();
+    std::vector<RplRoutingTableEntry> routes = routingTable.GetDownwardRoutes ();
+    NS_TEST_ASSERT_MSG_EQ (routes.size (), 1, "Block aggregated");
+    NS_TEST_EXPECT_MSG_EQ (routes[0].GetDest (), Ipv6Address ("2001:1::1:0"), "Block prefix");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)routes[0].GetDestNetworkPrefix ().GetPrefixLength (), 120, "Block length");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)routes[0].GetPathSequence (), 2, "Newest path sequence kept");
+
+    // a route inside the block through the same child is redundant
+    routingTable.AddDownwardRoute (Host (0x20), 128, childA, 1, 3, 0xff);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNDownwardRoutes (), 2, "Redundant host route installed");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AggregateDownwardRoutes (), 1, "Redundant host route pruned");
+
+    // a new exception splits the block exactly
+    routingTable.AddDownwardRoute (Host (9), 128, childC, 1, 1, 0xff);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNDownwardRoutes (), 9, "Block split around the exception");
+    CheckNextHops (routingTable, Host (9), childC, childA);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AggregateDownwardRoutes (), 0, "Nothing left to aggregate");
+  }
+};
+
+struct RplRepairTest : public TestCase
+{
+  RplRepairTest () : TestCase ("Rpl Repair Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    // version numbers: lollipop counter, 0 left to nodes that have not joined
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)Rpl::NextVersion (1), 2, "Next version");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)Rpl::NextVersion (127), 1, "Circular part wraps, skipping 0");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)Rpl::NextVersion (200), 201, "Linear part");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)Rpl::NextVersion (255), 1, "Linear part runs into the circular one");
+
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (2, 1), true, "2 newer than 1");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (1, 2), false, "1 older than 2");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (5, 5), false, "Same version");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (1, 127), true, "Newer across the wrap");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (127, 1), false, "Older across the wrap");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (1, 255), true, "Circular after linear");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (240, 100), true, "Restarted counter newer than a distant one");
+    NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (100, 240), false, "Distant counter older than a restarted one");
+    for (uint32_t v = 1; v < 256; v++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (Rpl::IsNewerVersion (Rpl::NextVersion (v), v), true, "Next of " << v << " is newer");
+      }
+
+    // a floating root has no default route
+    RplRoutingTable routingTable;
+    routingTable.SetDodagParent (Ipv6Address ("fe80::1"), 1);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDodagParent (), Ipv6Address ("fe80::1"), "Parent set");
+    routingTable.RemoveDodagParent ();
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDodagParent (), Ipv6Address::GetZero (), "Parent removed");
+  }
+};
+
+struct RplDisTest : public TestCase
+{
+  RplDisTest () : TestCase ("Rpl Dis Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    // predicates of the Solicited Information option
+    RplSolicitedInformationOption solicited;
+    NS_TEST_EXPECT_MSG_EQ (solicited.GetFlagV () || solicited.GetFlagI () || solicited.GetFlagD (), false, "No predicate by default");
+    solicited.SetFlagV (true);
+    solicited.SetFlagD (true);
+    solicited.SetRplInstanceId (3);
+    solicited.SetVersionNumber (7);
+    solicited.SetDodagId (Ipv6Address ("2001:1::1"));
+    Ptr<Packet> p = Create<Packet> ();
+    p->AddHeader (solicited);
+    NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 21, "Solicited Information size");
+    uint8_t bytes[4];
+    p->CopyData (bytes, 4);
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[2], 3, "RPLInstanceID before the flags");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)bytes[3], 0xa0, "V and D flags");
+    RplSolicitedInformationOption solicited2;
+    p->RemoveHeader (solicited2);
+    NS_TEST_EXPECT_MSG_EQ (solicited2.GetFlagV (), true, "V flag");
+    NS_TEST_EXPECT_MSG_EQ (solicited2.GetFlagI (), false, "I flag");
+    NS_TEST_EXPECT_MSG_EQ (solicited2.GetFlagD (), true, "D flag");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)solicited2.GetRplInstanceId (), 3, "RPLInstanceID");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)solicited2.GetVersionNumber (), 7, "Version number");
+    NS_TEST_EXPECT_MSG_EQ (solicited2.GetDodagId (), Ipv6Address ("2001:1::1"), "DODAG ID");
+
+    // DIS responses: a burst, then one per second
+    RplTokenBucket tokens;
+    tokens.SetRate (1, 3);
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (tokens.Consume (Seconds (0)), true, "Burst response " << i);
+      }
+    NS_TEST_EXPECT_MSG_EQ (tokens.Consume (Seconds (0)), false, "Burst exhausted");
+    NS_TEST_EXPECT_MSG_EQ (tokens.GetDelay (Seconds (0)), Seconds (1), "Next token in a second");
+    NS_TEST_EXPECT_MSG_EQ (tokens.Consume (Seconds (0.5)), false, "Half a token");
+    NS_TEST_EXPECT_MSG_EQ (tokens.Consume (Seconds (1)), true, "Token refilled");
+    uint32_t taken = 0;
+    while (tokens.Consume (Seconds (100)))
+      {
+        taken++;
+      }
+    NS_TEST_EXPECT_MSG_EQ (taken, 3, "Refill capped at the burst");
+
+    RplTokenBucket unlimited;
+    for (uint32_t i = 0; i < 100; i++)
+      {
+        NS_TEST_EXPECT_MSG_EQ (unlimited.Consume (Seconds (0)), true, "No limit");
+      }
+  }
+};
+
+/*
+ * Multicast DIS solicitation of a node with two interfaces, each on a link
+ * of its own. Alone, the node sends a DIS on both interfaces at once, with
+ * the jittered gap between two rounds doubling from DIS_TEST_INTERVAL up to
+ * DIS_TEST_MAX_INTERVAL, and gives up after DIS_TEST_MAX_ATTEMPTS rounds.
+ * With a root on its first link, whose first DIO comes late because of a
+ * long Imin, the node stops soliciting once that DIO arrives.
+ */
+#define DIS_TEST_SIM_TIME 60
+#define DIS_TEST_INTERVAL 1
+#define DIS_TEST_MAX_INTERVAL 4
+#define DIS_TEST_MAX_ATTEMPTS 6
+#define DIS_TEST_ROOT_IMIN 8
+
+struct RplDisSolicitationTest : public TestCase
+{
+  std::vector<Time> m_disTimes;
+  Time m_firstDio;
+
+  RplDisSolicitationTest () : TestCase ("Rpl Dis Solicitation Test")
+  {
+  }
+
+  void NodeControlTx (Ptr<const Packet> packet, uint8_t code)
+  {
+    if (code == 0)
+      {
+        m_disTimes.push_back (Simulator::Now ());
+      }
+  }
+
+  void RootControlTx (Ptr<const Packet> packet, uint8_t code)
+  {
+    if (code == 1 && m_firstDio.IsNegative ())
+      {
+        m_firstDio = Simulator::Now ();
+      }
+  }
+
+  // the soliciting node, with a root on its first link if withRoot
+  Ptr<Rpl> Build (bool withRoot, uint32_t maxAttempts)
+  {
+    NodeContainer nodes;
+    nodes.Create (withRoot ? 2 : 1);
+    std::vector<NetDeviceContainer> linkDevices;
+    for (uint32_t l = 0; l < 2; l++)
+      {
+        Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+        NetDeviceContainer devices;
+        for (uint32_t n = 0; n < (l == 0 ? nodes.GetN () : 1); n++)
+          {
+            Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+            device->SetAddress (Mac48Address::Allocate ());
+            device->SetChannel (channel);
+            nodes.Get (n)->AddDevice (device);
+            devices.Add (device);
+          }
+        linkDevices.push_back (devices);
+      }
+
+    RplHelper RplRouting;
+    RplRouting.Set ("DisStartDelay", TimeValue (Seconds (DIS_TEST_INTERVAL)));
+    RplRouting.Set ("DisInterval", TimeValue (Seconds (DIS_TEST_INTERVAL)));
+    RplRouting.Set ("DisMaxInterval", TimeValue (Seconds (DIS_TEST_MAX_INTERVAL)));
+    RplRouting.Set ("DisMaxAttempts", UintegerValue (maxAttempts));
+    if (withRoot)
+      {
+        RplRouting.SetRoot (nodes.Get (1));
+      }
+    InternetStackHelper internetv6routers;
+    internetv6routers.SetIpv4StackInstall (false);
+    internetv6routers.SetRoutingHelper (RplRouting);
+    internetv6routers.Install (nodes);
+    RplRouting.AssignStreams (nodes, 0);
+
+    Ipv6AddressHelper ipv6;
+    ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+    for (uint32_t l = 0; l < linkDevices.size (); l++)
+      {
+        ipv6.Assign (linkDevices[l]);
+        ipv6.NewNetwork ();
+      }
+
+    m_disTimes.clear ();
+    m_firstDio = Seconds (-1);
+    Ptr<Rpl> rpl = nodes.Get (0)->GetObject<Rpl> ();
+    rpl->TraceConnectWithoutContext ("ControlTx", MakeCallback (&RplDisSolicitationTest::NodeControlTx, this));
+    if (withRoot)
+      {
+        Ptr<Rpl> root = nodes.Get (1)->GetObject<Rpl> ();
+        root->SetAttribute ("MinimumIntervalSize", TimeValue (Seconds (DIS_TEST_ROOT_IMIN)));
+        root->TraceConnectWithoutContext ("ControlTx", MakeCallback (&RplDisSolicitationTest::RootControlTx, this));
+      }
+    return rpl;
+  }
+
+  virtual void DoRun ()
+  {
+    // alone: rounds on every interface, backed off, then given up
+    Ptr<Rpl> rpl = Build (false, DIS_TEST_MAX_ATTEMPTS);
+    Simulator::Stop (Seconds (DIS_TEST_SIM_TIME));
+    Simulator::Run ();
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetNRplInterfaces (), 2, "Two RPL interfaces");
+    Simulator::Destroy ();
+
+    std::vector<Time> rounds;
+    for (uint32_t i = 0; i < m_disTimes.size (); i += 2)
+      {
+        NS_TEST_ASSERT_MSG_EQ ((i + 1 < m_disTimes.size () && m_disTimes[i + 1] == m_disTimes[i]), true,
+                               "A DIS on each interface in round " << rounds.size ());
+        rounds.push_back (m_disTimes[i]);
+      }
+    NS_TEST_ASSERT_MSG_EQ (rounds.empty (), false, "No DIS sent");
+    NS_TEST_EXPECT_MSG_EQ ((uint32_t)rounds.size (), DIS_TEST_MAX_ATTEMPTS, "Solicitation stops after DisMaxAttempts");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (rounds.front (), Seconds (DIS_TEST_INTERVAL), "First DIS within DisStartDelay");
+    Time backoff = Seconds (DIS_TEST_INTERVAL);
+    for (uint32_t r = 1; r < rounds.size (); r++)
+      {
+        // jittered over the second half of the current backoff
+        NS_TEST_EXPECT_MSG_GT_OR_EQ (rounds[r] - rounds[r - 1], backoff / 2, "Gap " << r << " too short");
+        NS_TEST_EXPECT_MSG_LT_OR_EQ (rounds[r] - rounds[r - 1], backoff, "Gap " << r << " too long");
+        backoff = std::min (backoff + backoff, Seconds (DIS_TEST_MAX_INTERVAL));
+      }
+
+    // with a root: no limit on the attempts, the DIO ends the solicitation
+    // stopped a few backoffs past the latest first DIO, before the node
+    // would probe its silent parent with a unicast DIS
+    rpl = Build (true, 0);
+    Simulator::Stop (Seconds (DIS_TEST_ROOT_IMIN + 3 * DIS_TEST_MAX_INTERVAL));
+    Simulator::Run ();
+    NS_TEST_EXPECT_MSG_NE (rpl->GetRank (), 0, "Joined the root");
+    Simulator::Destroy ();
+
+    NS_TEST_ASSERT_MSG_EQ (m_firstDio.IsNegative (), false, "The root sent a DIO");
+    NS_TEST_ASSERT_MSG_GT ((uint32_t)m_disTimes.size (), 0, "Solicited before the DIO");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_disTimes.back (), m_firstDio, "No DIS after the DIO");
+  }
+};
+
+struct RplInterfaceTest : public TestCase
+{
+  RplInterfaceTest () : TestCase ("Rpl Interface Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Rpl> rpl = CreateObject<Rpl> ();
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetNRplInterfaces (), 0, "No socket before initialization");
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetInterfaceCost (1), 0, "No cost by default");
+    rpl->SetInterfaceCost (2, 512);
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetInterfaceCost (2), 512, "Interface cost");
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetInterfaceCost (1), 0, "Other interfaces keep no cost");
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetInterfaceCost (7), 0, "Unknown interface");
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetAdvertisedRank (2), 0, "Nothing advertised before joining");
+
+    // costs set through the helper are applied to the created protocol
+    Ptr<Node> node = CreateObject<Node> ();
+    RplHelper helper;
+    helper.SetInterfaceCost (node, 1, 256);
+    Ptr<Rpl> created = DynamicCast<Rpl> (helper.Create (node));
+    NS_TEST_EXPECT_MSG_EQ (created->GetInterfaceCost (1), 256, "Cost from the helper");
+    NS_TEST_EXPECT_MSG_EQ (created->GetInterfaceCost (2), 0, "Other interface");
+  }
+};
+
+struct RplLeafTest : public TestCase
+{
+  RplLeafTest () : TestCase ("Rpl Leaf Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Rpl> rpl = CreateObject<Rpl> ();
+    NS_TEST_EXPECT_MSG_EQ (rpl->IsLeaf (), false, "Router by default");
+    NS_TEST_EXPECT_MSG_EQ (rpl->GetNRoutes (), 0, "No route before joining");
+
+    // the node type is configured, so it survives a change of DODAG
+    RplRoutingTable routingTable;
+    routingTable.SetNodeType (false);
+    routingTable.SetDodagParent (Ipv6Address ("fe80::1"), 1);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNRoutes (), 1, "Default route only");
+    routingTable.AddNetworkRouteTo (Ipv6Address ("fe80::2"), 1);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNRoutes (), 2, "Default and host routes");
+    routingTable.ClearRoutingTable ();
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNRoutes (), 0, "Routes cleared");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNodeType (), false, "Still a leaf");
+
+    // a leaf keeps its parent only, until a lower rank is heard
+    RplNeighborSet neighbors;
+    neighbors.SetCapacity (1, RPL_EVICT_WORST_RANK);
+    Neighbor parent;
+    parent.SetNeighborAddress ("fe80::1");
+    parent.SetRank (512);
+    parent.SetReachable (true);
+    neighbors.AddNeighbor (parent);
+    Neighbor worse = parent;
+    worse.SetNeighborAddress ("fe80::2");
+    worse.SetRank (768);
+    NS_TEST_EXPECT_MSG_EQ ((neighbors.AddNeighbor (worse) == 0), true, "Higher rank ignored");
+    Neighbor better = parent;
+    better.SetNeighborAddress ("fe80::3");
+    better.SetRank (256);
+    neighbors.AddNeighbor (better);
+    NS_TEST_EXPECT_MSG_EQ (neighbors.GetNNeighbors (), 1, "One neighbor kept");
+    NS_TEST_EXPECT_MSG_EQ ((neighbors.FindNeighbor ("fe80::3") != 0), true, "Lower rank replaces the parent");
+  }
+};
+
+struct RplDodagExportTest : public TestCase
+{
+  RplDodagExportTest () : TestCase ("Rpl Dodag Export Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    Ptr<Node> detached = CreateObject<Node> ();
+    detached->AggregateObject (CreateObject<Rpl> ());
+    Ptr<Node> other = CreateObject<Node> ();
+
+    std::ostringstream json;
+    RplHelper::ExportDodag (Create<OutputStreamWrapper> (&json), false);
+    std::ostringstream line;
+    line << "{\"time\":0,\"node\":" << detached->GetId ()
+         << ",\"rank\":0,\"parent\":null,\"parents\":[],\"routes\":0}\n";
+    NS_TEST_EXPECT_MSG_NE (json.str ().find (line.str ()), std::string::npos, "One JSON line per RPL node");
+    std::ostringstream node;
+    node << "\"node\":" << other->GetId () << ",";
+    NS_TEST_EXPECT_MSG_EQ (json.str ().find (node.str ()), std::string::npos, "Nodes without RPL skipped");
+
+    std::ostringstream dot;
+    RplHelper::ExportDodag (Create<OutputStreamWrapper> (&dot), true);
+    std::ostringstream vertex;
+    vertex << "  n" << detached->GetId () << " [label=\"" << detached->GetId () << "\\nrank 0\\nroutes 0\"];\n";
+    NS_TEST_EXPECT_MSG_EQ (dot.str ().compare (0, 13, "digraph \"t=0s"), 0, "One digraph per snapshot");
+    NS_TEST_EXPECT_MSG_NE (dot.str ().find (vertex.str ()), std::string::npos, "One vertex per RPL node");
+    NS_TEST_EXPECT_MSG_EQ (dot.str ().find ("->"), std::string::npos, "No edge before joining");
+    NS_TEST_EXPECT_MSG_EQ (dot.str ().substr (dot.str ().size () - 2), "}\n", "Digraph closed");
+
+    Simulator::Destroy ();
+  }
+};
+
+struct RplRoutingTableDumpTest : public TestCase
+{
+  RplRoutingTableDumpTest () : TestCase ("Rpl Routing Table Dump Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplRoutingTable routingTable;
+    routingTable.SetDodagParent (Ipv6Address ("fe80::1"), 1);
+    routingTable.AddNetworkRouteTo (Ipv6Address ("fe80::2"), 1);
+    routingTable.AddDownwardRoute (Ipv6Address ("2001:1::5"), 128, Ipv6Address ("fe80::2"), 1, 3, 30);
+
+    std::ostringstream text;
+    routingTable.Print (text);
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("::/0"), std::string::npos, "Default route printed");
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("fe80::2/128"), std::string::npos, "Host route printed");
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("2001:1::5/128"), std::string::npos, "Downward route printed");
+
+    uint32_t size = routingTable.GetSerializedSize ();
+    NS_TEST_EXPECT_MSG_EQ (size, 4 + 3 * 40, "Fixed size records");
+    Buffer buffer;
+    buffer.AddAtStart (size);
+    routingTable.Serialize (buffer.Begin ());
+    std::ostringstream csv;
+    NS_TEST_EXPECT_MSG_EQ (RplRoutingTable::ConvertToCsv (buffer.Begin (), size, csv, "1,"), size, "Every route read");
+    NS_TEST_EXPECT_MSG_EQ (csv.str (), "1,default,::,0,fe80::1,1,0,0\n"
+                           "1,host,fe80::2,128,::,1,0,0\n"
+                           "1,downward,2001:1::5,128,fe80::2,1,3,30\n", "One row per route");
+    std::ostringstream truncated;
+    NS_TEST_EXPECT_MSG_EQ (RplRoutingTable::ConvertToCsv (buffer.Begin (), size - 1, truncated, ""), 0, "Truncated routes");
+
+    // bulk dump of all the nodes running RPL
+    Ptr<Node> node = CreateObject<Node> ();
+    node->AggregateObject (CreateObject<Rpl> ());
+    std::stringstream dump;
+    RplHelper::DumpRoutingTables (dump);
+    std::string bytes = dump.str ();
+    std::ostringstream rows;
+    NS_TEST_EXPECT_MSG_EQ (RplHelper::ConvertRoutingTableDump (dump, rows), true, "Dump read back");
+    NS_TEST_EXPECT_MSG_EQ (rows.str ().compare (0, 15, "time,node,rank,"), 0, "CSV header");
+    std::istringstream cut (bytes.substr (0, bytes.size () - 1));
+    NS_TEST_EXPECT_MSG_EQ (RplHelper::ConvertRoutingTableDump (cut, rows), false, "Truncated dump");
+
+    Simulator::Destroy ();
+  }
+};
+
+struct RplP2pRouteTest : public TestCase
+{
+  RplP2pRouteTest () : TestCase ("Rpl P2P Route Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplRoutingTable routingTable;
+    routingTable.AddDownwardRoute (Ipv6Address ("2001:1::9"), 128, Ipv6Address ("fe80::2"), 1, 3, 30);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddP2pRoute (Ipv6Address ("2001:1::9"), Ipv6Address ("fe80::3"), 1, Seconds (10)),
+                           true, "P2P route added");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNP2pRoutes (), 1, "One P2P route");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNRoutes (), 2, "P2P route next to the downward route");
+    std::ostringstream text;
+    routingTable.Print (text);
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("UGH"), std::string::npos, "P2P route printed");
+
+    // the DODAG routes are rebuilt after a repair, the P2P routes are kept
+    routingTable.ClearRoutingTable ();
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNP2pRoutes (), 1, "P2P route kept");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveP2pRoute (Ipv6Address ("2001:1::9")), true, "P2P route removed");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveP2pRoute (Ipv6Address ("2001:1::9")), false, "Nothing to remove");
+
+    // routes expire after their lifetime
+    routingTable.AddP2pRoute (Ipv6Address ("2001:1::8"), Ipv6Address ("fe80::3"), 1, Seconds (10));
+    Simulator::Stop (Seconds (11));
+    Simulator::Run ();
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNP2pRoutes (), 0, "P2P route expired");
+    Simulator::Destroy ();
+  }
+};
+
+struct RplMulticastTest : public TestCase
+{
+  RplMulticastTest () : TestCase ("Rpl Multicast Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    // per-group downstream neighbors
+    RplRoutingTable routingTable;
+    Ipv6Address group ("ff05::fb");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddMulticastRoute (group, Ipv6Address ("fe80::2"), 1, 5, 30), true, "First subscriber");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddMulticastRoute (group, Ipv6Address ("fe80::3"), 1, 1, 30), true, "Second subscriber");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.AddMulticastRoute (group, Ipv6Address ("fe80::2"), 1, 4, 30), false, "Stale announcement");
+    routingTable.AddMulticastRoute (Ipv6Address ("ff05::fc"), Ipv6Address ("fe80::3"), 1, 1, 30);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetMulticastRoutes (group).size (), 2, "Two subscribed children");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetMulticastRoutes ().size (), 3, "Every group");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNRoutes (), 3, "Multicast routes counted");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveMulticastRoute (group, Ipv6Address ("fe80::3")), true, "Subscriber withdrawn");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.RemoveMulticastRoute (group, Ipv6Address ("fe80::3")), false, "Nothing to withdraw");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetMulticastRoutes (group)[0].GetNextHop (), Ipv6Address ("fe80::2"),
+                           "Remaining subscriber");
+
+    std::ostringstream text;
+    routingTable.Print (text);
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("ff05::fb/128"), std::string::npos, "Group printed");
+    NS_TEST_EXPECT_MSG_NE (text.str ().find ("UGM"), std::string::npos, "Multicast flag");
+    uint32_t size = routingTable.GetSerializedSize ();
+    Buffer buffer;
+    buffer.AddAtStart (size);
+    routingTable.Serialize (buffer.Begin ());
+    std::ostringstream csv;
+    NS_TEST_EXPECT_MSG_EQ (RplRoutingTable::ConvertToCsv (buffer.Begin (), size, csv, ""), size, "Every route read");
+    NS_TEST_EXPECT_MSG_EQ (csv.str ().compare (0, 18, "multicast,ff05::fb"), 0, "Multicast row");
+
+    // the sub-DODAG a source is in, by longest prefix match
+    routingTable.AddDownwardRoute (Ipv6Address ("2001:1::"), 112, Ipv6Address ("fe80::2"), 1, 1, 30);
+    routingTable.AddDownwardRoute (Ipv6Address ("2001:1::9"), 128, Ipv6Address ("fe80::3"), 1, 1, 30);
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDownwardNextHop (Ipv6Address ("2001:1::9")), Ipv6Address ("fe80::3"), "Host route");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDownwardNextHop (Ipv6Address ("2001:1::8")), Ipv6Address ("fe80::2"), "Prefix");
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetDownwardNextHop (Ipv6Address ("2001:2::8")), Ipv6Address::GetAny (),
+                           "Outside the sub-DODAG");
+
+    // the DODAG state goes with the DODAG
+    routingTable.ClearRoutingTable ();
+    NS_TEST_EXPECT_MSG_EQ (routingTable.GetNMulticastRoutes (), 0, "Groups cleared");
+
+    // groups are never merged into prefixes
+    RplDaoTargets targets;
+    RplDaoTarget target;
+    target.pathSequence = 1;
+    target.pathLifetime = 30;
+    targets[std::make_pair (Ipv6Address ("ff05::fa"), 128)] = target;
+    targets[std::make_pair (Ipv6Address ("ff05::fb"), 128)] = target;
+    NS_TEST_EXPECT_MSG_EQ (Rpl::AggregateDaoTargets (targets), 0, "No merge");
+
+    Ptr<Rpl> rpl = CreateObject<Rpl> ();
+    rpl->JoinGroup (group);
+    rpl->JoinGroup (group);
+    NS_TEST_EXPECT_MSG_EQ (rpl->IsGroupMember (group), true, "Subscribed");
+    rpl->LeaveGroup (group);
+    NS_TEST_EXPECT_MSG_EQ (rpl->IsGroupMember (group), false, "Unsubscribed");
+  }
+};
+
+struct RplPathStatsTest : public TestCase
+{
+  RplPathStatsTest () : TestCase ("Rpl Path Stats Test")
+  {
+  }
+  virtual void DoRun ()
+  {
+    RplPathStats stats;
+    NS_TEST_EXPECT_MSG_EQ (stats.IsEnabled (), false, "Disabled by default");
+    NS_TEST_EXPECT_MSG_EQ (CreateObject<Rpl> ()->GetPathStats ().GetCapacity (), 0, "Nothing allocated by default");
+
+    // the ring buffer keeps the newest records, oldest first
+    stats.SetCapacity (3);
+    NS_TEST_EXPECT_MSG_EQ (stats.IsEnabled (), true, "Enabled with a capacity");
+    for (uint32_t i = 1; i <= 5; i++)
+      {
+        RplPathRecord record = { i, i * 1000, 7, uint16_t (256 * i), 0 };
+        stats.Record (record);
+      }
+    NS_TEST_EXPECT_MSG_EQ (stats.GetNRecords (), 3, "Capacity reached");
+    NS_TEST_EXPECT_MSG_EQ (stats.GetRecord (0).packetUid, 3, "Oldest record kept");
+    NS_TEST_EXPECT_MSG_EQ (stats.GetRecord (2).packetUid, 5, "Newest record");
+    NS_TEST_EXPECT_MSG_EQ (stats.GetNOverwritten (), 2, "Oldest records overwritten");
+
+    // the flow key depends on the five-tuple only
+    uint32_t key = RplPathStats::FlowKey ("2001:1::2", "2001:1::1", 17, 49153, 9);
+    NS_TEST_EXPECT_MSG_EQ (RplPathStats::FlowKey ("2001:1::2", "2001:1::1", 17, 49153, 9), key, "Same flow");
+    NS_TEST_EXPECT_MSG_NE (RplPathStats::FlowKey ("2001:1::2", "2001:1::1", 17, 49154, 9), key, "Other source port");
+    NS_TEST_EXPECT_MSG_NE (RplPathStats::FlowKey ("2001:1::1", "2001:1::2", 17, 9, 49153), key, "Reverse flow");
+
+    NS_TEST_EXPECT_MSG_EQ (RplHelper::GetFlowPaths ().empty (), true, "No flow traced without records");
+  }
+};
+
+/*
+ * Convergence and overhead at scale. The nodes are joined by point-to-point
+ * links, so that the results do not depend on MAC contention, and the
+ * DODAG, in storing mode, is rooted at node 0. Each run, under a fixed
+ * seed, checks that every node joined, and that the convergence time, the
+ * DIO, DIS and DAO counts and the peak memory of the neighbor sets and
+ * routing tables stay within budgets derived from the topology (hop
+ * distance to the root, degrees), the Trickle Imin and the protocol
+ * constants, plus SCALE_TOLERANCE.
+ */
+#define SCALE_SIM_TIME 60
+#define SCALE_SEED 1
+#define SCALE_SAMPLE_INTERVAL 0.01
+#define SCALE_TOLERANCE 0.25
+
+enum RplScaleTopology
+{
+  RPL_SCALE_LINE,
+  RPL_SCALE_GRID,
+  RPL_SCALE_RANDOM
+};
+
+struct RplScaleTest : public TestCase
+{
+  RplScaleTopology m_topology;
+  uint32_t m_size;
+  std::vector<std::pair<uint32_t, uint32_t> > m_links;
+  NodeContainer m_nodes;
+  Time m_converged;
+  uint32_t m_messages[3];
+  uint64_t m_peakBytes;
+
+  static std::string TopologyName (RplScaleTopology topology)
+  {
+    return topology == RPL_SCALE_LINE ? "line" : topology == RPL_SCALE_GRID ? "grid" : "random";
+  }
+
+  static std::string Name (RplScaleTopology topology, uint32_t size)
+  {
+    std::ostringstream name;
+    name << "Rpl Scale Test: " << TopologyName (topology) << " of " << size << " nodes";
+    return name.str ();
+  }
+
+  RplScaleTest (RplScaleTopology topology, uint32_t size)
+    : TestCase (Name (topology, size)), m_topology (topology), m_size (size)
+  {
+  }
+
+  // for a grid, size is the number of nodes and must be a square
+  void BuildLinks ()
+  {
+    m_links.clear ();
+    if (m_topology == RPL_SCALE_LINE)
+      {
+        for (uint32_t i = 1; i < m_size; i++)
+          {
+            m_links.push_back (std::make_pair (i - 1, i));
+          }
+      }
+    else if (m_topology == RPL_SCALE_GRID)
+      {
+        uint32_t width = std::sqrt (double (m_size));
+        NS_ABORT_MSG_IF (width * width != m_size, "a grid needs a square number of nodes");
+        for (uint32_t i = 0; i < m_size; i++)
+          {
+            if (i % width + 1 < width)
+              {
+                m_links.push_back (std::make_pair (i, i + 1));
+              }
+            if (i + width < m_size)
+              {
+                m_links.push_back (std::make_pair (i, i + width));
+              }
+          }
+      }
+    else
+      {
+        // random geometric graph with about 6 neighbors per node, its
+        // components then bridged through their closest pair of nodes
+        Ptr<UniformRandomVariable> uniform = CreateObject<UniformRandomVariable> ();
+        uniform->SetStream (m_size);
+        std::vector<double> x (m_size), y (m_size);
+        for (uint32_t i = 0; i < m_size; i++)
+          {
+            x[i] = uniform->GetValue (0, 1);
+            y[i] = uniform->GetValue (0, 1);
+          }
+        double range = std::sqrt (6.0 / (M_PI * m_size));
+        for (uint32_t i = 0; i < m_size; i++)
+          {
+            for (uint32_t j = i + 1; j < m_size; j++)
+              {
+                if (std::hypot (x[i] - x[j], y[i] - y[j]) <= range)
+                  {
+                    m_links.push_back (std::make_pair (i, j));
+                  }
+              }
+          }
+        std::vector<uint32_t> depth = Depths ();
+        while (std::count (depth.begin (), depth.end (), UINT32_MAX) > 0)
+          {
+            uint32_t a = 0;
+            uint32_t b = 0;
+            double closest = 2;
+            for (uint32_t i = 0; i < m_size; i++)
+              {
+                for (uint32_t j = 0; j < m_size; j++)
+                  {
+                    if (depth[i] != UINT32_MAX && depth[j] == UINT32_MAX &&
+                        std::hypot (x[i] - x[j], y[i] - y[j]) < closest)
+                      {
+                        closest = std::hypot (x[i] - x[j], y[i] - y[j]);
+                        a = i;
+                        b = j;
+                      }
+                  }
+              }
+            m_links.push_back (std::make_pair (a, b));
+            depth = Depths ();
+          }
+      }
+  }
+
+  // hop distance of every node to the root, UINT32_MAX if unreachable
+  std::vector<uint32_t> Depths () const
+  {
+    std::vector<std::vector<uint32_t> > adjacency (m_size);
+    for (uint32_t l = 0; l < m_links.size (); l++)
+      {
+        adjacency[m_links[l].first].push_back (m_links[l].second);
+        adjacency[m_links[l].second].push_back (m_links[l].first);
+      }
+    std::vector<uint32_t> depth (m_size, UINT32_MAX);
+    std::vector<uint32_t> queue (1, 0);
+    depth[0] = 0;
+    for (uint32_t q = 0; q < queue.size (); q++)
+      {
+        for (uint32_t n = 0; n < adjacency[queue[q]].size (); n++)
+          {
+            uint32_t next = adjacency[queue[q]][n];
+            if (depth[next] == UINT32_MAX)
+              {
+                depth[next] = depth[queue[q]] + 1;
+                queue.push_back (next);
+              }
+          }
+      }
+    return depth;
+  }
+
+  void ControlTx (Ptr<const Packet> packet, uint8_t code)
+  {
+    if (code < 3)
+      {
+        m_messages[code]++;
+      }
+  }
+
+  void Sample ()
+  {
+    uint64_t bytes = 0;
+    bool joined = true;
+    for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+      {
+        Ptr<Rpl> rpl = m_nodes.Get (i)->GetObject<Rpl> ();
+        bytes += rpl->GetNeighborSet ().GetNNeighbors () * sizeof (Neighbor) +
+          rpl->GetNRoutes () * sizeof (RplRoutingTableEntry);
+        joined = joined && rpl->GetRank () != 0;
+      }
+    m_peakBytes = std::max (m_peakBytes, bytes);
+    if (joined && m_converged.IsNegative ())
+      {
+        m_converged = Simulator::Now ();
+      }
+    Simulator::Schedule (Seconds (SCALE_SAMPLE_INTERVAL), &RplScaleTest::Sample, this);
+  }
+
+  virtual void DoRun ()
+  {
+    RngSeedManager::SetSeed (SCALE_SEED);
+    RngSeedManager::SetRun (1);
+    BuildLinks ();
+    std::vector<uint32_t> depth = Depths ();
+    std::vector<uint32_t> degree (m_size, 0);
+    for (uint32_t l = 0; l < m_links.size (); l++)
+      {
+        degree[m_links[l].first]++;
+        degree[m_links[l].second]++;
+      }
+
+    m_nodes = NodeContainer ();
+    m_nodes.Create (m_size);
+    std::vector<NetDeviceContainer> linkDevices;
+    for (uint32_t l = 0; l < m_links.size (); l++)
+      {
+        Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+        NetDeviceContainer devices;
+        uint32_t ends[2] = { m_links[l].first, m_links[l].second };
+        for (uint32_t e = 0; e < 2; e++)
+          {
+            Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+            device->SetAddress (Mac48Address::Allocate ());
+            device->SetChannel (channel);
+            m_nodes.Get (ends[e])->AddDevice (device);
+            devices.Add (device);
+          }
+        linkDevices.push_back (devices);
+      }
+
+    RplHelper RplRouting;
+    RplRouting.Set ("DownwardRoutes", BooleanValue (true));
+    RplRouting.SetRoot (m_nodes.Get (0));
+    InternetStackHelper internetv6routers;
+    internetv6routers.SetIpv4StackInstall (false);
+    internetv6routers.SetRoutingHelper (RplRouting);
+    internetv6routers.Install (m_nodes);
+    RplRouting.AssignStreams (m_nodes, 0);
+
+    Ipv6AddressHelper ipv6;
+    ipv6.SetBase (Ipv6Address ("2001:1::"), Ipv6Prefix (64));
+    for (uint32_t l = 0; l < linkDevices.size (); l++)
+      {
+        Ipv6InterfaceContainer interfaces = ipv6.Assign (linkDevices[l]);
+        interfaces.SetForwarding (0, true);
+        interfaces.SetForwarding (1, true);
+        ipv6.NewNetwork ();
+      }
+
+    m_converged = Seconds (-1);
+    m_messages[0] = m_messages[1] = m_messages[2] = 0;
+    m_peakBytes = 0;
+    for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+      {
+        m_nodes.Get (i)->GetObject<Rpl> ()->TraceConnectWithoutContext ("ControlTx", MakeCallback (&RplScaleTest::ControlTx, this));
+      }
+    Simulator::Schedule (Seconds (SCALE_SAMPLE_INTERVAL), &RplScaleTest::Sample, this);
+
+    TimeValue iMinValue;
+    m_nodes.Get (0)->GetObject<Rpl> ()->GetAttribute ("MinimumIntervalSize", iMinValue);
+    double iMin = iMinValue.Get ().GetSeconds ();
+
+    Simulator::Stop (Seconds (SCALE_SIM_TIME));
+    Simulator::Run ();
+    Simulator::Destroy ();
+
+    // Budgets. A node joins on the first DIO of a neighbor, which comes
+    // within the minimum Trickle interval Imin of that neighbor joining, so
+    // a DODAG of D hops forms in about D Imin. The Trickle timer of an
+    // interface doubles up to log2 (T / Imin) intervals in a run of T, and
+    // is reset at most once for each neighbor soliciting it or changing
+    // its parent. A node sends DISs only while it has not joined, at most
+    // the few that fit in its backoff before the DODAG reaches it. In
+    // storing mode every node sends one DAO per DAO delay while
+    // announcements of its sub-DODAG keep arriving, that is for about the
+    // depth of the DODAG in seconds. The neighbor set of a node holds its
+    // neighbors, up to the table size, and its routing table a host route
+    // per neighbor, a network route per interface, the default route, and
+    // the targets of its descendants, one per interface.
+    uint32_t diameter = *std::max_element (depth.begin (), depth.end ());
+    double trickleRuns = std::ceil (std::log (SCALE_SIM_TIME / iMin) / std::log (2.0)) + 1;
+    double dioBudget = 0;
+    double disBudget = 0;
+    double daoBudget = 0;
+    double routeBudget = 0;
+    double neighborBudget = 0;
+    for (uint32_t i = 0; i < m_size; i++)
+      {
+        dioBudget += degree[i] * trickleRuns * (1 + 2 * degree[i]);
+        disBudget += degree[i] * 3;
+        daoBudget += diameter + 2;
+        routeBudget += 2 * degree[i] + 1 + degree[i] * depth[i];
+        neighborBudget += std::min<uint32_t> (degree[i], 32);
+      }
+    double convergenceBudget = 1.0 + (diameter + 1) * 4 * iMin;
+    double bytesBudget = neighborBudget * sizeof (Neighbor) + routeBudget * sizeof (RplRoutingTableEntry);
+    double tolerance = 1 + SCALE_TOLERANCE;
+
+    NS_TEST_ASSERT_MSG_EQ (m_converged.IsNegative (), false, "Not every node joined the DODAG");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_converged.GetSeconds (), convergenceBudget * tolerance, "Convergence time");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_messages[1], dioBudget * tolerance, "DIOs sent");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_messages[0], disBudget * tolerance, "DISs sent");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_messages[2], daoBudget * tolerance, "DAOs sent");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ (m_peakBytes, bytesBudget * tolerance, "Peak neighbor and route memory");
+  }
+};
 
 struct RplTest : public TestCase
 {
@@ -325,6 +2040,7 @@ struct RplTest : public TestCase
     NetDeviceContainer ndc = csma.Install (nodes);
 
     RplHelper RplRouting;
+    RplRouting.SetRoot (txNode);
     InternetStackHelper internetv6routers;
     internetv6routers.SetIpv4StackInstall (false);
     internetv6routers.SetRoutingHelper (RplRouting);
@@ -563,13 +2279,44 @@ RplTestSuite::RplTestSuite ()
   AddTestCase (new DioHeaderTest, TestCase::QUICK);
   AddTestCase (new DisHeaderTest, TestCase::QUICK);
   AddTestCase (new DaoHeaderTest, TestCase::QUICK);
+  AddTestCase (new DroHeaderTest, TestCase::QUICK);
   AddTestCase (new RplDodagConfigurationOptionTest, TestCase::QUICK);
   AddTestCase (new RplSolicitedInformationOptionTest, TestCase::QUICK);
+  AddTestCase (new RplP2pRouteDiscoveryOptionTest, TestCase::QUICK);
+  AddTestCase (new RplMetricContainerOptionTest, TestCase::QUICK);
+  AddTestCase (new RplMetricObjectTest, TestCase::QUICK);
   AddTestCase (new RplObjectiveFunction0Test, TestCase::QUICK);
   AddTestCase (new RplRoutingTableEntryTest, TestCase::QUICK);
   AddTestCase (new RplRoutingTableTest, TestCase::QUICK);
   AddTestCase (new RplNeighborTest, TestCase::QUICK);
+  AddTestCase (new RplNeighborSetTest, TestCase::QUICK);
+  AddTestCase (new RplLoadBalancingTest, TestCase::QUICK);
+  AddTestCase (new RplParentSetTest, TestCase::QUICK);
+  AddTestCase (new RplEtxTest, TestCase::QUICK);
+  AddTestCase (new RplNeighborEvictionTest, TestCase::QUICK);
+  AddTestCase (new RplMultipathTest, TestCase::QUICK);
+  AddTestCase (new RplCongestionTest, TestCase::QUICK);
+  AddTestCase (new RplEnergyTest, TestCase::QUICK);
+  AddTestCase (new RplWakeScheduleTest, TestCase::QUICK);
+  AddTestCase (new RplMobilityTest, TestCase::QUICK);
+  AddTestCase (new RplDaoTest, TestCase::QUICK);
+  AddTestCase (new RplRouteAggregationTest, TestCase::QUICK);
+  AddTestCase (new RplRepairTest, TestCase::QUICK);
+  AddTestCase (new RplDisTest, TestCase::QUICK);
+  AddTestCase (new RplDisSolicitationTest, TestCase::QUICK);
+  AddTestCase (new RplInterfaceTest, TestCase::QUICK);
+  AddTestCase (new RplLeafTest, TestCase::QUICK);
+  AddTestCase (new RplDodagExportTest, TestCase::QUICK);
+  AddTestCase (new RplRoutingTableDumpTest, TestCase::QUICK);
+  AddTestCase (new RplP2pRouteTest, TestCase::QUICK);
+  AddTestCase (new RplMulticastTest, TestCase::QUICK);
+  AddTestCase (new RplPathStatsTest, TestCase::QUICK);
   AddTestCase (new RplTest, TestCase::QUICK);
+  AddTestCase (new RplScaleTest (RPL_SCALE_LINE, 50), TestCase::EXTENSIVE);
+  AddTestCase (new RplScaleTest (RPL_SCALE_GRID, 100), TestCase::EXTENSIVE);
+  AddTestCase (new RplScaleTest (RPL_SCALE_GRID, 400), TestCase::EXTENSIVE);
+  AddTestCase (new RplScaleTest (RPL_SCALE_RANDOM, 200), TestCase::EXTENSIVE);
+  AddTestCase (new RplScaleTest (RPL_SCALE_RANDOM, 500), TestCase::EXTENSIVE);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,63 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Turn a routing table dump, written by RplHelper::DumpRoutingTablesAt,
+// into CSV: one line per route, with the time of the dump, the node ID
+// and rank, and the type, destination, prefix length, next hop,
+// interface, path sequence and lifetime of the route.
+//
+// ./waf --run "rpl-dump-to-csv --input=tables.bin --output=tables.csv"
+//
+
+#include "ns3/core-module.h"
+#include "ns3/rpl-helper.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "routing table dump", input);
+  cmd.AddValue ("output", "CSV file, standard output if empty", output);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (input.empty (), "--input is needed");
+  std::ifstream dump (input.c_str (), std::ios::in | std::ios::binary);
+  NS_ABORT_MSG_IF (!dump, "Cannot open " << input);
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      NS_ABORT_MSG_IF (!file, "Cannot open " << output);
+    }
+
+  if (!RplHelper::ConvertRoutingTableDump (dump, output.empty () ? std::cout : file))
+    {
+      std::cerr << input << " is not a complete routing table dump" << std::endl;
+      return 1;
+    }
+  return 0;
+}